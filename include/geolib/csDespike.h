@@ -10,7 +10,7 @@
 
 namespace cseis_geolib {
 
-template <typename T> class csVector;
+class csSlidingMedian;
 class csDespike;
 struct DespikeConfig;
 
@@ -24,16 +24,6 @@ struct DespikeConfig;
  * @date 2008
  */
 class csDespike {
-private:
-  struct DespikePoint {
-    DespikePoint( int theIndex, float theValue ) {
-      index = theIndex;
-      value = theValue;
-    }
-    int   index;
-    float value;
-  };
-
 public:
 //  static int const TAPER_NONE   = 210;
 //  static int const TAPER_COSINE = 211;
@@ -73,6 +63,8 @@ private:
 
   float myMaxRatio;
   float* myRatios;
+  /// Median of reference window
+  csSlidingMedian* myMedian;
   
   // Special advanced settings
   int myRatioAmplifier;
@@ -80,7 +72,6 @@ private:
 
   void init( int numSamples, double sampleInt );
   bool computeRatios( float* samples, int numSamples );
-  void insertNewValue( DespikePoint* p, cseis_geolib::csVector<DespikePoint*>* sortedList );
 };
 
 /**
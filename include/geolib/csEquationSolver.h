@@ -34,6 +34,11 @@ namespace cseis_geolib {
  *  - setUserConstants() sets the values of the necessary user constants
  *  - solve() solves the equation and returns the result
  *
+ * The parsed equation is compiled into a flat list of operations on a register array. User constants occupy the first
+ * registers, followed by numeric constants and intermediate results. Operations with constant arguments only are
+ * evaluated once at preparation time (constant folding).
+ * solve( numValues, ... ) evaluates the equation for a whole batch of user constant values, one operation at a time.
+ *
  * @author Bjorn Olofsson
  * @date 2005
  */
@@ -70,11 +75,45 @@ public:
   * @return result
   */
   double solve();
+  /**
+  * Solve equation for a batch of user constant values
+  * Same result as calling setUserConstants() and solve() for each set of values in turn
+  * @param numValues     Number of value sets
+  * @param userConstants Values of user constants, one array of numValues values per user constant
+  * @param results       (o) Result for each value set
+  */
+  void solve( int numValues, double const* const* userConstants, double* results );
+  /**
+  * @return Number of operations performed by solve(), after constant folding. 0 if equation is constant
+  */
+  inline int numOperations() const { return myNumOperations; }
 
 private:
   void init();
+  /// Operation on register array: result = arg1 (op) arg2, or result = function( arg1[, arg2] )
+  struct Operation {
+    int code;
+    int result;
+    int arg1;
+    int arg2;
+    csMathFunction const* function;
+  };
+  static int const OP_ADD   = 1;
+  static int const OP_SUB   = 2;
+  static int const OP_MUL   = 3;
+  static int const OP_DIV   = 4;
+  static int const OP_FUNC1 = 5;
+  static int const OP_FUNC2 = 6;
+  /// Number of value sets per register in batch mode
+  static int const BATCH_SIZE = 256;
+
   void prepareExpressionList( csVector<csToken>& tokenList );
-  double getValue( csToken const* tokenPtr );
+  void compile();
+  int compileOperand( csToken const* token, int const* expressionRegisters, csVector<double>* regValues, csVector<int>* regIsConst );
+  int compileOperation( int code, csMathFunction const* function, int arg1, int arg2,
+                        csVector<Operation>* operations, csVector<double>* regValues, csVector<int>* regIsConst );
+  static inline double evaluate( Operation const& op, double arg1, double arg2 );
+  void freeProgram();
   /// Tokenize regular expression (lower case, no spaces)
   void tokenizeExpression( std::string expression, csVector<csToken>& tokenList );
   /// @return boolean   true if character c is valid operator
@@ -95,17 +134,25 @@ private:
   static bool const DEBUG_EQ_SOLVER = false;
   /// Number of user constants
   int myNumUserConstants;
-  /// Values of user constants
-  double* myUserConstants;    // Array of user constant values (3 rows, for index i-1, i and i+1)
   /// Identifier names for user constants
   std::string*  myUserConstantNames;
   std::string myErrorMessage;
   /// Reduced list of expressions that is solved in solve() method in order to solve the original equation.
   /// Each expression is a simple expression involving only either a math function or a succession of */+- operations
   csVector< csVector<csToken> >* myExpressionList;
-  /// Stack of fixed size that is used in the solve() method.
-  /// Contains solution values for each of the expressions in the above expression list
-  double* myValueStack;
+  /// Compiled equation: Operations performed in solve() method
+  Operation* myOperations;
+  int myNumOperations;
+  /// Register array: User constants, followed by numeric constants and intermediate results
+  double* myRegisters;
+  int myNumRegisters;
+  /// Register holding final result
+  int myResultRegister;
+  /// true if equation contains a function that must be evaluated in the original order (random)
+  bool myHasSequentialFunction;
+  /// Register arrays for batch mode, BATCH_SIZE values per register
+  double* myBatchRegisters;
+  double const** myBatchArgs;
   int myNumValuesSpecialFloatArray;
   std::string myNameSpecialFloatArray;
   bool myIsSpecialFloatArray;
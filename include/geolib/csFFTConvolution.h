@@ -0,0 +1,57 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_FFT_CONVOLUTION_H
+#define CS_FFT_CONVOLUTION_H
+
+namespace cseis_geolib {
+
+class csFFTEngine;
+
+/**
+ * Frequency domain convolution with a fixed filter, using the overlap-save method
+ *
+ * Computes output samples of the full linear convolution y = x * filter:
+ *   samplesOut[i] = y[i+sampleAtZero] = SUM_j[ filter(j) * x(i+sampleAtZero-j) ],  i = 0..nSampIn-1
+ * The filter spectrum is computed once in the constructor. Input data is processed in blocks of
+ * a fixed transform length, so the transform length does not grow with the trace length.
+ */
+class csFFTConvolution {
+public:
+  /**
+   * @param filter            Filter samples
+   * @param numFilterSamples  Number of filter samples
+   * @param nSampIn           Number of input samples
+   */
+  csFFTConvolution( float const* filter, int numFilterSamples, int nSampIn );
+  ~csFFTConvolution();
+  /**
+   * @param samplesIn    (i) nSampIn input samples
+   * @param samplesOut   (o) nSampIn output samples. Must not overlap samplesIn
+   * @param sampleAtZero (i) Output sample index shift, i.e. filter sample index at zero time
+   */
+  void convolve( float const* samplesIn, float* samplesOut, int sampleAtZero );
+  /// @return Transform length of one block
+  int numFFTSamples() const;
+  /**
+   * @return true if the frequency domain convolution is expected to be faster than the time domain convolution
+   */
+  static bool isFasterThanTimeDomain( int numFilterSamples, int nSampIn );
+
+private:
+  csFFTConvolution( csFFTConvolution const& obj );
+  static int blockLength( int numFilterSamples, int nSampIn );
+  int myNumSamplesIn;
+  int myNumFilterSamples;
+  csFFTEngine const* myPlan;
+  /// Filter spectrum, scaled by 1/numFFTSamples
+  float* myFilterReal;
+  float* myFilterImag;
+  float* myReal;
+  float* myImag;
+  float* myBuffer;
+  float* myWork;
+};
+
+} // namespace
+#endif
@@ -0,0 +1,66 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_FFT_CORRELATION_H
+#define CS_FFT_CORRELATION_H
+
+namespace cseis_geolib {
+
+class csFFTEngine;
+
+/**
+ * Frequency domain two-sided cross-correlation
+ *
+ * Computes the same correlation function as compute_twosided_correlation():
+ *   corr[lag+maxlag] = SUM_i[ left(i) * right(i+lag) ],  lag = -maxlag..maxlag
+ * The spectrum of the 'left' (pilot) series is computed once by setPilot() and reused for all
+ * subsequent 'right' series. Correlating one pilot with N traces therefore costs N+1 real transforms.
+ *
+ * Series are zero-padded to a transform length >= nSampIn+maxlag, so no wrap-around occurs.
+ */
+class csFFTCorrelation {
+public:
+  /**
+   * @param nSampIn Number of values in input series
+   * @param maxlag  Maximum time lag to compute, in number of samples
+   */
+  csFFTCorrelation( int nSampIn, int maxlag );
+  ~csFFTCorrelation();
+  /**
+   * Set 'left' series (pilot) and compute its spectrum
+   * @param samplesLeft  nSampIn values
+   */
+  void setPilot( float const* samplesLeft );
+  /**
+   * Correlate pilot with 'right' series
+   * @param samplesRight (i) nSampIn values
+   * @param corr         (o) 2*maxlag+1 values
+   * @param dampen       (i) Scale each lag by the number of overlapping samples divided by nSampIn
+   */
+  void correlate( float const* samplesRight, float* corr, bool dampen );
+  /// @return Transform length
+  int numFFTSamples() const;
+  /**
+   * @param nSampIn       Number of values in input series
+   * @param maxlag        Maximum time lag
+   * @param isPilotCached true if the pilot spectrum is reused for several correlations
+   * @return true if the frequency domain correlation is expected to be faster than the time domain correlation
+   */
+  static bool isFasterThanTimeDomain( int nSampIn, int maxlag, bool isPilotCached );
+
+private:
+  csFFTCorrelation( csFFTCorrelation const& obj );
+  int myNumSamplesIn;
+  int myMaxLag;
+  csFFTEngine const* myPlan;
+  /// Pilot spectrum, scaled by 1/numFFTSamples
+  float* myPilotReal;
+  float* myPilotImag;
+  float* myReal;
+  float* myImag;
+  float* myBuffer;
+  float* myWork;
+};
+
+} // namespace
+#endif
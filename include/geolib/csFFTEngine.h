@@ -0,0 +1,112 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_FFT_ENGINE_H
+#define CS_FFT_ENGINE_H
+
+namespace cseis_geolib {
+
+/**
+ * FFT engine
+ *
+ * Mixed-radix FFT (radix 2, 3, 4 and 5) for transform lengths of the form 2^a * 3^b * 5^c.
+ * Complex transforms operate on separate real and imaginary arrays. Real-to-complex transforms of even length
+ * are computed via a complex transform of half the length.
+ * Butterflies are computed on several values at once (SIMD vectors), in single or double precision.
+ *
+ * Plans (factorization and twiddle factors) are created once per transform length and shared by all users.
+ * Plans are read-only after creation: The same plan can be used by several threads at once, each thread
+ * providing its own work buffer.
+ *
+ * Sign convention: FORWARD transform uses exp(-i*2*pi*k*n/N), INVERSE transform uses exp(+i*2*pi*k*n/N).
+ * Transforms are not normalized.
+ */
+class csFFTEngine {
+public:
+  static int const FORWARD = 1;
+  static int const INVERSE = 2;
+
+  /**
+   * @return Plan for the given transform length. Plans are cached. Throws csException if length is not supported
+   */
+  static csFFTEngine const* getPlan( int numSamples );
+  /**
+   * @return true if transform length is supported, i.e. a product of powers of 2, 3 and 5
+   */
+  static bool isSupportedSize( int numSamples );
+  /**
+   * @return Smallest supported transform length greater or equal to the given number of samples
+   */
+  static int nextSupportedSize( int numSamples );
+
+public:
+  /// @return Transform length
+  int numSamples() const { return myNumSamples; }
+  /// @return Required size of work buffer (number of values) passed to transform methods
+  int workSize() const { return 4*myNumSamples; }
+
+  /**
+   * In-place complex transform
+   * @param dir   FORWARD or INVERSE
+   * @param real  Real part, numSamples() values
+   * @param imag  Imaginary part, numSamples() values
+   * @param work  Work buffer, workSize() values
+   */
+  void complexTransform( int dir, float* real, float* imag, float* work ) const;
+  void complexTransform( int dir, double* real, double* imag, double* work ) const;
+  /**
+   * Forward transform of real input data
+   * @param samples Input data, numSamples() values
+   * @param real    Output real part of spectrum, numSamples()/2+1 values
+   * @param imag    Output imaginary part of spectrum, numSamples()/2+1 values
+   * @param work    Work buffer, workSize() values
+   */
+  void realForward( float const* samples, float* real, float* imag, float* work ) const;
+  void realForward( double const* samples, double* real, double* imag, double* work ) const;
+  /**
+   * Inverse transform to real output data
+   * @param real    Real part of spectrum, numSamples()/2+1 values
+   * @param imag    Imaginary part of spectrum, numSamples()/2+1 values. Negative frequencies are assumed to be complex conjugate
+   * @param samples Output data, numSamples() values
+   * @param work    Work buffer, workSize() values
+   */
+  void realInverse( float const* real, float const* imag, float* samples, float* work ) const;
+  void realInverse( double const* real, double const* imag, double* samples, double* work ) const;
+
+private:
+  csFFTEngine( int numSamples );
+  ~csFFTEngine();
+  csFFTEngine( csFFTEngine const& obj );
+  static csFFTEngine const* getPlanLocked( int numSamples );
+
+  template<typename T> void transform( T* real, T* imag, T* work ) const;
+  template<typename T> void realForwardT( T const* samples, T* real, T* imag, T* work ) const;
+  template<typename T> void realInverseT( T const* real, T const* imag, T* samples, T* work ) const;
+
+  void getTwiddles( float const** twReal, float const** twImag, float const** twRealHalf, float const** twImagHalf ) const;
+  void getTwiddles( double const** twReal, double const** twImag, double const** twRealHalf, double const** twImagHalf ) const;
+
+  int myNumSamples;
+  int myNumStages;
+  /// Radix of each stage
+  int* myRadix;
+  /// Index of first twiddle factor of each stage
+  int* myTwiddleIndex;
+  /// Twiddle factors of all stages
+  double* myTwiddleRealD;
+  double* myTwiddleImagD;
+  float*  myTwiddleRealF;
+  float*  myTwiddleImagF;
+  /// Twiddle factors exp(-i*2*pi*k/N), k=0..N/2, for real transforms
+  double* myTwiddleRealHalfD;
+  double* myTwiddleImagHalfD;
+  float*  myTwiddleRealHalfF;
+  float*  myTwiddleImagHalfF;
+  /// Plan of half length, used for real transforms of even length
+  csFFTEngine const* myHalfPlan;
+
+  friend class csFFTPlanCache;
+};
+
+} // namespace
+#endif
@@ -6,6 +6,14 @@
 
 namespace cseis_geolib {
 
+class csFFTEngine;
+
+/**
+ * FFT tools
+ *
+ * Transforms are computed by csFFTEngine in single precision, using real-to-complex transforms for real input data.
+ * Spectra are stored as full complex spectra (positive and negative frequencies) in double precision buffers.
+ */
 class csFFTTools {
 public:
   static int const FORWARD = 1;
@@ -43,6 +51,11 @@ public:
    * @param sampleIntOut  Sample interval in output data in milliseconds [ms].
    */
   csFFTTools( int numSamplesIn, int numSamplesOut, float sampleIntIn, float sampleIntOut );
+  /**
+   * Copy constructor. Copies all settings including filters, but allocates new work buffers.
+   * Use to create an independent FFT object for another thread.
+   */
+  csFFTTools( csFFTTools const& obj );
   ~csFFTTools();
 
   void setFilter( float order, float cutOffFreqHz, bool outputImpulseResponse );
@@ -126,6 +139,13 @@ protected:
   void init();
   void setBuffer( float const* samples );
   void convertFromAmpPhase( float const* ampSpec, float const* phaseSpec );
+  /**
+   * Transform data in real/imaginary buffers
+   * Uses real-to-complex transforms if data is real (forward transform) or spectrum is Hermitian (inverse transform).
+   * @param dir            FORWARD or INVERSE
+   * @param numFFTSamples  Number of samples to transform, either numFFTSamples() or numFFTSamplesOut()
+   */
+  bool transform( int dir, int numFFTSamples, bool doNormalisation );
 
   /// Number of samples in input data
   int myNumSamplesIn;
@@ -147,6 +167,11 @@ protected:
   double* myBufferReal;
   double* myBufferImag;
   double* myNotchFilter;
+  /// FFT plans for input and output data. Shared, do not delete
+  csFFTEngine const* myFFTPlanIn;
+  csFFTEngine const* myFFTPlanOut;
+  /// Single precision work buffer for FFT engine
+  float* myFFTWorkBuffer;
 
   double* myFilterWavelet;
   int     myLengthFilterWavelet;
@@ -85,10 +85,23 @@ class csIOSelection {
   cseis_geolib::csVector<int>* mySelectedTraceIndexList;
   cseis_geolib::csSortManager* mySortManager;
   cseis_geolib::csVector<csFlexNumber*>* mySelectedValueList;
+  /// true if selected traces have been determined from the reader's header index. Selected traces are then already sorted
+  bool myIsIndexed;
+  /**
+   * Determine selected traces from header index
+   * @param sortedValues       Header values of all traces, sorted by increasing value. NULL for 64bit integer headers
+   * @param sortedValuesInt64  Same as sortedValues, for 64bit integer headers
+   * @param sortedTraceIndices Trace indices matching sorted values
+   * @param numTraces          Number of traces
+   * @param hdrType            Type of trace header
+   */
+  void selectFromIndex( double const* sortedValues, csInt64_t const* sortedValuesInt64, int const* sortedTraceIndices,
+                        int numTraces, cseis_geolib::type_t hdrType );
 
   int mySTEPCurrentTraceIndex;
   int mySTEPTraceIndex;
   cseis_geolib::csSelection* mySTEPSelection;
+  cseis_geolib::type_t mySTEPHdrType;
 };
 
 } // end namespace
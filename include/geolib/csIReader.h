@@ -27,6 +27,18 @@ class csIReader {
   virtual bool setHeaderToPeek( std::string const& headerName ) = 0;
   virtual bool setHeaderToPeek( std::string const& headerName, cseis_geolib::type_t& headerType ) = 0;
   virtual bool peekHeaderValue( cseis_geolib::csFlexHeader* value, int traceIndex ) = 0;
+  /**
+   * Retrieve values of given trace header for all traces from a header index, without scanning the input file.
+   * @param headerName         (i) Trace header name
+   * @param sortedValues       (o) Header values of all traces, sorted by increasing value. NULL for 64bit integer headers
+   * @param sortedValuesInt64  (o) Same as sortedValues, for 64bit integer headers. These are kept exact. NULL for all other headers
+   * @param sortedTraceIndices (o) Trace indices matching sorted values. Traces with equal header values are in trace order
+   * @return false if the reader has no up-to-date header index for this trace header
+   */
+  virtual bool getIndexedHeaderValues( std::string const& headerName, double const*& sortedValues, csInt64_t const*& sortedValuesInt64,
+                                       int const*& sortedTraceIndices ) {
+    return false;
+  }
   //  virtual bool peekHeaderValue( cseis_geolib::csFlexNumber* value, int traceIndex = -1 ) = 0;
 };
 
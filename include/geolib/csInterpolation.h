@@ -13,6 +13,8 @@ class csInterpolation {
  public:
   csInterpolation( int numSamples, float sampleInt );
   csInterpolation( int numSamples, float sampleInt, int numCoefficients );
+  /// Copy constructor. Creates independent object with same settings, for example to be used by another thread
+  csInterpolation( csInterpolation const& obj );
   ~csInterpolation();
 
   void setExtrapolation( float valLeft, float valRight );
@@ -28,6 +30,19 @@ class csInterpolation {
     process( sampleIntSkew, xVal1, samplesIn, sIndexOut, samplesOut, myNumSamples );
   }
   float valueAt( float time_ms, float const* samplesIn );
+  /**
+   * Precompute interpolation table for process() with the same arguments. Use with apply() to interpolate several traces
+   * at the same output positions, or the same trace repeatedly.
+   * @param sampleIndex  (o) Index of first input sample of interpolation operator, for each output sample
+   * @param coefIndex    (o) Index of interpolation operator, for each output sample
+   */
+  void computeIndexTable( float sampleIntSkew, float xVal1, float const* sIndexOut, int* sampleIndex, int* coefIndex, int numSamplesOut ) const;
+  /**
+   * Interpolate samples at the output positions of a precomputed table, see computeIndexTable()
+   * Products are summed in four partial sums (SIMD lanes), so results may differ from process() in the last bit.
+   * Results are the same with and without SIMD support.
+   */
+  void apply( float const* samplesIn, int const* sampleIndex, int const* coefIndex, float* samplesOut, int numSamplesOut ) const;
 
   static double sincFunction( double value );
   static bool toeplitzSolver( int numDimensions, double const* topRow, double const* vecRight, double* vecLeft, double* vecSolve );
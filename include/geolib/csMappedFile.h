@@ -0,0 +1,53 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_MAPPED_FILE_H
+#define CS_MAPPED_FILE_H
+
+#include <string>
+#include "geolib_defines.h"
+#include "csSharedBuffer.h"
+
+namespace cseis_geolib {
+
+/**
+ * Memory-mapped file
+ *
+ * Maps a whole file read-only into memory. Data can then be accessed directly, without copying it through a read buffer.
+ * The mapping is reference counted (see csSharedBuffer): It is only unmapped when the last object referencing
+ * mapped data has released it. This allows to reference mapped data after the file has been closed by its reader.
+ */
+class csMappedFile : public csSharedBuffer {
+public:
+  static int const ACCESS_NORMAL     = 0;
+  static int const ACCESS_SEQUENTIAL = 1;
+  static int const ACCESS_RANDOM     = 2;
+
+public:
+  /**
+   * Map file. Throws csException if file cannot be mapped
+   * @param filename Name of file to map
+   */
+  csMappedFile( std::string const& filename );
+  /// @return pointer to start of mapped file
+  inline char const* data() const { return myData; }
+  /// @return size of mapped file in bytes
+  inline csInt64_t size() const { return mySize; }
+  /**
+   * Advise operating system on expected access pattern for the whole file
+   * @param accessType ACCESS_NORMAL, ACCESS_SEQUENTIAL or ACCESS_RANDOM
+   */
+  void setAccessPattern( int accessType );
+  /**
+   * Advise operating system that the given byte range will be accessed soon
+   */
+  void willNeed( csInt64_t byteOffset, csInt64_t byteSize );
+protected:
+  virtual ~csMappedFile();
+private:
+  char* myData;
+  csInt64_t mySize;
+};
+
+} // namespace
+#endif
@@ -15,6 +15,10 @@ namespace cseis_geolib {
   * Uses one of three NMO interpolation methods.
   * NOTE: This is an adaptation for model based NMO correction, not entirely suitable for NMO & stacking
   *
+  * Moveout tables (interpolation index tables, see csInterpolation::computeIndexTable()) are cached for the most
+  * recently used combinations of velocity function and offset. Traces with the same velocity function and offset,
+  * for example in regular geometries, reuse the cached table and are only interpolated.
+  *
   * @author Bjorn Olofsson
   * @date 2005
   */
@@ -40,6 +44,11 @@ public:
   * method_interpolation NMO interpolation method
   */
   csNMOCorrection( double sampleInt_ms, int numSamples, int method_nmo = csNMOCorrection::PP_NMO );
+  /**
+  * Copy constructor. Copies all settings, but allocates new work buffers.
+  * Use to create an independent NMO object for another thread.
+  */
+  csNMOCorrection( csNMOCorrection const& obj );
   ~csNMOCorrection();
 
   void setModeOfApplication( int mode );
@@ -64,6 +73,11 @@ public:
   void perform_nmo( int numVelocities_in, float const* time_in, float const* vel_rms_in, double offset, float* samplesOut );
   void perform_nmo( float const* samplesIn, int numVelocities_in, float const* time_in, float const* vel_rms_in, double offset, float* samplesOut );
   void perform_nmo( csTimeFunction<double> const* velTimeFunc, double offset, float* samplesOut );
+  /**
+  * Set maximum number of cached moveout tables. Each table holds two integer arrays of trace length.
+  * numTables  Maximum number of tables. 0: Disable cache
+  */
+  void setMoveoutCacheSize( int numTables );
 
   void perform_differential_nmo( int numVelocities_in, float const* time_in, float const* vel_rms_in, double offsetIn, double offsetOut, float* samplesOut );
   void perform_differential_nmo( float const* samplesIn, int numVelocities_in, float const* time_in, float const* vel_rms_in, double offsetIn, double offsetOut, float* samplesOut );
@@ -71,6 +85,20 @@ public:
   void perform_differential_nmo_ORIG( csTimeFunction<double> const* velTimeFunc, double offsetIn, double offsetOut, float* samplesOut );
 
 private:
+  /// Moveout table for one velocity function and offset
+  struct MoveoutTable {
+    int velFunctionId;
+    double offset;
+    int* sampleIndex;
+    int* coefIndex;
+    long lastUsed;
+  };
+  void setVelocityFunction( int numVels, float const* times, float const* vel_rms, float const* eta );
+  void computeVelocityTrace();
+  MoveoutTable const* getMoveoutTable( double offset );
+  void clearMoveoutCache();
+  void freeMoveoutCache();
+
   void perform_nmo_internal( int numVels, float const* times, float const* vel_rms, double offset, float* samplesOut, float const* eta );
   void perform_nmo_horizonBased_prepare( int numVelocities_in, float const* times, float const* vel_rms_in, double offset, float* samplesOut );
   void perform_nmo_horizonBased( int numVelocities, float const* times, float const* vel_rms, double offset, float* samplesInOut );
@@ -83,6 +111,7 @@ private:
   //  void perform_nmo_horizonBased( float* samplesOut, float const* vel_rms, float const* t0_s, int numVelocities, double offset, float const* samplesIn );
   // void perform_nmo_internal( double offset, float* samplesOut );
   // void perform_nmo_internal( int numVels, float const* times, float* vels, double offset, float* samplesOut );
+  void init( double sampleInt_ms, int numSamples, int method_nmo );
   void allocateVelocity();
 
   /// NMO 'method': PP, PS ...
@@ -109,6 +138,21 @@ private:
   float* myTimeTraceDiff;
   csInterpolation* myInterpol;
 
+  /// Cached moveout tables. Table 0 is used as work table if the cache is disabled
+  MoveoutTable* myMoveoutTables;
+  int  myNumMoveoutTables;
+  int  myMaxNumMoveoutTables;
+  long myMoveoutCounter;
+  /// Current velocity function, and its ID in moveout tables
+  int    myVelFunctionId;
+  int    myVelFunctionNumValues;
+  int    myVelFunctionNumAlloc;
+  float* myVelFunctionTimes;
+  float* myVelFunctionVels;
+  float* myVelFunctionEta;
+  /// true if myVelocityTrace (and myETATrace) hold the current velocity function
+  bool   myIsVelocityTraceValid;
+
   /// 'Horizon-based' NMO (stretch happens mostly between horizons, which can lead to sharp 'jumps' at the horizons)
   bool myIsHorizonBasedNMO;
 
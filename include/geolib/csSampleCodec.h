@@ -0,0 +1,84 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_SAMPLE_CODEC_H
+#define CS_SAMPLE_CODEC_H
+
+namespace cseis_geolib {
+
+/**
+ * Codec for trace samples (32bit floating point)
+ *
+ * Lossless coding, see encode():
+ * Samples are coded in groups of GROUP_SIZE samples. Each group is coded in the mode that gives the smallest size:
+ *  - Integer mode: All samples of the group are integer multiples of a common power of two. This is the case for
+ *    data converted from integer formats, for muted (zero) zones, and often for smooth data. Differences between
+ *    consecutive integers, or errors of the linear prediction from the two previous integers, are stored.
+ *  - Float mode: Sign bits, differences between consecutive exponents, and mantissas without the trailing zero bits
+ *    common to the group.
+ *  - Raw mode: Samples are stored as is. Limits the encoded size to one byte per group more than the input size.
+ * Within a group, each stored quantity is bit-packed with the smallest bit width that holds all its values.
+ * Decoding reproduces the input bit for bit, including NaN, Inf, denormals and negative zero.
+ * Groups are byte aligned, and traces are coded independently of each other.
+ *
+ * Lossy coding with bounded error, see encodeLossy():
+ * Samples are quantized to integer multiples of a step slightly smaller than twice the maximum error. The integers
+ * are transformed by a reversible integer wavelet transform (CDF 5/3 lifting, as in JPEG 2000), which concentrates
+ * band-limited signals in few, large lowpass coefficients. The number of wavelet levels giving the smallest size is
+ * chosen per trace. Coefficients are bit-packed in groups as in integer mode.
+ * The transform is exact, so that the error is due to quantization only. Traces that cannot be quantized within the
+ * maximum error (NaN, Inf, maximum error below float precision) are coded losslessly.
+ */
+class csSampleCodec {
+public:
+  /// Number of samples per group
+  static int const GROUP_SIZE = 32;
+  /// Codec identifiers stored in file headers
+  static int const CODEC_LOSSLESS = 1;
+  static int const CODEC_LOSSY    = 2;
+
+public:
+  /**
+   * @param numSamples Number of samples
+   * @return maximum number of bytes required to encode numSamples samples, with encode() or encodeLossy()
+   */
+  static int maxEncodedByteSize( int numSamples );
+  /**
+   * Encode samples
+   * @param samples    Samples to encode
+   * @param numSamples Number of samples
+   * @param buffer     (o) Encoded samples. Must hold at least maxEncodedByteSize(numSamples) bytes
+   * @return number of bytes written to buffer
+   */
+  static int encode( float const* samples, int numSamples, char* buffer );
+  /**
+   * Decode samples. Throws csException if buffer is corrupt
+   * @param buffer     Encoded samples
+   * @param byteSize   Number of bytes in buffer
+   * @param numSamples Number of samples to decode. Must equal the number of samples that were encoded
+   * @param samples    (o) Decoded samples
+   */
+  static void decode( char const* buffer, int byteSize, int numSamples, float* samples );
+  /**
+   * Encode samples with bounded error
+   * @param samples     Samples to encode
+   * @param numSamples  Number of samples
+   * @param maxError    Maximum absolute error of decoded samples. 0: Lossless
+   * @param buffer      (o) Encoded samples. Must hold at least maxEncodedByteSize(numSamples) bytes
+   * @param energy      (o) Sum of squared samples
+   * @param errorEnergy (o) Sum of squared errors of decoded samples
+   * @return number of bytes written to buffer
+   */
+  static int encodeLossy( float const* samples, int numSamples, float maxError, char* buffer, double& energy, double& errorEnergy );
+  /**
+   * Decode samples encoded with encodeLossy(). Throws csException if buffer is corrupt
+   * @param buffer     Encoded samples
+   * @param byteSize   Number of bytes in buffer
+   * @param numSamples Number of samples to decode. Must equal the number of samples that were encoded
+   * @param samples    (o) Decoded samples
+   */
+  static void decodeLossy( char const* buffer, int byteSize, int numSamples, float* samples );
+};
+
+} // namespace
+#endif
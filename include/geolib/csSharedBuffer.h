@@ -0,0 +1,36 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_SHARED_BUFFER_H
+#define CS_SHARED_BUFFER_H
+
+#include <atomic>
+
+namespace cseis_geolib {
+
+/**
+ * Reference counted buffer
+ *
+ * Base class for read-only memory that is referenced by several objects at once, for example trace samples
+ * that are not copied into each trace. The buffer is deleted when the last reference is released.
+ * Adding and releasing references is thread-safe.
+ */
+class csSharedBuffer {
+public:
+  /// Create buffer holding one reference, owned by the caller
+  csSharedBuffer();
+  /// Add reference
+  void addRef();
+  /// Release reference. Deletes buffer when last reference is released. Do not use buffer afterwards
+  void release();
+  /// @return current number of references. 1: Caller holds the only reference, no other object can add one
+  inline int numRefs() const { return myNumRefs.load( std::memory_order_acquire ); }
+protected:
+  virtual ~csSharedBuffer();
+private:
+  csSharedBuffer( csSharedBuffer const& obj );
+  std::atomic<int> myNumRefs;
+};
+
+} // namespace
+#endif
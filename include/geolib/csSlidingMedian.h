@@ -0,0 +1,80 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_SLIDING_MEDIAN_H
+#define CS_SLIDING_MEDIAN_H
+
+namespace cseis_geolib {
+
+/**
+ * Sliding window median, or any other order statistic (quantile)
+ *
+ * Holds the most recent values of a data series, up to the window length. Once the window is full, each new value
+ * replaces the oldest value. The value of the requested rank (for example the median) is available after each update.
+ *
+ * Window values are split into two binary heaps: A max-heap holding the (rank+1) smallest values and a min-heap
+ * holding the remaining values. The requested value is the top of the max-heap.
+ * Each value has a fixed slot in a ring buffer, and each slot records its position in its heap. Replacing the oldest
+ * value is therefore an in-place heap update, O(log W) for window length W.
+ * All storage is allocated once, in flat arrays.
+ */
+class csSlidingMedian {
+public:
+  /**
+   * Sliding median. For even window lengths, the upper of the two middle values is returned
+   * @param windowLength  Number of values in window
+   */
+  csSlidingMedian( int windowLength );
+  /**
+   * Sliding order statistic
+   * @param windowLength  Number of values in window
+   * @param rank          Rank of value to return, 0 for minimum, windowLength-1 for maximum
+   */
+  csSlidingMedian( int windowLength, int rank );
+  ~csSlidingMedian();
+  /**
+   * Add new value to window. If window is full, the oldest value is removed
+   */
+  void push( float value );
+  /**
+   * @return Value of requested rank among current window values. Requires at least rank+1 values in window
+   */
+  inline float value() const { return myValues[myLowerHeap[0]]; }
+  /// @return Number of values currently in window
+  inline int size() const { return myNumValues; }
+  /// @return Window length
+  inline int windowLength() const { return myWindowLength; }
+  /// Remove all values from window
+  void clear();
+
+private:
+  csSlidingMedian( csSlidingMedian const& obj );
+  void init( int windowLength, int rank );
+  void siftUp( bool isLower, int pos );
+  void siftDown( bool isLower, int pos );
+  void swapTops();
+  inline bool isBefore( bool isLower, int slot1, int slot2 ) const {
+    return( isLower ? myValues[slot1] > myValues[slot2] : myValues[slot1] < myValues[slot2] );
+  }
+
+  int myWindowLength;
+  int myRank;
+  int myNumValues;
+  /// Ring buffer slot of oldest value
+  int mySlotOldest;
+  /// Window values, by ring buffer slot
+  float* myValues;
+  /// Heap that each slot belongs to
+  bool* myIsInLower;
+  /// Position of each slot in its heap
+  int* myHeapPos;
+  /// Max-heap of slots holding the rank+1 smallest values
+  int* myLowerHeap;
+  int myLowerSize;
+  /// Min-heap of slots holding the remaining values
+  int* myUpperHeap;
+  int myUpperSize;
+};
+
+} // namespace
+#endif
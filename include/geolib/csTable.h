@@ -111,6 +111,8 @@ private:
 //  csVector<double>** myValues1D;
   /// Key values at each location (for 1D & 2D tables)
   double const** myKeyValues;
+  /// true if key values are sorted in non-decreasing order: Key location is found by binary search
+  bool myIsKeySorted;
   /// Values at each knee point of each location, including time values
   csTimeFunction<double>** myTimeFunctions2D;
   csTimeFunction<double>* myCurrentTimeFunction;
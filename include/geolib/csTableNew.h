@@ -123,6 +123,14 @@ public:
   //---------------------------------------------------------
   // Time function
   virtual csTimeFunction<double> const* getFunction( double const* keyValues, bool dump = false ) const;
+  /**
+   * Same as getFunction(keyValues,dump), but interpolated function is written to object provided by caller.
+   * Thread-safe: Several threads may retrieve functions from the same table at the same time, each using its own time function object
+   * @param keyValues     Array containing key values
+   * @param timeFunction  (o) Time function object that is filled with interpolated function
+   * @return timeFunction
+   */
+  csTimeFunction<double> const* getFunction( double const* keyValues, csTimeFunction<double>* timeFunction, bool dump = false ) const;
   virtual double getTimeValue( double const* keyValues, double time ) const;
   void interpolateTimeFunction( csTimeFunction<double> const* timeFuncLeft, csTimeFunction<double> const* timeFuncRight,
 				double weightLoc, csTimeFunction<double>* newTimeFunction ) const;
@@ -140,6 +148,13 @@ public:
                                 int& locLeftUp, int& locLeftDown,
                                 int& locRightUp, int& locRightDown,
                                 int keyIndex1, int keyIndex2 ) const;
+  /**
+   * Find locations matching the exact (non-interpolated) key values.
+   * Uses the hash index built when reading the table contents.
+   * @param locStart  (o) First location with matching key values
+   * @param locEnd    (o) Last location with matching key values
+   * @return true if key values were found
+   */
   bool findExactKeyLocation( double const* keyValues_in, int& locStart, int& locEnd ) const;
   double interpolateStep2( double const* keyValues_in, int keyIndex1, int keyIndex2, int valueIndex,
                            int locLeftUp, int locLeftDown, int locRightUp, int locRightDown ) const;
@@ -181,6 +196,14 @@ protected:
 
   csVector<csTableValueList*>* myValues;
 
+  /// Hash index of exact key values: One entry per run of consecutive locations with identical exact key values
+  int  myNumKeyRuns;
+  int* myKeyRunStart;
+  int* myKeyRunEnd;
+  /// Open addressing hash table, holding run index or -1 for empty slot. Size is a power of 2
+  int* myKeyHashSlots;
+  int  myKeyHashMask;
+
  protected:
   csTableNew();
   csTableNew( csTableNew const& obj );
@@ -191,6 +214,11 @@ protected:
   void findKeyLocation2D( double const* keyValues_in, int& locLeftUp, int& locLeftDown, int& locRightUp, int& locRightDown ) const;
   double interpolate( int valueIndex, double const* keyValues_in ) const;
   void clearBuffers();
+  void buildKeyIndex();
+  unsigned long long hashExactKeys( double const* keyValues_in ) const;
+  unsigned long long hashExactKeys( int location ) const;
+  bool isSameExactKeys( int location1, int location2 ) const;
+  bool findExactKeyLocationLinear( double const* keyValues_in, int& locStart, int& locEnd ) const;
   void addData_internal( cseis_geolib::csVector<double>* valueList );
 
   //------------------------------------------------------------------------------------
@@ -0,0 +1,112 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_VELOCITY_SCAN_H
+#define CS_VELOCITY_SCAN_H
+
+namespace cseis_geolib {
+
+class csInterpolation;
+
+/**
+ * Velocity scan: Semblance of one gather (CMP) for a range of trial velocities
+ *
+ * For each trial velocity, all traces are moveout corrected and summed into a stack trace and an energy trace,
+ * one trace at a time. Semblance is the ratio of the sliding window sums of stack energy and total energy.
+ * Moveout times are computed from tables that are set up once: Squared zero-offset times per sample, and squared
+ * offsets per trace. The remaining per-sample loops are free of branches and divisions, so that the compiler can
+ * vectorize them.
+ * Velocities are independent of each other and are processed in parallel (OpenMP), each thread using its own
+ * work buffers.
+ *
+ * Usage: setGather() once per gather, then computeSemblance().
+ */
+class csVelocityScan {
+public:
+  /// Hyperbolic PP moveout
+  static int const MOVEOUT_PP     = 1;
+  /// Isotropic PS moveout
+  static int const MOVEOUT_PS     = 2;
+  /// Linear moveout. Trial velocities are relative to a reference velocity, see setLinearReferenceVelocity()
+  static int const MOVEOUT_LINEAR = 3;
+
+public:
+  /**
+   * @param numSamples       Number of samples per trace
+   * @param sampleInt_ms     Sample interval [ms]
+   * @param moveoutType      Moveout type, MOVEOUT_PP, MOVEOUT_PS or MOVEOUT_LINEAR
+   * @param windowHalfLength Semblance window spans windowHalfLength samples on either side of the output sample
+   */
+  csVelocityScan( int numSamples, double sampleInt_ms, int moveoutType, int windowHalfLength );
+  ~csVelocityScan();
+  /**
+   * Set reference velocity of linear moveout already applied to the input data
+   * @param refVel Reference velocity [m/s]. 0: Input data is not LMO corrected
+   */
+  void setLinearReferenceVelocity( float refVel );
+  /**
+   * @param numThreads Maximum number of threads used to process velocities in parallel. 0: OpenMP default
+   */
+  void setNumThreads( int numThreads );
+  /**
+   * Set input gather. Arrays are referenced, not copied: They must remain valid until computeSemblance() returns
+   * @param numTraces     Number of traces in gather
+   * @param samples       Trace samples, one array per trace
+   * @param offsets       Trace offsets [m]
+   * @param sampleMuteEnd Per trace, index of last muted sample. Samples up to and including this sample do not contribute.
+   */
+  void setGather( int numTraces, float const* const* samples, float const* offsets, int const* sampleMuteEnd );
+  /**
+   * Compute semblance panel
+   * @param numVels    Number of trial velocities
+   * @param velocities Trial velocities [m/s]
+   * @param velMin     Per sample, minimum velocity to test. Semblance is set to zero for lower velocities. NULL: No limit
+   * @param velMax     Per sample, maximum velocity to test. Semblance is set to zero for higher velocities. NULL: No limit
+   * @param semblance  (o) Semblance, numSamples values for each velocity
+   */
+  void computeSemblance( int numVels, float const* velocities, float const* velMin, float const* velMax, float* semblance );
+
+private:
+  /// Work buffers of one thread
+  struct WorkSpace {
+    float*  times;
+    float*  samplesMoveout;
+    double* stack;
+    double* energy;
+    double* sumStackEnergy;
+    double* sumTotalEnergy;
+  };
+  csVelocityScan( csVelocityScan const& obj );
+  void allocateWorkSpaces( int numWorkSpaces );
+  void freeWorkSpaces();
+  void computeSemblance( float velocity, float const* velMin, float const* velMax, WorkSpace* ws, float* semblance );
+  void computeMoveoutTimes( float velocity, int itrc, int sampFirst, int sampLast, float* times ) const;
+
+  int    myNumSamples;
+  double mySampleInt_sec;
+  float  mySampleInt_ms;
+  int    myMoveoutType;
+  int    myWindowHalfLength;
+  float  myLinearRefVel;
+  float  myLinearRefVelInverse;
+  int    myNumThreads;
+
+  /// Moveout table: Squared zero-offset time per sample [s^2]
+  double* myTimeZeroSq;
+  /// Moveout table: Squared offset per trace [m^2]
+  double* myOffsetSq;
+  int     myNumTracesAlloc;
+
+  int myNumTraces;
+  float const* const* mySamples;
+  float const* myOffsets;
+  int const* mySampleMuteEnd;
+
+  /// Sinc interpolator. Only its read-only process() method is used, shared by all threads
+  csInterpolation* myInterpol;
+  WorkSpace* myWorkSpaces;
+  int myNumWorkSpaces;
+};
+
+} // namespace
+#endif
@@ -61,6 +61,9 @@ template<class A> static A MIN( A val1, A val2 ) {
   * @param nSampIn      (i) Number of values in input series
   * @param corr         (o) Ouput correlation function
   * @param maxlag_in_num_samples  (i) Maximum time lag to compute, in number of samples
+  *
+  * The correlation is computed in the frequency domain when this is expected to be faster (see csFFTCorrelation).
+  * To correlate one pilot series with many others, use csFFTCorrelation directly: The pilot spectrum is then only computed once.
   */
  void compute_twosided_correlation( float const* samplesLeft, float const* samplesRight,
                                     int nSampIn, float* corr );
@@ -35,6 +35,11 @@
  #define ARCHITECTURE_ITANIUM 1
 #endif
 
+// x86 SIMD kernels selected at runtime (see geolib_simd.h). Requires gcc/clang function target attributes
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+ #define ARCHITECTURE_X86_SIMD 1
+#endif
+
 /*
  * Apparently, the Gnu g++ compiler works with either separator, on both Windows and Unix systems
 #ifndef PLATFORM_WINDOWS
@@ -0,0 +1,35 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef GEOLIB_SIMD_H
+#define GEOLIB_SIMD_H
+
+namespace cseis_geolib {
+
+/**
+ * Runtime selection of SIMD kernels
+ *
+ * Vectorized kernels (sample byte swapping, IBM/IEEE conversion) are compiled for several instruction sets.
+ * The kernel used is chosen at runtime, depending on the instruction sets supported by the CPU.
+ * All kernels produce bit-identical results to the scalar code.
+ */
+
+static int const SIMD_NONE = 0;
+static int const SIMD_SSE2 = 1;
+static int const SIMD_AVX2 = 2;
+
+/**
+ * @return Highest SIMD level supported by the CPU, limited by setMaxSIMDLevel()
+ */
+int getSIMDLevel();
+
+/**
+ * Limit SIMD level used by vectorized kernels, for example SIMD_NONE to force the scalar code
+ * The environment variable CSEIS_SIMD (none, sse2, avx2) sets the initial limit.
+ * @param level  SIMD_NONE, SIMD_SSE2 or SIMD_AVX2
+ */
+void setMaxSIMDLevel( int level );
+
+} // end namespace
+
+#endif
@@ -0,0 +1,46 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef GEOLIB_WINDOW_H
+#define GEOLIB_WINDOW_H
+
+namespace cseis_geolib {
+
+/**
+ * Sliding window kernels
+ *
+ * Compute sums over a window sliding along a data series, for every output sample.
+ * The window of output sample i spans input samples i+offsetFirst to i+offsetLast, clipped to the data series.
+ * Sums are assembled from block-wise prefix and suffix sums (van Herk/Gil-Werman), so the cost per output sample
+ * is independent of the window length. Sums are accumulated in double precision by addition only: Unlike a running
+ * sum that adds and subtracts values, there is no cancellation error in windows with small values following large ones.
+ * Results match a direct single precision summation of each window within float rounding, but not bit for bit.
+ */
+
+/**
+ * Sliding window sum
+ * @param values      (i) Input values
+ * @param numValues   (i) Number of input values
+ * @param offsetFirst (i) Offset of first window sample relative to output sample
+ * @param offsetLast  (i) Offset of last window sample relative to output sample
+ * @param sums        (o) Sum of values in window, numValues values
+ */
+void compute_window_sum( float const* values, int numValues, int offsetFirst, int offsetLast, double* sums );
+void compute_window_sum( double const* values, int numValues, int offsetFirst, int offsetLast, double* sums );
+/**
+ * Sliding window sum of squares (energy)
+ * @param energy      (o) Sum of squared values in window, numValues values
+ */
+void compute_window_energy( float const* values, int numValues, int offsetFirst, int offsetLast, double* energy );
+
+/**
+ * Centred windows: Window of output sample i spans input samples i-halfWidth to i+halfWidth.
+ * Mean and RMS are normalised by the number of samples in the window after clipping to the data series.
+ */
+void compute_window_energy( float const* values, int numValues, int halfWidth, double* energy );
+void compute_window_mean( float const* values, int numValues, int halfWidth, float* mean );
+void compute_window_rms( float const* values, int numValues, int halfWidth, float* rms );
+
+} // end namespace
+
+#endif
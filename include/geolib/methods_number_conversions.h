@@ -23,6 +23,23 @@ namespace cseis_geolib {
   void ibm2ieee( unsigned char* values, int numValues );
   void ieee2ibm( unsigned char* values, int numValues );
 
+  /**
+  * Convert from IBM to IEEE floating point, in place
+  * Uses SIMD kernels if supported by the CPU. Results are bit-identical to the scalar conversion.
+  * @param values       Array of 4 byte IBM floats
+  * @param numValues    Number of values in array
+  * @param doSwapEndian true if values shall be endian-swapped before conversion (in the same pass)
+  */
+  void ibm2ieee( unsigned char* values, int numValues, bool doSwapEndian );
+  /**
+  * Convert from IEEE to IBM floating point, in place
+  * Uses SIMD kernels if supported by the CPU. Results are bit-identical to the scalar conversion.
+  * @param values       Array of 4 byte IEEE floats
+  * @param numValues    Number of values in array
+  * @param doSwapEndian true if values shall be endian-swapped after conversion (in the same pass)
+  */
+  void ieee2ibm( unsigned char* values, int numValues, bool doSwapEndian );
+
 } // end namespace
 
 #endif
@@ -9,6 +9,8 @@ namespace cseis_io {
   typedef unsigned char byte;
   static const char ID_TEXT_CSEIS[] = "CSEIS";
   static const char ID_TEXT_OSEIS[] = "OSEIS";
+  /// Identifier ending block compressed files (version 0.5), following the block index
+  static const char ID_TEXT_BLOCK_INDEX[] = "CSBLKIDX";
 
  class csIODefines {
  public:
@@ -0,0 +1,103 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_SEISMIC_INDEX_H
+#define CS_SEISMIC_INDEX_H
+
+#include <string>
+#include "geolib_defines.h"
+
+namespace cseis_geolib {
+  template <typename T> class csVector;
+}
+
+namespace cseis_io {
+
+/**
+ * Trace header index, Cseis format
+ *
+ * Sidecar file written next to a SeaSeis data file, holding the values of selected trace headers of all traces,
+ * sorted by increasing header value. Traces with equal header values are kept in trace order.
+ * Readers use the index to evaluate header selections and sorted reads without scanning the data file.
+ *
+ * Values of 64bit integer headers are stored exactly, all other header values are stored as double.
+ *
+ * The index is considered stale, and is ignored, if the number of traces, the data file size or the data file
+ * modification time (in nanoseconds) do not match those recorded when the index was written.
+ */
+class csSeismicIndex {
+ public:
+  csSeismicIndex();
+  ~csSeismicIndex();
+  /**
+   * @return name of index file belonging to given data file
+   */
+  static std::string indexFilename( std::string const& filenameData );
+  /**
+   * Add trace header to be indexed. Call before first call to addTrace()
+   * @param name         Trace header name
+   * @param type         Trace header type. Only TYPE_INT, TYPE_FLOAT, TYPE_DOUBLE and TYPE_INT64 are supported
+   * @param byteLocation Byte location of trace header in trace header value block
+   */
+  void addHeader( std::string const& name, cseis_geolib::type_t type, int byteLocation );
+  /**
+   * Add header values of next trace
+   * @param hdrValueBlock Trace header value block, as written to data file
+   */
+  void addTrace( char const* hdrValueBlock );
+  /**
+   * Sort header values and write index file. Call after data file has been closed
+   * @return false if index file could not be written
+   */
+  bool write( std::string const& filenameData );
+  /**
+   * Read index file
+   * @param filenameData Name of data file
+   * @param numTraces    Number of traces in data file
+   * @return false if index file does not exist, or is stale
+   */
+  bool read( std::string const& filenameData, int numTraces );
+  /**
+   * @return index of given trace header in index, or -1 if trace header is not indexed
+   */
+  int headerIndex( std::string const& name ) const;
+  /**
+   * @return header type of indexed header
+   */
+  cseis_geolib::type_t headerType( int hdrIndex ) const;
+  /**
+   * @return number of traces in index
+   */
+  int numTraces() const { return myNumTraces; }
+  /**
+   * @return header values of all traces, sorted by increasing header value. NULL for TYPE_INT64 headers
+   */
+  double const* sortedValues( int hdrIndex ) const { return mySortedValues[hdrIndex]; }
+  /**
+   * @return header values of all traces, sorted by increasing header value. NULL unless header is of TYPE_INT64
+   */
+  csInt64_t const* sortedValuesInt64( int hdrIndex ) const { return mySortedValuesInt64[hdrIndex]; }
+  /**
+   * @return trace indices matching sortedValues()
+   */
+  int const* sortedTraceIndices( int hdrIndex ) const { return mySortedTraceIndices[hdrIndex]; }
+
+ private:
+  csSeismicIndex( csSeismicIndex const& obj );
+  void freeMemory();
+  int myNumTraces;
+  cseis_geolib::csVector<std::string>* myNames;
+  cseis_geolib::csVector<cseis_geolib::type_t>* myTypes;
+  cseis_geolib::csVector<int>* myByteLocations;
+  /// Header values collected in trace order while writing, one list for each header. Empty for TYPE_INT64 headers
+  cseis_geolib::csVector<cseis_geolib::csVector<double>*>* myValues;
+  /// Same as myValues, for TYPE_INT64 headers. Empty for all other headers
+  cseis_geolib::csVector<cseis_geolib::csVector<csInt64_t>*>* myValuesInt64;
+  /// Sorted header values, one array for each header. Either mySortedValues or mySortedValuesInt64 is set for each header
+  double** mySortedValues;
+  csInt64_t** mySortedValuesInt64;
+  int** mySortedTraceIndices;
+};
+
+} // end namespace
+#endif
@@ -12,6 +12,7 @@
 namespace cseis_geolib {
   class csHeaderInfo;
   class csFlexHeader;
+  class csMappedFile;
 }
 
 namespace cseis_io {
@@ -43,6 +44,25 @@ class csSeismicReader_ver {
   virtual bool moveToTrace( int firstTraceIndex, int numTracesToRead );
   virtual bool moveToNextTrace();
   virtual void closeFile();
+  /**
+   * Memory-map input file. Traces are then read directly from the mapped file instead of through the read buffer.
+   * Call after the file header has been read.
+   * @return false if file cannot be mapped: Data samples are compressed, or file size is unknown
+   */
+  virtual bool mapFile();
+  /// @return true if input file is memory-mapped
+  bool isMapped() const { return myMappedFile != NULL; }
+  /// @return true if data samples can be referenced directly in the mapped file, see readTraceMapped()
+  bool isSharedReadSupported() const { return( myMappedFile != NULL && myIsMappedSamplesAligned ); }
+  /**
+   * Read next trace from memory-mapped file, without copying the data samples
+   * @param hdrValueBlock (o) Trace header values
+   * @param samples       (o) Pointer to data samples in mapped file
+   * @return false if end of file has been reached, or if samples cannot be referenced directly in the mapped file
+   */
+  bool readTraceMapped( char* hdrValueBlock, float const*& samples );
+  /// @return memory-mapped file, or NULL if file is not mapped
+  cseis_geolib::csMappedFile* mappedFile() { return myMappedFile; }
   static csSeismicReader_ver* createReaderObject( std::string filename, bool enableRandomAccess, int numTracesBuffer = 0 );
   static void extractVersionString( std::string filename, std::string& versionString );
   /**
@@ -128,6 +148,17 @@ protected:
   /// Index of first trace in current buffer
   int myBufferFirstTrace;
 
+  /// Memory-mapped input file. NULL if file is read through the read buffer
+  cseis_geolib::csMappedFile* myMappedFile;
+  /// true if data samples in mapped file are aligned for direct access as float values
+  bool myIsMappedSamplesAligned;
+  /// Number of traces to prefetch in mapped file when moving to new trace position
+  static int const NUM_TRACES_PREFETCH = 256;
+  /// @return pointer to given trace in mapped file
+  char const* mappedTrace( int traceIndex ) const;
+  bool copyMappedTrace( float* samples, char* hdrValueBlock, int numSamples );
+  bool peekMapped( int byteOffset, int byteSize, char* buffer, int traceIndex );
+
 };
 
 } // end namespace
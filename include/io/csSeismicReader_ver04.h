@@ -28,6 +28,18 @@ class csSeismicReader_ver04 : public csSeismicReader_ver {
   csSeismicReader_ver04( std::string filename, bool enableRandomAccess, int numTracesBuffer = 0 );
   virtual ~csSeismicReader_ver04();
   virtual bool readFileHeader( csSeismicIOConfig* config );
+
+ protected:
+  /// For derived versions that share the version 0.4 file header layout
+  csSeismicReader_ver04( std::string filename, bool enableRandomAccess, int numTracesBuffer, int version );
+  /**
+   * Read file header block, up to and including the trace header definitions. Sets sample and header byte sizes
+   * @return byte location in file header block following the trace header definitions
+   */
+  int readHeaderBlock( csSeismicIOConfig* config );
+
+ private:
+  void init( int version );
 };
 
 } // end namespace
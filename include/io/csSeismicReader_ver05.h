@@ -0,0 +1,80 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_SEISMIC_READER_VER05_H
+#define CS_SEISMIC_READER_VER05_H
+
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include "geolib_defines.h"
+#include "csSeismicReader_ver04.h"
+
+namespace cseis_geolib {
+  template <typename T> class csVector;
+}
+
+namespace cseis_io {
+
+/**
+ * Seismic file Reader, Cseis format
+ *
+ * Version 0.5: Same file header as version 0.4. Data samples are compressed with csSampleCodec, in blocks of traces,
+ * either losslessly or with bounded error.
+ * A block index at the end of the file gives the file position of each block. Reading a block decodes all its traces
+ * in parallel.
+ * Random access reads the block containing the requested trace. Trace headers are stored uncompressed, and can be
+ * peeked without decoding any samples.
+ */
+class csSeismicReader_ver05 : public csSeismicReader_ver04 {
+ public:
+  static int const VERSION_SEISMIC_READER   = 05;
+
+ public:
+  csSeismicReader_ver05( std::string filename, bool enableRandomAccess, int numTracesBuffer = 0 );
+  virtual ~csSeismicReader_ver05();
+  virtual bool readFileHeader( csSeismicIOConfig* config );
+  virtual bool readTrace( float* samples, char* hdrValueBlock );
+  virtual bool readTrace( float* samples, char* hdrValueBlock, int numSamples );
+  virtual bool moveToTrace( int firstTraceIndex );
+  virtual bool moveToTrace( int firstTraceIndex, int numTracesToRead );
+  virtual bool peek( int byteOffset, int byteSize, char* buffer, int traceIndex = -1 );
+  /// Compressed files cannot be memory-mapped
+  virtual bool mapFile();
+
+ private:
+  bool readBlockIndex();
+  void scanBlocks();
+  int  findBlock( int traceIndex ) const;
+  bool loadBlock( int blockIndex );
+  bool loadNextBlock();
+  void decodeBlock();
+
+  /// Codec used to compress data samples
+  int myCodec;
+  /// File position of each block. Empty if file size is unknown: Blocks can then only be read sequentially
+  cseis_geolib::csVector<csInt64_t>* myBlockOffsets;
+  /// Index of first trace in each block
+  cseis_geolib::csVector<int>* myBlockFirstTrace;
+  /// Index of block at current file position. -1 if unknown
+  int myFileBlockIndex;
+
+  /// Index of block currently loaded. -1 if none
+  int myLoadedBlockIndex;
+  /// Index of first trace in loaded block
+  int myLoadedFirstTrace;
+  /// Number of traces in loaded block
+  int myLoadedNumTraces;
+  /// Loaded block as stored in file, following the number of traces and block byte size
+  char* myBlockBuffer;
+  int   myBlockBufferSize;
+  /// Decoded samples of all traces in loaded block
+  float* myBlockSamples;
+  int    myBlockSamplesNumTraces;
+  /// Byte location of compressed samples of each trace in block buffer
+  int* myEncodedByteLoc;
+  int  myEncodedByteLocSize;
+};
+
+} // end namespace
+#endif
@@ -6,14 +6,17 @@
 
 #include <cstdio>
 #include <string>
+#include "geolib_defines.h"
 
 namespace cseis_geolib {
   class csHeaderInfo;
+  template <typename T> class csVector;
 }
 
 namespace cseis_io {
 
 class csSeismicIOConfig;
+class csSeismicIndex;
 
 /**
  * Seismic file writer, Cseis format
@@ -25,14 +28,34 @@ class csSeismicIOConfig;
 class csSeismicWriter_ver {
  public:
   static int const VERSION_SEISMIC_WRITER = 04;
+  /// File version written when data samples are block compressed, see setBlockCompression()
+  static int const VERSION_SEISMIC_WRITER_BLOCK = 05;
   static int const DEFAULT_BUFFERED_BYTES = 10000000;
  public:
   csSeismicWriter_ver( std::string filename );
   csSeismicWriter_ver( std::string filename, int numTracesBuffer, int sampleByteSize = 4, bool overwrite = true );
   ~csSeismicWriter_ver();
   bool writeFileHeader( csSeismicIOConfig const* config );
-  bool writeTrace( float* samples, char const* hdrValueBlock );
+  bool writeTrace( float const* samples, char const* hdrValueBlock );
   void close();
+  /**
+   * Write header index file next to data file, indexing the given trace header. See csSeismicIndex.
+   * Call before writeFileHeader()
+   * @param headerName Name of trace header to index
+   */
+  void addIndexHeader( std::string const& headerName );
+  /**
+   * Compress data samples, see cseis_geolib::csSampleCodec. Writes file version 0.5.
+   * Each buffer of traces is written as one block, compressed in parallel. A block index is appended to the file when it is closed.
+   * Call before writeFileHeader(). Requires 32bit samples
+   * @param maxError        Maximum error of lossy compression. 0: Lossless compression
+   * @param isRelativeError true if maxError is relative to the maximum absolute amplitude of each trace
+   */
+  void setBlockCompression( float maxError = 0.0f, bool isRelativeError = false );
+  /// @return ratio of uncompressed to compressed size of data samples written so far. 1 if not block compressed
+  double compressionRatio() const;
+  /// @return signal-to-noise ratio [dB] of data samples written so far: Energy of samples over energy of compression errors
+  double compressionSNR() const;
 public:
   short myVersionMinor;
   short myVersionMajor;
@@ -53,6 +76,8 @@ private:
   void open( bool overwrite );
   void initialize();
   bool writeCurrentDataBuffer();
+  bool writeCompressedBlock();
+  bool writeBlockIndex();
   void resizeDataBuffer( int newSize );
   void computeCompressionValues( float const* samples, float& minValue, float& rangeValue );
   void compressData( float const* samplesIn, char* samplesOut, float& minValue, float& rangeValue );
@@ -73,6 +98,38 @@ private:
   int   myNumBufferTraces;
   int   myByteSizeOneSample;
   char* myCompressedSampleBuffer;
+  /// Names of trace headers to index
+  cseis_geolib::csVector<std::string>* myIndexHeaderNames;
+  /// Header index, written when file is closed. NULL if no header index shall be written
+  csSeismicIndex* myIndex;
+
+  /// true if data samples are block compressed
+  bool  myIsBlockCompressed;
+  /// Maximum size in bytes of the compressed samples of one trace
+  int   myMaxEncodedByteSize;
+  /// Compressed samples of all traces in current block, myMaxEncodedByteSize bytes per trace
+  char* myEncodedBuffer;
+  /// Size in bytes of compressed samples of each trace in current block
+  int*  myEncodedByteSizes;
+  /// Codec, cseis_geolib::csSampleCodec::CODEC_LOSSLESS or CODEC_LOSSY
+  int   myCodec;
+  /// Maximum error of lossy compression
+  float myMaxError;
+  /// true if myMaxError is relative to maximum absolute amplitude of each trace
+  bool  myIsRelativeError;
+  /// Energy of samples and of compression errors of each trace in current block
+  double* myTraceEnergy;
+  double* myTraceErrorEnergy;
+  /// Total energy of samples and of compression errors written so far
+  double mySignalEnergy;
+  double myErrorEnergy;
+  /// Total size in bytes of uncompressed and compressed samples written so far
+  csInt64_t myNumBytesSamples;
+  csInt64_t myNumBytesEncoded;
+  /// File position of each block
+  cseis_geolib::csVector<csInt64_t>* myBlockOffsets;
+  /// Number of traces in each block
+  cseis_geolib::csVector<int>* myBlockNumTraces;
 };
 
 } // end namespace
@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <string>
 #include <fstream>
+#include <pthread.h>
 #include "csSegyHdrMap.h"
 #include "csSegyHeader.h"
 #include "csIReader.h"
@@ -48,6 +49,7 @@ public:
       overrideSampleFormat = csSegyHeader::AUTO;
       enableRandomAccess = false;
       isSUFormat = false;
+      readAheadDepth = 0;
     }
     int  numTracesBuffer;
     int  segyHeaderMapping;
@@ -57,6 +59,8 @@ public:
     int  overrideSampleFormat;
     bool enableRandomAccess;
     bool isSUFormat;
+    /// Number of buffers read in ahead by background thread. 0: Read in traces on calling thread. Only used for sequential access
+    int  readAheadDepth;
   };
 
 //---------------------------------------------------------------------------------------
@@ -248,6 +252,30 @@ private:
   bool myIsSUFormat;
   cseis_geolib::csIOSelection* myIOSelection;
 
+  /// Number of buffers read in ahead by read-ahead thread. 0 if read-ahead is disabled
+  int myReadAheadDepth;
+  /// true if read-ahead thread has been started
+  bool myIsReadAheadRunning;
+  /// Read-ahead buffers, myReadAheadDepth+1. The first one is myBigBuffer allocated in initialize()
+  char** myReadAheadBuffers;
+  /// Number of traces in each read-ahead buffer
+  int* myReadAheadNumTraces;
+  /// Index of read-ahead buffer currently being read from by calling thread
+  int myReadAheadCurrent;
+  /// Number of filled read-ahead buffers following current buffer
+  int myReadAheadNumFilled;
+  bool myReadAheadIsEOF;
+  bool myReadAheadIsError;
+  /// true if read-ahead thread shall stop
+  bool myReadAheadStop;
+  pthread_t myReadAheadThread;
+  /// Protects read-ahead buffer state
+  pthread_mutex_t myReadAheadMutex;
+  /// Signalled when read-ahead thread has filled a buffer, or reached the end of file
+  pthread_cond_t myReadAheadCondFilled;
+  /// Signalled when calling thread has released a buffer, or read-ahead shall stop
+  pthread_cond_t myReadAheadCondFree;
+
 public:
   void resetTrcHdrMap( csSegyHdrMap* map );
   csSegyHdrMap const* getTrcHdrMap() const { return myTrcHdrMap; }
@@ -257,6 +285,18 @@ public:
 private:
   void readCharBinHdr();
   void openFile();
+  /// Convert data samples of given number of traces in buffer to internal endian and sample format
+  void decodeSamples( char* buffer, int numTraces, int nSamples );
+  void startReadAhead();
+  void stopReadAhead();
+  /// Run read-ahead loop. Called by read-ahead thread
+  void runReadAhead();
+  static void* readAheadThread( void* args );
+  /**
+   * Move on to next buffer filled by read-ahead thread
+   * @return false if end of file has been reached
+   */
+  bool nextReadAheadBuffer();
 
   csSegyReader();
   csSegyReader( csSegyReader const& obj );
@@ -121,6 +121,18 @@ public:
   void setLastCall( bool isLastCall );
   void setCleanUp( bool isCleanUp );
   int getNumTraces() const { return numTraces; }
+  /**
+   * Declare the module's exec phase as thread-safe.
+   * Only applies to single-trace modules. A thread-safe exec phase only modifies the trace passed in,
+   * treats the 'variables' pointer as read-only and does not depend on isLastCall(). Thread-safe modules
+   * may be run in parallel on several traces at once when the flow is submitted with more than one thread.
+   * @param isThreadSafe true if the module's exec phase can be called concurrently on different traces
+   */
+  void setThreadSafe( bool isThreadSafe );
+  /**
+   * @return true if the module's exec phase has been declared thread-safe
+   */
+  inline bool isThreadSafe() const { return myIsThreadSafe; }
 
   /// class csModule needs access to the private fields of this class
   friend class csModule;
@@ -145,6 +157,8 @@ private:
   bool myTracesAreWaiting;
   /// true if this is the last call from the base system to this module's exec phase (different from cleanup phase)
   bool myIsLastCall;
+  /// true if the module's exec phase can be called concurrently on different traces
+  bool myIsThreadSafe;
 };
 
 } // namespace
@@ -0,0 +1,85 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_HEADER_EQUATION_H
+#define CS_HEADER_EQUATION_H
+
+#include <string>
+#include "geolib_defines.h"
+
+namespace cseis_geolib {
+  class csEquationSolver;
+  template <typename T> class csVector;
+}
+
+namespace cseis_system {
+
+class csTraceHeaderDef;
+class csTraceHeader;
+class csTraceGather;
+
+/**
+ * Mathematical equation based on trace header values
+ *
+ * Helper class between a module and the equation solver @class csEquationSolver.
+ * Variables in the equation are trace header names. Each variable is bound to its trace header index and number type
+ * once, in set(). solve() then reads only the referenced header values, directly from the trace header data block.
+ *
+ * @author Bjorn Olofsson
+ * @date   2007
+ */
+class csHeaderEquation {
+public:
+  csHeaderEquation();
+  ~csHeaderEquation();
+  /**
+   * Parse equation and bind variables to trace headers
+   * @param equation      Equation text
+   * @param hdef          Trace header definition object
+   * @param unknownNames  (o) If not NULL, names of all variables that are not trace headers are appended here instead of
+   *                      throwing an exception. The equation must not be solved if any name was appended.
+   * @throws csException if the equation cannot be parsed, references a string trace header, or references an unknown
+   *                     trace header and unknownNames is NULL
+   */
+  void set( std::string const& equation, csTraceHeaderDef const* hdef, cseis_geolib::csVector<std::string>* unknownNames = NULL );
+  /**
+   * @param trcHeader  Trace header object
+   * @return Result of equation for given trace header
+   */
+  double solve( csTraceHeader const* trcHeader );
+  /**
+   * Solve equation for all traces in gather
+   * @param gather   Trace gather
+   * @param results  (o) Result for each trace in gather
+   */
+  void solve( csTraceGather const* gather, double* results );
+  /**
+   * @return Number of variables (trace header references) in equation
+   */
+  inline int numVariables() const { return myNumVariables; }
+  /**
+   * @return Trace header name of given variable
+   */
+  std::string const& variableName( int index ) const;
+
+private:
+  csHeaderEquation( csHeaderEquation const& obj );
+  void freeBuffers();
+  inline double headerValue( csTraceHeader const* trcHeader, int ivar ) const;
+
+  cseis_geolib::csEquationSolver* mySolver;
+  int myNumVariables;
+  std::string* myVariableNames;
+  /// Trace header index of each variable
+  int* myHeaderIndex;
+  /// Trace header type of each variable
+  cseis_geolib::type_t* myHeaderType;
+  /// Variable values for single trace
+  double* myValues;
+  /// Variable values for batch of traces: One array of myBatchCapacity values per variable
+  double** myBatchValues;
+  int myBatchCapacity;
+};
+
+} // namespace
+#endif
@@ -6,6 +6,7 @@
 
 #include <cstdio>
 #include <string>
+#include <pthread.h>
 
 namespace cseis_system {
 
@@ -18,6 +19,8 @@ namespace cseis_system {
 * The methods will not do anything if no filename was given, or the file did not open correctly
 * This is to ensure that Cseis flows will not fail even if no log file is available.
 *
+* All methods are thread-safe: Each message is written in one piece, also when modules run in several threads.
+*
 * @author Bjorn Olofsson
 * @date   2007
 */
@@ -83,6 +86,8 @@ private:
   char const* myFilename;
   /// true if file is opened within class. If yes then the file srtream will be closed during object destruction
   bool myIsOpenedLocally;
+  /// Serialises messages written from different threads
+  pthread_mutex_t myMutex;
 };
   
 } // namespace
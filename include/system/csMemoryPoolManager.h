@@ -11,6 +11,7 @@
 namespace cseis_system {
 
   class csTracePool;
+  class csSlabAllocator;
   class csTrace;
   class csTraceHeaderInfo;
   class csTraceHeaderInfoPool;
@@ -30,10 +31,15 @@ class csMemoryPoolManager {
   static int const POLICY_SPEED  = 651;
   static int const POLICY_MEMORY = 156;
 
+  /// Default memory budget for trace samples and headers [MB]
   static csInt64_t const MAX_NUM_MEGABYTES = 12192;
 public:
   csMemoryPoolManager();
-  csMemoryPoolManager( int policy );
+  /**
+  * @param policy           POLICY_SPEED or POLICY_MEMORY
+  * @param maxNumMegabytes  Memory budget for trace samples and headers [MB]. Exceeding the budget throws an exception
+  */
+  csMemoryPoolManager( int policy, csInt64_t maxNumMegabytes = MAX_NUM_MEGABYTES );
   ~csMemoryPoolManager();
   /**
   * @return new trace from memory pool
@@ -49,6 +55,12 @@ public:
    * @return new trace from memory pool
    */
   csTrace* getNewTrace( csTrace const* trace_old );
+  /**
+   * Set size of trace header value block allocated for new traces. Call at end of init phase, with the largest number of
+   * trace header bytes of all modules in the flow: Traces then never reallocate their header block in the exec phase
+   * @param numHeaderBytes Number of bytes
+   */
+  void setMaxNumHeaderBytes( int numHeaderBytes );
   /**
   * @return new trace header info from memory pool
   */
@@ -62,20 +74,20 @@ public:
    * @param fout Output stream where dump shall be written to
    */
   void dumpSummary( FILE* fout ) const;
+  /// @return size of memory block allocated for one trace of given number of samples and header bytes, including alignment
+  static csInt64_t numBytesPerTrace( int numSamples, int numHeaderBytes );
 private:
 
   csMemoryPoolManager( csMemoryPoolManager const& obj );
-  void init( int policy );
-  bool checkMemory();
+  void init( int policy, csInt64_t maxNumMegabytes );
   /// Memory pool policy: Optimised for speed or memory usage
   int myPolicy;
+  /// Allocator for trace samples and trace headers. Enforces memory budget
+  csSlabAllocator* myAllocator;
   /// Trace pool buffer where all seismic traces are stored
   csTracePool* myTracePool;
   /// Trace header info pool buffer where all trace header info objects are stored
   csTraceHeaderInfoPool* myTraceHeaderInfoPool;
-  /// Maximum number of bytes to allocate
-  csInt64_t myMaxNumBytes;
-  csInt64_t myMaxNumBytesAllocated;
 };
 
 } // namespace
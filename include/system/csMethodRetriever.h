@@ -53,6 +53,12 @@ public:
   * @param name (i) Module name whose method shall be retrieved
   */
   static void getExecMethodMultiTrace( std::string const& name, int verMajor, int verMinor, MExecMultiTracePtr& exec );
+  /**
+  * Retrieve function pointer to clone method. This method is optional.
+  * @param name (i) Module name whose method shall be retrieved
+  * @param clone (o) Clone method, or NULL if module does not define a clone method
+  */
+  static void getCloneMethod( std::string const& name, int verMajor, int verMinor, MClonePtr& clone );
 
   /**
   * NOTE: This method is only used when statically linking Cseis modules
@@ -76,6 +82,7 @@ public:
   static MInitPtr  getInitMethod( std::string const& name, void* handle );
   static MExecSingleTracePtr getExecMethodSingleTrace( std::string const& name, void* handle );
   static MExecMultiTracePtr getExecMethodMultiTrace( std::string const& name, void* handle );
+  static MClonePtr getCloneMethod( std::string const& name, void* handle );
 
   static int getMethodIndex( std::string const& name );
   static int const METHOD_NOT_FOUND = -33;
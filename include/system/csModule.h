@@ -27,6 +27,7 @@ class csParamManager;
 class csParamDef;
 class csExecPhaseEnv;
 class csMemoryPoolManager;
+class csTraceRingBuffer;
 
 /**
 * Central Cseis class
@@ -51,11 +52,53 @@ public:
   bool isReadyToSubmitExec( bool forceToRun ) const;
   /// Submit exec phase. Return false if no trace was processed.
   bool submitExecPhase( bool forceToProcess, csLogWriter* log, int& port );
+  /**
+  * Return true if stage starting at this module is ready to be submitted
+  * @param forceToRun:   true if all previous modules have finished processing
+  * @param minNumTraces: Minimum number of traces that shall be collected before stage is submitted
+  */
+  bool isReadyToSubmitStage( bool forceToRun, int minNumTraces ) const;
+  /**
+  * Submit exec phase of a stage, starting at this module.
+  * A stage consists of consecutive single-trace modules. All traces waiting at this module are passed through
+  * all stage modules, one trace after the other, each trace running through all modules back-to-back.
+  * Parallel stages consist of thread-safe modules only, and distribute the traces over several threads.
+  * Processed traces are output in their original order from the last module in the stage.
+  * CPU time and trace counts are accumulated separately for each stage module.
+  * @param stageModules:    All modules in stage. The first module must be this module
+  * @param numStageModules: Number of modules in stage
+  * @param numThreads:      Number of threads. 1 for fused stages of modules that are not thread-safe
+  * @return false if no trace was processed.
+  */
+  bool submitExecPhaseStage( csModule** stageModules, int numStageModules, int numThreads, bool forceToProcess, csLogWriter* log, int& port );
+  /**
+  * Set up module to run its exec phase in several threads at once (module must be thread-safe, see csExecPhaseDef::setThreadSafe).
+  * If the module defines a clone method, each worker gets its own copy of the module variables.
+  * For multi-trace modules, several trace gathers (complete ensembles, or fixed number of traces) are then processed in parallel by submitExecPhase().
+  * @param numWorkers:         Number of workers (threads)
+  * @param numGathersPerWorker: Multi-trace modules: Number of trace gathers collected per worker before exec phase is submitted
+  */
+  void setNumWorkers( int numWorkers, int numGathersPerWorker = 1 );
+  /// @return number of workers (threads) that run the module's exec phase in parallel
+  inline int numWorkers() const { return myNumWorkers; }
   /// Submit clean-up phase. Returning false means there was some unspecified error, probably a program bug.
   bool submitCleanupPhase( csLogWriter* log );
 
   /// Move seismic traces from module 'module' that is connected to this module at input port 'inPort'
   void moveTracesFrom( csModule* module, int inPort );
+  /**
+  * Pass processed traces on to ring buffer, to be received by a module running in another thread
+  * @param buffer: Ring buffer. Blocks while buffer is full. Traces are freed if buffer has been aborted
+  */
+  void passTracesTo( csTraceRingBuffer* buffer );
+  /**
+  * Receive traces from ring buffer, passed on by a module running in another thread.
+  * Blocks until at least one trace is available, then receives all traces currently held in buffer.
+  * @param buffer: Ring buffer
+  * @param inPort: Input port
+  * @return number of received traces. 0 if no more traces will be passed on.
+  */
+  int receiveTracesFrom( csTraceRingBuffer* buffer, int inPort );
   /// Call to clean up last module in flow. Call after each exec phase submission
   void lastModuleTraceCleanup();  //...
   /// @return true if there are still unprocessed traces waiting in the trace gather
@@ -90,6 +133,8 @@ public:
   int tempNumTraces();
   /// @return CPU time used during module's exec phase
   inline double getExecPhaseCPUTime() const { return myTimeExecPhaseCPU; }
+  /// @return maximum memory held in traces (samples and headers) buffered by this module at one time [bytes]
+  inline csInt64_t getMaxNumBytesHeld() const { return myMaxNumBytesHeld; }
   /**
   * Set module version number
   * @param major: Major version (1-99)
@@ -133,6 +178,10 @@ private:
   csExecPhaseEnv* myExecEnvPtr;
   /// Accumulated CPU time taken by module's exec phase
   double myTimeExecPhaseCPU;
+  /// Memory high-water mark: Maximum memory held in traces buffered by this module at one time [bytes]
+  csInt64_t myMaxNumBytesHeld;
+  /// Update memory high-water mark, given number of traces currently buffered by this module
+  void updateMaxNumBytesHeld( int numTraces );
 
   //-----------------------------------------------------------------------------------------
   // Fields relating to ensemble breaks -- maybe these could be wrapped up in another class? Maybe csExecPhaseDef?
@@ -149,10 +198,24 @@ private:
   * @param inPort: Input port
   */
   void addNewTraceToQueue( csTrace* trace, int inPort );
+  /**
+  * Helper method: Add trace passed on from previous module, either to trace gather or trace queue
+  * @param trace: Trace to add
+  * @param inPort: Input port
+  */
+  void addIncomingTrace( csTrace* trace, int inPort );
 
   /// Special method to update trace gathers for 'ensemble' modules
   void updateTracesEnsembleModule();
   /**
+  * Exec phase for multi-trace modules with more than one worker: Process several trace gathers in parallel,
+  * i.e. complete ensembles (ensemble mode) or fixed number of traces (fixed mode)
+  * @return number of processed traces
+  */
+  int submitExecPhaseWorkers( bool forceToProcess, csLogWriter* log, int& outPort );
+  /// Read ensemble key values from trace header
+  void readEnsembleKeys( csTrace* trace, cseis_geolib::csFlexNumber* keyValues ) const;
+  /**
   * Is this trace part of the current ensemble?
   * @return true if trace is part of currently collected ensemble
   *    If this is the first trace in a new ensemble, the ensemble key value is set
@@ -175,6 +238,19 @@ private:
   bool myIsEnsembleFull;
   /// true if processing of current trace gather is finished
   bool myIsFinishedProcessing;
+  /// Number of ensembles held in trace queue, including last (maybe incomplete) ensemble. Only counted for ensemble modules with more than one worker
+  int myNumEnsemblesInQueue;
+  /// Ensemble key values of last trace in trace queue
+  cseis_geolib::csFlexNumber* myLastQueuedKeyValue;
+
+  /// Number of workers (threads) running exec phase
+  int myNumWorkers;
+  /// Multi-trace modules with several workers: Number of trace gathers processed in one exec phase submission
+  int myNumGathersPerSubmit;
+  /// Exec phase definition for each worker. Worker 0 uses the module's own exec phase definition
+  csExecPhaseDef** myWorkerExecPhaseDef;
+  /// Exec phase environment for each worker. Worker 0 uses the module's own exec phase environment
+  csExecPhaseEnv** myWorkerExecEnv;
 
   /// Parameter method (function pointer)
   MParamPtr myMethodParam;
@@ -184,6 +260,8 @@ private:
   MExecSingleTracePtr myMethodExecSingleTrace;
   /// EXEC phase method for multi trace modules (function pointer)
   MExecMultiTracePtr myMethodExecMultiTrace;
+  /// CLONE method (function pointer). NULL if module does not define a clone method
+  MClonePtr myMethodClone;
   //--------------------
   // Module structure  
   //
@@ -22,6 +22,8 @@ class csUserConstant;
 class csParamDef;
 class csUserParam;
 class csMemoryPoolManager;
+class csTraceRingBuffer;
+class csRunManager;
 
  struct modInfoStruct {
     modInfoStruct() {
@@ -37,6 +39,17 @@ class csMemoryPoolManager;
     int modType;
   };
 
+  /// Arguments passed to thread running one group of modules in pipelined exec phase
+  struct csGroupThreadArgs {
+    csRunManager* runManager;
+    int firstModule;
+    int lastModule;
+    csTraceRingBuffer* inBuffer;
+    csTraceRingBuffer* outBuffer;
+    /// Set by thread: false if an error occurred
+    bool isSuccess;
+  };
+
 /**
  * Run Manager
  *
@@ -54,8 +67,13 @@ public:
   * @param log   Log writer
   * @param memoryPolicy   ...as defined in csMemoryPoolManager: POLICY_SPEED or POLICY_MEMORY
   * @param isDebug true if extended debug information shall be printed
+  * @param numThreads Number of threads used to run consecutive thread-safe single-trace modules in parallel
+  * @param queueDepth If > 0, run modules in pipelined mode: Each group of modules runs in its own thread, traces are passed on
+  *                   through ring buffers holding up to queueDepth traces
+  * @param maxMemoryMB Memory budget for trace samples and headers [MB]. 0: Use default budget
+  * @param isFusion  true if consecutive single-trace modules shall be fused, i.e. run back-to-back on each trace
   */
-  csRunManager( csLogWriter* log, int memoryPolicy, bool isDebug = false );
+  csRunManager( csLogWriter* log, int memoryPolicy, bool isDebug = false, int numThreads = 1, int queueDepth = 0, int maxMemoryMB = 0, bool isFusion = true );
   ~csRunManager();
   /**
   * Run initialisation phase for all modules
@@ -87,6 +105,52 @@ private:
   cseis_geolib::csVector<int>** myPrevModuleID;
   int myNumModules;
   bool myIsDebug;
+  /// Number of threads used in exec phase
+  int myNumThreads;
+  /// true if consecutive single-trace modules are run as fused stages
+  bool myIsFusion;
+  /// Number of traces collected per thread before a parallel or fused stage is submitted
+  static int const NUM_TRACES_PER_THREAD = 32;
+  /**
+   * Set up parallel stages: Runs of consecutive thread-safe single-trace modules that can be executed by several threads.
+   * Set up fused stages: Remaining runs of consecutive single-trace modules, executed back-to-back on each trace in one thread.
+   * Also set up thread-safe multi-trace modules to process several ensembles, or several single-trace gathers, in parallel.
+   * @param stageLastModule (o) For each module that starts a stage, index of last module in stage. -1 for all other modules
+   */
+  void setupParallelStages( int* stageLastModule );
+  /// @return true if module can be part of a fused stage
+  bool isFusedStageModule( int moduleIndex ) const;
+  /// @return true if module can be part of a parallel stage
+  bool isParallelStageModule( int moduleIndex ) const;
+  /// @return index of last module in stage starting at firstModule
+  int findStageLastModule( int firstModule, bool isParallel, int const* stageLastModule ) const;
+  /// @return true if multi-trace module can process several ensembles, or several single-trace gathers, in parallel
+  bool isParallelWorkerModule( int moduleIndex ) const;
+  /// For each module that starts a parallel or fused stage, index of last module in stage. -1 for all other modules
+  int* myStageLastModule;
+  /// Depth of ring buffers between pipeline groups. 0 if pipelined mode is switched off
+  int myQueueDepth;
+  /**
+   * Set up pipeline groups: Groups of consecutive modules that run in their own thread.
+   * Flow is split between two modules where all traces leaving the modules above are passed to the module below,
+   * i.e. never inside IF or SPLIT blocks, or inside parallel or fused stages.
+   * @param groupFirstModule (o) Index of first module in each group, followed by number of modules
+   * @return number of groups
+   */
+  int setupPipelineGroups( int* groupFirstModule ) const;
+  /**
+   * Run exec phase for one group of modules
+   * @param firstModule Index of first module in group
+   * @param lastModule  Index of last module in group
+   * @param inBuffer    Ring buffer from which traces are received. NULL for group containing the input module
+   * @param outBuffer   Ring buffer to which traces are passed on. NULL for last group
+   * @return false if an error occurred in this group, or if a neighbouring group aborted the ring buffer in between
+   */
+  bool runExecPhaseGroup( int firstModule, int lastModule, csTraceRingBuffer* inBuffer, csTraceRingBuffer* outBuffer );
+  /// Thread function: Run exec phase for one group of modules. Argument is of type csGroupThreadArgs
+  static void* runExecPhaseGroupThread( void* args );
+  /// Pass processed traces of last module in group on to next group, or clean up traces if there is no next group
+  static void passTracesOut( csModule* module, csTraceRingBuffer* outBuffer );
   /**
    * Parse version string.
    * @return false if string does not contain valid version string
@@ -11,11 +11,13 @@
 
 namespace cseis_io {
   class csSeismicReader_ver;
+  class csSeismicIndex;
 }
 
 namespace cseis_geolib {
   class csFlexHeader;
   class csIOSelection;
+  class csSharedBuffer;
 }
 namespace cseis_system {
 
@@ -65,6 +67,24 @@ public:
   */
   bool readTrace( float* samples, char* hdrValueBlock );
   bool readTrace( float* samples, char* hdrValueBlock, int numSamples );
+  /**
+   * Memory-map seismic file. Call after readFileHeader().
+   * Traces are then read from the mapped file, and may reference the mapped data samples instead of copying them, see readTraceShared()
+   * @return false if file cannot be mapped, e.g. because data samples are compressed. The file is then read as usual
+   */
+  bool mapFile();
+  /**
+  * Read next trace from memory-mapped file, without copying data samples
+  * @param hdrValueBlock (o) Buffer to hold all trace header values in the format defined in the trace header definition
+  * @param samples       (o) Read-only trace samples, residing in mapped file
+  * @param owner         (o) Owner of mapped file. Add reference to keep samples valid after reader has been deleted
+  * @return false if end of file has been reached, or if samples cannot be referenced in mapped file. Use readTrace() in the latter case
+  */
+  bool readTraceShared( char* hdrValueBlock, float const*& samples, cseis_geolib::csSharedBuffer*& owner );
+  /**
+   * @return true if data samples can be referenced in mapped file, see readTraceShared()
+   */
+  bool isSharedReadSupported() const;
   /**
    * Set header to peek
    * Initiates header 'peeking' operation. Next, the method 'peekheaderValue' may be called to retrieve the header value
@@ -123,6 +143,11 @@ public:
    */
   bool setSelection( std::string const& hdrValueSelectionText, std::string const& headerName, int sortOrder, int sortMethod );
   int getCurrentTraceIndex() const;
+  /**
+   * Retrieve header values from header index file, if it exists and is up to date. See csSeismicIndex
+   */
+  bool getIndexedHeaderValues( std::string const& headerName, double const*& sortedValues, csInt64_t const*& sortedValuesInt64,
+                               int const*& sortedTraceIndices );
 
 private:
   void init();
@@ -137,6 +162,10 @@ private:
   char* myHdrCheckBuffer;
   cseis_system::csTraceHeaderDef const* myTrcHdrDef;  // Pointer only, do not free!
   cseis_geolib::csIOSelection* myIOSelection;
+  std::string myFilename;
+  /// Header index. NULL if not read yet, or if no up-to-date index file exists
+  cseis_io::csSeismicIndex* myIndex;
+  bool myIsIndexRead;
 };
 
 } // end namespace
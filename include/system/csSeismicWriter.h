@@ -49,7 +49,27 @@ public:
    * @param samples  (i) Trace samples
    * @param hdrValueBlock (i) Buffer holding all trace header values in the format defined in the trace header definition
    */
-  bool writeTrace( float* samples, char const* hdrValueBlock );
+  bool writeTrace( float const* samples, char const* hdrValueBlock );
+  /**
+   * Write header index file next to output file, indexing the given trace header.
+   * Readers use the index to select and sort traces without scanning the data file.
+   * Call before writeFileHeader()
+   * @param headerName (i) Name of trace header to index. Only number headers are supported
+   */
+  void addIndexHeader( std::string const& headerName );
+  /**
+   * Compress data samples in blocks of buffered traces. Writes file version 0.5.
+   * Call before writeFileHeader(). Requires 32bit samples
+   * @param maxError        Maximum error of lossy compression. 0: Lossless compression
+   * @param isRelativeError true if maxError is relative to the maximum absolute amplitude of each trace
+   */
+  void setBlockCompression( float maxError = 0.0f, bool isRelativeError = false );
+  /// Flush buffered traces and close output file
+  void close();
+  /// @return ratio of uncompressed to compressed size of data samples written so far
+  double compressionRatio() const;
+  /// @return signal-to-noise ratio [dB] of data samples written so far, due to lossy compression
+  double compressionSNR() const;
 
 private:
   cseis_io::csSeismicWriter_ver* myWriter;
@@ -0,0 +1,128 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_SLAB_ALLOCATOR_H
+#define CS_SLAB_ALLOCATOR_H
+
+#include <cstdio>
+#include <map>
+#include <pthread.h>
+#include "geolib_defines.h"
+
+namespace cseis_system {
+
+/**
+* Slab allocator
+*
+* Allocates memory blocks for trace samples and trace headers.
+* Blocks are rounded up to size classes and carved from slabs of up to SLAB_SIZE bytes. Size classes are spaced
+* by MIN_BLOCK_SIZE up to 512 bytes, and by 1/8 of the next lower power of two above that, so that no more than
+* 12.5% of a block is unused. Released blocks are re-used by later requests of the same size class.
+* Slabs whose blocks have all been released are returned to the system (POLICY_MEMORY), or kept for re-use if
+* they are the only empty slab of their size class (POLICY_SPEED).
+* Blocks larger than the largest size class are allocated separately, with their exact (aligned) size.
+* All blocks are aligned to ALIGNMENT bytes, suitable for SIMD loads/stores.
+*
+* The number of bytes in use, i.e. handed out in blocks, is limited to a memory budget. Exceeding this budget throws an exception.
+*/
+class csSlabAllocator {
+public:
+  /// Alignment of all memory blocks [bytes]
+  static int const ALIGNMENT = 64;
+  /**
+  * @param maxNumBytes Memory budget: Maximum number of bytes in use
+  * @param policy      csMemoryPoolManager::POLICY_SPEED or POLICY_MEMORY
+  */
+  csSlabAllocator( csInt64_t maxNumBytes, int policy );
+  ~csSlabAllocator();
+  /**
+  * Allocate memory block. Thread-safe.
+  * @param numBytes Minimum size of block
+  * @return pointer to ALIGNMENT-byte aligned memory block of blockSize(numBytes) bytes
+  */
+  void* allocate( csInt64_t numBytes );
+  /**
+  * Release memory block. Thread-safe.
+  * @param ptr      Block returned by allocate()
+  * @param numBytes Size of block, as passed to allocate()
+  */
+  void release( void* ptr, csInt64_t numBytes );
+  /// @return actual size of block that is allocated for the given number of bytes
+  static csInt64_t blockSize( csInt64_t numBytes );
+  /// @return number of bytes currently handed out in blocks
+  inline csInt64_t numBytesInUse() const { return myNumBytesInUse; }
+  /// @return maximum number of bytes handed out in blocks at one time
+  inline csInt64_t maxNumBytesInUse() const { return myMaxNumBytesInUse; }
+  /// @return number of bytes allocated from system (slabs and separately allocated blocks)
+  inline csInt64_t numBytesAllocated() const { return myNumBytesAllocated; }
+  /// @return memory budget [bytes]
+  inline csInt64_t maxNumBytes() const { return myMaxNumBytes; }
+  void dumpSummary( FILE* fout ) const;
+
+private:
+  csSlabAllocator( csSlabAllocator const& obj );
+  /// Smallest size class [bytes]
+  static int const MIN_BLOCK_SIZE = 64;
+  /// Number of size classes between two powers of two
+  static int const NUM_SUB_CLASSES = 8;
+  /// Largest size class that is spaced by MIN_BLOCK_SIZE [bytes]
+  static int const MAX_SMALL_BLOCK_SIZE = MIN_BLOCK_SIZE * NUM_SUB_CLASSES;
+  /// Size of one slab [bytes]
+  static csInt64_t const SLAB_SIZE = 1024*1024;
+  /// Minimum number of blocks held by one slab
+  static int const MIN_BLOCKS_PER_SLAB = 4;
+  /// Largest size class [bytes]
+  static csInt64_t const MAX_BLOCK_SIZE = SLAB_SIZE / MIN_BLOCKS_PER_SLAB;
+  /// Number of size classes: NUM_SUB_CLASSES small classes, plus NUM_SUB_CLASSES for each power of two from MAX_SMALL_BLOCK_SIZE to MAX_BLOCK_SIZE
+  static int const NUM_SIZE_CLASSES = NUM_SUB_CLASSES * 10;
+
+  /// Released block, linked into free list of its slab
+  struct csFreeBlock {
+    csFreeBlock* next;
+  };
+  /// Slab: Memory holding blocks of one size class
+  struct csSlab {
+    char* memory;
+    csInt64_t numBytes;
+    int sizeClass;
+    int numBlocks;
+    int numFreeBlocks;
+    csFreeBlock* freeBlocks;
+    /// Previous/next slab in list of slabs with free blocks of the same size class
+    csSlab* prev;
+    csSlab* next;
+  };
+
+  /// @return size class for given number of bytes, or -1 if block shall be allocated separately
+  static int sizeClass( csInt64_t numBytes );
+  /// @return block size of given size class [bytes]
+  static csInt64_t classSize( int sizeClass );
+  /// Allocate aligned memory from system. Call with locked mutex
+  void* allocateSystem( csInt64_t numBytes );
+  /// Allocate new slab for given size class and add it to the list of slabs with free blocks. Call with locked mutex
+  csSlab* allocateSlab( int sizeClass );
+  /// Return empty slab to system. Call with locked mutex
+  void releaseSlab( csSlab* slab );
+  /// Add/remove slab to/from list of slabs with free blocks. Call with locked mutex
+  void linkSlab( csSlab* slab );
+  void unlinkSlab( csSlab* slab );
+
+  /// Slabs with free blocks, for each size class
+  csSlab* myPartialSlabs[NUM_SIZE_CLASSES];
+  /// Number of slabs without used blocks, for each size class
+  int myNumEmptySlabs[NUM_SIZE_CLASSES];
+  /// All slabs, by start address
+  std::map<char*,csSlab*>* mySlabMap;
+  /// true if empty slabs shall be returned to system immediately
+  bool myReleaseEmptySlabs;
+
+  csInt64_t myMaxNumBytes;
+  csInt64_t myNumBytesInUse;
+  csInt64_t myMaxNumBytesInUse;
+  csInt64_t myNumBytesAllocated;
+  csInt64_t myMaxNumBytesAllocated;
+  pthread_mutex_t myMutex;
+};
+
+} // namespace
+#endif
@@ -4,6 +4,8 @@
 #ifndef CS_TRACE_H
 #define CS_TRACE_H
 
+#include <atomic>
+
 namespace cseis_system {
 
 class csTraceHeader;
@@ -36,9 +38,11 @@ public:
   /// @return pointer to trace data object
   csTraceData* getTraceDataObject();
   csTraceData const* getTraceDataObject() const;
-  /// @return pointer to trace data object
+  /// @return pointer to trace samples, for read and write access
   float* getTraceSamples();
   float const* getTraceSamples() const;
+  /// @return pointer to trace samples, for read access only. Avoids copying samples that are shared, see csTraceData
+  float const* getTraceSamplesReadOnly() const;
   /// @return number of samples in trace
   int numSamples() const;
   /// @return number of trace headers in trace
@@ -69,8 +73,10 @@ public:
   csTracePool* const myTracePoolPtr;
   /// Unique trace identifier
   int const myIdentNumber;
-  /// Sequential trace counter
-  static int myIdentCounter;
+  /// true if trace is currently not in use, i.e. held as a free trace by the trace pool
+  bool myIsFree;
+  /// Sequential trace counter. Traces may be created in several threads at once
+  static std::atomic<int> myIdentCounter;
 };
 
 } // namespace
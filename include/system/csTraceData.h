@@ -7,13 +7,25 @@
 #include <cstdlib>
 #include "csException.h"
 
+namespace cseis_geolib {
+  class csSharedBuffer;
+}
+
 namespace cseis_system {
 
+class csSlabAllocator;
+
 /**
 * Trace samples/trace data
 *
 * Manages seismic trace samples for one trace
 *
+* Samples may be shared: Instead of holding its own copy, the trace then references read-only samples held elsewhere,
+* for example in a memory-mapped input file, or in the sample buffer of another trace (see shareData()).
+* Shared samples are copied into the trace's own buffer (copy-on-write) as soon as write access is requested through
+* getSamples(). The last trace referencing another trace's sample buffer takes the buffer over instead of copying it.
+* Modules that only read samples should use getSamplesReadOnly().
+*
 * @author Bjorn Olofsson
 * @date   2007
 */
@@ -21,9 +33,37 @@ class csTraceData {
 public:
   csTraceData();
   csTraceData( int numSamples );
+  /**
+  * @param allocator Allocator from which sample buffer is allocated. NULL: Allocate from heap
+  */
+  csTraceData( csSlabAllocator* allocator );
   ~csTraceData();
-  /// Return data samples
-  inline float* getSamples() { return myDataSamples; }
+  /// Return data samples for read and write access
+  inline float* getSamples() {
+    if( mySharedSamples != NULL ) unshare( true );
+    return myDataSamples;
+  }
+  /// Return data samples for read access only. Does not copy shared samples
+  inline float const* getSamplesReadOnly() const {
+    return( mySharedSamples != NULL ? mySharedSamples : myDataSamples );
+  }
+  /// @return true if samples are shared, i.e. not held in trace's own buffer
+  inline bool isShared() const { return( mySharedSamples != NULL ); }
+  /**
+  * Set shared data samples. Samples are not copied
+  * @param samples    Read-only samples. Must remain valid until owner is released
+  * @param nSamples   Number of samples
+  * @param owner      Owner of samples. A reference is held until samples are unshared, or the trace is freed
+  */
+  void setSharedData( float const* samples, int nSamples, cseis_geolib::csSharedBuffer* owner );
+  /**
+  * Share samples of other trace data object instead of copying them (copy-on-write).
+  * The other object's sample buffer becomes reference counted, and is shared by both objects until one of them requests
+  * write access. Note: Sample pointers previously retrieved from either object through getSamples() must not be used
+  * for writing afterwards.
+  * @param data Trace data to share
+  */
+  void shareData( csTraceData* data );
   /// Return number of samples
   inline int numSamples() const { return myNumSamples; }
   /// Return number of samples
@@ -36,18 +76,36 @@ public:
   void setData( float const* samples, int nSamples );
   inline float& operator [] ( int index ) {  // May throw exception
     if( index >= 0 && index < myNumSamples ) {
-      return myDataSamples[index];
+      return getSamples()[index];
     }
     throw cseis_geolib::csException("Wrong sample index passed to trace");
   }
   void trim();
   friend class csMemoryPoolManager;
   friend class csModule;
+  friend class csTrace;
 private:
+  /// Allocator for sample buffer. NULL if sample buffer is allocated from heap
+  csSlabAllocator* myAllocator;
   float* myDataSamples;
   int myNumSamples;
   int myNumAllocatedSamples;
   bool myDoTrimOnNextCall;
+  /// Shared read-only samples. NULL if trace holds samples in its own buffer
+  float const* mySharedSamples;
+  /// Owner of shared samples
+  cseis_geolib::csSharedBuffer* mySharedOwner;
+  /// true if shared samples are the sample buffer of a trace, owned by a csSharedSamples object
+  bool myIsSharedTraceBuffer;
+
+  void setSharedData( float const* samples, int nSamples, cseis_geolib::csSharedBuffer* owner, bool isTraceBuffer );
+  /**
+  * Stop sharing samples, and release reference to shared samples
+  * @param copySamples true if shared samples shall be copied into trace's own buffer
+  */
+  void unshare( bool copySamples );
+  /// Release sample buffer. Number of samples is set to 0
+  void clearMemory();
 
   /// Set number of samples to maximum between numSamples passed as argument and numSamples as currently set
   inline void setMax( int numSamplesNew ) {
@@ -57,6 +115,14 @@ private:
     set( numSamplesNew, 0 );
   }
   void set( int numSamplesNew, int firstLiveSample );
+  /**
+  * Allocate sample buffer
+  * @param numSamples          (i) Minimum number of samples
+  * @param numAllocatedSamples (o) Number of samples actually allocated
+  */
+  float* allocateSamples( int numSamples, int& numAllocatedSamples );
+  /// Release sample buffer of given size, allocated by allocateSamples()
+  void releaseSamples( float* samples, int numAllocatedSamples );
 };
 
 } // namespace
@@ -4,6 +4,8 @@
 #ifndef CS_TRACE_GATHER_H
 #define CS_TRACE_GATHER_H
 
+#include "geolib_defines.h"
+
 namespace cseis_geolib {
   template <typename T> class csVector;
 }
@@ -14,6 +16,7 @@ namespace cseis_system {
   class csModule;
   class csMemoryPoolManager;
   class csTraceHeaderDef;
+  class csTraceHeaderData;
 
 /**
 * Collection of traces (pointers to the traces)
@@ -92,6 +95,10 @@ public:
   */
   void moveTraceTo( int traceIndex, csTraceGather* traceGather, int toTraceIndex = -1 );
   void moveTracesTo( int firstTraceIndex, int nTraces, csTraceGather* traceGather );
+  /**
+  * Copy specified trace to another trace gather, insert at end of gather.
+  * Trace samples are shared between original and copy until either trace requests write access, see csTraceData::shareData()
+  */
   void copyTraceTo( int traceIndex, csTraceGather* traceGather );
   /**
   * @return number of traces currently in gather
@@ -101,8 +108,53 @@ public:
   * @return true if gather is empty
   */
   inline bool isEmpty() const { return numTraces() == 0; }
+  /**
+  * Extract one trace header from a range of traces into a contiguous array (one value per trace).
+  * The header type is resolved once for the whole range, not once per trace. Values are converted to the
+  * array type in the same way as by csTraceHeader::doubleValue(), floatValue() etc.
+  * All traces in the gather must share the same trace header definition.
+  *
+  * @param hdrIndex    Trace header index
+  * @param values      (o) Header values, numTraces values
+  * @param firstTrace  Index of first trace
+  * @param numTraces   Number of traces. -1: All traces from firstTrace to end of gather
+  */
+  void getHeaderValues( int hdrIndex, double* values, int firstTrace = 0, int numTraces = -1 ) const;
+  void getHeaderValues( int hdrIndex, float* values, int firstTrace = 0, int numTraces = -1 ) const;
+  void getHeaderValues( int hdrIndex, int* values, int firstTrace = 0, int numTraces = -1 ) const;
+  void getHeaderValues( int hdrIndex, csInt64_t* values, int firstTrace = 0, int numTraces = -1 ) const;
+  /**
+  * Scatter contiguous array into one trace header of a range of traces (one value per trace).
+  * Values are converted to the header type in the same way as by csTraceHeader::setDoubleValue(), setFloatValue() etc.
+  *
+  * @param hdrIndex    Trace header index
+  * @param values      Header values, numTraces values
+  * @param firstTrace  Index of first trace
+  * @param numTraces   Number of traces. -1: All traces from firstTrace to end of gather
+  */
+  void setHeaderValues( int hdrIndex, double const* values, int firstTrace = 0, int numTraces = -1 );
+  void setHeaderValues( int hdrIndex, float const* values, int firstTrace = 0, int numTraces = -1 );
+  void setHeaderValues( int hdrIndex, int const* values, int firstTrace = 0, int numTraces = -1 );
+  void setHeaderValues( int hdrIndex, csInt64_t const* values, int firstTrace = 0, int numTraces = -1 );
+  /**
+  * Set one trace header to the same value in a range of traces
+  * @param hdrIndex    Trace header index
+  * @param value       Header value
+  * @param firstTrace  Index of first trace
+  * @param numTraces   Number of traces. -1: All traces from firstTrace to end of gather
+  */
+  void setHeaderValue( int hdrIndex, double value, int firstTrace = 0, int numTraces = -1 );
+
   friend class csModule;
 private:
+  /// Trace header values of trace at given index
+  inline csTraceHeaderData* headerData( int traceIndex ) const;
+  /// Check and resolve trace range of header column access. Returns number of traces in range
+  int headerColumnRange( int firstTrace, int numTraces ) const;
+  template<typename T> void readHeaderColumn( int hdrIndex, T* values, int firstTrace, int numTraces ) const;
+  /// Write header column. valueStep: 1 to write one value per trace, 0 to write values[0] to all traces
+  template<typename T> void writeHeaderColumn( int hdrIndex, T const* values, int valueStep, int firstTrace, int numTraces );
+
   void setMemoryManager( csMemoryPoolManager* memManager );
   csMemoryPoolManager* myMemoryManager;
 
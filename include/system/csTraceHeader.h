@@ -27,7 +27,11 @@ namespace cseis_system {
 
 class csTraceHeader {
 public:
-  csTraceHeader();
+  /**
+  * @param allocator Allocator from which header value block is allocated. NULL: Allocate from heap
+  * @param numBytesToAllocate Initial size of header value block, see csTraceHeaderData
+  */
+  csTraceHeader( csSlabAllocator* allocator = NULL, int numBytesToAllocate = 0 );
 //  csTraceHeader( csTraceHeaderData* const traceHeaderData, csTraceHeaderDef const* traceHeaderDef );
   ~csTraceHeader();
   //--------------------------------------------------
@@ -81,6 +85,8 @@ public:
    * Dump all trace header names and values
    */
   void dump( std::FILE* stream = NULL ) const;
+  friend class csHeaderEquation;
+  friend class csTraceGather;
 private:
   /// The actual trace header values:
   csTraceHeaderData* myTraceHeaderData;
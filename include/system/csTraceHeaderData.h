@@ -14,6 +14,7 @@ namespace cseis_geolib {
 namespace cseis_system {
 
   class csTraceHeaderDef;
+  class csSlabAllocator;
 static int const DEFAULT_STRING_LENGTH = 20;
 
 /**
@@ -28,7 +29,12 @@ static int const DEFAULT_STRING_LENGTH = 20;
 */
 class csTraceHeaderData {
 public:
-  csTraceHeaderData();
+  /**
+  * @param allocator Allocator from which header value block is allocated. NULL: Allocate from heap
+  * @param numBytesToAllocate Initial size of header value block. Traces whose header blocks are sized for the largest
+  *                           header definition in the flow never reallocate when passing from one module to the next
+  */
+  csTraceHeaderData( csSlabAllocator* allocator = NULL, int numBytesToAllocate = 0 );
   ~csTraceHeaderData();
   /// Set/create trace header data from trace header definition
   void setHeaders( csTraceHeaderDef const* hdef, int inPort = -1 );
@@ -89,6 +95,8 @@ public:
 
 private:
   void deleteHeaders( csTraceHeaderDef const* hdef );
+  /// Allocator for header value block. NULL if value block is allocated from heap
+  csSlabAllocator* myAllocator;
   /// Buffer that holds all trace header values in one chunk of memory
   char* myValueBlock;
   /// Maps the sequential header index 0,1,2... to the byte location index in the char* 'value block'
@@ -147,8 +147,24 @@ class csTraceHeaderDef {
   void dump() const;
   /**
   * Set byte location... Call before using this object in exec phase
+  * Also compiles the plan to delete trace headers from traces leaving the module, see getDeleteSegments()
   */
   void resetByteLocation();
+  /// Byte range in trace header value block that is moved when trace headers are deleted
+  struct ByteSegment {
+    int byteSource;
+    int byteDest;
+    int numBytes;
+  };
+  /**
+  * Plan to delete trace headers from the value block of traces leaving the module: Byte segments of the remaining
+  * headers, to be moved in place, in the given order. Segments that do not move are omitted.
+  * Set up in resetByteLocation().
+  */
+  inline ByteSegment const* getDeleteSegments() const { return myDeleteSegments; }
+  inline int numDeleteSegments() const { return myNumDeleteSegments; }
+  /// @return number of bytes in trace header value block after trace headers have been deleted
+  inline int getNumBytesAfterDelete() const { return myNumBytesAfterDelete; }
   /**
   * Retrieve pointer handle to list of byte locations for each trace header value in trace header value block.
   */
@@ -193,6 +209,12 @@ private:
   /// Maps the sequential header index 0,1,2... to the byte location index in the char* 'value block'
   int* myByteLocation;
 
+  /// Delete plan, see getDeleteSegments()
+  ByteSegment* myDeleteSegments;
+  int myNumDeleteSegments;
+  int myNumBytesAfterDelete;
+  void compileDeletePlan();
+
   /// Return index to given header. The index can be used in all setter and getter methods in the trace data object (defined separately)
   bool getIndex( std::string const& name, int& index ) const;
   /// Initialize object with header definitions from all input ports
@@ -5,12 +5,14 @@
 #define CS_TRACE_POOL_H
 
 #include <cstdio>
-#include <map>
+#include <atomic>
+#include <pthread.h>
 #include "geolib_defines.h"
 
 namespace cseis_system {
 
 class csTrace;
+class csSlabAllocator;
 
 /**
 * Trace pool
@@ -22,42 +24,78 @@ class csTrace;
 *
 * However, this increase in speed is bought by a greater need for memory.
 *
+* Free traces are kept on a stack, so that retrieving and freeing a trace takes constant time.
+* Retrieving and freeing traces is thread-safe: Traces may be retrieved in one thread and freed in another.
+* With memory policy POLICY_SPEED, each thread additionally keeps a small cache of free traces. Traces are only moved
+* between thread caches and the shared stack in batches, so that the pool's mutex is rarely locked.
+* Each thread holds a thread cache slot, the index of its cache in all trace pools. When a thread exits, the traces in
+* its caches are moved back to the shared stacks, and the slot is reused by the next thread.
 *
 * @author Bjorn Olofsson
 * @date   2007
 */
 class csTracePool {
 public:
-  csTracePool( int policy );
+  /**
+  * @param policy    Memory pool policy, see csMemoryPoolManager
+  * @param allocator Allocator for trace samples and headers. NULL: Allocate from heap
+  */
+  csTracePool( int policy, csSlabAllocator* allocator = NULL );
   ~csTracePool();
   /**
   * @return pointer to new trace object
   */
   csTrace* getNewTrace();
+  /**
+  * Set size of trace header value block allocated for new trace objects
+  * @param numHeaderBytes Number of bytes, typically the largest trace header definition in the flow
+  */
+  void setNumHeaderBytes( int numHeaderBytes );
   friend class csTrace;
   friend class csMemoryPoolManager;
   void dumpSummary( FILE* fout ) const;
   /// For debugging purposes
   void dump();
-  int numAvailableTraces() { return myNumAllocatedTraces-myNumUsedTraces;  };
-
-protected:
-  csInt64_t computeNumBytes();
+  int numAvailableTraces() { return myNumAllocatedTraces.load(std::memory_order_relaxed)-myNumUsedTraces.load(std::memory_order_relaxed);  };
 
 private:
+  static int const BLOCK_SIZE_ATOM = 4;
+  /// Maximum number of free traces held in one thread cache
+  static int const CACHE_SIZE = 32;
+  /// Number of traces moved between thread cache and shared stack at once
+  static int const CACHE_BATCH_SIZE = CACHE_SIZE/2;
+  /// Maximum number of threads at one time that get their own cache. Further threads use the shared stack directly
+  static int const MAX_NUM_THREAD_CACHES = 64;
 
-  /// Traces
+  /// Cache of free traces, only accessed by the thread holding the cache slot
+  struct csTraceCache {
+    csTrace* traces[CACHE_SIZE];
+    int numTraces;
+  };
+  /// Thread cache slot held by one thread. Released when the thread exits
+  struct csThreadCacheSlot {
+    csThreadCacheSlot() : slot(-1) {}
+    ~csThreadCacheSlot();
+    /// Index of thread cache in all trace pools. -1 if no slot is held
+    int slot;
+  };
+
+  /// All trace objects created so far
   csTrace** myTraces;
+  /// Number of trace objects created so far
+  int myNumCreatedTraces;
+  /// Stack of free trace objects, shared by all threads
+  csTrace** myFreeTraces;
+  /// Number of traces on stack of free traces
+  int myNumFreeTraces;
+  /// Capacity of arrays myTraces and myFreeTraces
+  int myCapacity;
   /// Number of traces that are currently in use
-  int myNumUsedTraces;
+  std::atomic<int> myNumUsedTraces;
   /// Maximum number of traces in use at one time
-  int myMaxNumUsedTraces;
-  /// Number of traces allocated in trace pool
-  int myNumAllocatedTraces;
-  /// Index field, for each trace. If 'yes' for any particular trace, it means this trace is still 'free' (=available to be used)
-  bool* myIsTraceFree;
-  /// Index in trace array of a free trace
-  int myIndexNextFreeTrace;
+  std::atomic<int> myMaxNumUsedTraces;
+  /// Number of traces allocated in trace pool, including trace objects that are not created yet
+  std::atomic<int> myNumAllocatedTraces;
   /**
    * Size of block that is allocated anew when new trace shall be allocated. Increases steadily when new traces are allocated repeatibly.
    * Reason is to allocate some additional traces in advance to save time. This is faster than allocating each trace separately, but uses more memory
@@ -65,16 +103,54 @@ private:
   int myBlockSize;
   /// Memory pool policy: Optimised for speed or memory usage
   int myPolicy;
+  /// Allocator for trace samples and headers of all traces created by this pool
+  csSlabAllocator* myAllocator;
+  /// Size of trace header value block allocated for new trace objects
+  int myNumHeaderBytes;
+  /// Thread caches, indexed by thread cache slot. NULL if slot has not used pool yet
+  csTraceCache* myThreadCaches[MAX_NUM_THREAD_CACHES];
+  /// Next trace pool in list of all trace pools
+  csTracePool* myNextPool;
+
+  /// Thread cache slot of calling thread
+  static thread_local csThreadCacheSlot myThreadCacheSlot;
+  /// Protects the following list of trace pools and free slots
+  static pthread_mutex_t myThreadCacheSlotMutex;
+  /// First trace pool in list of all trace pools
+  static csTracePool* myFirstPool;
+  /// Slots released by threads that have exited
+  static int myFreeThreadCacheSlots[MAX_NUM_THREAD_CACHES];
+  static int myNumFreeThreadCacheSlots;
+  /// Number of slots handed out so far, including released slots
+  static int myNumThreadCacheSlots;
 
-  void reallocate( int newNumAllocatedTraces );
   /**
   * 'Free' the according trace from the buffer pool
   * This does not free any memory!
   * It makes the trace buffer available again, which means the trace is free'd to be used elsewhere, see 'getNewTrace()'.
   */
   void freeTrace( csTrace* trace );
-  static int const BLOCK_SIZE_ATOM = 4;
-  std::map<int,int>* myTraceIndexMap;
+  /**
+  * Retrieve free traces from shared stack. Creates new trace object if stack is empty. Call with locked mutex.
+  * @param traces    (o) Free traces
+  * @param maxTraces (i) Maximum number of traces to retrieve
+  * @return number of retrieved traces (at least 1)
+  */
+  int popFreeTraces( csTrace** traces, int maxTraces );
+  /// Put free traces back on shared stack. Call with locked mutex
+  void pushFreeTraces( csTrace* const* traces, int numTraces );
+  /// Grow arrays holding trace objects to given capacity. Call with locked mutex
+  void reallocate( int newCapacity );
+  /// @return cache of calling thread, or NULL if thread shall use shared stack directly
+  csTraceCache* threadCache();
+  /// @return free thread cache slot, or -1 if all slots are held by other threads
+  static int acquireThreadCacheSlot();
+  /// Move traces in given slot's caches back to shared stacks, then make slot available to other threads
+  static void releaseThreadCacheSlot( int slot );
+  /// Update number of traces in use
+  void addNumUsedTraces( int numTraces );
+  /// Protects shared stack of free traces
+  pthread_mutex_t myMutex;
 };
 
 } // namespace
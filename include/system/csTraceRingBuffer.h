@@ -0,0 +1,81 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#ifndef CS_TRACE_RING_BUFFER_H
+#define CS_TRACE_RING_BUFFER_H
+
+#include <atomic>
+
+namespace cseis_system {
+
+class csTrace;
+
+/**
+* Trace ring buffer
+*
+* Bounded single-producer/single-consumer queue of seismic traces.
+* Passes traces between two threads without locking: One thread pushes traces, another thread pops them.
+* The producer blocks while the buffer is full, the consumer blocks while the buffer is empty.
+* The limited capacity provides back-pressure, i.e. caps the number of traces in flight between two threads.
+* Either thread may abort the buffer after an error, which releases the other thread if it is blocked.
+*/
+class csTraceRingBuffer {
+public:
+  /**
+  * @param capacity Maximum number of traces held in buffer
+  */
+  csTraceRingBuffer( int capacity );
+  ~csTraceRingBuffer();
+  /**
+  * Push trace to end of buffer. Blocks while buffer is full.
+  * Only call from producer thread.
+  * @return false if buffer has been aborted. The trace is then not pushed
+  */
+  bool push( csTrace* trace );
+  /**
+  * Pop trace from start of buffer. Blocks while buffer is empty.
+  * Only call from consumer thread.
+  * @return NULL if producer has finished and buffer is empty, or if buffer has been aborted
+  */
+  csTrace* pop();
+  /**
+  * Pop trace from start of buffer, without blocking.
+  * Only call from consumer thread.
+  * @return NULL if buffer is empty
+  */
+  csTrace* tryPop();
+  /**
+  * Signal that producer has finished, i.e. no more traces will be pushed.
+  * Only call from producer thread.
+  */
+  void setFinished();
+  /**
+  * Abort buffer, e.g. when the producer or consumer thread stops due to an error.
+  * Can be called from either thread. All following calls to push() and pop() return immediately.
+  */
+  void abort();
+  /// @return true if buffer has been aborted
+  inline bool isAborted() const { return myIsAborted.load( std::memory_order_acquire ); }
+  /// @return capacity of buffer
+  inline int capacity() const { return myCapacity; }
+
+private:
+  csTraceRingBuffer( csTraceRingBuffer const& obj );
+  /// Wait for other thread: Yield processor for the first 100 waits, then sleep for 50 microseconds per wait
+  static void wait( int& numWaits );
+
+  csTrace** myBuffer;
+  int myCapacity;
+  /// Total number of traces popped. Only written by consumer
+  std::atomic<long> myNumPopped;
+  /// Total number of traces pushed. Only written by producer
+  std::atomic<long> myNumPushed;
+  /// true when producer has finished
+  std::atomic<bool> myIsFinished;
+  /// true when buffer has been aborted
+  std::atomic<bool> myIsAborted;
+};
+
+} // namespace
+
+#endif
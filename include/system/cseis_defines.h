@@ -34,6 +34,15 @@ typedef void (*MExecMultiTracePtr) (
   int* numTrcToKeep,
   csExecPhaseEnv* env,
   csLogWriter* log );
+/**
+* Clone method (optional)
+* Create a separate copy of the module variables, so that the exec phase can run in several threads at once.
+* Read-only settings from the init phase may be shared, scratch buffers must be allocated anew.
+* The clone's exec phase is called with isCleanup() = true at the end, just like for the original module.
+* @param env:      Exec phase environment of original module, holding variables set up in init phase
+* @param envClone: Exec phase environment of clone. Set the cloned variables in envClone->execPhaseDef
+*/
+typedef void (*MClonePtr) ( csExecPhaseEnv* env, csExecPhaseEnv* envClone );
 
 // Execution type for modules
 static int const EXEC_TYPE_INPUT       = 111;   // Input module
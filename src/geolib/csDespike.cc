@@ -2,8 +2,10 @@
 /* All rights reserved.                       */
 
 #include "csDespike.h"
-#include "csVector.h"
+#include "csSlidingMedian.h"
+#include "csException.h"
 #include "geolib_math.h"
+#include <algorithm>
 
 using namespace cseis_geolib;
 
@@ -15,12 +17,17 @@ void csDespike::init( int numSamples, double sampleInt ) {
   mySampleInt     = sampleInt;
   myNumSamples    = numSamples;
   myRatios = NULL;
+  myMedian = NULL;
 }
 csDespike::~csDespike() {
   if( myRatios != NULL ) {
     delete [] myRatios;
     myRatios = NULL;
   }
+  if( myMedian != NULL ) {
+    delete myMedian;
+    myMedian = NULL;
+  }
 }
 //***************************************************************************************
 //
@@ -30,6 +37,10 @@ void csDespike::set( DespikeConfig const& config ) {
     delete [] myRatios;
     myRatios = NULL;
   }
+  if( myMedian != NULL ) {
+    delete myMedian;
+    myMedian = NULL;
+  }
   myPerformDebias = config.performDebias;
   myMaxRatio = config.maxRatio;
   myMethod   = config.method;
@@ -62,6 +73,7 @@ void csDespike::set( DespikeConfig const& config ) {
   myNumWindows = ( numSamplesToProcess - myWidthRefWin ) / myIncWin + 1;
 
   myRatios = new float[myNumWindows];
+  myMedian = new csSlidingMedian( myWidthRefWin );
 }
 
 //***************************************************************************************
@@ -142,7 +154,7 @@ bool csDespike::computeRatios( float* samples, int numSamples ) {
   if( myWidthRefWin >= myNumSamples ) return false;
   if( numSamples != myNumSamples ) return false;
 
-  csVector<DespikePoint*> sortedList(myWidthRefWin);
+  myMedian->clear();
   int widthRefWinHalf  = myWidthRefWin / 2;
   int widthMeanWinHalf = myWidthMeanWin / 2;
 
@@ -152,19 +164,7 @@ bool csDespike::computeRatios( float* samples, int numSamples ) {
   double currentSumRefWin = 0.0;
   for( int i = 0; i < myWidthRefWin-1; i++ ) {
     int sampleIndex = i + myStartSample;
-    float value = fabs(samples[sampleIndex]);
-    DespikePoint* p = new DespikePoint( sampleIndex, value );
-    int is = 0;
-    for( ; is < sortedList.size(); is++ ){
-      DespikePoint* ptmp = sortedList.at(is);
-      if( p->value < ptmp->value ) {
-        sortedList.insert( p, is );
-        break;
-      }
-    }
-    if( is == sortedList.size() ) {
-      sortedList.insert( p, sortedList.size() );
-    }
+    myMedian->push( fabs(samples[sampleIndex]) );
     if( myPerformDebias ) {
       currentSumRefWin += samples[sampleIndex];
     }
@@ -181,7 +181,7 @@ bool csDespike::computeRatios( float* samples, int numSamples ) {
 // Main loop
 //
   for( int iwin = 0; iwin < myNumWindows; iwin++ ) {
-// (1) Determine median value in reference window (sort all values, pick middle one)
+// (1) Determine median value in reference window
     int sampleFirst = iwin * myIncWin + myStartSample;
     int sampleLast  = sampleFirst + myWidthRefWin - 1;
     int sampleMid   = widthRefWinHalf + sampleFirst;
@@ -189,80 +189,28 @@ bool csDespike::computeRatios( float* samples, int numSamples ) {
 
     int sampleFirstMean = sampleMid - widthMeanWinHalf;
     int sampleLastMean  = sampleMid + widthMeanWinHalf;
-// Remove previous point
-    DespikePoint* p = NULL;
     if( iwin > 0 ) {
-      int sample_del = sampleFirst - 1;
-      int length = sortedList.size();
-      for( int is = 0; is < length; is++ ) {   // Currently assumes that window increment is 1
-        p = sortedList.at(is);
-        if( p->index == sample_del ) {
-          sortedList.remove(is);
-          break;
-        }
-      }
       //fprintf(stderr,"-Sum min %d %f\n", sampleFirstMean-1, samples[sampleFirstMean-1] );
       currentSumMeanWin -= fabs((double)samples[sampleFirstMean-1]);
     }
-    else {
-      p = new DespikePoint( 0, 0 );
-    }
     //fprintf(stderr,"+Sum min %d %f\n", sampleLastMean, samples[sampleLastMean] );
     if( myPerformDebias ) {
       if( iwin > 0 ) currentSumRefWin -= (double)samples[sampleFirst - 1];
       currentSumRefWin += (double)samples[sampleLast];
       value -= (float)(currentSumRefWin / (double)myWidthRefWin);
     }
-    p->index = sampleLast;
-    p->value = value;
-    insertNewValue( p, &sortedList );
+    // New value replaces value of previous window's first sample (window increment is currently one sample)
+    myMedian->push( value );
 
-    double medianValue = sortedList.at( widthRefWinHalf )->value;
+    double medianValue = myMedian->value();
     currentSumMeanWin += fabs((double)samples[sampleLastMean]);
     myRatios[iwin] = (float)( currentSumMeanWin / (medianValue * myWidthMeanWin ) );  // Compute ratio from mean value
   }
-  // Free memory
-  for( int is = 0; is < sortedList.size(); is++ ) {
-    delete sortedList.at( is );
-  }
   return true;
 }
 //***************************************************************************************
 //
 //
-void csDespike::insertNewValue( DespikePoint* p, csVector<DespikePoint*>* sortedList ) {
-  int id1 = 0;
-  int id2 = sortedList->size() - 1;
-  float value = p->value;
-
-  while( true ) {
-    int id0 = (id1+id2)/2;
-    float val0 = sortedList->at(id0)->value;
-    if( value > val0 ) {
-      if( id2-id1 <= 1 ) {
-        if( value > sortedList->at(id2)->value ) {
-          sortedList->insert( p, id2+1 );
-        }
-        else {
-          sortedList->insert( p, id1+1 );
-        }
-        break;
-      }
-      id1 = id0;
-    }
-    else if( value < val0 ) {
-      if( id2-id1 <= 1 ) {
-        sortedList->insert( p, id1 );
-        break;
-      }
-      id2 = id0;
-    }
-    else {
-      sortedList->insert( p, id0 );
-      break;
-    }
-  }
-}
 void csDespike::getDefaultFrequencySpikeConfig( DespikeConfig& config ) {
   config.widthRefWin = 1.0;
   config.incWin      = 0;
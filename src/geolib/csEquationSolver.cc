@@ -8,6 +8,8 @@
 #include "csMathFunction.h"
 #include "csStack.h"
 #include "csVector.h"
+#include <algorithm>
+#include <cstring>
 
 using namespace cseis_geolib;
 
@@ -27,27 +29,26 @@ void csEquationSolver::init() {
   myNameSpecialFloatArray = "";
   myNumValuesSpecialFloatArray = 0;
   myNumUserConstants = 0;
-  myUserConstants = NULL;
   myUserConstantNames = NULL;
-  myValueStack = NULL;
   myExpressionList = new csVector< csVector<csToken> >;
+  myOperations     = NULL;
+  myNumOperations  = 0;
+  myRegisters      = NULL;
+  myNumRegisters   = 0;
+  myResultRegister = 0;
+  myHasSequentialFunction = false;
+  myBatchRegisters = NULL;
+  myBatchArgs      = NULL;
 }
 //------------------------------------------------------------
 //
 csEquationSolver::~csEquationSolver() {
   myNumUserConstants = 0;
-  if( myUserConstants ) {
-    delete [] myUserConstants;
-    myUserConstants = NULL;
-  }
   if( myUserConstantNames ) {
     delete [] myUserConstantNames;
     myUserConstantNames = NULL;
   }
-  if( myValueStack ) {
-    delete [] myValueStack;
-    myValueStack = NULL;
-  }
+  freeProgram();
   if( myExpressionList ) {
     delete myExpressionList;
     myExpressionList = NULL;
@@ -73,19 +74,11 @@ bool csEquationSolver::prepare( std::string const& equation, std::string const*
 
   // Preliminary setup of user constant names. These lists will be reduced to the constants that are actually referenced in the equation
   myNumUserConstants  = nConstants;
-  myUserConstants     = new double[myNumUserConstants];
   myUserConstantNames = new std::string[myNumUserConstants];
   for( int i = 0; i < myNumUserConstants; i++ ) {
-    myUserConstants[i] = 0.0;
     myUserConstantNames[i] = toLowerCase( userConstantNames[i] );
   }
 
-  if( userConstants != NULL ) {
-    for( int i = 0; i < myNumUserConstants; i++ ) {
-      myUserConstants[i] = userConstants[i];
-    }
-  }
-
   try {
     csVector<csToken> tokenList;
     tokenizeExpression( expression, tokenList );
@@ -112,6 +105,9 @@ bool csEquationSolver::prepare( std::string const& equation, std::string const*
     myErrorMessage = std::string("Program bug: Unknown exception caught.\nEquation: ") + equation;
     return false;
   }
+  if( userConstants != NULL ) {
+    setUserConstants( userConstants, nConstants );
+  }
   return true;
 }
 //------------------------------------------------------------
@@ -445,17 +441,16 @@ void csEquationSolver::prepareUserConstants( csVector<std::string>* const consta
     }
   }
 
-  if( myUserConstants ) delete [] myUserConstants;
   if( myUserConstantNames ) delete [] myUserConstantNames;
 
   myNumUserConstants = constantList->size();
-  myUserConstants = new double[myNumUserConstants];
   myUserConstantNames = new std::string[myNumUserConstants];
 
   for( int i = 0; i < myNumUserConstants; i++ ) {
-    myUserConstants[i] = 0.0;
     myUserConstantNames[i] = toLowerCase( constantList->at(i) );
   }
+  // User constant indices have changed: Recompile
+  compile();
 }
 
 //--------------------------------------------------------------------------------
@@ -466,102 +461,99 @@ void csEquationSolver::setUserConstants( double const* userConstants, int nConst
   }
   else {
     for( int i = 0; i < myNumUserConstants; i++ ) {
-      myUserConstants[i] = userConstants[i];
+      myRegisters[i] = userConstants[i];
     }
   }
 }
 
 //--------------------------------------------------------------------------------
 //
+inline double csEquationSolver::evaluate( Operation const& op, double arg1, double arg2 ) {
+  switch( op.code ) {
+  case OP_ADD:
+    return arg1 + arg2;
+  case OP_SUB:
+    return arg1 - arg2;
+  case OP_MUL:
+    return arg1 * arg2;
+  case OP_DIV:
+    return arg1 / arg2;
+  case OP_FUNC1:
+    return op.function->method1ArgPtr( arg1 );
+  default:
+    return op.function->method2ArgPtr( arg1, arg2 );
+  }
+}
+
 double csEquationSolver::solve() {
-  int size = myExpressionList->size();
-  //  double result;
-  csToken* tokenArg1Ptr;
-  csToken* tokenOp1Ptr;
-  csToken* tokenOp2Ptr;
-  double arg1, arg2, arg3;
-  csToken token;
-  csToken tokenArgument;
-  tokenArgument.type = NUMBER;
-
-  for( int iex = 0; iex < size; iex++ ) {
-    int nTokens = myExpressionList->at(iex).size();
-    tokenArg1Ptr = &myExpressionList->at(iex).at(0);
-    //    printf("Solve expression: #%d, nTokens: %d\n", iex, nTokens);
+  double* reg = myRegisters;
+  for( int iop = 0; iop < myNumOperations; iop++ ) {
+    Operation const& op = myOperations[iop];
+    reg[op.result] = evaluate( op, reg[op.arg1], reg[op.arg2] );
+  }
+  return reg[myResultRegister];
+}
 
-    if( tokenArg1Ptr->type == FUNCTION ) {
-      arg1 = getValue( &(myExpressionList->at(iex).at(1)) );
-      if( nTokens == 2 ) {
-        //  printf("  input function '%s' %f\n", tokenArg1Ptr->function->name.c_str(), arg1 );
-        arg1 = tokenArg1Ptr->function->method1ArgPtr( arg1 );
-      }
-      
-      else {
-        arg2 = getValue( &(myExpressionList->at(iex).at(2)) );
-        //  printf("  input function '%s' %f %f\n", tokenArg1Ptr->function->name.c_str(), arg1, arg2 );
-        arg1 = tokenArg1Ptr->function->method2ArgPtr( arg1, arg2 );
+//--------------------------------------------------------------------------------
+//
+void csEquationSolver::solve( int numValues, double const* const* userConstants, double* results ) {
+  if( myHasSequentialFunction ) {
+    // Functions with internal state must be called in the same order as in single value mode
+    for( int ival = 0; ival < numValues; ival++ ) {
+      for( int i = 0; i < myNumUserConstants; i++ ) {
+        myRegisters[i] = userConstants[i][ival];
       }
-      //      printf("  function '%s' result: %f\n", tokenArg1Ptr->function->name.c_str(), arg1 );
+      results[ival] = solve();
     }
-    else {
-      arg1 = getValue( tokenArg1Ptr );
-      //      printf("  arg1: %f\n", arg1);
-
-      if( nTokens > 1 ) {
-        int itoken = 1;
-        tokenOp1Ptr = &myExpressionList->at(iex).at(itoken++);
-        arg2 = getValue( &(myExpressionList->at(iex).at(itoken++)) );
-        //  printf("  arg2: %f\n", arg2);
-        while( itoken < nTokens ) {
-          //    cout << "       ***  Keep on solving " << arg1 << " " << arg2 << endl;
-          tokenOp2Ptr = &myExpressionList->at(iex).at(itoken++);
-          arg3 = getValue( &(myExpressionList->at(iex).at(itoken++)) );
-          if( tokenOp1Ptr->type == OPERATOR_PLUS_MINUS ) {
-            if( tokenOp2Ptr->type == OPERATOR_MULT_DIV ) {  // Second operator is */ --> this takes precedence
-              arg2 = (tokenOp2Ptr->valChar == '*') ? arg2*arg3 : arg2/arg3;     
-            }
-            else {  // Both operators are + -
-              // Must solve arg1 & arg2 first in case next operator is */ 
-              arg1 = (tokenOp1Ptr->valChar == '+') ? arg1+arg2 : arg1-arg2;
-              tokenOp1Ptr = tokenOp2Ptr;
-              arg2 = arg3;
-            }
-          }
-          else {   // if( tokenOp1.type == OPERATOR_MULT_DIV ) {
-            // Evaluate arg1 & arg2 --> arg1
-            arg1 = (tokenOp1Ptr->valChar == '*') ? arg1*arg2 : arg1/arg2;
-            tokenOp1Ptr = tokenOp2Ptr;
-            arg2 = arg3;
-          }
-        }  // End while
-        // Final evaluation of arg1 & arg2
-        if( tokenOp1Ptr->type == OPERATOR_PLUS_MINUS ) {
-          arg1 = (tokenOp1Ptr->valChar == '+') ? arg1+arg2 : arg1-arg2;
-        }
-        else {   // if( tokenOp1.type == OPERATOR_MULT_DIV ) {
-          arg1 = (tokenOp1Ptr->valChar == '*') ? arg1*arg2 : arg1/arg2;
-        }
+    return;
+  }
+  if( myBatchRegisters == NULL ) {
+    myBatchRegisters = new double[myNumRegisters*BATCH_SIZE];
+    myBatchArgs      = new double const*[myNumRegisters];
+    for( int ireg = myNumUserConstants; ireg < myNumRegisters; ireg++ ) {
+      double* values = &myBatchRegisters[ireg*BATCH_SIZE];
+      for( int i = 0; i < BATCH_SIZE; i++ ) {
+        values[i] = myRegisters[ireg];
       }
+      myBatchArgs[ireg] = values;
     }
-    myValueStack[iex] = arg1;
-    //        printf("  Stack result arg1: %f\n", arg1);
   }
-  //  printf("  Final result: %f\n", myValueStack[size-1]);
-  return myValueStack[size-1];
-}
-
-//double csEquationSolver::getValue( csToken const& token, double const* myValueStack ) {
-double csEquationSolver::getValue( csToken const* token ) {
-  switch( token->type ) { 
-  case NUMBER:
-    return token->valDouble;
-  case INTERNAL_VAR:
-    return myValueStack[token->valInt];
-  case USER_CONSTANT:
-    return myUserConstants[token->valInt];
-  default:
-    printf("ERROR!\n");
-    return 0.0;
+  for( int valStart = 0; valStart < numValues; valStart += BATCH_SIZE ) {
+    int num = std::min( (int)BATCH_SIZE, numValues - valStart );
+    for( int i = 0; i < myNumUserConstants; i++ ) {
+      myBatchArgs[i] = &userConstants[i][valStart];
+    }
+    for( int iop = 0; iop < myNumOperations; iop++ ) {
+      Operation const& op = myOperations[iop];
+      double* res = &myBatchRegisters[op.result*BATCH_SIZE];
+      double const* arg1 = myBatchArgs[op.arg1];
+      double const* arg2 = myBatchArgs[op.arg2];
+      switch( op.code ) {
+      case OP_ADD:
+        for( int i = 0; i < num; i++ ) res[i] = arg1[i] + arg2[i];
+        break;
+      case OP_SUB:
+        for( int i = 0; i < num; i++ ) res[i] = arg1[i] - arg2[i];
+        break;
+      case OP_MUL:
+        for( int i = 0; i < num; i++ ) res[i] = arg1[i] * arg2[i];
+        break;
+      case OP_DIV:
+        for( int i = 0; i < num; i++ ) res[i] = arg1[i] / arg2[i];
+        break;
+      case OP_FUNC1: {
+        Math1ArgPtr func = op.function->method1ArgPtr;
+        for( int i = 0; i < num; i++ ) res[i] = func( arg1[i] );
+        break;
+      }
+      default: {
+        Math2ArgPtr func = op.function->method2ArgPtr;
+        for( int i = 0; i < num; i++ ) res[i] = func( arg1[i], arg2[i] );
+        break;
+      }
+      }
+    }
+    memcpy( &results[valStart], myBatchArgs[myResultRegister], num*sizeof(double) );
   }
 }
 
@@ -784,7 +776,143 @@ void csEquationSolver::prepareExpressionList( csVector<csToken>& tokenList ) {
     //    if( DEBUG_EQ_SOLVER )   std::cout << endl;
   }
   if( DEBUG_EQ_SOLVER ) std::cout << "-------------------------------------\n";
-  myValueStack = new double[myExpressionList->size()];
+  compile();
+}
+
+//--------------------------------------------------------------------------------
+// Compile expression list into list of register operations
+// Each simple expression is processed exactly as it used to be evaluated token by token: Operators are applied in the
+// same order, so that results are identical. Operations on constant arguments are evaluated here.
+//
+void csEquationSolver::compile() {
+  freeProgram();
+  csVector<Operation> operations;
+  csVector<double> regValues;
+  csVector<int> regIsConst;
+  for( int i = 0; i < myNumUserConstants; i++ ) {
+    regValues.insertEnd( 0.0 );
+    regIsConst.insertEnd( 0 );
+  }
+  int numExpressions = myExpressionList->size();
+  int* expressionRegisters = new int[numExpressions];
+
+  for( int iex = 0; iex < numExpressions; iex++ ) {
+    csVector<csToken> const& expression = myExpressionList->at(iex);
+    int nTokens = expression.size();
+    csToken const* tokenArg1Ptr = &expression.at(0);
+    int arg1;
+    if( tokenArg1Ptr->type == FUNCTION ) {
+      csMathFunction const* function = tokenArg1Ptr->function;
+      arg1 = compileOperand( &expression.at(1), expressionRegisters, &regValues, &regIsConst );
+      if( nTokens == 2 ) {
+        arg1 = compileOperation( OP_FUNC1, function, arg1, arg1, &operations, &regValues, &regIsConst );
+      }
+      else {
+        int arg2 = compileOperand( &expression.at(2), expressionRegisters, &regValues, &regIsConst );
+        arg1 = compileOperation( OP_FUNC2, function, arg1, arg2, &operations, &regValues, &regIsConst );
+      }
+    }
+    else {
+      arg1 = compileOperand( tokenArg1Ptr, expressionRegisters, &regValues, &regIsConst );
+      if( nTokens > 1 ) {
+        int itoken = 1;
+        csToken const* tokenOp1Ptr = &expression.at(itoken++);
+        int arg2 = compileOperand( &expression.at(itoken++), expressionRegisters, &regValues, &regIsConst );
+        while( itoken < nTokens ) {
+          csToken const* tokenOp2Ptr = &expression.at(itoken++);
+          int arg3 = compileOperand( &expression.at(itoken++), expressionRegisters, &regValues, &regIsConst );
+          if( tokenOp1Ptr->type == OPERATOR_PLUS_MINUS && tokenOp2Ptr->type == OPERATOR_MULT_DIV ) {
+            // Second operator is */ --> this takes precedence
+            int code = (tokenOp2Ptr->valChar == '*') ? OP_MUL : OP_DIV;
+            arg2 = compileOperation( code, NULL, arg2, arg3, &operations, &regValues, &regIsConst );
+          }
+          else {
+            int code;
+            if( tokenOp1Ptr->type == OPERATOR_PLUS_MINUS ) code = (tokenOp1Ptr->valChar == '+') ? OP_ADD : OP_SUB;
+            else code = (tokenOp1Ptr->valChar == '*') ? OP_MUL : OP_DIV;
+            arg1 = compileOperation( code, NULL, arg1, arg2, &operations, &regValues, &regIsConst );
+            tokenOp1Ptr = tokenOp2Ptr;
+            arg2 = arg3;
+          }
+        }
+        int code;
+        if( tokenOp1Ptr->type == OPERATOR_PLUS_MINUS ) code = (tokenOp1Ptr->valChar == '+') ? OP_ADD : OP_SUB;
+        else code = (tokenOp1Ptr->valChar == '*') ? OP_MUL : OP_DIV;
+        arg1 = compileOperation( code, NULL, arg1, arg2, &operations, &regValues, &regIsConst );
+      }
+    }
+    expressionRegisters[iex] = arg1;
+  }
+  myResultRegister = expressionRegisters[numExpressions-1];
+  delete [] expressionRegisters;
+
+  myNumRegisters = regValues.size();
+  myRegisters    = new double[myNumRegisters];
+  for( int ireg = 0; ireg < myNumRegisters; ireg++ ) {
+    myRegisters[ireg] = regValues.at(ireg);
+  }
+  myNumOperations = operations.size();
+  myOperations    = new Operation[std::max(myNumOperations,1)];
+  for( int iop = 0; iop < myNumOperations; iop++ ) {
+    myOperations[iop] = operations.at(iop);
+  }
+}
+//--------------------------------------------------------------------------------
+// @return Register holding value of token
+int csEquationSolver::compileOperand( csToken const* token, int const* expressionRegisters, csVector<double>* regValues, csVector<int>* regIsConst ) {
+  switch( token->type ) {
+  case NUMBER:
+    regIsConst->insertEnd( 1 );
+    return( regValues->insertEnd( token->valDouble ) );
+  case INTERNAL_VAR:
+    return expressionRegisters[token->valInt];
+  case USER_CONSTANT:
+    return token->valInt;
+  default:
+    throw( EquationException( std::string("Program bug: Unexpected token in expression.\n"), "" ) );
+  }
+}
+//--------------------------------------------------------------------------------
+// Add operation, or evaluate operation directly if all arguments are constant
+// @return Register holding result
+int csEquationSolver::compileOperation( int code, csMathFunction const* function, int arg1, int arg2,
+                                        csVector<Operation>* operations, csVector<double>* regValues, csVector<int>* regIsConst ) {
+  Operation op;
+  op.code     = code;
+  op.function = function;
+  op.arg1     = arg1;
+  op.arg2     = arg2;
+  bool isSequential = ( function != NULL && function->method1ArgPtr == csMathFunction::RANDOM );
+  if( isSequential ) myHasSequentialFunction = true;
+  if( !isSequential && regIsConst->at(arg1) && regIsConst->at(arg2) ) {
+    regIsConst->insertEnd( 1 );
+    return( regValues->insertEnd( evaluate( op, regValues->at(arg1), regValues->at(arg2) ) ) );
+  }
+  regIsConst->insertEnd( 0 );
+  op.result = regValues->insertEnd( 0.0 );
+  operations->insertEnd( op );
+  return op.result;
+}
+//--------------------------------------------------------------------------------
+//
+void csEquationSolver::freeProgram() {
+  if( myOperations != NULL ) {
+    delete [] myOperations;
+    myOperations = NULL;
+  }
+  if( myRegisters != NULL ) {
+    delete [] myRegisters;
+    myRegisters = NULL;
+  }
+  if( myBatchRegisters != NULL ) {
+    delete [] myBatchRegisters;
+    delete [] myBatchArgs;
+    myBatchRegisters = NULL;
+    myBatchArgs      = NULL;
+  }
+  myNumOperations  = 0;
+  myNumRegisters   = 0;
+  myHasSequentialFunction = false;
 }
 
 
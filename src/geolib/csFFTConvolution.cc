@@ -0,0 +1,109 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csFFTConvolution.h"
+#include "csFFTEngine.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using namespace cseis_geolib;
+
+namespace {
+  /// Cost of one real transform of length N, in units of time domain multiply-adds per N*log2(N). Measured.
+  double const FFT_COST_FACTOR = 1.0;
+  /// Preferred block length in multiples of the filter length
+  int const BLOCK_LENGTH_FACTOR = 4;
+  int const MIN_BLOCK_LENGTH = 64;
+}
+
+csFFTConvolution::csFFTConvolution( float const* filter, int numFilterSamples, int nSampIn ) {
+  myNumSamplesIn     = nSampIn;
+  myNumFilterSamples = numFilterSamples;
+  int numFFTSamples  = blockLength( numFilterSamples, nSampIn );
+  myPlan = csFFTEngine::getPlan( numFFTSamples );
+
+  int numFreq   = numFFTSamples/2 + 1;
+  myFilterReal  = new float[numFreq];
+  myFilterImag  = new float[numFreq];
+  myReal        = new float[numFreq];
+  myImag        = new float[numFreq];
+  myBuffer      = new float[numFFTSamples];
+  myWork        = new float[myPlan->workSize()];
+
+  memcpy( myBuffer, filter, numFilterSamples*sizeof(float) );
+  memset( &myBuffer[numFilterSamples], 0, (numFFTSamples-numFilterSamples)*sizeof(float) );
+  myPlan->realForward( myBuffer, myFilterReal, myFilterImag, myWork );
+  // Normalisation of inverse transform is applied to filter spectrum once
+  float norm = 1.0f / (float)numFFTSamples;
+  for( int i = 0; i < numFreq; i++ ) {
+    myFilterReal[i] *= norm;
+    myFilterImag[i] *= norm;
+  }
+}
+csFFTConvolution::~csFFTConvolution() {
+  delete [] myFilterReal;
+  delete [] myFilterImag;
+  delete [] myReal;
+  delete [] myImag;
+  delete [] myBuffer;
+  delete [] myWork;
+}
+int csFFTConvolution::numFFTSamples() const {
+  return myPlan->numSamples();
+}
+//--------------------------------------------------------------------
+// Even block length: Several times the filter length, but not longer than required for the whole trace
+//
+int csFFTConvolution::blockLength( int numFilterSamples, int nSampIn ) {
+  int length = BLOCK_LENGTH_FACTOR * numFilterSamples;
+  if( length < MIN_BLOCK_LENGTH ) length = MIN_BLOCK_LENGTH;
+  if( length > nSampIn + numFilterSamples - 1 ) length = nSampIn + numFilterSamples - 1;
+  return 2*csFFTEngine::nextSupportedSize( (length+1)/2 );
+}
+//--------------------------------------------------------------------
+void csFFTConvolution::convolve( float const* samplesIn, float* samplesOut, int sampleAtZero ) {
+  int numFFTSamples = myPlan->numSamples();
+  int numFreq       = numFFTSamples/2 + 1;
+  int numOverlap    = myNumFilterSamples - 1;
+  // Number of valid output samples per block
+  int step = numFFTSamples - numOverlap;
+
+  int sampOutEnd = sampleAtZero + myNumSamplesIn;
+  for( int sampOut = sampleAtZero; sampOut < sampOutEnd; sampOut += step ) {
+    // Input block starts numOverlap samples before first output sample. Zero outside of input trace
+    int sampIn    = sampOut - numOverlap;
+    int copyStart = std::max( 0, -sampIn );
+    int copyEnd   = std::min( numFFTSamples, myNumSamplesIn - sampIn );
+    if( copyEnd <= copyStart ) {
+      memset( myBuffer, 0, numFFTSamples*sizeof(float) );
+    }
+    else {
+      memset( myBuffer, 0, copyStart*sizeof(float) );
+      memcpy( &myBuffer[copyStart], &samplesIn[sampIn+copyStart], (copyEnd-copyStart)*sizeof(float) );
+      memset( &myBuffer[copyEnd], 0, (numFFTSamples-copyEnd)*sizeof(float) );
+    }
+    myPlan->realForward( myBuffer, myReal, myImag, myWork );
+    for( int i = 0; i < numFreq; i++ ) {
+      float re = myFilterReal[i]*myReal[i] - myFilterImag[i]*myImag[i];
+      float im = myFilterReal[i]*myImag[i] + myFilterImag[i]*myReal[i];
+      myReal[i] = re;
+      myImag[i] = im;
+    }
+    myPlan->realInverse( myReal, myImag, myBuffer, myWork );
+    // First numOverlap samples of the circular convolution are wrapped around: Discard
+    int numOut = std::min( step, sampOutEnd - sampOut );
+    memcpy( &samplesOut[sampOut-sampleAtZero], &myBuffer[numOverlap], numOut*sizeof(float) );
+  }
+}
+//--------------------------------------------------------------------
+bool csFFTConvolution::isFasterThanTimeDomain( int numFilterSamples, int nSampIn ) {
+  if( nSampIn <= 0 || numFilterSamples <= 1 ) return false;
+  // Time domain: One multiply-add per overlapping sample pair, for each output sample
+  double costTime = (double)nSampIn * (double)std::min( numFilterSamples, nSampIn );
+  int numFFTSamples = blockLength( numFilterSamples, nSampIn );
+  int step = numFFTSamples - (numFilterSamples-1);
+  int numBlocks = (nSampIn + step - 1) / step;
+  double costFFT = (double)numBlocks * 2.0 * FFT_COST_FACTOR * (double)numFFTSamples * log2( (double)numFFTSamples );
+  return( costFFT < costTime );
+}
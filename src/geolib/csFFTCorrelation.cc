@@ -0,0 +1,107 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csFFTCorrelation.h"
+#include "csFFTEngine.h"
+#include <cmath>
+#include <cstring>
+
+using namespace cseis_geolib;
+
+namespace {
+  /// Cost of one real transform of length N, in units of time domain multiply-adds per N*log2(N). Measured.
+  double const FFT_COST_FACTOR = 1.25;
+
+  /// Even transform length (fast real transform) without wrap-around for lags up to maxlag
+  int fftLength( int nSampIn, int maxlag ) {
+    return 2*csFFTEngine::nextSupportedSize( (nSampIn + maxlag + 1)/2 );
+  }
+}
+
+csFFTCorrelation::csFFTCorrelation( int nSampIn, int maxlag ) {
+  myNumSamplesIn = nSampIn;
+  myMaxLag       = maxlag;
+  int numFFTSamples = fftLength( nSampIn, maxlag );
+  myPlan = csFFTEngine::getPlan( numFFTSamples );
+
+  int numFreq  = numFFTSamples/2 + 1;
+  myPilotReal  = new float[numFreq];
+  myPilotImag  = new float[numFreq];
+  myReal       = new float[numFreq];
+  myImag       = new float[numFreq];
+  myBuffer     = new float[numFFTSamples];
+  myWork       = new float[myPlan->workSize()];
+  for( int i = 0; i < numFreq; i++ ) {
+    myPilotReal[i] = 0;
+    myPilotImag[i] = 0;
+  }
+}
+csFFTCorrelation::~csFFTCorrelation() {
+  delete [] myPilotReal;
+  delete [] myPilotImag;
+  delete [] myReal;
+  delete [] myImag;
+  delete [] myBuffer;
+  delete [] myWork;
+}
+int csFFTCorrelation::numFFTSamples() const {
+  return myPlan->numSamples();
+}
+//--------------------------------------------------------------------
+void csFFTCorrelation::setPilot( float const* samplesLeft ) {
+  int numFFTSamples = myPlan->numSamples();
+  memcpy( myBuffer, samplesLeft, myNumSamplesIn*sizeof(float) );
+  memset( &myBuffer[myNumSamplesIn], 0, (numFFTSamples-myNumSamplesIn)*sizeof(float) );
+  myPlan->realForward( myBuffer, myPilotReal, myPilotImag, myWork );
+  // Normalisation of inverse transform is applied to pilot spectrum once
+  float norm = 1.0f / (float)numFFTSamples;
+  int numFreq = numFFTSamples/2 + 1;
+  for( int i = 0; i < numFreq; i++ ) {
+    myPilotReal[i] *= norm;
+    myPilotImag[i] *= norm;
+  }
+}
+//--------------------------------------------------------------------
+void csFFTCorrelation::correlate( float const* samplesRight, float* corr, bool dampen ) {
+  int numFFTSamples = myPlan->numSamples();
+  memcpy( myBuffer, samplesRight, myNumSamplesIn*sizeof(float) );
+  memset( &myBuffer[myNumSamplesIn], 0, (numFFTSamples-myNumSamplesIn)*sizeof(float) );
+  myPlan->realForward( myBuffer, myReal, myImag, myWork );
+
+  // Multiply with complex conjugate of pilot spectrum
+  int numFreq = numFFTSamples/2 + 1;
+  for( int i = 0; i < numFreq; i++ ) {
+    float re = myPilotReal[i]*myReal[i] + myPilotImag[i]*myImag[i];
+    float im = myPilotReal[i]*myImag[i] - myPilotImag[i]*myReal[i];
+    myReal[i] = re;
+    myImag[i] = im;
+  }
+  myPlan->realInverse( myReal, myImag, myBuffer, myWork );
+
+  // Negative lags are found at the end of the circular correlation
+  int maxlag = myMaxLag;
+  for( int ilag = -maxlag; ilag < 0; ilag++ ) {
+    corr[ilag+maxlag] = myBuffer[ilag+numFFTSamples];
+  }
+  memcpy( &corr[maxlag], myBuffer, (maxlag+1)*sizeof(float) );
+
+  if( dampen ) {
+    for( int ilag = -maxlag; ilag <= maxlag; ilag++ ) {
+      int nSamp = myNumSamplesIn - (ilag < 0 ? -ilag : ilag);
+      if( nSamp < 0 ) nSamp = 0;
+      corr[ilag+maxlag] = (float)nSamp * corr[ilag+maxlag] / (float)myNumSamplesIn;
+    }
+  }
+}
+//--------------------------------------------------------------------
+bool csFFTCorrelation::isFasterThanTimeDomain( int nSampIn, int maxlag, bool isPilotCached ) {
+  if( nSampIn <= 0 || maxlag <= 0 ) return false;
+  // Time domain: One multiply-add per overlapping sample pair, for each lag
+  int maxlagOverlap = maxlag < nSampIn ? maxlag : nSampIn-1;
+  double costTime = (double)nSampIn * (double)(2*maxlagOverlap+1) - (double)maxlagOverlap * (double)(maxlagOverlap+1);
+  // Frequency domain: Forward and inverse transform, plus pilot transform if not cached
+  int numFFTSamples = fftLength( nSampIn, maxlag );
+  double numTransforms = isPilotCached ? 2.0 : 3.0;
+  double costFFT = numTransforms * FFT_COST_FACTOR * (double)numFFTSamples * log2( (double)numFFTSamples );
+  return( costFFT < costTime );
+}
@@ -261,7 +261,7 @@ void csFFTDesignature::dump_wavelet( FILE* stream, bool doNormalize ) {
   }
   convertFromAmpPhase( desigAmpFilter, desigPhaseShift );
   // bool success = 
-  fft( csFFTTools::INVERSE, myTwoPowerIn, myBufferReal, myBufferImag, false );
+  transform( csFFTTools::INVERSE, myNumFFTSamplesIn, false );
   double const* real = realData();
   float normScalar = 1.0f;
   if( doNormalize ) normScalar = 1.0f / (float)(myNumFFTSamplesIn/2);
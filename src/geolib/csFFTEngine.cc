@@ -0,0 +1,484 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csFFTEngine.h"
+#include "csException.h"
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <pthread.h>
+
+using namespace cseis_geolib;
+
+namespace cseis_geolib {
+  /**
+   * Cache of FFT plans, shared by all threads. Plans are deleted at program exit
+   */
+  class csFFTPlanCache {
+  public:
+    ~csFFTPlanCache() {
+      for( std::map<int,csFFTEngine*>::iterator it = plans.begin(); it != plans.end(); ++it ) {
+        delete it->second;
+      }
+    }
+    std::map<int,csFFTEngine*> plans;
+  };
+}
+
+namespace {
+  csFFTPlanCache planCache;
+  pthread_mutex_t planCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+  //--------------------------------------------------------------------
+  // SIMD vector types. Butterflies are written once for scalar and vector types.
+  // Vectors are used along the stride of each Stockham stage where data is contiguous.
+  //
+#if defined(__GNUC__)
+  typedef float  vFloat  __attribute__((vector_size(16)));
+  typedef double vDouble __attribute__((vector_size(16)));
+#else
+  typedef float  vFloat;
+  typedef double vDouble;
+#endif
+  template<typename T> struct VectorType { };
+  template<> struct VectorType<float>  { typedef vFloat type; };
+  template<> struct VectorType<double> { typedef vDouble type; };
+
+  template<typename V, typename T> inline V load( T const* ptr ) {
+    V value;
+    memcpy( &value, ptr, sizeof(V) );
+    return value;
+  }
+  template<typename V, typename T> inline void store( T* ptr, V value ) {
+    memcpy( ptr, &value, sizeof(V) );
+  }
+
+  double const COS_72  = cos( 2.0*M_PI/5.0 );
+  double const COS_144 = cos( 4.0*M_PI/5.0 );
+  double const SIN_72  = sin( 2.0*M_PI/5.0 );
+  double const SIN_144 = sin( 4.0*M_PI/5.0 );
+  double const SIN_120 = sin( 2.0*M_PI/3.0 );
+
+  //--------------------------------------------------------------------
+  // Stockham autosort butterflies, decimation in frequency
+  // Stage with radix P, current sub-transform length P*m and stride s:
+  //  a(k) = x[q + s*(pp + k*m)],  k = 0..P-1
+  //  y[q + s*(P*pp + t)] = w(pp)^t * sum_k a(k) exp(-i*2*pi*k*t/P),  t = 0..P-1
+  // Each call computes all indices pp, and values q = qBegin..qEnd-1 in steps of the vector size.
+  // Twiddle factors w(pp)^t are stored at index pp*(P-1)+t-1
+  //
+  template<typename T, typename V>
+  void radix2( T const* xr, T const* xi, T* yr, T* yi, int m, int s, T const* twReal, T const* twImag, int qBegin, int qEnd ) {
+    int const step = sizeof(V)/sizeof(T);
+    for( int pp = 0; pp < m; pp++ ) {
+      T w1r = twReal[pp];
+      T w1i = twImag[pp];
+      int ix0 = s*pp;
+      int ix1 = s*(pp+m);
+      int iy0 = s*2*pp;
+      int iy1 = iy0 + s;
+      for( int q = qBegin; q < qEnd; q += step ) {
+        V ar = load<V>( xr+ix0+q ), ai = load<V>( xi+ix0+q );
+        V br = load<V>( xr+ix1+q ), bi = load<V>( xi+ix1+q );
+        store( yr+iy0+q, ar + br );
+        store( yi+iy0+q, ai + bi );
+        V dr = ar - br;
+        V di = ai - bi;
+        store( yr+iy1+q, dr*w1r - di*w1i );
+        store( yi+iy1+q, dr*w1i + di*w1r );
+      }
+    }
+  }
+  template<typename T, typename V>
+  void radix3( T const* xr, T const* xi, T* yr, T* yi, int m, int s, T const* twReal, T const* twImag, int qBegin, int qEnd ) {
+    int const step = sizeof(V)/sizeof(T);
+    T const sin120 = (T)SIN_120;
+    for( int pp = 0; pp < m; pp++ ) {
+      T w1r = twReal[2*pp],   w1i = twImag[2*pp];
+      T w2r = twReal[2*pp+1], w2i = twImag[2*pp+1];
+      int ix0 = s*pp;
+      int ix1 = ix0 + s*m;
+      int ix2 = ix1 + s*m;
+      int iy0 = s*3*pp;
+      for( int q = qBegin; q < qEnd; q += step ) {
+        V a0r = load<V>( xr+ix0+q ), a0i = load<V>( xi+ix0+q );
+        V a1r = load<V>( xr+ix1+q ), a1i = load<V>( xi+ix1+q );
+        V a2r = load<V>( xr+ix2+q ), a2i = load<V>( xi+ix2+q );
+        V sr = a1r + a2r;
+        V si = a1i + a2i;
+        store( yr+iy0+q, a0r + sr );
+        store( yi+iy0+q, a0i + si );
+        V tr = a0r - sr*(T)0.5;
+        V ti = a0i - si*(T)0.5;
+        // -i*sin120*(a1-a2)
+        V ur = (a1i - a2i)*sin120;
+        V ui = (a2r - a1r)*sin120;
+        V b1r = tr + ur, b1i = ti + ui;
+        V b2r = tr - ur, b2i = ti - ui;
+        store( yr+iy0+s+q,   b1r*w1r - b1i*w1i );
+        store( yi+iy0+s+q,   b1r*w1i + b1i*w1r );
+        store( yr+iy0+2*s+q, b2r*w2r - b2i*w2i );
+        store( yi+iy0+2*s+q, b2r*w2i + b2i*w2r );
+      }
+    }
+  }
+  template<typename T, typename V>
+  void radix4( T const* xr, T const* xi, T* yr, T* yi, int m, int s, T const* twReal, T const* twImag, int qBegin, int qEnd ) {
+    int const step = sizeof(V)/sizeof(T);
+    for( int pp = 0; pp < m; pp++ ) {
+      T w1r = twReal[3*pp],   w1i = twImag[3*pp];
+      T w2r = twReal[3*pp+1], w2i = twImag[3*pp+1];
+      T w3r = twReal[3*pp+2], w3i = twImag[3*pp+2];
+      int ix0 = s*pp;
+      int ix1 = ix0 + s*m;
+      int ix2 = ix1 + s*m;
+      int ix3 = ix2 + s*m;
+      int iy0 = s*4*pp;
+      for( int q = qBegin; q < qEnd; q += step ) {
+        V a0r = load<V>( xr+ix0+q ), a0i = load<V>( xi+ix0+q );
+        V a1r = load<V>( xr+ix1+q ), a1i = load<V>( xi+ix1+q );
+        V a2r = load<V>( xr+ix2+q ), a2i = load<V>( xi+ix2+q );
+        V a3r = load<V>( xr+ix3+q ), a3i = load<V>( xi+ix3+q );
+        V s02r = a0r + a2r, s02i = a0i + a2i;
+        V d02r = a0r - a2r, d02i = a0i - a2i;
+        V s13r = a1r + a3r, s13i = a1i + a3i;
+        // -i*(a1-a3)
+        V d13r = a1i - a3i, d13i = a3r - a1r;
+        store( yr+iy0+q, s02r + s13r );
+        store( yi+iy0+q, s02i + s13i );
+        V b1r = d02r + d13r, b1i = d02i + d13i;
+        V b2r = s02r - s13r, b2i = s02i - s13i;
+        V b3r = d02r - d13r, b3i = d02i - d13i;
+        store( yr+iy0+s+q,   b1r*w1r - b1i*w1i );
+        store( yi+iy0+s+q,   b1r*w1i + b1i*w1r );
+        store( yr+iy0+2*s+q, b2r*w2r - b2i*w2i );
+        store( yi+iy0+2*s+q, b2r*w2i + b2i*w2r );
+        store( yr+iy0+3*s+q, b3r*w3r - b3i*w3i );
+        store( yi+iy0+3*s+q, b3r*w3i + b3i*w3r );
+      }
+    }
+  }
+  template<typename T, typename V>
+  void radix5( T const* xr, T const* xi, T* yr, T* yi, int m, int s, T const* twReal, T const* twImag, int qBegin, int qEnd ) {
+    int const step = sizeof(V)/sizeof(T);
+    T const c1 = (T)COS_72;
+    T const c2 = (T)COS_144;
+    T const s1 = (T)SIN_72;
+    T const s2 = (T)SIN_144;
+    for( int pp = 0; pp < m; pp++ ) {
+      T const* twr = &twReal[4*pp];
+      T const* twi = &twImag[4*pp];
+      int ix0 = s*pp;
+      int ix1 = ix0 + s*m;
+      int ix2 = ix1 + s*m;
+      int ix3 = ix2 + s*m;
+      int ix4 = ix3 + s*m;
+      int iy0 = s*5*pp;
+      for( int q = qBegin; q < qEnd; q += step ) {
+        V a0r = load<V>( xr+ix0+q ), a0i = load<V>( xi+ix0+q );
+        V a1r = load<V>( xr+ix1+q ), a1i = load<V>( xi+ix1+q );
+        V a2r = load<V>( xr+ix2+q ), a2i = load<V>( xi+ix2+q );
+        V a3r = load<V>( xr+ix3+q ), a3i = load<V>( xi+ix3+q );
+        V a4r = load<V>( xr+ix4+q ), a4i = load<V>( xi+ix4+q );
+        V t1r = a1r + a4r, t1i = a1i + a4i;
+        V t2r = a2r + a3r, t2i = a2i + a3i;
+        V t3r = a1r - a4r, t3i = a1i - a4i;
+        V t4r = a2r - a3r, t4i = a2i - a3i;
+        store( yr+iy0+q, a0r + t1r + t2r );
+        store( yi+iy0+q, a0i + t1i + t2i );
+        V e1r = a0r + t1r*c1 + t2r*c2, e1i = a0i + t1i*c1 + t2i*c2;
+        V e2r = a0r + t1r*c2 + t2r*c1, e2i = a0i + t1i*c2 + t2i*c1;
+        // -i*(s1*t3 + s2*t4) and -i*(s2*t3 - s1*t4)
+        V f1r = t3i*s1 + t4i*s2, f1i = -(t3r*s1 + t4r*s2);
+        V f2r = t3i*s2 - t4i*s1, f2i = -(t3r*s2 - t4r*s1);
+        V b[8] = { e1r + f1r, e1i + f1i,  e2r + f2r, e2i + f2i,  e2r - f2r, e2i - f2i,  e1r - f1r, e1i - f1i };
+        for( int t = 1; t < 5; t++ ) {
+          V br = b[2*t-2];
+          V bi = b[2*t-1];
+          store( yr+iy0+t*s+q, br*twr[t-1] - bi*twi[t-1] );
+          store( yi+iy0+t*s+q, br*twi[t-1] + bi*twr[t-1] );
+        }
+      }
+    }
+  }
+
+  template<typename T, typename V>
+  void stage( int radix, T const* xr, T const* xi, T* yr, T* yi, int m, int s, T const* twReal, T const* twImag, int qBegin, int qEnd ) {
+    switch( radix ) {
+    case 2:
+      radix2<T,V>( xr, xi, yr, yi, m, s, twReal, twImag, qBegin, qEnd );
+      break;
+    case 3:
+      radix3<T,V>( xr, xi, yr, yi, m, s, twReal, twImag, qBegin, qEnd );
+      break;
+    case 4:
+      radix4<T,V>( xr, xi, yr, yi, m, s, twReal, twImag, qBegin, qEnd );
+      break;
+    case 5:
+      radix5<T,V>( xr, xi, yr, yi, m, s, twReal, twImag, qBegin, qEnd );
+      break;
+    }
+  }
+}
+
+//--------------------------------------------------------------------
+// Plan creation & cache
+//
+bool csFFTEngine::isSupportedSize( int numSamples ) {
+  if( numSamples < 1 ) return false;
+  int factors[3] = { 2, 3, 5 };
+  for( int i = 0; i < 3; i++ ) {
+    while( numSamples % factors[i] == 0 ) numSamples /= factors[i];
+  }
+  return( numSamples == 1 );
+}
+int csFFTEngine::nextSupportedSize( int numSamples ) {
+  if( numSamples < 1 ) return 1;
+  while( !isSupportedSize( numSamples ) ) numSamples += 1;
+  return numSamples;
+}
+csFFTEngine const* csFFTEngine::getPlan( int numSamples ) {
+  if( !isSupportedSize( numSamples ) ) {
+    throw( csException("csFFTEngine: Unsupported FFT length %d. Length must be a product of powers of 2, 3 and 5", numSamples) );
+  }
+  pthread_mutex_lock( &planCacheMutex );
+  csFFTEngine const* plan = getPlanLocked( numSamples );
+  pthread_mutex_unlock( &planCacheMutex );
+  return plan;
+}
+csFFTEngine const* csFFTEngine::getPlanLocked( int numSamples ) {
+  std::map<int,csFFTEngine*>::iterator it = planCache.plans.find( numSamples );
+  if( it != planCache.plans.end() ) return it->second;
+  csFFTEngine* plan = new csFFTEngine( numSamples );
+  if( numSamples % 2 == 0 ) {
+    plan->myHalfPlan = getPlanLocked( numSamples/2 );
+  }
+  planCache.plans[numSamples] = plan;
+  return plan;
+}
+
+csFFTEngine::csFFTEngine( int numSamples ) {
+  myNumSamples = numSamples;
+  myHalfPlan = NULL;
+
+  // Factorize: Radix 4 first, then 2, 3, 5
+  int radix[64];
+  myNumStages = 0;
+  int n = numSamples;
+  while( n % 4 == 0 ) { radix[myNumStages++] = 4; n /= 4; }
+  while( n % 2 == 0 ) { radix[myNumStages++] = 2; n /= 2; }
+  while( n % 3 == 0 ) { radix[myNumStages++] = 3; n /= 3; }
+  while( n % 5 == 0 ) { radix[myNumStages++] = 5; n /= 5; }
+
+  myRadix        = new int[myNumStages+1];
+  myTwiddleIndex = new int[myNumStages+1];
+  int numTwiddles = 0;
+  n = numSamples;
+  for( int istage = 0; istage < myNumStages; istage++ ) {
+    myRadix[istage] = radix[istage];
+    myTwiddleIndex[istage] = numTwiddles;
+    numTwiddles += n - n/radix[istage];
+    n /= radix[istage];
+  }
+  myTwiddleIndex[myNumStages] = numTwiddles;
+
+  myTwiddleRealD = new double[numTwiddles+1];
+  myTwiddleImagD = new double[numTwiddles+1];
+  myTwiddleRealF = new float[numTwiddles+1];
+  myTwiddleImagF = new float[numTwiddles+1];
+  n = numSamples;
+  for( int istage = 0; istage < myNumStages; istage++ ) {
+    int p = myRadix[istage];
+    int m = n / p;
+    for( int pp = 0; pp < m; pp++ ) {
+      for( int t = 1; t < p; t++ ) {
+        int index = myTwiddleIndex[istage] + pp*(p-1) + t-1;
+        double phase = -2.0 * M_PI * (double)(pp*t) / (double)n;
+        myTwiddleRealD[index] = cos( phase );
+        myTwiddleImagD[index] = sin( phase );
+        myTwiddleRealF[index] = (float)myTwiddleRealD[index];
+        myTwiddleImagF[index] = (float)myTwiddleImagD[index];
+      }
+    }
+    n = m;
+  }
+
+  int numHalf = numSamples/2 + 1;
+  myTwiddleRealHalfD = new double[numHalf];
+  myTwiddleImagHalfD = new double[numHalf];
+  myTwiddleRealHalfF = new float[numHalf];
+  myTwiddleImagHalfF = new float[numHalf];
+  for( int k = 0; k < numHalf; k++ ) {
+    double phase = -2.0 * M_PI * (double)k / (double)numSamples;
+    myTwiddleRealHalfD[k] = cos( phase );
+    myTwiddleImagHalfD[k] = sin( phase );
+    myTwiddleRealHalfF[k] = (float)myTwiddleRealHalfD[k];
+    myTwiddleImagHalfF[k] = (float)myTwiddleImagHalfD[k];
+  }
+}
+csFFTEngine::~csFFTEngine() {
+  delete [] myRadix;
+  delete [] myTwiddleIndex;
+  delete [] myTwiddleRealD;
+  delete [] myTwiddleImagD;
+  delete [] myTwiddleRealF;
+  delete [] myTwiddleImagF;
+  delete [] myTwiddleRealHalfD;
+  delete [] myTwiddleImagHalfD;
+  delete [] myTwiddleRealHalfF;
+  delete [] myTwiddleImagHalfF;
+}
+void csFFTEngine::getTwiddles( float const** twReal, float const** twImag, float const** twRealHalf, float const** twImagHalf ) const {
+  *twReal = myTwiddleRealF;
+  *twImag = myTwiddleImagF;
+  *twRealHalf = myTwiddleRealHalfF;
+  *twImagHalf = myTwiddleImagHalfF;
+}
+void csFFTEngine::getTwiddles( double const** twReal, double const** twImag, double const** twRealHalf, double const** twImagHalf ) const {
+  *twReal = myTwiddleRealD;
+  *twImag = myTwiddleImagD;
+  *twRealHalf = myTwiddleRealHalfD;
+  *twImagHalf = myTwiddleImagHalfD;
+}
+
+//--------------------------------------------------------------------
+// Transforms
+//
+template<typename T> void csFFTEngine::transform( T* real, T* imag, T* work ) const {
+  typedef typename VectorType<T>::type V;
+  int const vectorSize = sizeof(V)/sizeof(T);
+  T const* twReal;
+  T const* twImag;
+  T const* dummyReal;
+  T const* dummyImag;
+  getTwiddles( &twReal, &twImag, &dummyReal, &dummyImag );
+
+  T* xr = real;
+  T* xi = imag;
+  T* yr = work;
+  T* yi = work + myNumSamples;
+  int n = myNumSamples;
+  int s = 1;
+  for( int istage = 0; istage < myNumStages; istage++ ) {
+    int p = myRadix[istage];
+    int m = n / p;
+    int sVector = s - s % vectorSize;
+    T const* twr = &twReal[myTwiddleIndex[istage]];
+    T const* twi = &twImag[myTwiddleIndex[istage]];
+    if( sVector > 0 ) stage<T,V>( p, xr, xi, yr, yi, m, s, twr, twi, 0, sVector );
+    if( sVector < s ) stage<T,T>( p, xr, xi, yr, yi, m, s, twr, twi, sVector, s );
+    T* tmp = xr; xr = yr; yr = tmp;
+    tmp = xi; xi = yi; yi = tmp;
+    n = m;
+    s *= p;
+  }
+  if( xr != real ) {
+    memcpy( real, xr, myNumSamples*sizeof(T) );
+    memcpy( imag, xi, myNumSamples*sizeof(T) );
+  }
+}
+void csFFTEngine::complexTransform( int dir, float* real, float* imag, float* work ) const {
+  // Inverse transform: Swapping real and imaginary part is the same as conjugating input and output
+  if( dir == FORWARD ) transform( real, imag, work );
+  else transform( imag, real, work );
+}
+void csFFTEngine::complexTransform( int dir, double* real, double* imag, double* work ) const {
+  if( dir == FORWARD ) transform( real, imag, work );
+  else transform( imag, real, work );
+}
+
+//--------------------------------------------------------------------
+// Real transform of length N=2*H: z(j) = x(2j) + i*x(2j+1), Z = FFT_H(z)
+//  X(k) = E(k) + W^k*O(k),  E(k) = (Z(k) + Z*(H-k))/2,  O(k) = -i*(Z(k) - Z*(H-k))/2,  W = exp(-i*2*pi/N)
+//
+template<typename T> void csFFTEngine::realForwardT( T const* samples, T* real, T* imag, T* work ) const {
+  int numHalf = myNumSamples/2;
+  if( myHalfPlan == NULL ) {
+    // Odd length: Complex transform with zero imaginary part
+    T* xr = work;
+    T* xi = work + myNumSamples;
+    memcpy( xr, samples, myNumSamples*sizeof(T) );
+    memset( xi, 0, myNumSamples*sizeof(T) );
+    transform( xr, xi, work + 2*myNumSamples );
+    memcpy( real, xr, (numHalf+1)*sizeof(T) );
+    memcpy( imag, xi, (numHalf+1)*sizeof(T) );
+    return;
+  }
+  T const* dummyReal;
+  T const* dummyImag;
+  T const* wReal;
+  T const* wImag;
+  getTwiddles( &dummyReal, &dummyImag, &wReal, &wImag );
+
+  T* zr = work;
+  T* zi = work + numHalf;
+  for( int j = 0; j < numHalf; j++ ) {
+    zr[j] = samples[2*j];
+    zi[j] = samples[2*j+1];
+  }
+  myHalfPlan->transform( zr, zi, work + 2*numHalf );
+  for( int k = 0; k <= numHalf; k++ ) {
+    int k1 = ( k < numHalf ) ? k : 0;
+    int k2 = ( k > 0 ) ? numHalf-k : 0;
+    T er = (T)0.5 * ( zr[k1] + zr[k2] );
+    T ei = (T)0.5 * ( zi[k1] - zi[k2] );
+    T orr = (T)0.5 * ( zi[k1] + zi[k2] );
+    T oi  = (T)0.5 * ( zr[k2] - zr[k1] );
+    real[k] = er + wReal[k]*orr - wImag[k]*oi;
+    imag[k] = ei + wReal[k]*oi + wImag[k]*orr;
+  }
+}
+template<typename T> void csFFTEngine::realInverseT( T const* real, T const* imag, T* samples, T* work ) const {
+  int numHalf = myNumSamples/2;
+  if( myHalfPlan == NULL ) {
+    T* xr = work;
+    T* xi = work + myNumSamples;
+    xr[0] = real[0];
+    xi[0] = 0;
+    for( int k = 1; k <= numHalf; k++ ) {
+      xr[k] = real[k];
+      xi[k] = imag[k];
+      xr[myNumSamples-k] = real[k];
+      xi[myNumSamples-k] = -imag[k];
+    }
+    transform( xi, xr, work + 2*myNumSamples );
+    memcpy( samples, xr, myNumSamples*sizeof(T) );
+    return;
+  }
+  T const* dummyReal;
+  T const* dummyImag;
+  T const* wReal;
+  T const* wImag;
+  getTwiddles( &dummyReal, &dummyImag, &wReal, &wImag );
+
+  // Z(k) = E(k) + i*O(k),  E(k) = X(k) + X*(H-k),  O(k) = (X(k) - X*(H-k)) * W^-k
+  T* zr = work;
+  T* zi = work + numHalf;
+  for( int k = 0; k < numHalf; k++ ) {
+    T er = real[k] + real[numHalf-k];
+    T ei = imag[k] - imag[numHalf-k];
+    T dr = real[k] - real[numHalf-k];
+    T di = imag[k] + imag[numHalf-k];
+    T orr = dr*wReal[k] + di*wImag[k];
+    T oi  = di*wReal[k] - dr*wImag[k];
+    zr[k] = er - oi;
+    zi[k] = ei + orr;
+  }
+  myHalfPlan->transform( zi, zr, work + 2*numHalf );
+  for( int j = 0; j < numHalf; j++ ) {
+    samples[2*j]   = zr[j];
+    samples[2*j+1] = zi[j];
+  }
+}
+void csFFTEngine::realForward( float const* samples, float* real, float* imag, float* work ) const {
+  realForwardT( samples, real, imag, work );
+}
+void csFFTEngine::realForward( double const* samples, double* real, double* imag, double* work ) const {
+  realForwardT( samples, real, imag, work );
+}
+void csFFTEngine::realInverse( float const* real, float const* imag, float* samples, float* work ) const {
+  realInverseT( real, imag, samples, work );
+}
+void csFFTEngine::realInverse( double const* real, double const* imag, double* samples, double* work ) const {
+  realInverseT( real, imag, samples, work );
+}
@@ -2,6 +2,7 @@
 /* All rights reserved.                       */
 
 #include "csFFTTools.h"
+#include "csFFTEngine.h"
 #include "csException.h"
 #include "geolib_math.h"
 #include "geolib_defines.h"
@@ -46,6 +47,27 @@ csFFTTools::csFFTTools( int theNumSamplesIn, int theNumSamplesOut, float theSamp
 
   init();
 }
+
+csFFTTools::csFFTTools( csFFTTools const& obj ) {
+  myNumSamplesIn  = obj.myNumSamplesIn;
+  mySampleIntIn   = obj.mySampleIntIn;
+  myNumSamplesOut = obj.myNumSamplesOut;
+  mySampleIntOut  = obj.mySampleIntOut;
+
+  init();
+
+  myOrder        = obj.myOrder;
+  myCutOffFreqHz = obj.myCutOffFreqHz;
+  myOutputImpulseResponse = obj.myOutputImpulseResponse;
+  if( obj.myNotchFilter != NULL ) {
+    myNotchFilter = new double[myNumFFTSamplesIn];
+    memcpy( myNotchFilter, obj.myNotchFilter, myNumFFTSamplesIn*sizeof(double) );
+  }
+  if( obj.myIsFilterWavelet ) {
+    setFilterWavelet( obj.myLengthFilterWavelet );
+    memcpy( myFilterWavelet, obj.myFilterWavelet, myLengthFilterWavelet*sizeof(double) );
+  }
+}
 //--------------------------------------------------------------------------------
 //
 //
@@ -74,6 +96,11 @@ void csFFTTools::init() {
   myBufferImag = new double[myNumFFTSamplesIn];
   myNotchFilter = NULL;
 
+  myFFTPlanIn  = csFFTEngine::getPlan( myNumFFTSamplesIn );
+  myFFTPlanOut = csFFTEngine::getPlan( myNumFFTSamplesOut );
+  int numSamplesMax = std::max( myNumFFTSamplesIn, myNumFFTSamplesOut );
+  myFFTWorkBuffer = new float[7*numSamplesMax+2];
+
   myOutputImpulseResponse = false;
 }
 
@@ -89,7 +116,7 @@ csFFTTools::~csFFTTools() {
     delete [] myBufferImag;
     myBufferImag = NULL;
   }
-  if( myNotchFilter == NULL ) {
+  if( myNotchFilter != NULL ) {
     delete []   myNotchFilter;
     myNotchFilter = NULL;
   }
@@ -98,6 +125,10 @@ csFFTTools::~csFFTTools() {
     delete [] myFilterWavelet;
     myFilterWavelet = NULL;
   }
+  if( myFFTWorkBuffer != NULL ) {
+    delete [] myFFTWorkBuffer;
+    myFFTWorkBuffer = NULL;
+  }
 }
 //--------------------------------------------------------------------------------
 //
@@ -118,7 +149,7 @@ void csFFTTools::setFilterWavelet( int length ) {
 //--------------------------------------------------------------------------------
 bool csFFTTools::fft_forward( float const* samples, bool doNormalisation ) {
   setBuffer( samples );
-  return csFFTTools::fft( csFFTTools::FORWARD, myTwoPowerIn, myBufferReal, myBufferImag, doNormalisation );
+  return transform( csFFTTools::FORWARD, myNumFFTSamplesIn, doNormalisation );
 }
 //--------------------------------------------------------------------------------
 bool csFFTTools::fft_forward( float const* samples, float* ampSpec, bool doNormalisation ) {
@@ -126,7 +157,7 @@ bool csFFTTools::fft_forward( float const* samples, float* ampSpec, bool doNorma
 }
 bool csFFTTools::fft_forward( float const* samples, float* ampSpec, float* phaseSpec, bool doNormalisation ) {
   setBuffer( samples );
-  bool success = csFFTTools::fft( csFFTTools::FORWARD, myTwoPowerIn, myBufferReal, myBufferImag, doNormalisation );
+  bool success = transform( csFFTTools::FORWARD, myNumFFTSamplesIn, doNormalisation );
   if( !success ) return false;
   
   convertToAmpPhase( ampSpec, phaseSpec );
@@ -167,7 +198,7 @@ void csFFTTools::convertFromAmpPhase( float const* ampSpec, float const* phaseSp
 //--------------------------------------------------------------------------------
 //
 bool csFFTTools::fft_inverse( bool doNormalisation ) {
-  return csFFTTools::fft( csFFTTools::INVERSE, myTwoPowerIn, myBufferReal, myBufferImag, doNormalisation );
+  return transform( csFFTTools::INVERSE, myNumFFTSamplesIn, doNormalisation );
 }
 bool csFFTTools::fft_inverse( float const* samples, int fftDataType, bool doNormalisation ) {
   if( fftDataType == FX_REAL_IMAG ) {
@@ -184,12 +215,12 @@ bool csFFTTools::fft_inverse( float const* samples, int fftDataType, bool doNorm
     // ...just use currently stored real/imag buffers for inverse FFT
 //    return false;
   }
-  return csFFTTools::fft( csFFTTools::INVERSE, myTwoPowerIn, myBufferReal, myBufferImag, doNormalisation );
+  return transform( csFFTTools::INVERSE, myNumFFTSamplesIn, doNormalisation );
 }
 
 bool csFFTTools::fft_inverse( float const* ampSpec, float const* phaseSpec, bool doNormalisation ) {
   convertFromAmpPhase( ampSpec, phaseSpec );
-  return csFFTTools::fft( csFFTTools::INVERSE, myTwoPowerIn, myBufferReal, myBufferImag, doNormalisation );
+  return transform( csFFTTools::INVERSE, myNumFFTSamplesIn, doNormalisation );
 }
 //--------------------------------------------------------------------------------
 //
@@ -215,7 +246,7 @@ void csFFTTools::highPass( float* samples, float order, float cutOffFreqHz, bool
 void csFFTTools::notchFilter( float* samples, bool addNoise ) {
 
   setBuffer( samples );
-  if( !csFFTTools::fft( csFFTTools::FORWARD, myTwoPowerIn, myBufferReal, myBufferImag, false ) ) {
+  if( !transform( csFFTTools::FORWARD, myNumFFTSamplesIn, false ) ) {
     delete [] myBufferReal;
     delete [] myBufferImag;
     throw( csException("csFFTTools::notchFilter(): Unknown error occurred during forward FFT transform.") );
@@ -255,7 +286,7 @@ void csFFTTools::notchFilter( float* samples, bool addNoise ) {
     myBufferImag[is] *= myNotchFilter[is];
   }
 
-  if( !csFFTTools::fft( csFFTTools::INVERSE, myTwoPowerOut, myBufferReal, myBufferImag, true ) ) {
+  if( !transform( csFFTTools::INVERSE, myNumFFTSamplesOut, true ) ) {
     delete [] myBufferReal;
     delete [] myBufferImag;
     myBufferReal = NULL;
@@ -427,7 +458,7 @@ float csFFTTools::resample( float* samples, float order, float cutOffFreqHz, boo
   float rmsOut = 1.0;
   if( applyNorm ) rmsIn = compute_rms( samples, myNumSamplesIn );
 
-  if( !csFFTTools::fft( csFFTTools::FORWARD, myTwoPowerIn, myBufferReal, myBufferImag, false ) ) {
+  if( !transform( csFFTTools::FORWARD, myNumFFTSamplesIn, false ) ) {
     delete [] myBufferReal;
     delete [] myBufferImag;
     throw( csException("csFFTTools::filter(): Unknown error occurred during forward FFT transform.") );
@@ -465,7 +496,7 @@ float csFFTTools::resample( float* samples, float order, float cutOffFreqHz, boo
     }
   }
 
-  if( !csFFTTools::fft( csFFTTools::INVERSE, myTwoPowerOut, myBufferReal, myBufferImag, true ) ) {
+  if( !transform( csFFTTools::INVERSE, myNumFFTSamplesOut, true ) ) {
     delete [] myBufferReal;
     delete [] myBufferImag;
     throw( csException("filter: Unknown error occurred during inverse FFT transform.") );
@@ -494,7 +525,7 @@ float csFFTTools::resample( float* samples, float order, float cutOffFreqHz, boo
 void csFFTTools::filter( float* samples, int filterType ) {
   setBuffer( samples );
 
-  if( !csFFTTools::fft( csFFTTools::FORWARD, myTwoPowerIn, myBufferReal, myBufferImag, false ) ) {
+  if( !transform( csFFTTools::FORWARD, myNumFFTSamplesIn, false ) ) {
     delete [] myBufferReal;
     delete [] myBufferImag;
     throw( csException("csFFTTools::filter(): Unknown error occurred during forward FFT transform.") );
@@ -597,7 +628,7 @@ void csFFTTools::filter( float* samples, int filterType ) {
     //
   }
 
-  if( !csFFTTools::fft( csFFTTools::INVERSE, myTwoPowerOut, myBufferReal, myBufferImag, true ) ) {
+  if( !transform( csFFTTools::INVERSE, myNumFFTSamplesOut, true ) ) {
     delete [] myBufferReal;
     delete [] myBufferImag;
     myBufferReal = NULL;
@@ -614,14 +645,14 @@ void csFFTTools::filter( float* samples, int filterType ) {
 /*void csFFTTools::applyQCompensation( float* samples, float qvalue, float freqRef, bool applyAmp, bool applyPhase ) {
   setBuffer( samples );
 
-  if( !csFFTTools::fft( csFFTTools::FORWARD, myTwoPowerIn, myBufferReal, myBufferImag, false ) ) {
+  if( !transform( csFFTTools::FORWARD, myNumFFTSamplesIn, false ) ) {
     delete [] myBufferReal;
     delete [] myBufferImag;
     throw( csException("csFFTTools::applyQCompensation(): Unknown error occurred during forward FFT transform.") );
   }
 
 
-  if( !csFFTTools::fft( csFFTTools::INVERSE, myTwoPowerOut, myBufferReal, myBufferImag, true ) ) {
+  if( !transform( csFFTTools::INVERSE, myNumFFTSamplesOut, true ) ) {
     delete [] myBufferReal;
     delete [] myBufferImag;
     throw( csException("filter: Unknown error occurred during inverse FFT transform.") );
@@ -659,6 +690,78 @@ void csFFTTools::setBuffer( float const* samples ) {
 }
 
 
+//--------------------------------------------------------------------------------
+// Transform data in real/imag buffers
+// Real input data (forward) and Hermitian spectra (inverse) are transformed by real-to-complex transforms,
+// which give the same result as the complex transform at half the cost.
+//
+bool csFFTTools::transform( int dir, int numFFTSamples, bool doNormalisation ) {
+  csFFTEngine const* plan = ( numFFTSamples == myNumFFTSamplesIn ) ? myFFTPlanIn : myFFTPlanOut;
+  int numHalf = numFFTSamples/2;
+  float* work = myFFTWorkBuffer;
+  float* real = &myFFTWorkBuffer[plan->workSize()];
+  float* imag = &real[numFFTSamples];
+  float* samples = &imag[numFFTSamples];
+  double scalar = doNormalisation ? 1.0/(double)numFFTSamples : 1.0;
+
+  if( dir == csFFTTools::FORWARD ) {
+    bool isReal = true;
+    for( int i = 0; i < numFFTSamples; i++ ) {
+      if( myBufferImag[i] != 0.0 ) {
+        isReal = false;
+        break;
+      }
+    }
+    if( isReal ) {
+      for( int i = 0; i < numFFTSamples; i++ ) {
+        samples[i] = (float)myBufferReal[i];
+      }
+      plan->realForward( samples, real, imag, work );
+      for( int i = 0; i <= numHalf; i++ ) {
+        myBufferReal[i] = scalar * real[i];
+        myBufferImag[i] = scalar * imag[i];
+      }
+      // Negative frequencies: Complex conjugate of positive frequencies
+      for( int i = numHalf+1; i < numFFTSamples; i++ ) {
+        myBufferReal[i] = myBufferReal[numFFTSamples-i];
+        myBufferImag[i] = -myBufferImag[numFFTSamples-i];
+      }
+      return true;
+    }
+  }
+  else {
+    bool isHermitian = ( myBufferImag[0] == 0.0 && ( numFFTSamples % 2 != 0 || myBufferImag[numHalf] == 0.0 ) );
+    for( int i = 1; i < (numFFTSamples+1)/2 && isHermitian; i++ ) {
+      isHermitian = ( myBufferReal[numFFTSamples-i] == myBufferReal[i] && myBufferImag[numFFTSamples-i] == -myBufferImag[i] );
+    }
+    if( isHermitian ) {
+      for( int i = 0; i <= numHalf; i++ ) {
+        real[i] = (float)myBufferReal[i];
+        imag[i] = (float)myBufferImag[i];
+      }
+      plan->realInverse( real, imag, samples, work );
+      for( int i = 0; i < numFFTSamples; i++ ) {
+        myBufferReal[i] = scalar * samples[i];
+        myBufferImag[i] = 0.0;
+      }
+      return true;
+    }
+  }
+
+  // General case: Complex transform
+  for( int i = 0; i < numFFTSamples; i++ ) {
+    real[i] = (float)myBufferReal[i];
+    imag[i] = (float)myBufferImag[i];
+  }
+  plan->complexTransform( dir == csFFTTools::FORWARD ? csFFTEngine::FORWARD : csFFTEngine::INVERSE, real, imag, work );
+  for( int i = 0; i < numFFTSamples; i++ ) {
+    myBufferReal[i] = scalar * real[i];
+    myBufferImag[i] = scalar * imag[i];
+  }
+  return true;
+}
+
+
 bool csFFTTools::Powerof2( int numFFTSamplesX, int* m, int* twopm ) {
   int value = numFFTSamplesX;
   *m = 0;
@@ -700,72 +803,20 @@ bool csFFTTools::Powerof2( int numFFTSamplesX, int* m, int* twopm ) {
 //}
 bool csFFTTools::fft( int dir, int power_of_two, double *realValues, double *imagValues, bool doNormalisation )
 {
-   long nn,i,i1,j,k,i2,l,l1,l2;
-   double c1,c2,tx,ty,t1,t2,u1,u2,z;
-
-   /* Calculate the number of points */
-   nn = 1;
-   for (i=0;i<power_of_two;i++)
-      nn *= 2;
-
-   /* Do the bit reversal */
-   i2 = nn >> 1;
-   j = 0;
-   for (i=0;i<nn-1;i++) {
-      if (i < j) {
-         tx = realValues[i];
-         ty = imagValues[i];
-         realValues[i] = realValues[j];
-         imagValues[i] = imagValues[j];
-         realValues[j] = tx;
-         imagValues[j] = ty;
-      }
-      k = i2;
-      while (k <= j) {
-         j -= k;
-         k >>= 1;
-      }
-      j += k;
-   }
-
-   /* Compute the FFT */
-   c1 = -1.0;
-   c2 = 0.0;
-   l2 = 1;
-   for (l=0;l<power_of_two;l++) {
-      l1 = l2;
-      l2 <<= 1;
-      u1 = 1.0;
-      u2 = 0.0;
-      for (j=0;j<l1;j++) {
-         for (i=j;i<nn;i+=l2) {
-            i1 = i + l1;
-            t1 = u1 * realValues[i1] - u2 * imagValues[i1];
-            t2 = u1 * imagValues[i1] + u2 * realValues[i1];
-            realValues[i1] = realValues[i] - t1;
-            imagValues[i1] = imagValues[i] - t2;
-            realValues[i] += t1;
-            imagValues[i] += t2;
-         }
-         z =  u1 * c1 - u2 * c2;
-         u2 = u1 * c2 + u2 * c1;
-         u1 = z;
-      }
-      c2 = sqrt((1.0 - c1) / 2.0);
-      if (dir == 1)
-         c2 = -c2;
-      c1 = sqrt((1.0 + c1) / 2.0);
-   }
-
-   // Normalisation should be done for reverse transform
-   if( doNormalisation ) {
-      for (i=0;i<nn;i++) {
-         realValues[i] /= (double)nn;
-         imagValues[i] /= (double)nn;
-      }
-   }
+  int numSamples = 1 << power_of_two;
+  csFFTEngine const* plan = csFFTEngine::getPlan( numSamples );
+  double* work = new double[plan->workSize()];
+  plan->complexTransform( dir == csFFTTools::FORWARD ? csFFTEngine::FORWARD : csFFTEngine::INVERSE, realValues, imagValues, work );
+  delete [] work;
 
-   return(true);
+  // Normalisation should be done for reverse transform
+  if( doNormalisation ) {
+    for( int i = 0; i < numSamples; i++ ) {
+      realValues[i] /= (double)numSamples;
+      imagValues[i] /= (double)numSamples;
+    }
+  }
+  return true;
 }
 
 // Not tested yet...
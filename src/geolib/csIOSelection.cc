@@ -2,6 +2,7 @@
 /* All rights reserved.                       */
 
 #include <cstdio>
+#include <algorithm>
 #include "csIOSelection.h"
 #include "csFlexHeader.h"
 #include "csFlexNumber.h"
@@ -27,6 +28,8 @@ csIOSelection::csIOSelection( std::string const& headerName, int sortOrder, int
   myCurrentSelectedIndex = -1;
   mySelectedValueList = new cseis_geolib::csVector<csFlexNumber*>();
   mySTEPSelection = NULL;
+  mySTEPHdrType = TYPE_UNKNOWN;
+  myIsIndexed = false;
 }
 csIOSelection::~csIOSelection() {
   if( mySTEPSelection != NULL ) {
@@ -66,8 +69,20 @@ void csIOSelection::step1( cseis_geolib::csIReader* reader, std::string const& h
   mySTEPSelection = new csSelection( 1, &hdrType );
   mySTEPSelection->add( hdrValueSelectionText );
   mySTEPTraceIndex = 0;
+  mySTEPHdrType = hdrType;
 }
 bool csIOSelection::step2( cseis_geolib::csIReader* reader, int& numTracesToRead ) {
+  double const* sortedValues = NULL;
+  csInt64_t const* sortedValuesInt64 = NULL;
+  int const* sortedTraceIndices = NULL;
+  if( mySTEPTraceIndex == 0 && reader->getIndexedHeaderValues( myHdrName, sortedValues, sortedValuesInt64, sortedTraceIndices ) ) {
+    // Header index exists: No need to scan input file
+    selectFromIndex( sortedValues, sortedValuesInt64, sortedTraceIndices, reader->numTraces(), mySTEPHdrType );
+    numTracesToRead  = reader->numTraces();
+    mySTEPTraceIndex = reader->numTraces();
+    myIsIndexed = true;
+    return true;
+  }
   int lastTrace = std::min( reader->numTraces(), mySTEPTraceIndex+numTracesToRead );
   numTracesToRead = lastTrace - mySTEPTraceIndex;
   for( int itrc = mySTEPTraceIndex; itrc < lastTrace; itrc++ ) {
@@ -102,7 +117,7 @@ bool csIOSelection::step3( cseis_geolib::csIReader* reader ) {
     return false;
   }
 
-  if( mySortOrder != csIOSelection::SORT_NONE ) {
+  if( mySortOrder != csIOSelection::SORT_NONE && !myIsIndexed ) {
     mySortManager->resetValues( myNumSelectedTraces );
     for( int is = 0; is < myNumSelectedTraces; is++ ) {
       csFlexNumber* flexNum = mySelectedValueList->at( is );
@@ -128,8 +143,77 @@ bool csIOSelection::step3( cseis_geolib::csIReader* reader ) {
 
 
 
+namespace {
+  /// Header value at given position in sorted header index
+  csFlexNumber indexValue( double const* sortedValues, csInt64_t const* sortedValuesInt64, int is, type_t hdrType ) {
+    if( sortedValuesInt64 != NULL ) return csFlexNumber( sortedValuesInt64[is] );
+    if( hdrType == TYPE_INT ) return csFlexNumber( (int)sortedValues[is] );
+    if( hdrType == TYPE_FLOAT ) return csFlexNumber( (float)sortedValues[is] );
+    return csFlexNumber( sortedValues[is] );
+  }
+  bool isSameIndexValue( double const* sortedValues, csInt64_t const* sortedValuesInt64, int is1, int is2 ) {
+    if( sortedValuesInt64 != NULL ) return( sortedValuesInt64[is1] == sortedValuesInt64[is2] );
+    return( sortedValues[is1] == sortedValues[is2] );
+  }
+}
+
+void csIOSelection::selectFromIndex( double const* sortedValues, csInt64_t const* sortedValuesInt64, int const* sortedTraceIndices,
+                                     int numTraces, type_t hdrType ) {
+  // Evaluate selection once for each distinct header value
+  bool* isSelected = new bool[std::max(numTraces,1)];
+  for( int is = 0; is < numTraces; is++ ) {
+    if( is > 0 && isSameIndexValue( sortedValues, sortedValuesInt64, is, is-1 ) ) {
+      isSelected[is] = isSelected[is-1];
+    }
+    else {
+      csFlexNumber value = indexValue( sortedValues, sortedValuesInt64, is, hdrType );
+      isSelected[is] = mySTEPSelection->contains( &value );
+    }
+  }
+  int* sortIndex = new int[std::max(numTraces,1)];
+  int numSelected = 0;
+  if( mySortOrder == SORT_INCREASING ) {
+    for( int is = 0; is < numTraces; is++ ) {
+      if( isSelected[is] ) sortIndex[numSelected++] = is;
+    }
+  }
+  else if( mySortOrder == SORT_DECREASING ) {
+    // Decreasing header values. Traces with equal header values remain in trace order
+    int isLast = numTraces-1;
+    while( isLast >= 0 ) {
+      int isFirst = isLast;
+      while( isFirst > 0 && isSameIndexValue( sortedValues, sortedValuesInt64, isFirst-1, isLast ) ) isFirst--;
+      for( int is = isFirst; is <= isLast; is++ ) {
+        if( isSelected[is] ) sortIndex[numSelected++] = is;
+      }
+      isLast = isFirst-1;
+    }
+  }
+  else {
+    // Trace order
+    int* traceIndex = new int[std::max(numTraces,1)];
+    for( int is = 0; is < numTraces; is++ ) {
+      traceIndex[is] = -1;
+    }
+    for( int is = 0; is < numTraces; is++ ) {
+      if( isSelected[is] ) traceIndex[sortedTraceIndices[is]] = is;
+    }
+    for( int itrc = 0; itrc < numTraces; itrc++ ) {
+      if( traceIndex[itrc] >= 0 ) sortIndex[numSelected++] = traceIndex[itrc];
+    }
+    delete [] traceIndex;
+  }
+  for( int isel = 0; isel < numSelected; isel++ ) {
+    int is = sortIndex[isel];
+    mySelectedTraceIndexList->insertEnd( sortedTraceIndices[is] );
+    mySelectedValueList->insertEnd( new csFlexNumber( indexValue( sortedValues, sortedValuesInt64, is, hdrType ) ) );
+  }
+  delete [] sortIndex;
+  delete [] isSelected;
+}
+
 int csIOSelection::getCurrentTraceIndex() {
-  if( mySortOrder == SORT_NONE ) {
+  if( mySortOrder == SORT_NONE || myIsIndexed ) {
     return mySelectedTraceIndexList->at(myCurrentSelectedIndex);
   }
   else {
@@ -146,7 +230,7 @@ int csIOSelection::getNextTraceIndex() {
 }
 
 int csIOSelection::getNumSelectedTraces() const {
-  if( mySortOrder == SORT_NONE ) {
+  if( mySortOrder == SORT_NONE || myIsIndexed ) {
     return mySelectedValueList->size();
   }
   else {
@@ -155,7 +239,7 @@ int csIOSelection::getNumSelectedTraces() const {
 }
 
 int csIOSelection::getSelectedIndex( int traceIndex ) const {
-  if( mySortOrder != SORT_NONE ) {
+  if( mySortOrder != SORT_NONE && !myIsIndexed ) {
     return mySortManager->sortedIndex( traceIndex );
   }
   else {
@@ -168,7 +252,7 @@ cseis_geolib::csFlexNumber const* csIOSelection::getSelectedValue( int traceInde
     throw( csException("csIOSelection::getSelectedValue: Incorrect trace index provided: %d >= %d: This is probably a bug in the calling function",
                        traceIndex, getNumSelectedTraces()) );
   }
-  if( mySortOrder == SORT_NONE ) {
+  if( mySortOrder == SORT_NONE || myIsIndexed ) {
     return mySelectedValueList->at( traceIndex );
   }
   else {
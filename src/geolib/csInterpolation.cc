@@ -6,10 +6,53 @@
 #include <cstdlib>
 #include <cmath>
 #include "geolib_math.h"
+#include "geolib_simd.h"
+#include "geolib_platform_dependent.h"
 #include "csException.h"
 
+#ifdef ARCHITECTURE_X86_SIMD
+ #include <immintrin.h>
+#endif
+
 using namespace cseis_geolib;
 
+namespace {
+  /// Dot product in four partial sums, lane i summing products i, i+4, i+8... Fixed summation order for scalar and SIMD code
+  inline float dotProduct4( float const* values, float const* coef, int numCoef ) {
+    float lane[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for( int icoef = 0; icoef < numCoef; icoef++ ) {
+      lane[icoef%4] += values[icoef] * coef[icoef];
+    }
+    return( (lane[0] + lane[2]) + (lane[1] + lane[3]) );
+  }
+#ifdef ARCHITECTURE_X86_SIMD
+  __attribute__((target("sse2")))
+  inline float dotProduct4SSE2( float const* values, float const* coef, int numCoef ) {
+    int numVector = numCoef - numCoef % 4;
+    __m128 sum = _mm_setzero_ps();
+    for( int icoef = 0; icoef < numVector; icoef += 4 ) {
+      sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( &values[icoef] ), _mm_loadu_ps( &coef[icoef] ) ) );
+    }
+    float lane[4];
+    _mm_storeu_ps( lane, sum );
+    for( int icoef = numVector; icoef < numCoef; icoef++ ) {
+      lane[icoef%4] += values[icoef] * coef[icoef];
+    }
+    return( (lane[0] + lane[2]) + (lane[1] + lane[3]) );
+  }
+  __attribute__((target("sse2")))
+  void applySSE2( float const* samplesIn, int const* sampleIndex, int const* coefIndex, float* samplesOut, int numSamplesOut,
+                  float const* const* coefficients, int numCoef, int numSamplesMin ) {
+    for( int isamp = 0; isamp < numSamplesOut; isamp++ ) {
+      int currentSample = sampleIndex[isamp];
+      if( currentSample >= 0 && currentSample <= numSamplesMin ) {
+        samplesOut[isamp] = dotProduct4SSE2( &samplesIn[currentSample], coefficients[coefIndex[isamp]], numCoef );
+      }
+    }
+  }
+#endif
+}
+
 csInterpolation::csInterpolation( int numSamples, float sampleInt ) {
   init( numSamples, sampleInt, 16 );
 }
@@ -18,6 +61,12 @@ csInterpolation::csInterpolation( int numSamples, float sampleInt, int numCoeffi
   init( numSamples, sampleInt, numCoefficients );
 }
 
+csInterpolation::csInterpolation( csInterpolation const& obj ) {
+  init( obj.myNumSamples, obj.mySampleInt, obj.myNumCoefficients );
+  myExtrapolValLeft  = obj.myExtrapolValLeft;
+  myExtrapolValRight = obj.myExtrapolValRight;
+}
+
 void csInterpolation::init( int numSamples, float sampleInt, int numCoefficients ) {
   mySampleInt  = sampleInt;
   myNumSamples = numSamples;
@@ -136,6 +185,62 @@ void csInterpolation::process( float sampleIntSkew, float xVal1, float const* sa
 
 }
 
+//--------------------------------------------------------------------------
+//
+//
+void csInterpolation::computeIndexTable( float sampleIntSkew, float xVal1, float const* sIndexOut, int* sampleIndex, int* coefIndex, int numSamplesOut ) const {
+  int sampleOffset  = 1 - 3*myNumCoefficients/2;
+  float sampleRate  = 1.0f / sampleIntSkew;
+  float helpIndex   = (float)myNumCoefficients - xVal1 * sampleRate;
+  float numValMin   = (float)(myNumValues-1);
+
+  for( int isamp = 0; isamp < numSamplesOut; isamp++ ) {
+    float sampleOut  = helpIndex + sIndexOut[isamp] * sampleRate;
+    int isampleOut   = (int)sampleOut;
+    float remainder  = sampleOut-(float)isampleOut;
+    sampleIndex[isamp] = sampleOffset+isampleOut;
+    coefIndex[isamp]   = (int)( remainder >= 0.0 ? remainder*numValMin+0.5 : (remainder+1.0)*numValMin-0.5 );
+  }
+}
+//--------------------------------------------------------------------------
+//
+//
+void csInterpolation::apply( float const* samplesIn, int const* sampleIndex, int const* coefIndex, float* samplesOut, int numSamplesOut ) const {
+  int numSamplesMin = myNumSamples - myNumCoefficients;
+  bool isSIMD = false;
+#ifdef ARCHITECTURE_X86_SIMD
+  // SIMD kernel computes interior samples only. Samples near either end of the input trace are computed below
+  if( getSIMDLevel() >= SIMD_SSE2 ) {
+    applySSE2( samplesIn, sampleIndex, coefIndex, samplesOut, numSamplesOut, myCoefficients, myNumCoefficients, numSamplesMin );
+    isSIMD = true;
+  }
+#endif
+  for( int isamp = 0; isamp < numSamplesOut; isamp++ ) {
+    int currentSample = sampleIndex[isamp];
+    float const* coefRed = myCoefficients[ coefIndex[isamp] ];
+    if( currentSample >= 0 && currentSample <= numSamplesMin ) {
+      if( !isSIMD ) samplesOut[isamp] = dotProduct4( &samplesIn[currentSample], coefRed, myNumCoefficients );
+    }
+    else {
+      float lane[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+      for( int icoef = 0; icoef < myNumCoefficients; icoef++,currentSample++ ) {
+        float valOut;
+        if( currentSample < 0 ) {
+          valOut = myExtrapolValLeft;
+        }
+        else if( currentSample >= myNumSamples ) {
+          valOut = myExtrapolValRight;
+        }
+        else {
+          valOut = samplesIn[currentSample];
+        }
+        lane[icoef%4] += valOut * coefRed[icoef];
+      }
+      samplesOut[isamp] = (lane[0] + lane[2]) + (lane[1] + lane[3]);
+    }
+  }
+}
+
 /**
  * Sinc function
  * sinc(x) = sin(pi*x)/(pi*x)
@@ -0,0 +1,71 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csMappedFile.h"
+#include "csException.h"
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+extern "C" {
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+}
+
+using namespace cseis_geolib;
+
+csMappedFile::csMappedFile( std::string const& filename ) :
+  csSharedBuffer()
+{
+  myData = NULL;
+  mySize = 0;
+  int fd = open( filename.c_str(), O_RDONLY );
+  if( fd < 0 ) {
+    throw( csException("csMappedFile: Could not open file '%s': %s", filename.c_str(), strerror(errno)) );
+  }
+  struct stat statFile;
+  if( fstat( fd, &statFile ) != 0 ) {
+    close( fd );
+    throw( csException("csMappedFile: Could not determine size of file '%s': %s", filename.c_str(), strerror(errno)) );
+  }
+  mySize = (csInt64_t)statFile.st_size;
+  if( mySize > 0 ) {
+    void* ptr = mmap( NULL, (size_t)mySize, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( ptr == MAP_FAILED ) {
+      close( fd );
+      throw( csException("csMappedFile: Could not map file '%s': %s", filename.c_str(), strerror(errno)) );
+    }
+    myData = reinterpret_cast<char*>( ptr );
+  }
+  // Mapping remains valid after file descriptor has been closed
+  close( fd );
+}
+csMappedFile::~csMappedFile() {
+  if( myData != NULL ) {
+    munmap( myData, (size_t)mySize );
+    myData = NULL;
+  }
+}
+//--------------------------------------------------------------------
+void csMappedFile::setAccessPattern( int accessType ) {
+  if( myData == NULL ) return;
+  int advice = MADV_NORMAL;
+  if( accessType == ACCESS_SEQUENTIAL ) {
+    advice = MADV_SEQUENTIAL;
+  }
+  else if( accessType == ACCESS_RANDOM ) {
+    advice = MADV_RANDOM;
+  }
+  // Advice only: Ignore errors
+  madvise( myData, (size_t)mySize, advice );
+}
+void csMappedFile::willNeed( csInt64_t byteOffset, csInt64_t byteSize ) {
+  if( myData == NULL || byteOffset >= mySize || byteSize <= 0 ) return;
+  // madvise requires page aligned start address
+  csInt64_t pageSize = (csInt64_t)sysconf( _SC_PAGESIZE );
+  csInt64_t byteStart = (byteOffset / pageSize) * pageSize;
+  csInt64_t byteEnd   = std::min( byteOffset + byteSize, mySize );
+  madvise( myData + byteStart, (size_t)(byteEnd - byteStart), MADV_WILLNEED );
+}
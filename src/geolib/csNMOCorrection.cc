@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <algorithm>
 #include "csNMOCorrection.h"
 #include "csInterpolation.h"
 #include "csTimeFunction.h"
@@ -16,6 +17,23 @@ namespace cseis_geolib {
 }
 
 csNMOCorrection::csNMOCorrection( double sampleInt_ms, int numSamples, int method_nmo ) {
+  init( sampleInt_ms, numSamples, method_nmo );
+  allocateVelocity();
+}
+csNMOCorrection::csNMOCorrection( csNMOCorrection const& obj ) {
+  init( obj.mySampleInt_sec*1000.0, obj.myNumSamples, obj.myNMOMethod );
+  mySampleInt_sec     = obj.mySampleInt_sec;
+  myTimeOfLastSample  = obj.myTimeOfLastSample;
+  myModeOfApplication = obj.myModeOfApplication;
+  myOffsetApex        = obj.myOffsetApex;
+  myZeroOffsetDamping = obj.myZeroOffsetDamping;
+  myTimeSample1_s     = obj.myTimeSample1_s;
+  myIsHorizonBasedNMO = obj.myIsHorizonBasedNMO;
+  myHorInterpolationMethod = obj.myHorInterpolationMethod;
+  if( obj.myMaxNumMoveoutTables != myMaxNumMoveoutTables ) setMoveoutCacheSize( obj.myMaxNumMoveoutTables );
+  allocateVelocity();
+}
+void csNMOCorrection::init( double sampleInt_ms, int numSamples, int method_nmo ) {
   myNMOMethod = method_nmo;
   mySampleInt_sec      = sampleInt_ms/1000.0;
   myNumSamples          = numSamples;
@@ -33,7 +51,17 @@ csNMOCorrection::csNMOCorrection( double sampleInt_ms, int numSamples, int metho
   myInterpol = NULL;
   myTimeSample1_s = 0.0;
 
-  allocateVelocity();
+  myMaxNumMoveoutTables = 64;
+  myNumMoveoutTables    = 0;
+  myMoveoutCounter      = 0;
+  myMoveoutTables       = new MoveoutTable[myMaxNumMoveoutTables > 0 ? myMaxNumMoveoutTables : 1];
+  myVelFunctionId        = 0;
+  myVelFunctionNumValues = 0;
+  myVelFunctionNumAlloc  = 0;
+  myVelFunctionTimes     = NULL;
+  myVelFunctionVels      = NULL;
+  myVelFunctionEta       = NULL;
+  myIsVelocityTraceValid = false;
 }
 //--------------------------------------------------------------------------------
 //
@@ -66,12 +94,20 @@ csNMOCorrection::~csNMOCorrection() {
     delete myInterpol;
     myInterpol = NULL;
   }
+  freeMoveoutCache();
+  if( myVelFunctionTimes != NULL ) {
+    delete [] myVelFunctionTimes;
+    delete [] myVelFunctionVels;
+    delete [] myVelFunctionEta;
+    myVelFunctionTimes = NULL;
+  }
 }
 //--------------------------------------------------------------------------------
 //
 void csNMOCorrection::setTimeSample1( float timeSample1_ms ) {
   if( timeSample1_ms > 0 ) throw( csException("Inconsistent time of first sample provided: %f. Must be <= 0\n", timeSample1_ms) );
   myTimeSample1_s = timeSample1_ms / 1000.0;
+  clearMoveoutCache();
 }
 //--------------------------------------------------------------------------------
 //
@@ -84,6 +120,8 @@ void csNMOCorrection::setHorizonBasedNMO( bool setHorizonBased, int method_inter
 //--------------------------------------------------------------------------------
 //
 void csNMOCorrection::allocateVelocity() {
+  clearMoveoutCache();
+  myIsVelocityTraceValid = false;
   if( myVelocityTrace != NULL ) {
     delete [] myVelocityTrace;
     myVelocityTrace = NULL;
@@ -109,6 +147,7 @@ void csNMOCorrection::allocateVelocity() {
     for( int isamp = 0; isamp < myNumSamples; isamp++ ) {
       myTimeTrace[isamp] = (float)( mySampleInt_sec * isamp ) + myTimeSample1_s;
     }
+    if( myInterpol != NULL ) delete myInterpol;
     myInterpol = new csInterpolation( myNumSamples, mySampleInt_sec );
   }
 }
@@ -116,6 +155,7 @@ void csNMOCorrection::allocateVelocity() {
 //
 void csNMOCorrection::setModeOfApplication( int mode ) {
   myModeOfApplication = mode;
+  clearMoveoutCache();
 }
 //--------------------------------------------------------------------------------
 //
@@ -123,6 +163,29 @@ void csNMOCorrection::setEmpiricalNMO( double offsetApex_m, double zeroOffsetDam
   myNMOMethod  = csNMOCorrection::EMPIRICAL_NMO;
   myOffsetApex = offsetApex_m;
   myZeroOffsetDamping = zeroOffsetDamping;
+  clearMoveoutCache();
+}
+//--------------------------------------------------------------------------------
+//
+void csNMOCorrection::setMoveoutCacheSize( int numTables ) {
+  freeMoveoutCache();
+  myMaxNumMoveoutTables = numTables > 0 ? numTables : 0;
+  myMoveoutTables = new MoveoutTable[myMaxNumMoveoutTables > 0 ? myMaxNumMoveoutTables : 1];
+}
+void csNMOCorrection::clearMoveoutCache() {
+  for( int i = 0; i < myNumMoveoutTables; i++ ) {
+    myMoveoutTables[i].velFunctionId = -1;
+  }
+}
+void csNMOCorrection::freeMoveoutCache() {
+  if( myMoveoutTables == NULL ) return;
+  for( int i = 0; i < myNumMoveoutTables; i++ ) {
+    delete [] myMoveoutTables[i].sampleIndex;
+    delete [] myMoveoutTables[i].coefIndex;
+  }
+  delete [] myMoveoutTables;
+  myMoveoutTables    = NULL;
+  myNumMoveoutTables = 0;
 }
 //--------------------------------------------------------------------------------
 //
@@ -184,27 +247,85 @@ void csNMOCorrection::perform_nmo( csTimeFunction<double> const* velTimeFunc, do
   delete [] vel_rms;
 }
 //--------------------------------------------------------------------------------
+// Set current velocity function. Start new velocity function ID if it differs from the previous one
 //
-void csNMOCorrection::perform_nmo_internal( int numVels, float const* times, float const* vel_rms, double offset, float* samplesOut, float const* eta ) {
-
+void csNMOCorrection::setVelocityFunction( int numVels, float const* times, float const* vel_rms, float const* eta ) {
+  bool isEta = ( myNMOMethod == csNMOCorrection::PP_NMO_VTI );
+  if( numVels == myVelFunctionNumValues && myVelFunctionNumValues > 0 &&
+      !memcmp( times, myVelFunctionTimes, numVels*sizeof(float) ) &&
+      !memcmp( vel_rms, myVelFunctionVels, numVels*sizeof(float) ) &&
+      ( !isEta || !memcmp( eta, myVelFunctionEta, numVels*sizeof(float) ) ) ) {
+    return;
+  }
+  if( numVels > myVelFunctionNumAlloc ) {
+    if( myVelFunctionTimes != NULL ) {
+      delete [] myVelFunctionTimes;
+      delete [] myVelFunctionVels;
+      delete [] myVelFunctionEta;
+    }
+    myVelFunctionNumAlloc = numVels;
+    myVelFunctionTimes = new float[numVels];
+    myVelFunctionVels  = new float[numVels];
+    myVelFunctionEta   = new float[numVels];
+  }
+  memcpy( myVelFunctionTimes, times, numVels*sizeof(float) );
+  memcpy( myVelFunctionVels, vel_rms, numVels*sizeof(float) );
+  if( isEta ) memcpy( myVelFunctionEta, eta, numVels*sizeof(float) );
+  myVelFunctionNumValues = numVels;
+  myVelFunctionId += 1;
+  myIsVelocityTraceValid = false;
+}
+void csNMOCorrection::computeVelocityTrace() {
+  if( myIsVelocityTraceValid ) return;
   // Linearly interpolate input velocities
-  csInterpolation::linearInterpolation( numVels, times, vel_rms, myNumSamples, mySampleInt_sec, myVelocityTrace );
+  csInterpolation::linearInterpolation( myVelFunctionNumValues, myVelFunctionTimes, myVelFunctionVels, myNumSamples, mySampleInt_sec, myVelocityTrace );
   if( myNMOMethod == csNMOCorrection::PP_NMO_VTI ) {
-    csInterpolation::linearInterpolation( numVels, times, eta, myNumSamples, mySampleInt_sec, myETATrace );
+    csInterpolation::linearInterpolation( myVelFunctionNumValues, myVelFunctionTimes, myVelFunctionEta, myNumSamples, mySampleInt_sec, myETATrace );
+  }
+  myIsVelocityTraceValid = true;
+}
+//--------------------------------------------------------------------------------
+// Retrieve moveout table for current velocity function and given offset. Compute table if not cached.
+// Least recently used table is replaced when cache is full.
+//
+csNMOCorrection::MoveoutTable const* csNMOCorrection::getMoveoutTable( double offset ) {
+  myMoveoutCounter += 1;
+  for( int i = 0; i < myNumMoveoutTables; i++ ) {
+    MoveoutTable* table = &myMoveoutTables[i];
+    if( table->velFunctionId == myVelFunctionId && table->offset == offset ) {
+      table->lastUsed = myMoveoutCounter;
+      return table;
+    }
+  }
+  MoveoutTable* table = NULL;
+  if( myNumMoveoutTables < std::max( myMaxNumMoveoutTables, 1 ) ) {
+    table = &myMoveoutTables[myNumMoveoutTables++];
+    table->sampleIndex = new int[myNumSamples];
+    table->coefIndex   = new int[myNumSamples];
   }
+  else {
+    table = &myMoveoutTables[0];
+    for( int i = 1; i < myNumMoveoutTables; i++ ) {
+      if( myMoveoutTables[i].lastUsed < table->lastUsed ) table = &myMoveoutTables[i];
+    }
+  }
+  // Cache disabled: Work table never matches
+  table->velFunctionId = ( myMaxNumMoveoutTables > 0 ) ? myVelFunctionId : -1;
+  table->offset   = offset;
+  table->lastUsed = myMoveoutCounter;
 
-  memcpy( myBuffer, samplesOut, myNumSamples*sizeof(float) );
+  computeVelocityTrace();
   double offset_sq = offset*offset;
 
   int isampTimeZero = (int)round( -myTimeSample1_s / mySampleInt_sec );
   for( int isamp = isampTimeZero; isamp < myNumSamples; isamp++ ) {
-    //  for( int isamp = 0; isamp < myNumSamples; isamp++ ) {
     double timeOut = (double)isamp*mySampleInt_sec + myTimeSample1_s;
     double timeOut_sq = timeOut * timeOut;
     int isampVel = isamp - isampTimeZero;
     if( isampVel < 0 ) isampVel = 0;
     double vel = myVelocityTrace[isampVel];
     if( vel <= 0.0 ) {
+      table->velFunctionId = -1;
       throw( csException("csNMOCorrection::perform_nmo_internal(): Velocity <= 0 encountered. Wrong input velocity function?") );
     }
     switch( myNMOMethod ) {
@@ -220,20 +341,14 @@ void csNMOCorrection::perform_nmo_internal( int numVels, float const* times, flo
     case csNMOCorrection::EMPIRICAL_NMO:
       myTimeTrace[isamp] = timeOut + ( ( vel * ( pow( (offset-myOffsetApex)/1000,2) - pow(myOffsetApex/1000,2) ) -  (vel/(vel+0.1)) * myZeroOffsetDamping * exp(-0.5*pow(offset/1000,2)) ) / 1000);
       break;
-    case csNMOCorrection::OUTPUT_VEL:
-      samplesOut[isamp] = vel;
-      break;
     }
   }
   for( int isamp = 0; isamp < isampTimeZero; isamp++ ) {
     myTimeTrace[isamp] = myTimeTrace[isampTimeZero] + myTimeTrace[isampTimeZero] - myTimeTrace[2*isampTimeZero-isamp+1];
   }
 
-  if( myNMOMethod == csNMOCorrection::OUTPUT_VEL ) {
-    // Do nothing
-  }
-  else if( myModeOfApplication == csNMOCorrection::NMO_APPLY ) {
-    myInterpol->process( mySampleInt_sec, myTimeSample1_s, myBuffer, myTimeTrace, samplesOut );
+  if( myModeOfApplication == csNMOCorrection::NMO_APPLY ) {
+    myInterpol->computeIndexTable( mySampleInt_sec, myTimeSample1_s, myTimeTrace, table->sampleIndex, table->coefIndex, myNumSamples );
   }
   else { // if( myModeOfApplication == csNMOCorrection::NMO_REMOVE ) {
     if( myTimeTraceInverse == NULL ) {
@@ -245,8 +360,32 @@ void csNMOCorrection::perform_nmo_internal( int numVels, float const* times, flo
       }
     }
     csInterpolation::xy2yxInterpolation( myTimeTrace, myTimeTraceInverse, myNumSamples, mySampleInt_sec );
-    myInterpol->process( mySampleInt_sec, 0, myBuffer, myTimeTraceInverse, samplesOut );
+    myInterpol->computeIndexTable( mySampleInt_sec, 0, myTimeTraceInverse, table->sampleIndex, table->coefIndex, myNumSamples );
+  }
+  return table;
+}
+//--------------------------------------------------------------------------------
+//
+void csNMOCorrection::perform_nmo_internal( int numVels, float const* times, float const* vel_rms, double offset, float* samplesOut, float const* eta ) {
+  setVelocityFunction( numVels, times, vel_rms, eta );
+
+  if( myNMOMethod == csNMOCorrection::OUTPUT_VEL ) {
+    computeVelocityTrace();
+    int isampTimeZero = (int)round( -myTimeSample1_s / mySampleInt_sec );
+    for( int isamp = isampTimeZero; isamp < myNumSamples; isamp++ ) {
+      int isampVel = isamp - isampTimeZero;
+      if( isampVel < 0 ) isampVel = 0;
+      if( myVelocityTrace[isampVel] <= 0.0 ) {
+        throw( csException("csNMOCorrection::perform_nmo_internal(): Velocity <= 0 encountered. Wrong input velocity function?") );
+      }
+      samplesOut[isamp] = myVelocityTrace[isampVel];
+    }
+    return;
   }
+
+  MoveoutTable const* table = getMoveoutTable( offset );
+  memcpy( myBuffer, samplesOut, myNumSamples*sizeof(float) );
+  myInterpol->apply( myBuffer, table->sampleIndex, table->coefIndex, samplesOut, myNumSamples );
 }
 
 //--------------------------------------------------------------------------------
@@ -424,7 +563,8 @@ void csNMOCorrection::perform_differential_nmo_ORIG( csTimeFunction<double> cons
 
 void csNMOCorrection::perform_differential_nmo_internal( int numVels, float const* times, float const* vel_rms, double offsetIn, double offsetOut, float* samplesOut, float const* eta ) {
 
-  // Linearly interpolate input velocities
+  // Linearly interpolate input velocities. Overwrites velocity trace of current velocity function
+  myIsVelocityTraceValid = false;
   csInterpolation::linearInterpolation( numVels, times, vel_rms, myNumSamples, mySampleInt_sec, myVelocityTrace );
   if( myNMOMethod == csNMOCorrection::PP_NMO_VTI ) {
     csInterpolation::linearInterpolation( numVels, times, eta, myNumSamples, mySampleInt_sec, myETATrace );
@@ -590,7 +730,8 @@ void csNMOCorrection::perform_differential_nmo_internal( int numVels, float cons
 
 void csNMOCorrection::perform_differential_nmo_internal_ORIG( int numVels, float const* times, float const* vel_rms, double offsetIn, double offsetOut, float* samplesOut ) {
 
-  // Linearly interpolate input velocities
+  // Linearly interpolate input velocities. Overwrites velocity trace of current velocity function
+  myIsVelocityTraceValid = false;
   csInterpolation::linearInterpolation( numVels, times, vel_rms, myNumSamples, mySampleInt_sec, myVelocityTrace );
 
   memcpy( myBuffer, samplesOut, myNumSamples*sizeof(float) );
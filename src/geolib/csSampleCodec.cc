@@ -0,0 +1,631 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csSampleCodec.h"
+#include "csException.h"
+#include "geolib_defines.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+using namespace cseis_geolib;
+
+namespace {
+  typedef unsigned long long uint64;
+
+  /// Integer mode, values predicted from previous value
+  int const MODE_INTEGER        = 0;
+  int const MODE_FLOAT          = 1;
+  int const MODE_RAW            = 2;
+  /// Integer mode, values predicted by linear extrapolation of two previous values
+  int const MODE_INTEGER_LINEAR = 3;
+
+  int const SIGN_POSITIVE = 0;
+  int const SIGN_NEGATIVE = 1;
+  int const SIGN_MIXED    = 2;
+
+  /// Group header: Mode, exponent of least significant bit (2 bytes), bit width of first value, bit width of remaining values
+  int const BYTES_HEADER_INTEGER = 5;
+  /// Group header: Mode, sign mode, first exponent, exponent bit width, mantissa bit width
+  int const BYTES_HEADER_FLOAT   = 5;
+  /// Group header: Mode
+  int const BYTES_HEADER_RAW     = 1;
+  /// Maximum number of significant bits of integers in integer mode
+  int const MAX_INTEGER_BITS = 32;
+  /// Maximum bit width of packed values: Zigzag coded prediction error of linear extrapolation
+  int const MAX_BIT_WIDTH    = MAX_INTEGER_BITS + 3;
+  int const NUM_MANTISSA_BITS = 23;
+
+  /// Lossy coding: Trace is coded losslessly, see csSampleCodec::encode()
+  int const TRACE_LOSSLESS = 0;
+  /// Lossy coding: Trace is quantized and wavelet transformed
+  int const TRACE_WAVELET  = 1;
+  /// Trace header: Mode, quantization step (float), number of wavelet levels
+  int const BYTES_HEADER_WAVELET = 6;
+  /// Coefficient group, values stored as is
+  int const COEF_DIRECT = 0;
+  /// Coefficient group, values predicted from previous value
+  int const COEF_DELTA  = 1;
+  /// Coefficient group, values predicted by linear extrapolation of two previous values
+  int const COEF_LINEAR = 2;
+  /// Group header: Mode, bit width of first value, bit width of remaining values
+  int const BYTES_HEADER_COEF = 3;
+  /// Quantized samples are limited to this magnitude. Wavelet coefficients then stay below 2^34
+  double const MAX_QUANTIZED_VALUE = 1073741824.0;
+  /// Maximum bit width of coefficient groups: Zigzag coded prediction error of linear extrapolation
+  int const MAX_BIT_WIDTH_COEF = 40;
+  int const MAX_WAVELET_LEVELS = 6;
+  /// Wavelet levels are added as long as the lowpass band is longer than this
+  int const MIN_WAVELET_LENGTH = 16;
+
+  inline int bitLength( uint64 value ) {
+    int numBits = 0;
+    while( value != 0 ) {
+      numBits += 1;
+      value >>= 1;
+    }
+    return numBits;
+  }
+  /// @return number of trailing zero bits. value must not be 0
+  inline int trailingZeros( unsigned int value ) {
+#if defined(__GNUC__)
+    return __builtin_ctz( value );
+#else
+    int numBits = 0;
+    while( (value & 1) == 0 ) {
+      numBits += 1;
+      value >>= 1;
+    }
+    return numBits;
+#endif
+  }
+  inline uint64 zigzagEncode( csInt64_t value ) {
+    return( ((uint64)value << 1) ^ (uint64)(value >> 63) );
+  }
+  inline csInt64_t zigzagDecode( uint64 value ) {
+    return( (csInt64_t)(value >> 1) ^ -(csInt64_t)(value & 1) );
+  }
+
+  /// Packs values of given bit width into consecutive bytes, least significant bit first
+  class BitWriter {
+  public:
+    BitWriter( unsigned char* ptr ) : myPtr(ptr), myBits(0), myNumBits(0) {}
+    inline void put( uint64 value, int numBits ) {
+      myBits |= value << myNumBits;
+      myNumBits += numBits;
+      while( myNumBits >= 8 ) {
+        *myPtr++ = (unsigned char)myBits;
+        myBits >>= 8;
+        myNumBits -= 8;
+      }
+    }
+    /// Write remaining bits, padded to full byte. @return pointer to next byte
+    inline unsigned char* flush() {
+      if( myNumBits > 0 ) *myPtr++ = (unsigned char)myBits;
+      myBits    = 0;
+      myNumBits = 0;
+      return myPtr;
+    }
+  private:
+    unsigned char* myPtr;
+    uint64 myBits;
+    int myNumBits;
+  };
+
+  /// Unpacks values written by BitWriter
+  class BitReader {
+  public:
+    BitReader( unsigned char const* ptr, unsigned char const* end ) : myPtr(ptr), myEnd(end), myBits(0), myNumBits(0) {}
+    inline uint64 get( int numBits ) {
+      while( myNumBits < numBits ) {
+        if( myPtr == myEnd ) throw( csException("csSampleCodec::decode: Unexpected end of encoded data") );
+        myBits |= (uint64)(*myPtr++) << myNumBits;
+        myNumBits += 8;
+      }
+      uint64 value = myBits & ( ((uint64)1 << numBits) - 1 );
+      myBits >>= numBits;
+      myNumBits -= numBits;
+      return value;
+    }
+    /// Skip padding bits of current byte. @return pointer to next byte
+    inline unsigned char const* align() {
+      myBits    = 0;
+      myNumBits = 0;
+      return myPtr;
+    }
+  private:
+    unsigned char const* myPtr;
+    unsigned char const* myEnd;
+    uint64 myBits;
+    int myNumBits;
+  };
+
+  /**
+   * Convert samples to integer multiples of a common power of two, sample = value * 2^lsbExponent
+   * @return false if samples cannot be represented exactly: NaN, Inf, negative zero, or too many significant bits
+   */
+  bool convertToInteger( unsigned int const* bits, int numSamples, csInt64_t* values, int& lsbExponent ) {
+    int lsb[csSampleCodec::GROUP_SIZE];
+    unsigned int significand[csSampleCodec::GROUP_SIZE];
+    lsbExponent = 0;
+    bool isFirst = true;
+    for( int isamp = 0; isamp < numSamples; isamp++ ) {
+      unsigned int value = bits[isamp];
+      if( value == 0 ) continue;
+      int exponent = (int)( (value >> 23) & 0xff );
+      unsigned int mantissa = value & 0x7fffff;
+      if( exponent == 255 || (value & 0x7fffffff) == 0 ) return false;
+      unsigned int fullMantissa = ( exponent != 0 ) ? ( mantissa | 0x800000 ) : mantissa;
+      int tz = trailingZeros( fullMantissa );
+      significand[isamp] = fullMantissa >> tz;
+      lsb[isamp] = std::max( exponent, 1 ) - 150 + tz;
+      if( isFirst || lsb[isamp] < lsbExponent ) lsbExponent = lsb[isamp];
+      isFirst = false;
+    }
+    for( int isamp = 0; isamp < numSamples; isamp++ ) {
+      if( bits[isamp] == 0 ) {
+        values[isamp] = 0;
+        continue;
+      }
+      int shift = lsb[isamp] - lsbExponent;
+      if( bitLength( significand[isamp] ) + shift > MAX_INTEGER_BITS ) return false;
+      csInt64_t value = (csInt64_t)significand[isamp] << shift;
+      values[isamp] = ( bits[isamp] & 0x80000000 ) ? -value : value;
+    }
+    return true;
+  }
+
+  unsigned char* encodeGroup( unsigned int const* bits, int numSamples, unsigned char* ptr ) {
+    int const rawByteSize = BYTES_HEADER_RAW + numSamples*4;
+
+    // (1) Integer mode: Prediction errors of previous value, and of linear extrapolation of two previous values.
+    // The first value of the group is stored as is, with its own bit width
+    csInt64_t values[csSampleCodec::GROUP_SIZE];
+    uint64 diffs[csSampleCodec::GROUP_SIZE];
+    uint64 diffsLinear[csSampleCodec::GROUP_SIZE];
+    int lsbExponent = 0;
+    int intByteSize = rawByteSize + 1;
+    int intBitWidthFirst = 0;
+    int intBitWidth = 0;
+    int intMode = MODE_INTEGER;
+    if( convertToInteger( bits, numSamples, values, lsbExponent ) ) {
+      diffs[0] = diffsLinear[0] = zigzagEncode( values[0] );
+      uint64 orDiffs = 0;
+      uint64 orDiffsLinear = 0;
+      for( int isamp = 1; isamp < numSamples; isamp++ ) {
+        csInt64_t predLinear = ( isamp > 1 ) ? 2*values[isamp-1] - values[isamp-2] : values[0];
+        diffs[isamp]       = zigzagEncode( values[isamp] - values[isamp-1] );
+        diffsLinear[isamp] = zigzagEncode( values[isamp] - predLinear );
+        orDiffs       |= diffs[isamp];
+        orDiffsLinear |= diffsLinear[isamp];
+      }
+      intBitWidthFirst = bitLength( diffs[0] );
+      intBitWidth = bitLength( orDiffs );
+      int bitWidthLinear = bitLength( orDiffsLinear );
+      if( bitWidthLinear < intBitWidth ) {
+        intBitWidth = bitWidthLinear;
+        intMode     = MODE_INTEGER_LINEAR;
+      }
+      intByteSize = BYTES_HEADER_INTEGER + ( intBitWidthFirst + (numSamples-1)*intBitWidth + 7 ) / 8;
+    }
+
+    // (2) Float mode
+    unsigned int orSigns  = 0;
+    unsigned int andSigns = 1;
+    unsigned int orMantissa = 0;
+    unsigned int orExpDiffs = 0;
+    int exponentFirst = (int)( (bits[0] >> 23) & 0xff );
+    int exponentPrev  = exponentFirst;
+    for( int isamp = 0; isamp < numSamples; isamp++ ) {
+      unsigned int sign = bits[isamp] >> 31;
+      int exponent = (int)( (bits[isamp] >> 23) & 0xff );
+      orSigns    |= sign;
+      andSigns   &= sign;
+      orMantissa |= bits[isamp] & 0x7fffff;
+      orExpDiffs |= (unsigned int)zigzagEncode( exponent - exponentPrev );
+      exponentPrev = exponent;
+    }
+    int signMode = ( orSigns == 0 ) ? SIGN_POSITIVE : ( andSigns == 1 ? SIGN_NEGATIVE : SIGN_MIXED );
+    int signBitWidth     = ( signMode == SIGN_MIXED ) ? 1 : 0;
+    int exponentBitWidth = bitLength( orExpDiffs );
+    int mantissaShift    = ( orMantissa == 0 ) ? NUM_MANTISSA_BITS : trailingZeros( orMantissa );
+    int mantissaBitWidth = NUM_MANTISSA_BITS - mantissaShift;
+    int floatByteSize = BYTES_HEADER_FLOAT + ( numSamples*(signBitWidth+exponentBitWidth+mantissaBitWidth) + 7 ) / 8;
+
+    if( intByteSize <= floatByteSize && intByteSize <= rawByteSize ) {
+      short lsbExponentShort = (short)lsbExponent;
+      *ptr++ = (unsigned char)intMode;
+      memcpy( ptr, &lsbExponentShort, 2 );
+      ptr += 2;
+      *ptr++ = (unsigned char)intBitWidthFirst;
+      *ptr++ = (unsigned char)intBitWidth;
+      BitWriter writer( ptr );
+      writer.put( diffs[0], intBitWidthFirst );
+      if( intBitWidth > 0 ) {
+        uint64 const* diffsOut = ( intMode == MODE_INTEGER ) ? diffs : diffsLinear;
+        for( int isamp = 1; isamp < numSamples; isamp++ ) {
+          writer.put( diffsOut[isamp], intBitWidth );
+        }
+      }
+      return writer.flush();
+    }
+    else if( floatByteSize <= rawByteSize ) {
+      *ptr++ = (unsigned char)MODE_FLOAT;
+      *ptr++ = (unsigned char)signMode;
+      *ptr++ = (unsigned char)exponentFirst;
+      *ptr++ = (unsigned char)exponentBitWidth;
+      *ptr++ = (unsigned char)mantissaBitWidth;
+      BitWriter writer( ptr );
+      if( signBitWidth > 0 ) {
+        for( int isamp = 0; isamp < numSamples; isamp++ ) {
+          writer.put( bits[isamp] >> 31, 1 );
+        }
+      }
+      if( exponentBitWidth > 0 ) {
+        exponentPrev = exponentFirst;
+        for( int isamp = 0; isamp < numSamples; isamp++ ) {
+          int exponent = (int)( (bits[isamp] >> 23) & 0xff );
+          writer.put( zigzagEncode( exponent - exponentPrev ), exponentBitWidth );
+          exponentPrev = exponent;
+        }
+      }
+      if( mantissaBitWidth > 0 ) {
+        for( int isamp = 0; isamp < numSamples; isamp++ ) {
+          writer.put( (bits[isamp] & 0x7fffff) >> mantissaShift, mantissaBitWidth );
+        }
+      }
+      return writer.flush();
+    }
+    else {
+      *ptr++ = (unsigned char)MODE_RAW;
+      memcpy( ptr, bits, numSamples*4 );
+      return( ptr + numSamples*4 );
+    }
+  }
+
+
+  //--------------------------------------------------------------------
+  // Reversible integer wavelet transform, CDF 5/3 lifting scheme with symmetric extension (as in JPEG 2000).
+  // Each level splits the lowpass band of the previous level into lowpass and highpass band, stored in this order.
+  //
+  /// Apply one level of the wavelet transform to the first length values
+  void forwardWaveletLevel( csInt64_t* values, int length, csInt64_t* temp ) {
+    int numLow  = (length+1)/2;
+    int numHigh = length/2;
+    csInt64_t* low  = temp;
+    csInt64_t* high = &temp[numLow];
+    for( int i = 0; i < numLow; i++ ) low[i] = values[2*i];
+    for( int i = 0; i < numHigh; i++ ) high[i] = values[2*i+1];
+    for( int i = 0; i < numHigh; i++ ) {
+      high[i] -= ( low[i] + low[std::min(i+1,numLow-1)] ) >> 1;
+    }
+    for( int i = 0; i < numLow && numHigh > 0; i++ ) {
+      low[i] += ( high[std::max(i-1,0)] + high[std::min(i,numHigh-1)] + 2 ) >> 2;
+    }
+    memcpy( values, temp, length*sizeof(csInt64_t) );
+  }
+  void inverseWavelet( csInt64_t* values, int numSamples, int numLevels, csInt64_t* temp ) {
+    for( int level = numLevels-1; level >= 0; level-- ) {
+      int length = numSamples;
+      for( int i = 0; i < level; i++ ) length = (length+1)/2;
+      int numLow  = (length+1)/2;
+      int numHigh = length/2;
+      csInt64_t* low  = values;
+      csInt64_t* high = &values[numLow];
+      for( int i = 0; i < numLow && numHigh > 0; i++ ) {
+        low[i] -= ( high[std::max(i-1,0)] + high[std::min(i,numHigh-1)] + 2 ) >> 2;
+      }
+      for( int i = 0; i < numHigh; i++ ) {
+        high[i] += ( low[i] + low[std::min(i+1,numLow-1)] ) >> 1;
+      }
+      for( int i = 0; i < numLow; i++ ) temp[2*i] = low[i];
+      for( int i = 0; i < numHigh; i++ ) temp[2*i+1] = high[i];
+      memcpy( values, temp, length*sizeof(csInt64_t) );
+    }
+  }
+
+  /**
+   * Select coding of one group of wavelet coefficients: Values as is, or prediction errors
+   * @return number of bytes required to code the group
+   */
+  int selectCoefMode( csInt64_t const* values, int numValues, int& mode, int& bitWidthFirst, int& bitWidth ) {
+    uint64 orDirect = 0;
+    uint64 orDelta  = 0;
+    uint64 orLinear = 0;
+    for( int i = 1; i < numValues; i++ ) {
+      csInt64_t predLinear = ( i > 1 ) ? 2*values[i-1] - values[i-2] : values[0];
+      orDirect |= zigzagEncode( values[i] );
+      orDelta  |= zigzagEncode( values[i] - values[i-1] );
+      orLinear |= zigzagEncode( values[i] - predLinear );
+    }
+    mode     = COEF_DIRECT;
+    bitWidth = bitLength( orDirect );
+    if( bitLength( orDelta ) < bitWidth ) {
+      mode     = COEF_DELTA;
+      bitWidth = bitLength( orDelta );
+    }
+    if( bitLength( orLinear ) < bitWidth ) {
+      mode     = COEF_LINEAR;
+      bitWidth = bitLength( orLinear );
+    }
+    bitWidthFirst = bitLength( zigzagEncode( values[0] ) );
+    return( BYTES_HEADER_COEF + ( bitWidthFirst + (numValues-1)*bitWidth + 7 ) / 8 );
+  }
+  /// @return number of bytes required to code all coefficients
+  int coefByteSize( csInt64_t const* values, int numValues ) {
+    int byteSize = 0;
+    for( int first = 0; first < numValues; first += csSampleCodec::GROUP_SIZE ) {
+      int mode, bitWidthFirst, bitWidth;
+      byteSize += selectCoefMode( &values[first], std::min( (int)csSampleCodec::GROUP_SIZE, numValues - first ), mode, bitWidthFirst, bitWidth );
+    }
+    return byteSize;
+  }
+  unsigned char* encodeCoefGroup( csInt64_t const* values, int numValues, unsigned char* ptr ) {
+    int mode;
+    int bitWidthFirst;
+    int bitWidth;
+    selectCoefMode( values, numValues, mode, bitWidthFirst, bitWidth );
+    *ptr++ = (unsigned char)mode;
+    *ptr++ = (unsigned char)bitWidthFirst;
+    *ptr++ = (unsigned char)bitWidth;
+    BitWriter writer( ptr );
+    writer.put( zigzagEncode( values[0] ), bitWidthFirst );
+    if( bitWidth > 0 ) {
+      for( int i = 1; i < numValues; i++ ) {
+        csInt64_t pred = 0;
+        if( mode == COEF_DELTA ) pred = values[i-1];
+        else if( mode == COEF_LINEAR ) pred = ( i > 1 ) ? 2*values[i-1] - values[i-2] : values[0];
+        writer.put( zigzagEncode( values[i] - pred ), bitWidth );
+      }
+    }
+    return writer.flush();
+  }
+  unsigned char const* decodeCoefGroup( unsigned char const* ptr, unsigned char const* end, int numValues, csInt64_t* values ) {
+    if( end - ptr < BYTES_HEADER_COEF ) throw( csException("csSampleCodec::decodeLossy: Unexpected end of encoded data") );
+    int mode          = ptr[0];
+    int bitWidthFirst = ptr[1];
+    int bitWidth      = ptr[2];
+    ptr += BYTES_HEADER_COEF;
+    if( mode > COEF_LINEAR || bitWidthFirst > MAX_BIT_WIDTH_COEF || bitWidth > MAX_BIT_WIDTH_COEF ) {
+      throw( csException("csSampleCodec::decodeLossy: Corrupt data: Coefficient group header") );
+    }
+    BitReader reader( ptr, end );
+    values[0] = zigzagDecode( reader.get( bitWidthFirst ) );
+    for( int i = 1; i < numValues; i++ ) {
+      csInt64_t pred = 0;
+      if( mode == COEF_DELTA ) pred = values[i-1];
+      else if( mode == COEF_LINEAR ) pred = ( i > 1 ) ? 2*values[i-1] - values[i-2] : values[0];
+      values[i] = pred + ( bitWidth > 0 ? zigzagDecode( reader.get( bitWidth ) ) : 0 );
+    }
+    return reader.align();
+  }
+
+  /**
+   * Quantize samples to integer multiples of step
+   * @return false if the error exceeds maxError for any sample, or samples are too large for the given step
+   */
+  bool quantize( float const* samples, int numSamples, float step, double maxError, csInt64_t* values, double& errorEnergy ) {
+    errorEnergy = 0;
+    for( int isamp = 0; isamp < numSamples; isamp++ ) {
+      double ratio = (double)samples[isamp] / (double)step;
+      if( !( fabs(ratio) < MAX_QUANTIZED_VALUE ) ) return false;  // Also catches NaN and Inf
+      values[isamp] = (csInt64_t)floor( ratio + 0.5 );
+      // Reconstruction exactly as in decodeLossy()
+      float sampleOut = (float)( (double)values[isamp] * (double)step );
+      double error = (double)samples[isamp] - (double)sampleOut;
+      if( fabs(error) > maxError ) return false;
+      errorEnergy += error*error;
+    }
+    return true;
+  }
+}
+
+//--------------------------------------------------------------------
+int csSampleCodec::maxEncodedByteSize( int numSamples ) {
+  int numGroups = ( numSamples + GROUP_SIZE - 1 ) / GROUP_SIZE;
+  return( 1 + numGroups * BYTES_HEADER_RAW + numSamples * 4 );
+}
+//--------------------------------------------------------------------
+int csSampleCodec::encode( float const* samples, int numSamples, char* buffer ) {
+  unsigned int bits[GROUP_SIZE];
+  unsigned char* ptr = (unsigned char*)buffer;
+  for( int sampFirst = 0; sampFirst < numSamples; sampFirst += GROUP_SIZE ) {
+    int numSamplesGroup = std::min( (int)GROUP_SIZE, numSamples - sampFirst );
+    memcpy( bits, &samples[sampFirst], numSamplesGroup*4 );
+    ptr = encodeGroup( bits, numSamplesGroup, ptr );
+  }
+  return (int)( ptr - (unsigned char*)buffer );
+}
+//--------------------------------------------------------------------
+void csSampleCodec::decode( char const* buffer, int byteSize, int numSamples, float* samples ) {
+  unsigned int bits[GROUP_SIZE];
+  unsigned char const* ptr = (unsigned char const*)buffer;
+  unsigned char const* end = ptr + byteSize;
+  for( int sampFirst = 0; sampFirst < numSamples; sampFirst += GROUP_SIZE ) {
+    int numSamplesGroup = std::min( (int)GROUP_SIZE, numSamples - sampFirst );
+    if( ptr == end ) throw( csException("csSampleCodec::decode: Unexpected end of encoded data") );
+    int mode = *ptr++;
+    if( mode == MODE_INTEGER || mode == MODE_INTEGER_LINEAR ) {
+      if( end - ptr < BYTES_HEADER_INTEGER-1 ) throw( csException("csSampleCodec::decode: Unexpected end of encoded data") );
+      short lsbExponent;
+      memcpy( &lsbExponent, ptr, 2 );
+      int bitWidthFirst = ptr[2];
+      int bitWidth      = ptr[3];
+      ptr += 4;
+      if( bitWidthFirst > MAX_BIT_WIDTH || bitWidth > MAX_BIT_WIDTH ) {
+        throw( csException("csSampleCodec::decode: Corrupt data: Bit widths %d %d", bitWidthFirst, bitWidth) );
+      }
+      float* samplesGroup = &samples[sampFirst];
+      if( bitWidthFirst == 0 && bitWidth == 0 ) {
+        for( int isamp = 0; isamp < numSamplesGroup; isamp++ ) {
+          samplesGroup[isamp] = 0.0f;
+        }
+        continue;
+      }
+      // value * 2^lsbExponent is exact in double precision, and so is the conversion to the original float
+      double scalar = ldexp( 1.0, lsbExponent );
+      BitReader reader( ptr, end );
+      csInt64_t value = zigzagDecode( reader.get( bitWidthFirst ) );
+      samplesGroup[0] = (float)( (double)value * scalar );
+      if( mode == MODE_INTEGER ) {
+        for( int isamp = 1; isamp < numSamplesGroup; isamp++ ) {
+          value += zigzagDecode( reader.get( bitWidth ) );
+          samplesGroup[isamp] = (float)( (double)value * scalar );
+        }
+      }
+      else {
+        csInt64_t valuePrev = value;
+        for( int isamp = 1; isamp < numSamplesGroup; isamp++ ) {
+          csInt64_t valueNew = 2*value - valuePrev + zigzagDecode( reader.get( bitWidth ) );
+          valuePrev = value;
+          value     = valueNew;
+          samplesGroup[isamp] = (float)( (double)value * scalar );
+        }
+      }
+      ptr = reader.align();
+    }
+    else if( mode == MODE_FLOAT ) {
+      if( end - ptr < BYTES_HEADER_FLOAT-1 ) throw( csException("csSampleCodec::decode: Unexpected end of encoded data") );
+      int signMode         = ptr[0];
+      int exponent         = ptr[1];
+      int exponentBitWidth = ptr[2];
+      int mantissaBitWidth = ptr[3];
+      ptr += 4;
+      if( signMode > SIGN_MIXED || exponentBitWidth > MAX_BIT_WIDTH || mantissaBitWidth > NUM_MANTISSA_BITS ) {
+        throw( csException("csSampleCodec::decode: Corrupt data: Float group header") );
+      }
+      BitReader reader( ptr, end );
+      for( int isamp = 0; isamp < numSamplesGroup; isamp++ ) {
+        unsigned int sign = ( signMode == SIGN_MIXED ) ? (unsigned int)reader.get( 1 ) : (unsigned int)signMode;
+        bits[isamp] = sign << 31;
+      }
+      for( int isamp = 0; isamp < numSamplesGroup; isamp++ ) {
+        if( exponentBitWidth > 0 ) exponent += (int)zigzagDecode( reader.get( exponentBitWidth ) );
+        bits[isamp] |= ( (unsigned int)exponent & 0xff ) << 23;
+      }
+      if( mantissaBitWidth > 0 ) {
+        int mantissaShift = NUM_MANTISSA_BITS - mantissaBitWidth;
+        for( int isamp = 0; isamp < numSamplesGroup; isamp++ ) {
+          bits[isamp] |= (unsigned int)reader.get( mantissaBitWidth ) << mantissaShift;
+        }
+      }
+      ptr = reader.align();
+      memcpy( &samples[sampFirst], bits, numSamplesGroup*4 );
+    }
+    else if( mode == MODE_RAW ) {
+      if( end - ptr < numSamplesGroup*4 ) throw( csException("csSampleCodec::decode: Unexpected end of encoded data") );
+      memcpy( &samples[sampFirst], ptr, numSamplesGroup*4 );
+      ptr += numSamplesGroup*4;
+    }
+    else {
+      throw( csException("csSampleCodec::decode: Corrupt data: Unknown group mode %d", mode) );
+    }
+  }
+  if( ptr != end ) {
+    throw( csException("csSampleCodec::decode: Size of encoded data (%d bytes) does not match number of samples (%d)", byteSize, numSamples) );
+  }
+}
+//--------------------------------------------------------------------
+int csSampleCodec::encodeLossy( float const* samples, int numSamples, float maxError, char* buffer, double& energy, double& errorEnergy ) {
+  energy = 0;
+  double maxAbs = 0;
+  for( int isamp = 0; isamp < numSamples; isamp++ ) {
+    energy += (double)samples[isamp] * (double)samples[isamp];
+    if( fabs(samples[isamp]) > maxAbs ) maxAbs = fabs(samples[isamp]);
+  }
+  errorEnergy = 0;
+  unsigned char* ptr = (unsigned char*)buffer;
+  int maxByteSize = maxEncodedByteSize( numSamples );
+  int byteSize = maxByteSize+1;
+
+  // Quantization step below twice the maximum error leaves room for rounding of the reconstructed samples to float
+  float step = (float)( 2.0 * ( (double)maxError - ldexp( maxAbs, -NUM_MANTISSA_BITS ) ) * (1.0 - 1.0/1024.0) );
+  if( maxError > 0 && numSamples > 0 && step > 0 ) {
+    csInt64_t* values    = new csInt64_t[numSamples];
+    csInt64_t* quantized = new csInt64_t[numSamples];
+    csInt64_t* temp      = new csInt64_t[numSamples];
+    if( quantize( samples, numSamples, step, maxError, quantized, errorEnergy ) ) {
+      // Number of wavelet levels giving the smallest size. Strongly oversampled data may code best without transform,
+      // by prediction from previous values
+      memcpy( values, quantized, numSamples*sizeof(csInt64_t) );
+      int numLevels = 0;
+      byteSize = coefByteSize( values, numSamples );
+      int length = numSamples;
+      for( int level = 1; level <= MAX_WAVELET_LEVELS && length > MIN_WAVELET_LENGTH; level++ ) {
+        forwardWaveletLevel( values, length, temp );
+        length = (length+1)/2;
+        int byteSizeLevel = coefByteSize( values, numSamples );
+        if( byteSizeLevel < byteSize ) {
+          byteSize  = byteSizeLevel;
+          numLevels = level;
+        }
+      }
+      memcpy( values, quantized, numSamples*sizeof(csInt64_t) );
+      length = numSamples;
+      for( int level = 0; level < numLevels; level++ ) {
+        forwardWaveletLevel( values, length, temp );
+        length = (length+1)/2;
+      }
+      byteSize += BYTES_HEADER_WAVELET;
+      if( byteSize <= maxByteSize ) {
+        *ptr++ = (unsigned char)TRACE_WAVELET;
+        memcpy( ptr, &step, 4 );
+        ptr += 4;
+        *ptr++ = (unsigned char)numLevels;
+        for( int sampFirst = 0; sampFirst < numSamples; sampFirst += GROUP_SIZE ) {
+          ptr = encodeCoefGroup( &values[sampFirst], std::min( (int)GROUP_SIZE, numSamples - sampFirst ), ptr );
+        }
+      }
+    }
+    delete [] values;
+    delete [] quantized;
+    delete [] temp;
+  }
+  if( byteSize > maxByteSize ) {
+    // Samples cannot be quantized within the maximum error, or quantized samples do not compress: Code losslessly
+    errorEnergy = 0;
+    *ptr++ = (unsigned char)TRACE_LOSSLESS;
+    ptr += encode( samples, numSamples, (char*)ptr );
+  }
+  return (int)( ptr - (unsigned char*)buffer );
+}
+//--------------------------------------------------------------------
+void csSampleCodec::decodeLossy( char const* buffer, int byteSize, int numSamples, float* samples ) {
+  if( byteSize < 1 ) throw( csException("csSampleCodec::decodeLossy: Unexpected end of encoded data") );
+  unsigned char const* ptr = (unsigned char const*)buffer;
+  unsigned char const* end = ptr + byteSize;
+  int mode = *ptr++;
+  if( mode == TRACE_LOSSLESS ) {
+    decode( (char const*)ptr, byteSize-1, numSamples, samples );
+    return;
+  }
+  if( mode != TRACE_WAVELET || byteSize < BYTES_HEADER_WAVELET ) {
+    throw( csException("csSampleCodec::decodeLossy: Corrupt data: Trace header") );
+  }
+  float step;
+  memcpy( &step, ptr, 4 );
+  int numLevels = ptr[4];
+  ptr += 5;
+  if( numLevels > MAX_WAVELET_LEVELS ) throw( csException("csSampleCodec::decodeLossy: Corrupt data: Number of wavelet levels %d", numLevels) );
+  csInt64_t* values = new csInt64_t[numSamples];
+  csInt64_t* temp   = new csInt64_t[numSamples];
+  try {
+    for( int sampFirst = 0; sampFirst < numSamples; sampFirst += GROUP_SIZE ) {
+      ptr = decodeCoefGroup( ptr, end, std::min( (int)GROUP_SIZE, numSamples - sampFirst ), &values[sampFirst] );
+    }
+    if( ptr != end ) {
+      throw( csException("csSampleCodec::decodeLossy: Size of encoded data (%d bytes) does not match number of samples (%d)", byteSize, numSamples) );
+    }
+  }
+  catch( csException& ) {
+    delete [] values;
+    delete [] temp;
+    throw;
+  }
+  inverseWavelet( values, numSamples, numLevels, temp );
+  for( int isamp = 0; isamp < numSamples; isamp++ ) {
+    samples[isamp] = (float)( (double)values[isamp] * (double)step );
+  }
+  delete [] values;
+  delete [] temp;
+}
@@ -0,0 +1,21 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csSharedBuffer.h"
+
+using namespace cseis_geolib;
+
+csSharedBuffer::csSharedBuffer() :
+  myNumRefs( 1 )
+{
+}
+csSharedBuffer::~csSharedBuffer() {
+}
+void csSharedBuffer::addRef() {
+  myNumRefs.fetch_add( 1, std::memory_order_relaxed );
+}
+void csSharedBuffer::release() {
+  if( myNumRefs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+    delete this;
+  }
+}
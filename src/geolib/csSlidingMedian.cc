@@ -0,0 +1,121 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csSlidingMedian.h"
+#include "csException.h"
+
+using namespace cseis_geolib;
+
+csSlidingMedian::csSlidingMedian( int windowLength ) {
+  init( windowLength, windowLength/2 );
+}
+csSlidingMedian::csSlidingMedian( int windowLength, int rank ) {
+  init( windowLength, rank );
+}
+void csSlidingMedian::init( int windowLength, int rank ) {
+  if( windowLength < 1 ) {
+    throw( csException("csSlidingMedian: Window length must be at least 1. Specified: %d", windowLength) );
+  }
+  if( rank < 0 || rank >= windowLength ) {
+    throw( csException("csSlidingMedian: Rank (%d) must be between 0 and window length-1 (%d)", rank, windowLength-1) );
+  }
+  myWindowLength = windowLength;
+  myRank         = rank;
+  myValues       = new float[windowLength];
+  myIsInLower    = new bool[windowLength];
+  myHeapPos      = new int[windowLength];
+  myLowerHeap    = new int[rank+2];  // One extra for temporary overflow in push()
+  myUpperHeap    = new int[windowLength-rank];
+  clear();
+}
+csSlidingMedian::~csSlidingMedian() {
+  delete [] myValues;
+  delete [] myIsInLower;
+  delete [] myHeapPos;
+  delete [] myLowerHeap;
+  delete [] myUpperHeap;
+}
+void csSlidingMedian::clear() {
+  myNumValues  = 0;
+  mySlotOldest = 0;
+  myLowerSize  = 0;
+  myUpperSize  = 0;
+}
+//--------------------------------------------------------------------
+void csSlidingMedian::push( float value ) {
+  if( myNumValues < myWindowLength ) {
+    // Window not full yet: Add value to lower heap, move largest value to upper heap if lower heap is complete
+    int slot = myNumValues++;
+    myValues[slot]    = value;
+    myIsInLower[slot] = true;
+    myHeapPos[slot]   = myLowerSize;
+    myLowerHeap[myLowerSize++] = slot;
+    siftUp( true, myLowerSize-1 );
+    if( myLowerSize > myRank+1 ) {
+      int slotMax = myLowerHeap[0];
+      myLowerSize -= 1;
+      if( myLowerSize > 0 ) {
+        myLowerHeap[0] = myLowerHeap[myLowerSize];
+        myHeapPos[myLowerHeap[0]] = 0;
+        siftDown( true, 0 );
+      }
+      myIsInLower[slotMax] = false;
+      myHeapPos[slotMax]   = myUpperSize;
+      myUpperHeap[myUpperSize++] = slotMax;
+      siftUp( false, myUpperSize-1 );
+      return;
+    }
+  }
+  else {
+    // Window full: Replace oldest value, restore order within its heap
+    int slot = mySlotOldest;
+    mySlotOldest = ( mySlotOldest + 1 ) % myWindowLength;
+    myValues[slot] = value;
+    siftUp( myIsInLower[slot], myHeapPos[slot] );
+    siftDown( myIsInLower[slot], myHeapPos[slot] );
+  }
+  // Restore order between heaps. Only the updated value can violate the order
+  if( myUpperSize > 0 && myValues[myLowerHeap[0]] > myValues[myUpperHeap[0]] ) {
+    swapTops();
+  }
+}
+//--------------------------------------------------------------------
+void csSlidingMedian::swapTops() {
+  int slotLower = myLowerHeap[0];
+  int slotUpper = myUpperHeap[0];
+  myLowerHeap[0] = slotUpper;
+  myUpperHeap[0] = slotLower;
+  myIsInLower[slotUpper] = true;
+  myIsInLower[slotLower] = false;
+  siftDown( true, 0 );
+  siftDown( false, 0 );
+}
+void csSlidingMedian::siftUp( bool isLower, int pos ) {
+  int* heap = isLower ? myLowerHeap : myUpperHeap;
+  int slot = heap[pos];
+  while( pos > 0 ) {
+    int posParent = (pos-1)/2;
+    if( !isBefore( isLower, slot, heap[posParent] ) ) break;
+    heap[pos] = heap[posParent];
+    myHeapPos[heap[pos]] = pos;
+    pos = posParent;
+  }
+  heap[pos] = slot;
+  myHeapPos[slot] = pos;
+}
+void csSlidingMedian::siftDown( bool isLower, int pos ) {
+  int* heap = isLower ? myLowerHeap : myUpperHeap;
+  int size  = isLower ? myLowerSize : myUpperSize;
+  int slot = heap[pos];
+  while( true ) {
+    int posChild = 2*pos + 1;
+    if( posChild >= size ) break;
+    if( posChild+1 < size && isBefore( isLower, heap[posChild+1], heap[posChild] ) ) posChild += 1;
+    if( !isBefore( isLower, heap[posChild], slot ) ) break;
+    heap[pos] = heap[posChild];
+    myHeapPos[heap[pos]] = pos;
+    pos = posChild;
+  }
+  heap[pos] = slot;
+  myHeapPos[slot] = pos;
+}
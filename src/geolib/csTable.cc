@@ -26,6 +26,7 @@ csTable::csTable() {
 
   myNumCols        = 0;
   myNumLocations   = 0;
+  myIsKeySorted    = false;
   myIndexTimeCol   = 0;
   myIndexFirstValueCol = 0;
   myHasReadTableContents = false;
@@ -288,6 +289,10 @@ void csTable::readTableContents( type_t const* types, int numCols ) {
     for( int i = 0; i < myNumLocations; i++ ) {
       myKeyValues[i] = keyValueList.at(i);
     }
+    myIsKeySorted = ( myNumKeys == 1 );
+    for( int i = 1; i < myNumLocations && myIsKeySorted; i++ ) {
+      myIsKeySorted = ( myKeyValues[i][0] >= myKeyValues[i-1][0] );
+    }
   }
   else { // No keys specified --> there is only a single location
     myNumLocations = 1;
@@ -554,6 +559,34 @@ void csTable::findKeyLocation( double const* keyValues_in, int& locLeft, int& lo
 //  for( int ikey = 0; ikey < myNumKeys; ikey++ ) {
   int ikey = 0;
   double currentKeyValue = keyValues_in[ikey];
+  if( myIsKeySorted ) {
+    // Binary search for last location with key value <= current key value. Same result as linear search below
+    if( !(currentKeyValue >= myKeyValues[0][ikey]) ) {
+      locLeft  = 0;
+      locRight = 0;
+      weight   = 1.0;
+      return;
+    }
+    int location = 0;
+    int locEnd   = myNumLocations;
+    while( locEnd - location > 1 ) {
+      int locMid = (location + locEnd) / 2;
+      if( currentKeyValue >= myKeyValues[locMid][ikey] ) {
+        location = locMid;
+      }
+      else {
+        locEnd = locMid;
+      }
+    }
+    locLeft  = location;
+    locRight = location;
+    weight   = 1.0;
+    if( location < myNumLocations-1 && currentKeyValue != myKeyValues[location][ikey] ) {
+      locRight = location+1;
+      weight = (currentKeyValue-myKeyValues[location][ikey])/(myKeyValues[location+1][ikey]-myKeyValues[location][ikey]);
+    }
+    return;
+  }
   for( int location = myNumLocations-1; location >= 0; location-- ) {
     if( currentKeyValue >= myKeyValues[location][ikey] ) {
       if( location == myNumLocations-1 ) {
@@ -44,6 +44,11 @@ void csTableNew::init( int tableType ) {
   myValueColumns   = NULL;
 
   myNumLocations   = 0;
+  myNumKeyRuns     = 0;
+  myKeyRunStart    = NULL;
+  myKeyRunEnd      = NULL;
+  myKeyHashSlots   = NULL;
+  myKeyHashMask    = 0;
   myHasReadTableContents = false;
   myHasBeenInitialized   = false;
 
@@ -172,6 +177,15 @@ void csTableNew::clearBuffers() {
     delete [] myKeyValues;
     myKeyValues = NULL;
   }
+  if( myKeyRunStart != NULL ) {
+    delete [] myKeyRunStart;
+    delete [] myKeyRunEnd;
+    delete [] myKeyHashSlots;
+    myKeyRunStart  = NULL;
+    myKeyRunEnd    = NULL;
+    myKeyHashSlots = NULL;
+  }
+  myNumKeyRuns = 0;
 }
 
 //-----------------------------------------------------------------------------------
@@ -427,6 +441,77 @@ no matching function for call to 'cseis_geolib::csTimeFunction<double>::set(csei
       }
     }
   }
+  buildKeyIndex();
+}
+
+//-----------------------------------------------------------------------------------
+// Hash index of exact key values
+// Consecutive locations with identical exact key values form one run. Each run is entered into an open addressing
+// hash table. Table does not need to be sorted. If the same key values occur in more than one run, the first run is used.
+//
+namespace {
+  inline unsigned long long hashKeyValue( unsigned long long hash, double value ) {
+    if( value == 0.0 ) value = 0.0;  // -0.0 == 0.0
+    unsigned long long bits;
+    memcpy( &bits, &value, sizeof(double) );
+    hash ^= bits;
+    hash *= 0x100000001b3ULL;
+    return( hash ^ (hash >> 29) );
+  }
+  unsigned long long const HASH_SEED = 0xcbf29ce484222325ULL;
+}
+unsigned long long csTableNew::hashExactKeys( double const* keyValues_in ) const {
+  unsigned long long hash = HASH_SEED;
+  for( int ikey = 0; ikey < myNumKeys; ikey++ ) {
+    hash = hashKeyValue( hash, keyValues_in[ikey] );
+  }
+  return hash;
+}
+unsigned long long csTableNew::hashExactKeys( int location ) const {
+  unsigned long long hash = HASH_SEED;
+  for( int ikey = 0; ikey < myNumKeys; ikey++ ) {
+    hash = hashKeyValue( hash, myKeyValues[ikey][location] );
+  }
+  return hash;
+}
+bool csTableNew::isSameExactKeys( int location1, int location2 ) const {
+  for( int ikey = 0; ikey < myNumKeys; ikey++ ) {
+    if( myKeyValues[ikey][location1] != myKeyValues[ikey][location2] ) return false;
+  }
+  return true;
+}
+void csTableNew::buildKeyIndex() {
+  if( myNumKeys == 0 || myKeyValues == NULL || myNumLocations == 0 ) return;
+
+  int* runStart = new int[myNumLocations];
+  int* runEnd   = new int[myNumLocations];
+  int numRuns = 0;
+  runStart[0] = 0;
+  for( int iloc = 1; iloc < myNumLocations; iloc++ ) {
+    if( !isSameExactKeys( iloc, iloc-1 ) ) {
+      runEnd[numRuns++] = iloc-1;
+      runStart[numRuns] = iloc;
+    }
+  }
+  runEnd[numRuns++] = myNumLocations-1;
+
+  int numSlots = 2;
+  while( numSlots < 2*numRuns ) numSlots *= 2;
+  myKeyHashSlots = new int[numSlots];
+  myKeyHashMask  = numSlots-1;
+  for( int islot = 0; islot < numSlots; islot++ ) {
+    myKeyHashSlots[islot] = -1;
+  }
+  for( int irun = 0; irun < numRuns; irun++ ) {
+    int islot = (int)( hashExactKeys( runStart[irun] ) & myKeyHashMask );
+    while( myKeyHashSlots[islot] >= 0 && !isSameExactKeys( runStart[myKeyHashSlots[islot]], runStart[irun] ) ) {
+      islot = (islot + 1) & myKeyHashMask;
+    }
+    if( myKeyHashSlots[islot] < 0 ) myKeyHashSlots[islot] = irun;
+  }
+  myKeyRunStart = runStart;
+  myKeyRunEnd   = runEnd;
+  myNumKeyRuns  = numRuns;
 }
 
 //-----------------------------------------------------------------------------------
@@ -446,6 +531,29 @@ double csTableNew::getKeyValue( int indexLocation, int indexKey ) const {
 // Reminder: Non-interpolated keys come first, in fields keyValues_in and myKeyValues 
 //
 bool csTableNew::findExactKeyLocation( double const* keyValues_in, int& locStart, int& locEnd ) const {
+  if( myKeyHashSlots == NULL ) {
+    return findExactKeyLocationLinear( keyValues_in, locStart, locEnd );
+  }
+  locStart = -1;
+  locEnd   = -1;
+  int islot = (int)( hashExactKeys( keyValues_in ) & myKeyHashMask );
+  while( myKeyHashSlots[islot] >= 0 ) {
+    int irun = myKeyHashSlots[islot];
+    int loc  = myKeyRunStart[irun];
+    int ikey = 0;
+    while( ikey < myNumKeys && keyValues_in[ikey] == myKeyValues[ikey][loc] ) {
+      ikey += 1;
+    }
+    if( ikey == myNumKeys ) {
+      locStart = loc;
+      locEnd   = myKeyRunEnd[irun];
+      return true;
+    }
+    islot = (islot + 1) & myKeyHashMask;
+  }
+  return false;
+}
+bool csTableNew::findExactKeyLocationLinear( double const* keyValues_in, int& locStart, int& locEnd ) const {
   locStart = -1;
   locEnd   = -1;
   int startLocationIndex = 0;
@@ -812,6 +920,9 @@ void csTableNew::dump() const {
 //
 //
 csTimeFunction<double> const* csTableNew::getFunction( double const* keyValues_in, bool dump ) const {
+  return getFunction( keyValues_in, myCurrentTimeFunction, dump );
+}
+csTimeFunction<double> const* csTableNew::getFunction( double const* keyValues_in, csTimeFunction<double>* timeFunction, bool dump ) const {
   int locLeft    = 0;
   int locRight   = myNumLocations-1;
   double weightLoc = 1.0;
@@ -823,9 +934,10 @@ csTimeFunction<double> const* csTableNew::getFunction( double const* keyValues_i
 
   if( myNumAllKeys > 0 ) {
     if( myNumInterpKeys == 0 ) { // No interpolation, need to find excact key
-      if( !findInterpKeyLocation( keyValues_in[myNumKeys-1], 0, locLeft, locRight, weightLoc ) ) {
+      if( !findExactKeyLocation( keyValues_in, locLeft, locRight ) ) {
         throw( csException("Key value not found: %f. Suggest to specify to interpolate key value.\n", keyValues_in[myNumKeys-1]) );
       }
+      locRight      = locLeft;
       timeFuncLeft  = myTimeFunctions2D[locLeft];
       timeFuncRight = myTimeFunctions2D[locRight];
       //      fprintf(stderr,"Locations: %f  %d %d   %f\n", keyValues_in[0], locLeft, locRight, weightLoc );
@@ -853,18 +965,18 @@ csTimeFunction<double> const* csTableNew::getFunction( double const* keyValues_i
     } // END more than one interpolated key
   } // END if myNumAllKeys > 0
 
-  interpolateTimeFunction( timeFuncLeft, timeFuncRight, weightLoc, myCurrentTimeFunction );
+  interpolateTimeFunction( timeFuncLeft, timeFuncRight, weightLoc, timeFunction );
 
   if( dump ) {
-    for(int i = 0; i < myCurrentTimeFunction->numValues(); i++ ) {
+    for(int i = 0; i < timeFunction->numValues(); i++ ) {
       for( int ikey = 0; ikey < myNumAllKeys; ikey++ ) {
 	fprintf(stdout,"%f ", keyValues_in[ikey] );
       }
-      fprintf(stdout,"%f %f\n",myCurrentTimeFunction->timeAtIndex( i ), myCurrentTimeFunction->valueAtIndex( i ) );
+      fprintf(stdout,"%f %f\n",timeFunction->timeAtIndex( i ), timeFunction->valueAtIndex( i ) );
     }
   }
 
-  return myCurrentTimeFunction;
+  return timeFunction;
 }
 
 void csTableNew::interpolateTimeFunction( csTimeFunction<double> const* timeFuncLeft, csTimeFunction<double> const* timeFuncRight,
@@ -0,0 +1,234 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csVelocityScan.h"
+#include "csInterpolation.h"
+#include "csException.h"
+#include "geolib_window.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace cseis_geolib;
+
+csVelocityScan::csVelocityScan( int numSamples, double sampleInt_ms, int moveoutType, int windowHalfLength ) {
+  if( moveoutType != MOVEOUT_PP && moveoutType != MOVEOUT_PS && moveoutType != MOVEOUT_LINEAR ) {
+    throw( csException("csVelocityScan: Unknown moveout type: %d", moveoutType) );
+  }
+  myNumSamples       = numSamples;
+  mySampleInt_sec    = sampleInt_ms/1000.0;
+  mySampleInt_ms     = (float)sampleInt_ms;
+  myMoveoutType      = moveoutType;
+  myWindowHalfLength = windowHalfLength;
+  myLinearRefVel        = 0;
+  myLinearRefVelInverse = 0;
+  myNumThreads       = 1;
+
+  myTimeZeroSq = new double[myNumSamples];
+  for( int isamp = 0; isamp < myNumSamples; isamp++ ) {
+    double time = (double)isamp*mySampleInt_sec;
+    myTimeZeroSq[isamp] = time * time;
+  }
+  myOffsetSq       = NULL;
+  myNumTracesAlloc = 0;
+  myNumTraces      = 0;
+  mySamples        = NULL;
+  myOffsets        = NULL;
+  mySampleMuteEnd  = NULL;
+
+  // Same interpolation operators as csNMOCorrection (NMO) and csInterpolation::static_shift (LMO)
+  if( myMoveoutType == MOVEOUT_LINEAR ) {
+    myInterpol = new csInterpolation( myNumSamples, mySampleInt_ms, 8 );
+  }
+  else {
+    myInterpol = new csInterpolation( myNumSamples, (float)mySampleInt_sec );
+  }
+  myWorkSpaces    = NULL;
+  myNumWorkSpaces = 0;
+}
+csVelocityScan::~csVelocityScan() {
+  freeWorkSpaces();
+  if( myTimeZeroSq != NULL ) {
+    delete [] myTimeZeroSq;
+    myTimeZeroSq = NULL;
+  }
+  if( myOffsetSq != NULL ) {
+    delete [] myOffsetSq;
+    myOffsetSq = NULL;
+  }
+  if( myInterpol != NULL ) {
+    delete myInterpol;
+    myInterpol = NULL;
+  }
+}
+void csVelocityScan::setLinearReferenceVelocity( float refVel ) {
+  myLinearRefVel = refVel;
+  myLinearRefVelInverse = ( refVel != 0 ) ? 1.0/refVel : 0;
+}
+void csVelocityScan::setNumThreads( int numThreads ) {
+  myNumThreads = numThreads;
+}
+//--------------------------------------------------------------------
+void csVelocityScan::allocateWorkSpaces( int numWorkSpaces ) {
+  if( numWorkSpaces <= myNumWorkSpaces ) return;
+  freeWorkSpaces();
+  myWorkSpaces = new WorkSpace[numWorkSpaces];
+  for( int i = 0; i < numWorkSpaces; i++ ) {
+    WorkSpace* ws = &myWorkSpaces[i];
+    ws->times          = new float[myNumSamples];
+    ws->samplesMoveout = new float[myNumSamples];
+    ws->stack          = new double[myNumSamples];
+    ws->energy         = new double[myNumSamples];
+    ws->sumStackEnergy = new double[myNumSamples];
+    ws->sumTotalEnergy = new double[myNumSamples];
+  }
+  myNumWorkSpaces = numWorkSpaces;
+}
+void csVelocityScan::freeWorkSpaces() {
+  if( myWorkSpaces == NULL ) return;
+  for( int i = 0; i < myNumWorkSpaces; i++ ) {
+    WorkSpace* ws = &myWorkSpaces[i];
+    delete [] ws->times;
+    delete [] ws->samplesMoveout;
+    delete [] ws->stack;
+    delete [] ws->energy;
+    delete [] ws->sumStackEnergy;
+    delete [] ws->sumTotalEnergy;
+  }
+  delete [] myWorkSpaces;
+  myWorkSpaces    = NULL;
+  myNumWorkSpaces = 0;
+}
+//--------------------------------------------------------------------
+void csVelocityScan::setGather( int numTraces, float const* const* samples, float const* offsets, int const* sampleMuteEnd ) {
+  if( numTraces > myNumTracesAlloc ) {
+    if( myOffsetSq != NULL ) delete [] myOffsetSq;
+    myOffsetSq = new double[numTraces];
+    myNumTracesAlloc = numTraces;
+  }
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    double offset = offsets[itrc];
+    myOffsetSq[itrc] = offset*offset;
+  }
+  myNumTraces     = numTraces;
+  mySamples       = samples;
+  myOffsets       = offsets;
+  mySampleMuteEnd = sampleMuteEnd;
+}
+//--------------------------------------------------------------------
+void csVelocityScan::computeSemblance( int numVels, float const* velocities, float const* velMin, float const* velMax, float* semblance ) {
+  if( myMoveoutType != MOVEOUT_LINEAR ) {
+    for( int ivel = 0; ivel < numVels; ivel++ ) {
+      if( velocities[ivel] <= 0.0 ) {
+        throw( csException("csVelocityScan::computeSemblance(): Velocity <= 0 encountered: %f", velocities[ivel]) );
+      }
+    }
+  }
+  int numThreads = myNumThreads;
+#ifdef _OPENMP
+  if( numThreads <= 0 ) numThreads = omp_get_max_threads();
+#endif
+  numThreads = std::max( 1, std::min( numThreads, numVels ) );
+  allocateWorkSpaces( numThreads );
+
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+  for( int ivel = 0; ivel < numVels; ivel++ ) {
+    int threadID = 0;
+#ifdef _OPENMP
+    threadID = omp_get_thread_num();
+#endif
+    computeSemblance( velocities[ivel], velMin, velMax, &myWorkSpaces[threadID], &semblance[ivel*myNumSamples] );
+  }
+}
+//--------------------------------------------------------------------
+void csVelocityScan::computeSemblance( float velocity, float const* velMin, float const* velMax, WorkSpace* ws, float* semblance ) {
+  // Samples where this velocity is tested
+  int sampFirst = -1;
+  int sampLast  = -1;
+  for( int isamp = 0; isamp < myNumSamples; isamp++ ) {
+    if( ( velMin == NULL || velMin[isamp] <= velocity ) && ( velMax == NULL || velMax[isamp] >= velocity ) ) {
+      if( sampFirst < 0 ) sampFirst = isamp;
+      sampLast = isamp;
+    }
+  }
+  if( sampFirst < 0 ) {
+    memset( semblance, 0, myNumSamples*sizeof(float) );
+    return;
+  }
+  // Moveout correction is only required for samples within the semblance window of a tested sample
+  int sampStart = std::max( sampFirst - myWindowHalfLength, 0 );
+  int sampEnd   = std::min( sampLast + myWindowHalfLength, myNumSamples-1 );
+
+  double* stack  = ws->stack;
+  double* energy = ws->energy;
+  memset( stack, 0, myNumSamples*sizeof(double) );
+  memset( energy, 0, myNumSamples*sizeof(double) );
+  float sampleIntSkew = ( myMoveoutType == MOVEOUT_LINEAR ) ? 1.0f : (float)mySampleInt_sec;
+
+  // (1) Stack and total energy across traces, accumulated one trace at a time
+  for( int itrc = 0; itrc < myNumTraces; itrc++ ) {
+    int sampTrcStart = std::max( sampStart, mySampleMuteEnd[itrc]+1 );
+    if( sampTrcStart > sampEnd ) continue;
+    int numSampTrc = sampEnd - sampTrcStart + 1;
+    computeMoveoutTimes( velocity, itrc, sampTrcStart, sampEnd, ws->times );
+    myInterpol->process( sampleIntSkew, 0.0, mySamples[itrc], &ws->times[sampTrcStart], &ws->samplesMoveout[sampTrcStart], numSampTrc );
+    float const* samples = ws->samplesMoveout;
+    for( int isamp = sampTrcStart; isamp <= sampEnd; isamp++ ) {
+      float value = samples[isamp];
+      stack[isamp]  += value;
+      energy[isamp] += value*value;
+    }
+  }
+  for( int isamp = sampStart; isamp <= sampEnd; isamp++ ) {
+    stack[isamp] *= stack[isamp];
+  }
+  // (2) Sum over sliding window
+  compute_window_sum( stack, myNumSamples, -myWindowHalfLength, myWindowHalfLength, ws->sumStackEnergy );
+  compute_window_sum( energy, myNumSamples, -myWindowHalfLength, myWindowHalfLength, ws->sumTotalEnergy );
+
+  for( int isamp = 0; isamp < myNumSamples; isamp++ ) {
+    if( ( velMin != NULL && velMin[isamp] > velocity ) || ( velMax != NULL && velMax[isamp] < velocity ) ) {
+      semblance[isamp] = 0.0;
+    }
+    else if( ws->sumTotalEnergy[isamp] == 0 ) {
+      semblance[isamp] = 0.0;
+    }
+    else {
+      semblance[isamp] = ws->sumStackEnergy[isamp] / ws->sumTotalEnergy[isamp];
+    }
+  }
+}
+//--------------------------------------------------------------------
+// Input times for output samples sampFirst to sampLast.
+// NMO: Times in seconds. LMO: Sample indices, as in csInterpolation::static_shift
+//
+void csVelocityScan::computeMoveoutTimes( float velocity, int itrc, int sampFirst, int sampLast, float* times ) const {
+  double vel = velocity;
+  switch( myMoveoutType ) {
+  case MOVEOUT_PP: {
+    double ratio = myOffsetSq[itrc] / (vel*vel);
+    for( int isamp = sampFirst; isamp <= sampLast; isamp++ ) {
+      times[isamp] = (float)sqrt( myTimeZeroSq[isamp] + ratio );
+    }
+    break;
+  }
+  case MOVEOUT_PS: {
+    double ratio = 2.0 * myOffsetSq[itrc] / (vel*vel);
+    for( int isamp = sampFirst; isamp <= sampLast; isamp++ ) {
+      times[isamp] = (float)( 0.5 * sqrt( myTimeZeroSq[isamp] ) + 0.5 * sqrt( myTimeZeroSq[isamp] + ratio ) );
+    }
+    break;
+  }
+  case MOVEOUT_LINEAR: {
+    float shift_ms = -myOffsets[itrc]*1000.0 * ( (1.0/(myLinearRefVel+velocity)) - myLinearRefVelInverse );
+    float shiftSamples = shift_ms / mySampleInt_ms;
+    for( int isamp = sampFirst; isamp <= sampLast; isamp++ ) {
+      times[isamp] = (float)isamp - shiftSamples;
+    }
+    break;
+  }
+  }
+}
@@ -2,8 +2,40 @@
 /* All rights reserved.                       */
 
 #include "geolib_endian.h"
+#include "geolib_simd.h"
+#include "geolib_platform_dependent.h"
 #include <cstring>
 
+#ifdef ARCHITECTURE_X86_SIMD
+ #include <immintrin.h>
+
+namespace {
+  __attribute__((target("sse2")))
+  int swapEndian4SSE2( char* array, int size ) {
+    int sizeVector = size - size % 16;
+    for( int i = 0; i < sizeVector; i += 16 ) {
+      __m128i x = _mm_loadu_si128( reinterpret_cast<__m128i*>( &array[i] ) );
+      x = _mm_or_si128( _mm_slli_epi16( x, 8 ), _mm_srli_epi16( x, 8 ) );
+      x = _mm_shufflelo_epi16( x, _MM_SHUFFLE(2,3,0,1) );
+      x = _mm_shufflehi_epi16( x, _MM_SHUFFLE(2,3,0,1) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( &array[i] ), x );
+    }
+    return sizeVector;
+  }
+  __attribute__((target("avx2")))
+  int swapEndian4AVX2( char* array, int size ) {
+    __m256i const shuffle = _mm256_setr_epi8( 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+                                              3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12 );
+    int sizeVector = size - size % 32;
+    for( int i = 0; i < sizeVector; i += 32 ) {
+      __m256i x = _mm256_loadu_si256( reinterpret_cast<__m256i*>( &array[i] ) );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( &array[i] ), _mm256_shuffle_epi8( x, shuffle ) );
+    }
+    return sizeVector;
+  }
+}
+#endif
+
 bool cseis_geolib::isPlatformLittleEndian() {
   union {
     unsigned char  cc[2];
@@ -28,7 +60,17 @@ void cseis_geolib::swapEndian4( char* array, int size ) {
     array[2] = tmp;
   }
   else {
-    for( int i = 0; i < size; i+=4 ) {
+    int start = 0;
+#ifdef ARCHITECTURE_X86_SIMD
+    int simdLevel = getSIMDLevel();
+    if( simdLevel >= SIMD_AVX2 ) {
+      start = swapEndian4AVX2( array, size );
+    }
+    else if( simdLevel >= SIMD_SSE2 ) {
+      start = swapEndian4SSE2( array, size );
+    }
+#endif
+    for( int i = start; i < size; i+=4 ) {
       tmp        = array[i+3];
       array[i+3] = array[i];
       array[i]   = tmp;
@@ -6,6 +6,7 @@
 #include <limits>
 #include "geolib_math.h"
 #include "geolib_methods.h"
+#include "csFFTCorrelation.h"
 
 namespace cseis_geolib {
 
@@ -53,6 +54,14 @@ namespace cseis_geolib {
   void compute_twosided_correlation( float const* samplesLeft, float const* samplesRight,
 				     int nSampIn, float* corr, int maxlag_in_num_samples, bool dampen ) {
 
+    // Long series/lags: Correlate in frequency domain
+    if( csFFTCorrelation::isFasterThanTimeDomain( nSampIn, maxlag_in_num_samples, false ) ) {
+      csFFTCorrelation fftCorr( nSampIn, maxlag_in_num_samples );
+      fftCorr.setPilot( samplesLeft );
+      fftCorr.correlate( samplesRight, corr, dampen );
+      return;
+    }
+
     if( !dampen ) {
       //---------------------------------------
       // Compute negative lags
@@ -0,0 +1,43 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "geolib_simd.h"
+#include "geolib_platform_dependent.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+  int detectSIMDLevel() {
+    int level = cseis_geolib::SIMD_NONE;
+#ifdef ARCHITECTURE_X86_SIMD
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports("avx2") ) {
+      level = cseis_geolib::SIMD_AVX2;
+    }
+    else if( __builtin_cpu_supports("sse2") ) {
+      level = cseis_geolib::SIMD_SSE2;
+    }
+#endif
+    char const* env = getenv( "CSEIS_SIMD" );
+    if( env != NULL ) {
+      if( !strcmp( env, "none" ) ) {
+        level = cseis_geolib::SIMD_NONE;
+      }
+      else if( !strcmp( env, "sse2" ) && level > cseis_geolib::SIMD_SSE2 ) {
+        level = cseis_geolib::SIMD_SSE2;
+      }
+    }
+    return level;
+  }
+  int simdLevelMax = -1;
+}
+
+int cseis_geolib::getSIMDLevel() {
+  static int const simdLevelCPU = detectSIMDLevel();
+  if( simdLevelMax >= 0 && simdLevelMax < simdLevelCPU ) return simdLevelMax;
+  return simdLevelCPU;
+}
+
+void cseis_geolib::setMaxSIMDLevel( int level ) {
+  simdLevelMax = level;
+}
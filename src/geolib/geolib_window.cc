@@ -0,0 +1,110 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "geolib_window.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+  template<typename T> struct ValueOf {
+    static inline double get( T value ) { return (double)value; }
+  };
+  template<typename T> struct SquareOf {
+    static inline double get( T value ) { return (double)value*(double)value; }
+  };
+
+  /**
+   * Sliding window sum of Op::get(value)
+   * The data series is divided into blocks of one window length. For each sample, the partial sums from the start of its
+   * block (prefix) and to the end of its block (suffix) are computed. Any window then spans at most two blocks and its
+   * sum is either one prefix, one suffix, or a suffix plus a prefix. Values are only ever added, never subtracted, so
+   * that the sum of a window with small values is not affected by large values elsewhere in the data series.
+   */
+  template<typename T, typename Op>
+  void windowSum( T const* values, int numValues, int offsetFirst, int offsetLast, double* sums ) {
+    int windowLength = offsetLast - offsetFirst + 1;
+    if( windowLength <= 0 ) {
+      for( int isamp = 0; isamp < numValues; isamp++ ) {
+        sums[isamp] = 0.0;
+      }
+      return;
+    }
+    double* prefix = new double[numValues];
+    double* suffix = new double[numValues];
+    for( int blockStart = 0; blockStart < numValues; blockStart += windowLength ) {
+      int blockEnd = std::min( blockStart + windowLength, numValues );
+      double sum = 0.0;
+      for( int i = blockStart; i < blockEnd; i++ ) {
+        sum += Op::get( values[i] );
+        prefix[i] = sum;
+      }
+      sum = 0.0;
+      for( int i = blockEnd-1; i >= blockStart; i-- ) {
+        sum += Op::get( values[i] );
+        suffix[i] = sum;
+      }
+    }
+    for( int isamp = 0; isamp < numValues; isamp++ ) {
+      int sampFirst = std::max( isamp + offsetFirst, 0 );
+      int sampLast  = std::min( isamp + offsetLast, numValues-1 );
+      if( sampFirst > sampLast ) {
+        sums[isamp] = 0.0;
+      }
+      else if( sampFirst / windowLength != sampLast / windowLength ) {
+        sums[isamp] = suffix[sampFirst] + prefix[sampLast];
+      }
+      else if( sampFirst % windowLength == 0 ) {
+        sums[isamp] = prefix[sampLast];
+      }
+      else if( sampLast == numValues-1 || (sampLast+1) % windowLength == 0 ) {
+        sums[isamp] = suffix[sampFirst];
+      }
+      else { // Not expected: Shorter windows are clipped at start or end of data series, handled above
+        double sum = 0.0;
+        for( int i = sampFirst; i <= sampLast; i++ ) {
+          sum += Op::get( values[i] );
+        }
+        sums[isamp] = sum;
+      }
+    }
+    delete [] prefix;
+    delete [] suffix;
+  }
+
+  inline int windowCount( int isamp, int numValues, int halfWidth ) {
+    return( std::min( isamp+halfWidth, numValues-1 ) - std::max( isamp-halfWidth, 0 ) + 1 );
+  }
+}
+
+namespace cseis_geolib {
+
+void compute_window_sum( float const* values, int numValues, int offsetFirst, int offsetLast, double* sums ) {
+  windowSum< float, ValueOf<float> >( values, numValues, offsetFirst, offsetLast, sums );
+}
+void compute_window_sum( double const* values, int numValues, int offsetFirst, int offsetLast, double* sums ) {
+  windowSum< double, ValueOf<double> >( values, numValues, offsetFirst, offsetLast, sums );
+}
+void compute_window_energy( float const* values, int numValues, int offsetFirst, int offsetLast, double* energy ) {
+  windowSum< float, SquareOf<float> >( values, numValues, offsetFirst, offsetLast, energy );
+}
+void compute_window_energy( float const* values, int numValues, int halfWidth, double* energy ) {
+  compute_window_energy( values, numValues, -halfWidth, halfWidth, energy );
+}
+void compute_window_mean( float const* values, int numValues, int halfWidth, float* mean ) {
+  double* sums = new double[numValues];
+  compute_window_sum( values, numValues, -halfWidth, halfWidth, sums );
+  for( int isamp = 0; isamp < numValues; isamp++ ) {
+    mean[isamp] = (float)( sums[isamp] / (double)windowCount( isamp, numValues, halfWidth ) );
+  }
+  delete [] sums;
+}
+void compute_window_rms( float const* values, int numValues, int halfWidth, float* rms ) {
+  double* energy = new double[numValues];
+  compute_window_energy( values, numValues, -halfWidth, halfWidth, energy );
+  for( int isamp = 0; isamp < numValues; isamp++ ) {
+    rms[isamp] = (float)sqrt( energy[isamp] / (double)windowCount( isamp, numValues, halfWidth ) );
+  }
+  delete [] energy;
+}
+
+} // end namespace
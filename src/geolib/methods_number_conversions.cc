@@ -3,11 +3,17 @@
 
 #include "methods_number_conversions.h"
 #include "geolib_endian.h"
+#include "geolib_simd.h"
+#include "geolib_platform_dependent.h"
 #include <cstdlib>
 #include <cstdio>
 #include <cmath>
 #include <cstring>
 
+#ifdef ARCHITECTURE_X86_SIMD
+ #include <immintrin.h>
+#endif
+
 namespace{
 const char e2a[] = {
   '@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@',
@@ -88,30 +94,39 @@ short cseis_geolib::char2ebcdic( char c ) {
   return a2e[ (int)c ];
 }
 
-void cseis_geolib::ibm2ieee( unsigned char* values, int numValues ) {
-  register unsigned fraction;
-  register int exponent;
-  register int signum;
-
-  for( int i = 0; i < numValues; i++ ) {
-    memcpy( &fraction, &values[i*4], 4 );
+//--------------------------------------------------------------------
+// IBM <-> IEEE conversion
+//
+// Scalar conversion of one 32bit word. The vectorized kernels below compute the identical result:
+//
+// IBM to IEEE: The IBM fraction (24 bit) is normalized by converting it to float (exact for 24 bit integers).
+//  The float's mantissa is the normalized IEEE mantissa, its exponent yields the number of leading zeros.
+//  Results below the normalized range are truncated (no rounding), as in the scalar code. This is done by
+//  multiplying the 24bit fraction with 2^-shift and truncating it to integer, which is exact.
+// IEEE to IBM: The IEEE mantissa is shifted right by 0-3 bits to align the exponent to base 16.
+//  The result is always normalized, no further shifting is required.
+//
+namespace {
+  inline unsigned ibm2ieeeWord( unsigned fraction ) {
+    int exponent;
+    int signum;
 
     signum = fraction >> 31;
     fraction <<= 1;
     exponent = fraction >> 25;
     fraction <<= 7;
-    
+
     if( fraction == 0 ) {
       exponent = 0;
     }
     else {
       exponent = (exponent << 2) - 130;
-    
+
       while (fraction < 0x80000000) {
         --exponent;
         fraction <<= 1;
       }
-    
+
       if( exponent <= 0 ) {
         if( exponent < -24 ) {
           fraction = 0;
@@ -129,19 +144,14 @@ void cseis_geolib::ibm2ieee( unsigned char* values, int numValues ) {
         fraction <<= 1;
       }
     }
-    
-    fraction = (fraction >> 9) | (exponent << 23) | (signum << 31);
-    memcpy( &values[i*4], &fraction, 4 );
+
+    return( (fraction >> 9) | (exponent << 23) | (signum << 31) );
   }
-}
 
-void cseis_geolib::ieee2ibm( unsigned char* values, int numValues ) {
-  register unsigned fraction;
-  register int exponent;
-  register int signum;
+  inline unsigned ieee2ibmWord( unsigned fraction ) {
+    int exponent;
+    int signum;
 
-  for( int i = 0; i < numValues; i++ ) {
-    memcpy( &fraction, &values[i*4], 4 );
     signum = fraction >> 31;
     fraction <<= 1;
     exponent = fraction >> 24;
@@ -152,7 +162,7 @@ void cseis_geolib::ieee2ibm( unsigned char* values, int numValues ) {
       exponent += 130;
       fraction >>= -exponent & 3;
       exponent = (exponent + 3) >> 2;
-    
+
       while (fraction < 0x10000000) {
         --exponent;
         fraction <<= 4;
@@ -164,9 +174,216 @@ void cseis_geolib::ieee2ibm( unsigned char* values, int numValues ) {
         exponent = 0x7f;
       }
     }
-    
-    fraction = (fraction >> 8) | (exponent << 24) | (signum << 31);
-    memcpy( &values[i*4], &fraction, 4 );
+
+    return( (fraction >> 8) | (exponent << 24) | (signum << 31) );
   }
 
+  inline unsigned swapWord( unsigned value ) {
+    return( (value << 24) | ((value << 8) & 0x00ff0000) | ((value >> 8) & 0x0000ff00) | (value >> 24) );
+  }
+
+  void ibm2ieeeScalar( unsigned char* values, int numValues, bool doSwapEndian ) {
+    unsigned value;
+    for( int i = 0; i < numValues; i++ ) {
+      memcpy( &value, &values[i*4], 4 );
+      if( doSwapEndian ) value = swapWord( value );
+      value = ibm2ieeeWord( value );
+      memcpy( &values[i*4], &value, 4 );
+    }
+  }
+  void ieee2ibmScalar( unsigned char* values, int numValues, bool doSwapEndian ) {
+    unsigned value;
+    for( int i = 0; i < numValues; i++ ) {
+      memcpy( &value, &values[i*4], 4 );
+      value = ieee2ibmWord( value );
+      if( doSwapEndian ) value = swapWord( value );
+      memcpy( &values[i*4], &value, 4 );
+    }
+  }
+
+#ifdef ARCHITECTURE_X86_SIMD
+  //--------------------------------------------------------------------
+  // SSE2
+  //
+  __attribute__((target("sse2")))
+  inline __m128i swapSSE2( __m128i x ) {
+    x = _mm_or_si128( _mm_slli_epi16( x, 8 ), _mm_srli_epi16( x, 8 ) );
+    x = _mm_shufflelo_epi16( x, _MM_SHUFFLE(2,3,0,1) );
+    return _mm_shufflehi_epi16( x, _MM_SHUFFLE(2,3,0,1) );
+  }
+  // Select a where mask is set, b otherwise
+  __attribute__((target("sse2")))
+  inline __m128i selectSSE2( __m128i mask, __m128i a, __m128i b ) {
+    return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+  }
+  // (value >> shift) for 24bit values and shift = 0..31, computed as truncate(value * 2^-shift)
+  __attribute__((target("sse2")))
+  inline __m128i shiftRightSSE2( __m128i value, __m128i shift ) {
+    __m128 scale = _mm_castsi128_ps( _mm_slli_epi32( _mm_sub_epi32( _mm_set1_epi32(127), shift ), 23 ) );
+    return _mm_cvttps_epi32( _mm_mul_ps( _mm_cvtepi32_ps( value ), scale ) );
+  }
+  __attribute__((target("sse2")))
+  inline __m128i ibm2ieeeSSE2( __m128i w ) {
+    __m128i sign     = _mm_and_si128( w, _mm_set1_epi32( (int)0x80000000 ) );
+    __m128i fraction = _mm_and_si128( w, _mm_set1_epi32( 0x00ffffff ) );
+    __m128i normBits = _mm_castps_si128( _mm_cvtepi32_ps( fraction ) );
+    __m128i mantissa = _mm_and_si128( normBits, _mm_set1_epi32( 0x007fffff ) );
+    // IEEE exponent = 4*ibmExponent - 130 - leadingZeros(fraction<<8) = 4*ibmExponent + floatExponent - 280
+    __m128i exponent = _mm_add_epi32( _mm_and_si128( _mm_srli_epi32( w, 22 ), _mm_set1_epi32( 0x1fc ) ),
+                                      _mm_sub_epi32( _mm_srli_epi32( normBits, 23 ), _mm_set1_epi32( 280 ) ) );
+    __m128i resultNorm = _mm_or_si128( _mm_slli_epi32( exponent, 23 ), mantissa );
+    // Denormalized: 24bit fraction including hidden bit, shifted right by (1-exponent), max 31
+    // Shift is clamped to 0..31 for all lanes: Avoids denormal scale factors which are slow to compute
+    __m128i shift = _mm_sub_epi32( _mm_set1_epi32( 1 ), exponent );
+    shift = selectSSE2( _mm_cmpgt_epi32( shift, _mm_set1_epi32( 31 ) ), _mm_set1_epi32( 31 ), shift );
+    shift = _mm_andnot_si128( _mm_cmplt_epi32( shift, _mm_setzero_si128() ), shift );
+    __m128i resultDenorm = shiftRightSSE2( _mm_or_si128( mantissa, _mm_set1_epi32( 0x00800000 ) ), shift );
+
+    __m128i result = selectSSE2( _mm_cmplt_epi32( exponent, _mm_set1_epi32( 1 ) ), resultDenorm, resultNorm );
+    result = selectSSE2( _mm_cmpgt_epi32( exponent, _mm_set1_epi32( 254 ) ), _mm_set1_epi32( 0x7f800000 ), result );
+    result = _mm_andnot_si128( _mm_cmpeq_epi32( fraction, _mm_setzero_si128() ), result );
+    return _mm_or_si128( result, sign );
+  }
+  __attribute__((target("sse2")))
+  inline __m128i ieee2ibmSSE2( __m128i w ) {
+    __m128i sign     = _mm_and_si128( w, _mm_set1_epi32( (int)0x80000000 ) );
+    __m128i mantissa = _mm_and_si128( w, _mm_set1_epi32( 0x007fffff ) );
+    __m128i exponent = _mm_and_si128( _mm_srli_epi32( w, 23 ), _mm_set1_epi32( 0xff ) );
+    __m128i exp130   = _mm_add_epi32( exponent, _mm_set1_epi32( 130 ) );
+    __m128i shift    = _mm_and_si128( _mm_sub_epi32( _mm_setzero_si128(), exp130 ), _mm_set1_epi32( 3 ) );
+    __m128i fraction = shiftRightSSE2( _mm_or_si128( mantissa, _mm_set1_epi32( 0x00800000 ) ), shift );
+    __m128i resultNorm = _mm_or_si128( fraction, _mm_slli_epi32( _mm_srli_epi32( _mm_add_epi32( exp130, _mm_set1_epi32( 3 ) ), 2 ), 24 ) );
+    // Zero and IEEE denormalized values: Scalar code keeps mantissa shifted by one bit
+    __m128i resultZero = _mm_slli_epi32( mantissa, 1 );
+
+    __m128i result = selectSSE2( _mm_cmpeq_epi32( exponent, _mm_setzero_si128() ), resultZero, resultNorm );
+    result = selectSSE2( _mm_cmpeq_epi32( exponent, _mm_set1_epi32( 255 ) ), _mm_set1_epi32( 0x7fffffff ), result );
+    return _mm_or_si128( result, sign );
+  }
+  __attribute__((target("sse2")))
+  void ibm2ieeeKernelSSE2( unsigned char* values, int numValues, bool doSwapEndian ) {
+    int numVector = numValues - numValues % 4;
+    for( int i = 0; i < numVector; i += 4 ) {
+      __m128i w = _mm_loadu_si128( reinterpret_cast<__m128i*>( &values[i*4] ) );
+      if( doSwapEndian ) w = swapSSE2( w );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( &values[i*4] ), ibm2ieeeSSE2( w ) );
+    }
+    ibm2ieeeScalar( &values[numVector*4], numValues-numVector, doSwapEndian );
+  }
+  __attribute__((target("sse2")))
+  void ieee2ibmKernelSSE2( unsigned char* values, int numValues, bool doSwapEndian ) {
+    int numVector = numValues - numValues % 4;
+    for( int i = 0; i < numVector; i += 4 ) {
+      __m128i w = ieee2ibmSSE2( _mm_loadu_si128( reinterpret_cast<__m128i*>( &values[i*4] ) ) );
+      if( doSwapEndian ) w = swapSSE2( w );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( &values[i*4] ), w );
+    }
+    ieee2ibmScalar( &values[numVector*4], numValues-numVector, doSwapEndian );
+  }
+
+  //--------------------------------------------------------------------
+  // AVX2: Same algorithm as SSE2, 8 values at once
+  //
+  __attribute__((target("avx2")))
+  inline __m256i swapAVX2( __m256i x ) {
+    __m256i const shuffle = _mm256_setr_epi8( 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+                                              3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12 );
+    return _mm256_shuffle_epi8( x, shuffle );
+  }
+  __attribute__((target("avx2")))
+  inline __m256i shiftRightAVX2( __m256i value, __m256i shift ) {
+    __m256 scale = _mm256_castsi256_ps( _mm256_slli_epi32( _mm256_sub_epi32( _mm256_set1_epi32(127), shift ), 23 ) );
+    return _mm256_cvttps_epi32( _mm256_mul_ps( _mm256_cvtepi32_ps( value ), scale ) );
+  }
+  __attribute__((target("avx2")))
+  inline __m256i ibm2ieeeAVX2( __m256i w ) {
+    __m256i sign     = _mm256_and_si256( w, _mm256_set1_epi32( (int)0x80000000 ) );
+    __m256i fraction = _mm256_and_si256( w, _mm256_set1_epi32( 0x00ffffff ) );
+    __m256i normBits = _mm256_castps_si256( _mm256_cvtepi32_ps( fraction ) );
+    __m256i mantissa = _mm256_and_si256( normBits, _mm256_set1_epi32( 0x007fffff ) );
+    __m256i exponent = _mm256_add_epi32( _mm256_and_si256( _mm256_srli_epi32( w, 22 ), _mm256_set1_epi32( 0x1fc ) ),
+                                         _mm256_sub_epi32( _mm256_srli_epi32( normBits, 23 ), _mm256_set1_epi32( 280 ) ) );
+    __m256i resultNorm = _mm256_or_si256( _mm256_slli_epi32( exponent, 23 ), mantissa );
+    __m256i shift = _mm256_min_epi32( _mm256_sub_epi32( _mm256_set1_epi32( 1 ), exponent ), _mm256_set1_epi32( 31 ) );
+    shift = _mm256_max_epi32( shift, _mm256_setzero_si256() );
+    __m256i resultDenorm = shiftRightAVX2( _mm256_or_si256( mantissa, _mm256_set1_epi32( 0x00800000 ) ), shift );
+
+    __m256i result = _mm256_blendv_epi8( resultNorm, resultDenorm, _mm256_cmpgt_epi32( _mm256_set1_epi32( 1 ), exponent ) );
+    result = _mm256_blendv_epi8( result, _mm256_set1_epi32( 0x7f800000 ), _mm256_cmpgt_epi32( exponent, _mm256_set1_epi32( 254 ) ) );
+    result = _mm256_andnot_si256( _mm256_cmpeq_epi32( fraction, _mm256_setzero_si256() ), result );
+    return _mm256_or_si256( result, sign );
+  }
+  __attribute__((target("avx2")))
+  inline __m256i ieee2ibmAVX2( __m256i w ) {
+    __m256i sign     = _mm256_and_si256( w, _mm256_set1_epi32( (int)0x80000000 ) );
+    __m256i mantissa = _mm256_and_si256( w, _mm256_set1_epi32( 0x007fffff ) );
+    __m256i exponent = _mm256_and_si256( _mm256_srli_epi32( w, 23 ), _mm256_set1_epi32( 0xff ) );
+    __m256i exp130   = _mm256_add_epi32( exponent, _mm256_set1_epi32( 130 ) );
+    __m256i shift    = _mm256_and_si256( _mm256_sub_epi32( _mm256_setzero_si256(), exp130 ), _mm256_set1_epi32( 3 ) );
+    __m256i fraction = _mm256_srlv_epi32( _mm256_or_si256( mantissa, _mm256_set1_epi32( 0x00800000 ) ), shift );
+    __m256i resultNorm = _mm256_or_si256( fraction, _mm256_slli_epi32( _mm256_srli_epi32( _mm256_add_epi32( exp130, _mm256_set1_epi32( 3 ) ), 2 ), 24 ) );
+    __m256i resultZero = _mm256_slli_epi32( mantissa, 1 );
+
+    __m256i result = _mm256_blendv_epi8( resultNorm, resultZero, _mm256_cmpeq_epi32( exponent, _mm256_setzero_si256() ) );
+    result = _mm256_blendv_epi8( result, _mm256_set1_epi32( 0x7fffffff ), _mm256_cmpeq_epi32( exponent, _mm256_set1_epi32( 255 ) ) );
+    return _mm256_or_si256( result, sign );
+  }
+  __attribute__((target("avx2")))
+  void ibm2ieeeKernelAVX2( unsigned char* values, int numValues, bool doSwapEndian ) {
+    int numVector = numValues - numValues % 8;
+    for( int i = 0; i < numVector; i += 8 ) {
+      __m256i w = _mm256_loadu_si256( reinterpret_cast<__m256i*>( &values[i*4] ) );
+      if( doSwapEndian ) w = swapAVX2( w );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( &values[i*4] ), ibm2ieeeAVX2( w ) );
+    }
+    ibm2ieeeScalar( &values[numVector*4], numValues-numVector, doSwapEndian );
+  }
+  __attribute__((target("avx2")))
+  void ieee2ibmKernelAVX2( unsigned char* values, int numValues, bool doSwapEndian ) {
+    int numVector = numValues - numValues % 8;
+    for( int i = 0; i < numVector; i += 8 ) {
+      __m256i w = ieee2ibmAVX2( _mm256_loadu_si256( reinterpret_cast<__m256i*>( &values[i*4] ) ) );
+      if( doSwapEndian ) w = swapAVX2( w );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( &values[i*4] ), w );
+    }
+    ieee2ibmScalar( &values[numVector*4], numValues-numVector, doSwapEndian );
+  }
+#endif
+}
+
+void cseis_geolib::ibm2ieee( unsigned char* values, int numValues ) {
+  ibm2ieee( values, numValues, false );
+}
+void cseis_geolib::ieee2ibm( unsigned char* values, int numValues ) {
+  ieee2ibm( values, numValues, false );
+}
+
+void cseis_geolib::ibm2ieee( unsigned char* values, int numValues, bool doSwapEndian ) {
+#ifdef ARCHITECTURE_X86_SIMD
+  int simdLevel = getSIMDLevel();
+  if( simdLevel >= SIMD_AVX2 ) {
+    ibm2ieeeKernelAVX2( values, numValues, doSwapEndian );
+    return;
+  }
+  else if( simdLevel >= SIMD_SSE2 ) {
+    ibm2ieeeKernelSSE2( values, numValues, doSwapEndian );
+    return;
+  }
+#endif
+  ibm2ieeeScalar( values, numValues, doSwapEndian );
+}
+
+void cseis_geolib::ieee2ibm( unsigned char* values, int numValues, bool doSwapEndian ) {
+#ifdef ARCHITECTURE_X86_SIMD
+  int simdLevel = getSIMDLevel();
+  if( simdLevel >= SIMD_AVX2 ) {
+    ieee2ibmKernelAVX2( values, numValues, doSwapEndian );
+    return;
+  }
+  else if( simdLevel >= SIMD_SSE2 ) {
+    ieee2ibmKernelSSE2( values, numValues, doSwapEndian );
+    return;
+  }
+#endif
+  ieee2ibmScalar( values, numValues, doSwapEndian );
 }
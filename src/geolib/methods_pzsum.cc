@@ -2,6 +2,8 @@
 /* All rights reserved.                       */
 
 #include "geolib_math.h"
+#include "csFFTTools.h"
+#include "csFFTEngine.h"
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -49,7 +51,10 @@ void pz_analysis( float const* const* samples_p,  // (i) Hydrophone samples, for
     compute_twosided_correlation( samples_p[itrc], samples_p[itrc], nSamples, p_auto_xt, maxlag );
     compute_twosided_correlation( samples_z[itrc], samples_z[itrc], nSamples, z_auto_xt, maxlag );
     compute_twosided_correlation( samples_p[itrc], samples_z[itrc], nSamples, pz_cross_xt, maxlag );
-    compute_twosided_correlation( samples_z[itrc], samples_p[itrc], nSamples, zp_cross_xt, maxlag );
+    // Z-P cross-correlation is the time reverse of the P-Z cross-correlation
+    for( int i = 0; i < nSamplesCorr; i++ ) {
+      zp_cross_xt[i] = pz_cross_xt[nSamplesCorr-1-i];
+    }
 
     pzscal = sqrt(p_auto_xt[nSamplesCorr/2] / z_auto_xt[nSamplesCorr/2]);
     fprintf(stderr,"%f %f  %f\n", p_auto_xt[nSamplesCorr/2], z_auto_xt[nSamplesCorr/2], pzscal);
@@ -302,72 +307,8 @@ bool fft( int dir, int power_of_two, double *realValues, double *imagValues, boo
 */
 bool fft_1d(short int dir,long m,double *x,double *y)
 {
-   long n,i,i1,j,k,i2,l,l1,l2;
-   double c1,c2,tx,ty,t1,t2,u1,u2,z;
-
-   /* Calculate the number of points */
-   n = 1;
-   for (i=0;i<m;i++) 
-      n *= 2;
-
-   /* Do the bit reversal */
-   i2 = n >> 1;
-   j = 0;
-   for (i=0;i<n-1;i++) {
-      if (i < j) {
-         tx = x[i];
-         ty = y[i];
-         x[i] = x[j];
-         y[i] = y[j];
-         x[j] = tx;
-         y[j] = ty;
-      }
-      k = i2;
-      while (k <= j) {
-         j -= k;
-         k >>= 1;
-      }
-      j += k;
-   }
-
-   /* Compute the FFT */
-   c1 = -1.0; 
-   c2 = 0.0;
-   l2 = 1;
-   for (l=0;l<m;l++) {
-      l1 = l2;
-      l2 <<= 1;
-      u1 = 1.0; 
-      u2 = 0.0;
-      for (j=0;j<l1;j++) {
-         for (i=j;i<n;i+=l2) {
-            i1 = i + l1;
-            t1 = u1 * x[i1] - u2 * y[i1];
-            t2 = u1 * y[i1] + u2 * x[i1];
-            x[i1] = x[i] - t1; 
-            y[i1] = y[i] - t2;
-            x[i] += t1;
-            y[i] += t2;
-         }
-         z =  u1 * c1 - u2 * c2;
-         u2 = u1 * c2 + u2 * c1;
-         u1 = z;
-      }
-      c2 = sqrt((1.0 - c1) / 2.0);
-      if (dir == 1) 
-         c2 = -c2;
-      c1 = sqrt((1.0 + c1) / 2.0);
-   }
-
-   /* Scaling for forward transform */
-   if (dir == 1) {
-      for (i=0;i<n;i++) {
-         x[i] /= n;
-         y[i] /= n;
-      }
-   }
-   
-   return(true);
+  // Scaling for forward transform
+  return cseis_geolib::csFFTTools::fft( dir, (int)m, x, y, dir == 1 );
 }
 
 
@@ -459,142 +400,27 @@ bool fft( int dir, int power_of_two, double *realValues, double *imagValues ) {
 }
 bool fft( int dir, int power_of_two, double *realValues, double *imagValues, bool forceNormalisation )
 {
-   long nn,i,i1,j,k,i2,l,l1,l2;
-   double c1,c2,tx,ty,t1,t2,u1,u2,z;
-
-   /* Calculate the number of points */
-   nn = 1;
-   for (i=0;i<power_of_two;i++)
-      nn *= 2;
-
-   /* Do the bit reversal */
-   i2 = nn >> 1;
-   j = 0;
-   for (i=0;i<nn-1;i++) {
-      if (i < j) {
-         tx = realValues[i];
-         ty = imagValues[i];
-         realValues[i] = realValues[j];
-         imagValues[i] = imagValues[j];
-         realValues[j] = tx;
-         imagValues[j] = ty;
-      }
-      k = i2;
-      while (k <= j) {
-         j -= k;
-         k >>= 1;
-      }
-      j += k;
-   }
-
-   /* Compute the FFT */
-   c1 = -1.0;
-   c2 = 0.0;
-   l2 = 1;
-   for (l=0;l<power_of_two;l++) {
-      l1 = l2;
-      l2 <<= 1;
-      u1 = 1.0;
-      u2 = 0.0;
-      for (j=0;j<l1;j++) {
-         for (i=j;i<nn;i+=l2) {
-            i1 = i + l1;
-            t1 = u1 * realValues[i1] - u2 * imagValues[i1];
-            t2 = u1 * imagValues[i1] + u2 * realValues[i1];
-            realValues[i1] = realValues[i] - t1;
-            imagValues[i1] = imagValues[i] - t2;
-            realValues[i] += t1;
-            imagValues[i] += t2;
-         }
-         z =  u1 * c1 - u2 * c2;
-         u2 = u1 * c2 + u2 * c1;
-         u1 = z;
-      }
-      c2 = sqrt((1.0 - c1) / 2.0);
-      if (dir == 1)
-         c2 = -c2;
-      c1 = sqrt((1.0 + c1) / 2.0);
-   }
-
-   /* Scaling for inverse transform */
-   if( dir == -1 || forceNormalisation ) {
-      for (i=0;i<nn;i++) {
-         realValues[i] /= (double)nn;
-         imagValues[i] /= (double)nn;
-      }
-   }
-
-   return(true);
+  // Scaling for inverse transform
+  return cseis_geolib::csFFTTools::fft( dir, power_of_two, realValues, imagValues, dir == -1 || forceNormalisation );
 }
 
 bool fft_float(int dir,int power_of_two,float *realValues,float *imagValues)
 {
-   long nn,i,i1,j,k,i2,l,l1,l2;
-   float c1,c2,tx,ty,t1,t2,u1,u2,z;
-
-   /* Calculate the number of points */
-   nn = 1;
-   for (i=0;i<power_of_two;i++)
-      nn *= 2;
-
-   /* Do the bit reversal */
-   i2 = nn >> 1;
-   j = 0;
-   for (i=0;i<nn-1;i++) {
-      if (i < j) {
-         tx = realValues[i];
-         ty = imagValues[i];
-         realValues[i] = realValues[j];
-         imagValues[i] = imagValues[j];
-         realValues[j] = tx;
-         imagValues[j] = ty;
-      }
-      k = i2;
-      while (k <= j) {
-         j -= k;
-         k >>= 1;
-      }
-      j += k;
-   }
-
-   /* Compute the FFT */
-   c1 = -1.0;
-   c2 = 0.0;
-   l2 = 1;
-   for (l=0;l<power_of_two;l++) {
-      l1 = l2;
-      l2 <<= 1;
-      u1 = 1.0;
-      u2 = 0.0;
-      for (j=0;j<l1;j++) {
-         for (i=j;i<nn;i+=l2) {
-            i1 = i + l1;
-            t1 = u1 * realValues[i1] - u2 * imagValues[i1];
-            t2 = u1 * imagValues[i1] + u2 * realValues[i1];
-            realValues[i1] = realValues[i] - t1;
-            imagValues[i1] = imagValues[i] - t2;
-            realValues[i] += t1;
-            imagValues[i] += t2;
-         }
-         z =  u1 * c1 - u2 * c2;
-         u2 = u1 * c2 + u2 * c1;
-         u1 = z;
-      }
-      c2 = sqrt((1.0 - c1) / 2.0);
-      if (dir == 1)
-         c2 = -c2;
-      c1 = sqrt((1.0 + c1) / 2.0);
-   }
-
-   /* Scaling for forward transform */
-   if (dir == 1) {
-      for (i=0;i<nn;i++) {
-         realValues[i] /= (float)nn;
-         imagValues[i] /= (float)nn;
-      }
-   }
+  int nn = 1 << power_of_two;
+  cseis_geolib::csFFTEngine const* plan = cseis_geolib::csFFTEngine::getPlan( nn );
+  float* work = new float[plan->workSize()];
+  plan->complexTransform( dir == 1 ? cseis_geolib::csFFTEngine::FORWARD : cseis_geolib::csFFTEngine::INVERSE, realValues, imagValues, work );
+  delete [] work;
+
+  /* Scaling for forward transform */
+  if (dir == 1) {
+    for( int i = 0; i < nn; i++ ) {
+      realValues[i] /= (float)nn;
+      imagValues[i] /= (float)nn;
+    }
+  }
 
-   return(true);
+  return(true);
 }
 
 
@@ -0,0 +1,251 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csSeismicIndex.h"
+#include "csVector.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <sys/stat.h>
+
+using namespace cseis_io;
+
+namespace {
+  static char const ID_TEXT_INDEX[] = "CSEISIDX";
+  static int const VERSION_INDEX = 2;
+
+  /// Orders trace indices by increasing header value. Equal values are kept in trace order
+  template <typename T> struct ValueCompare {
+    T const* values;
+    ValueCompare( T const* v ) : values(v) {}
+    bool operator()( int itrc1, int itrc2 ) const {
+      if( values[itrc1] != values[itrc2] ) return( values[itrc1] < values[itrc2] );
+      return( itrc1 < itrc2 );
+    }
+  };
+  /// Sort header values, and write sorted values followed by matching trace indices
+  template <typename T> bool writeSorted( cseis_geolib::csVector<T> const* valueList, int numTraces, FILE* fout ) {
+    if( numTraces == 0 ) return true;
+    int* traceIndices = new int[numTraces];
+    T* values         = new T[numTraces];
+    T* valuesTrace    = new T[numTraces];
+    for( int itrc = 0; itrc < numTraces; itrc++ ) {
+      traceIndices[itrc] = itrc;
+      valuesTrace[itrc]  = valueList->at(itrc);
+    }
+    std::sort( traceIndices, traceIndices+numTraces, ValueCompare<T>(valuesTrace) );
+    for( int itrc = 0; itrc < numTraces; itrc++ ) {
+      values[itrc] = valuesTrace[traceIndices[itrc]];
+    }
+    bool success = ( fwrite( values, sizeof(T), numTraces, fout ) == (size_t)numTraces );
+    success = success && ( fwrite( traceIndices, sizeof(int), numTraces, fout ) == (size_t)numTraces );
+    delete [] traceIndices;
+    delete [] values;
+    delete [] valuesTrace;
+    return success;
+  }
+  /// Data file properties recorded in the index. Any change to the data file changes at least one of them
+  void fileStamp( struct stat const& statData, csInt64_t* stamp ) {
+    stamp[0] = (csInt64_t)statData.st_size;
+    stamp[1] = (csInt64_t)statData.st_mtim.tv_sec;
+    stamp[2] = (csInt64_t)statData.st_mtim.tv_nsec;
+  }
+}
+
+csSeismicIndex::csSeismicIndex() {
+  myNumTraces = 0;
+  myNames = new cseis_geolib::csVector<std::string>();
+  myTypes = new cseis_geolib::csVector<cseis_geolib::type_t>();
+  myByteLocations = new cseis_geolib::csVector<int>();
+  myValues = new cseis_geolib::csVector<cseis_geolib::csVector<double>*>();
+  myValuesInt64 = new cseis_geolib::csVector<cseis_geolib::csVector<csInt64_t>*>();
+  mySortedValues = NULL;
+  mySortedValuesInt64 = NULL;
+  mySortedTraceIndices = NULL;
+}
+csSeismicIndex::~csSeismicIndex() {
+  freeMemory();
+  delete myNames;
+  delete myTypes;
+  delete myByteLocations;
+  delete myValues;
+  delete myValuesInt64;
+}
+void csSeismicIndex::freeMemory() {
+  for( int ihdr = 0; ihdr < myValues->size(); ihdr++ ) {
+    delete myValues->at(ihdr);
+    delete myValuesInt64->at(ihdr);
+  }
+  myValues->clear();
+  myValuesInt64->clear();
+  if( mySortedValues != NULL ) {
+    for( int ihdr = 0; ihdr < myNames->size(); ihdr++ ) {
+      if( mySortedValues[ihdr] != NULL ) delete [] mySortedValues[ihdr];
+      if( mySortedValuesInt64[ihdr] != NULL ) delete [] mySortedValuesInt64[ihdr];
+      if( mySortedTraceIndices[ihdr] != NULL ) delete [] mySortedTraceIndices[ihdr];
+    }
+    delete [] mySortedValues;
+    delete [] mySortedValuesInt64;
+    delete [] mySortedTraceIndices;
+    mySortedValues = NULL;
+    mySortedValuesInt64 = NULL;
+    mySortedTraceIndices = NULL;
+  }
+}
+std::string csSeismicIndex::indexFilename( std::string const& filenameData ) {
+  return( filenameData + ".idx" );
+}
+//----------------------------------------------------------------
+void csSeismicIndex::addHeader( std::string const& name, cseis_geolib::type_t type, int byteLocation ) {
+  myNames->insertEnd( name );
+  myTypes->insertEnd( type );
+  myByteLocations->insertEnd( byteLocation );
+  myValues->insertEnd( new cseis_geolib::csVector<double>() );
+  myValuesInt64->insertEnd( new cseis_geolib::csVector<csInt64_t>() );
+}
+void csSeismicIndex::addTrace( char const* hdrValueBlock ) {
+  for( int ihdr = 0; ihdr < myNames->size(); ihdr++ ) {
+    char const* ptr = &hdrValueBlock[myByteLocations->at(ihdr)];
+    double value = 0;
+    switch( myTypes->at(ihdr) ) {
+    case cseis_geolib::TYPE_INT: {
+      int valueInt;
+      memcpy( &valueInt, ptr, sizeof(int) );
+      value = (double)valueInt;
+      break;
+    }
+    case cseis_geolib::TYPE_FLOAT: {
+      float valueFloat;
+      memcpy( &valueFloat, ptr, sizeof(float) );
+      value = (double)valueFloat;
+      break;
+    }
+    case cseis_geolib::TYPE_INT64: {
+      // Stored exactly: Conversion to double loses precision above 2^53
+      csInt64_t valueInt64;
+      memcpy( &valueInt64, ptr, sizeof(csInt64_t) );
+      myValuesInt64->at(ihdr)->insertEnd( valueInt64 );
+      continue;
+    }
+    default:
+      memcpy( &value, ptr, sizeof(double) );
+    }
+    myValues->at(ihdr)->insertEnd( value );
+  }
+  myNumTraces += 1;
+}
+//----------------------------------------------------------------
+bool csSeismicIndex::write( std::string const& filenameData ) {
+  struct stat statData;
+  if( stat( filenameData.c_str(), &statData ) != 0 ) return false;
+  std::string filename = indexFilename( filenameData );
+  FILE* fout = fopen( filename.c_str(), "wb" );
+  if( fout == NULL ) return false;
+
+  int numHeaders = myNames->size();
+  csInt64_t stamp[3];
+  fileStamp( statData, stamp );
+  bool success = ( fwrite( ID_TEXT_INDEX, 8, 1, fout ) == 1 );
+  success = success && ( fwrite( &VERSION_INDEX, sizeof(int), 1, fout ) == 1 );
+  success = success && ( fwrite( stamp, sizeof(csInt64_t), 3, fout ) == 3 );
+  success = success && ( fwrite( &myNumTraces, sizeof(int), 1, fout ) == 1 );
+  success = success && ( fwrite( &numHeaders, sizeof(int), 1, fout ) == 1 );
+
+  for( int ihdr = 0; ihdr < numHeaders && success; ihdr++ ) {
+    std::string const& name = myNames->at(ihdr);
+    int sizeName = (int)name.length();
+    int type = (int)myTypes->at(ihdr);
+    success = success && ( fwrite( &sizeName, sizeof(int), 1, fout ) == 1 );
+    success = success && ( fwrite( name.c_str(), sizeName, 1, fout ) == 1 );
+    success = success && ( fwrite( &type, sizeof(int), 1, fout ) == 1 );
+    if( myTypes->at(ihdr) == cseis_geolib::TYPE_INT64 ) {
+      success = success && writeSorted( myValuesInt64->at(ihdr), myNumTraces, fout );
+    }
+    else {
+      success = success && writeSorted( myValues->at(ihdr), myNumTraces, fout );
+    }
+  }
+  fclose( fout );
+  if( !success ) remove( filename.c_str() );
+  return success;
+}
+//----------------------------------------------------------------
+bool csSeismicIndex::read( std::string const& filenameData, int numTraces ) {
+  std::string filename = indexFilename( filenameData );
+  struct stat statData;
+  struct stat statIndex;
+  if( stat( filenameData.c_str(), &statData ) != 0 || stat( filename.c_str(), &statIndex ) != 0 ) return false;
+  FILE* fin = fopen( filename.c_str(), "rb" );
+  if( fin == NULL ) return false;
+
+  freeMemory();
+  myNames->clear();
+  myTypes->clear();
+  myByteLocations->clear();
+
+  char idText[8];
+  int version = 0;
+  csInt64_t stamp[3];
+  csInt64_t stampIndex[3];
+  fileStamp( statData, stamp );
+  int numHeaders = 0;
+  bool success = ( fread( idText, 8, 1, fin ) == 1 ) && !strncmp( idText, ID_TEXT_INDEX, 8 );
+  success = success && ( fread( &version, sizeof(int), 1, fin ) == 1 ) && version == VERSION_INDEX;
+  // Data file has been modified after index was written
+  success = success && ( fread( stampIndex, sizeof(csInt64_t), 3, fin ) == 3 ) && !memcmp( stamp, stampIndex, 3*sizeof(csInt64_t) );
+  success = success && ( fread( &myNumTraces, sizeof(int), 1, fin ) == 1 ) && myNumTraces == numTraces;
+  success = success && ( fread( &numHeaders, sizeof(int), 1, fin ) == 1 ) && numHeaders >= 0;
+  if( success ) {
+    mySortedValues       = new double*[numHeaders];
+    mySortedValuesInt64  = new csInt64_t*[numHeaders];
+    mySortedTraceIndices = new int*[numHeaders];
+    for( int ihdr = 0; ihdr < numHeaders; ihdr++ ) {
+      mySortedValues[ihdr]       = NULL;
+      mySortedValuesInt64[ihdr]  = NULL;
+      mySortedTraceIndices[ihdr] = NULL;
+    }
+  }
+  for( int ihdr = 0; ihdr < numHeaders && success; ihdr++ ) {
+    int sizeName = 0;
+    int type = 0;
+    success = ( fread( &sizeName, sizeof(int), 1, fin ) == 1 ) && sizeName > 0 && sizeName < 1024;
+    char name[1024];
+    success = success && ( fread( name, sizeName, 1, fin ) == 1 );
+    success = success && ( fread( &type, sizeof(int), 1, fin ) == 1 );
+    if( !success ) break;
+    name[sizeName] = '\0';
+    myNames->insertEnd( std::string(name) );
+    myTypes->insertEnd( (cseis_geolib::type_t)type );
+    myByteLocations->insertEnd( -1 );
+    mySortedTraceIndices[ihdr] = new int[std::max(myNumTraces,1)];
+    if( type == (int)cseis_geolib::TYPE_INT64 ) {
+      mySortedValuesInt64[ihdr] = new csInt64_t[std::max(myNumTraces,1)];
+      success = ( fread( mySortedValuesInt64[ihdr], sizeof(csInt64_t), myNumTraces, fin ) == (size_t)myNumTraces );
+    }
+    else {
+      mySortedValues[ihdr] = new double[std::max(myNumTraces,1)];
+      success = ( fread( mySortedValues[ihdr], sizeof(double), myNumTraces, fin ) == (size_t)myNumTraces );
+    }
+    success = success && ( fread( mySortedTraceIndices[ihdr], sizeof(int), myNumTraces, fin ) == (size_t)myNumTraces );
+  }
+  fclose( fin );
+  if( !success ) {
+    freeMemory();
+    myNames->clear();
+    myTypes->clear();
+    myByteLocations->clear();
+    myNumTraces = 0;
+  }
+  return success;
+}
+//----------------------------------------------------------------
+int csSeismicIndex::headerIndex( std::string const& name ) const {
+  if( mySortedValues == NULL ) return -1;
+  for( int ihdr = 0; ihdr < myNames->size(); ihdr++ ) {
+    if( !myNames->at(ihdr).compare( name ) ) return ihdr;
+  }
+  return -1;
+}
+cseis_geolib::type_t csSeismicIndex::headerType( int hdrIndex ) const {
+  return myTypes->at( hdrIndex );
+}
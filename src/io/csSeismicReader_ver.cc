@@ -7,12 +7,14 @@
 #include "csSeismicReader_ver02.h"
 #include "csSeismicReader_ver03.h"
 #include "csSeismicReader_ver04.h"
+#include "csSeismicReader_ver05.h"
 #include "csSeismicIOConfig.h"
 #include "csException.h"
 #include "csHeaderInfo.h"
 #include "csIODefines.h"
 #include "csFileUtils.h"
 #include "csFlexHeader.h"
+#include "csMappedFile.h"
 #include <cstring>
 #include <limits>
 
@@ -55,6 +57,9 @@ csSeismicReader_ver::csSeismicReader_ver( std::string filename, bool enableRando
   myCurrentPeekByteSize   = 0;
   myNumSamples = 0;
 
+  myMappedFile = NULL;
+  myIsMappedSamplesAligned = false;
+
   myFile = NULL;
   open();
 
@@ -63,7 +68,10 @@ csSeismicReader_ver::csSeismicReader_ver( std::string filename, bool enableRando
 csSeismicReader_ver* csSeismicReader_ver::createReaderObject( std::string filename, bool enableRandomAccess, int numTracesBuffer ) {
   std::string versionString;
   csSeismicReader_ver::extractVersionString( filename, versionString );
-  if( !versionString.substr(5,3).compare("0.4") ) {
+  if( !versionString.substr(5,3).compare("0.5") ) {
+    return new csSeismicReader_ver05( filename, enableRandomAccess, numTracesBuffer );
+  }
+  else if( !versionString.substr(5,3).compare("0.4") ) {
     return new csSeismicReader_ver04( filename, enableRandomAccess, numTracesBuffer );
   }
   else if( !versionString.substr(5,3).compare("0.3") ) {
@@ -124,6 +132,11 @@ csSeismicReader_ver::~csSeismicReader_ver() {
     delete [] myDataBuffer;
     myDataBuffer = NULL;
   }
+  if( myMappedFile != NULL ) {
+    // Mapping is kept until all traces referencing mapped samples have released it
+    myMappedFile->release();
+    myMappedFile = NULL;
+  }
 }
 //----------------------------------------------------------------
 void csSeismicReader_ver::open() {
@@ -204,6 +217,10 @@ bool csSeismicReader_ver::peek( int byteOffset, int byteSize, char* buffer, int
     throw( cseis_geolib::csException("csSeismicReader_ver::peek: File size unknown. This may be due to a compatibility problem of this compiled version of the program on the current platform." ) );
   }
 
+  if( myMappedFile != NULL ) {
+    return peekMapped( byteOffset, byteSize, buffer, traceIndex );
+  }
+
   myCurrentPeekByteOffset = byteOffset;
   myCurrentPeekByteSize   = byteSize;
 
@@ -514,6 +531,15 @@ bool csSeismicReader_ver::moveToTrace( int traceIndex, int numTracesToRead ) {
     throw( cseis_geolib::csException("csSeismicReader_ver::moveToTrace: Incorrect trace index: %d (number of traces in input file: %d). This is a program bug in the calling method",
                        traceIndex, myNumTraces) );
   }
+  if( myMappedFile != NULL ) {
+    if( myCurrentTraceIndex != traceIndex ) {
+      myMappedFile->willNeed( mappedTrace(traceIndex) - myMappedFile->data(),
+                              (csInt64_t)std::min(numTracesToRead,(int)NUM_TRACES_PREFETCH) * (csInt64_t)myTraceByteSize );
+    }
+    myCurrentTraceIndex = traceIndex;
+    myLastTraceIndex = std::min( traceIndex + numTracesToRead - 1, myNumTraces-1 );
+    return true;
+  }
   if (myPeekIsInProgress ) revertFromPeekPosition();
 
   if( myCurrentTraceIndex != traceIndex ) {
@@ -558,6 +584,9 @@ bool csSeismicReader_ver::readTrace( float* samples, char* hdrValueBlock ) {
 bool csSeismicReader_ver::readTrace( float* samples, char* hdrValueBlock, int numSamples ) {
   //  fprintf(stderr,"IN readTrace, compression = %d, numSamples: %d (myNumSamples: %d)\n", myByteSizeOneSample, numSamples, myNumSamples);
   if( !myIsReadFileHeader ) throw( cseis_geolib::csException("csSeismicReader_ver::readTrace(): File header has not been read. This is a program bug in the calling function") );
+  if( myMappedFile != NULL ) {
+    return copyMappedTrace( samples, hdrValueBlock, numSamples );
+  }
   if (myPeekIsInProgress ) revertFromPeekPosition();
   if( myBufferCapacityNumTraces == 1 ) {
     return readSingleTrace( samples, hdrValueBlock, numSamples );
@@ -629,4 +658,63 @@ void csSeismicReader_ver::decompressBuffer( float* samples, int numSamples ) {
     samples[isamp] = 0.0f;
   }
 }
-
+//----------------------------------------------------------------------
+//
+bool csSeismicReader_ver::mapFile() {
+  if( !myIsReadFileHeader ) throw( cseis_geolib::csException("csSeismicReader_ver::mapFile(): File header has not been read. This is a program bug in the calling function") );
+  if( myMappedFile != NULL ) return true;
+  if( myByteSizeOneSample != 4 || myFileSize == cseis_geolib::csFileUtils::FILESIZE_UNKNOWN ) return false;
+  if( myFile->is_open() && myFile->tellg() != (std::streampos)myHeaderByteSize ) return false;  // Traces have already been read
+  myMappedFile = new cseis_geolib::csMappedFile( myFilename );
+  if( myMappedFile->size() < myFileSize ) {
+    myMappedFile->release();
+    myMappedFile = NULL;
+    return false;
+  }
+  // Random access is enabled for trace selection or merging. Otherwise, traces are read sequentially
+  myMappedFile->setAccessPattern( myEnableRandomAccess ? cseis_geolib::csMappedFile::ACCESS_RANDOM : cseis_geolib::csMappedFile::ACCESS_SEQUENTIAL );
+  // Samples of all traces are aligned if samples of first trace are aligned, and trace size is a multiple of the sample size
+  myIsMappedSamplesAligned = ( (myHeaderByteSize + myByteSizeHdrValueBlock) % sizeof(float) == 0 && myTraceByteSize % sizeof(float) == 0 );
+  // Read buffer and file stream are no longer needed
+  if( myDataBuffer != NULL ) {
+    delete [] myDataBuffer;
+    myDataBuffer = NULL;
+  }
+  closeFile();
+  myCurrentTraceIndex  = 0;
+  myBufferNumTraces    = 0;
+  myBufferCurrentTrace = 0;
+  return true;
+}
+char const* csSeismicReader_ver::mappedTrace( int traceIndex ) const {
+  return( myMappedFile->data() + (csInt64_t)myHeaderByteSize + (csInt64_t)traceIndex * (csInt64_t)myTraceByteSize );
+}
+bool csSeismicReader_ver::readTraceMapped( char* hdrValueBlock, float const*& samples ) {
+  if( myMappedFile == NULL || !myIsMappedSamplesAligned ) return false;
+  if( myCurrentTraceIndex >= myNumTraces ) return false;
+  char const* tracePtr = mappedTrace( myCurrentTraceIndex );
+  memcpy( hdrValueBlock, tracePtr, myByteSizeHdrValueBlock );
+  samples = reinterpret_cast<float const*>( tracePtr + myByteSizeHdrValueBlock );
+  myCurrentTraceIndex += 1;
+  return true;
+}
+bool csSeismicReader_ver::copyMappedTrace( float* samples, char* hdrValueBlock, int numSamples ) {
+  if( myCurrentTraceIndex >= myNumTraces ) return false;
+  char const* tracePtr = mappedTrace( myCurrentTraceIndex );
+  memcpy( hdrValueBlock, tracePtr, myByteSizeHdrValueBlock );
+  int numSamplesToRead = std::min( numSamples, myNumSamples );
+  memcpy( samples, tracePtr + myByteSizeHdrValueBlock, numSamplesToRead*sizeof(float) );
+  for( int isamp = myNumSamples; isamp < numSamples; isamp++ ) {
+    samples[isamp] = 0.0f;  // Zero out rest of buffer
+  }
+  myCurrentTraceIndex += 1;
+  return true;
+}
+bool csSeismicReader_ver::peekMapped( int byteOffset, int byteSize, char* buffer, int traceIndex ) {
+  if( traceIndex < 0 ) {
+    traceIndex = myCurrentTraceIndex;
+  }
+  if( traceIndex >= myNumTraces ) return false;  // Last trace has been reached. Cannot peek ahead.
+  memcpy( buffer, mappedTrace( traceIndex ) + byteOffset, byteSize );
+  return true;
+}
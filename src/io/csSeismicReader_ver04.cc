@@ -21,9 +21,16 @@ using namespace cseis_io;
 
 csSeismicReader_ver04::csSeismicReader_ver04( std::string filename, bool enableRandomAccess, int numTracesBuffer ) :
   csSeismicReader_ver( filename, enableRandomAccess, numTracesBuffer ) {
-  cseis_io::csIODefines::createVersionString( VERSION_SEISMIC_READER, myVersionText );
+  init( VERSION_SEISMIC_READER );
+}
+csSeismicReader_ver04::csSeismicReader_ver04( std::string filename, bool enableRandomAccess, int numTracesBuffer, int version ) :
+  csSeismicReader_ver( filename, enableRandomAccess, numTracesBuffer ) {
+  init( version );
+}
+void csSeismicReader_ver04::init( int version ) {
+  cseis_io::csIODefines::createVersionString( version, myVersionText );
 
-  int versionNumber = VERSION_SEISMIC_READER % 100;
+  int versionNumber = version % 100;
   myVersionMajor = (short int)(versionNumber/10);
   myVersionMinor = (short int)(versionNumber - myVersionMajor*10);
 
@@ -37,7 +44,48 @@ bool csSeismicReader_ver04::readFileHeader( csSeismicIOConfig* config ) {
   if( myFile == NULL ) return false;
   if( myIsReadFileHeader ) throw( cseis_geolib::csException("csSeismicReader_ver00::readFileHeader: Attempt to re-read file header. This is probably a program bug in the calling function") );
   myIsReadFileHeader = true;
-  
+
+  readHeaderBlock( config );
+
+  //  fprintf(stderr,"ver04 Data buffer size %d  -->  %d \n", myBufferCapacityNumTraces, myBufferCapacityNumTraces * myTraceByteSize );
+
+  if( myBufferCapacityNumTraces <= 0 ) {  // Set number of buffered traces if it wasn't set explicitely in constructor
+    myBufferCapacityNumTraces = DEFAULT_BUFFERED_SAMPLES / config->numSamples;
+    if( myBufferCapacityNumTraces <= 0 ) myBufferCapacityNumTraces = 1;
+    else if( myBufferCapacityNumTraces > 20 ) myBufferCapacityNumTraces = 20;
+    //    fprintf(stderr,"RESET ver04 Data buffer size %d  -->  %d \n", myBufferCapacityNumTraces, myBufferCapacityNumTraces * myTraceByteSize );
+  }
+
+  // Determine number of traces in file
+  if( myFileSize != cseis_geolib::csFileUtils::FILESIZE_UNKNOWN ) {
+    csInt64_t sizeTraces  = myFileSize - (csInt64_t)myHeaderByteSize;
+    myNumTraces       = (int)(sizeTraces/(csInt64_t)(myTraceByteSize));  // Total number of full traces in input file
+    config->numTraces = myNumTraces;
+    myLastTraceIndex  = myNumTraces-1;
+    if( myBufferCapacityNumTraces > myNumTraces ) myBufferCapacityNumTraces = myNumTraces;
+    //    fprintf(stderr,"filesize: %lld, hdrsize: %d, Estimate number of traces in file:  %lld / %d = %d \n",
+    //       myFileSize, myHeaderByteSize, sizeTraces, myTraceByteSize, myNumTraces );
+  }
+  else {
+    config->numTraces = 0;
+    myLastTraceIndex = 0;
+  }
+
+  if( myBufferCapacityNumTraces > 1 || myByteSizeOneSample != 4 ) {
+    //    fprintf(stderr,"RESIZE ver04 Data buffer size %d  -->  %d \n", myBufferCapacityNumTraces, myBufferCapacityNumTraces * myTraceByteSize );
+    resizeDataBuffer( myBufferCapacityNumTraces );
+  }
+
+  //  fprintf(stderr,"IN:  Byte size: %d %d %d   %d, num trchdrs: %d\n", myByteSizeSamples, myByteSizeHdrValueBlock, myHeaderByteSize, byteSize, numTrcHdrs );
+
+  //  fprintf(stderr,"readFileHeader, byteSizeOneSample: %d, compression: %d\n", myByteSizeOneSample, myByteSizeCompression);
+
+  return true;
+}
+//--------------------------------------------------------------------
+// Read file header block, up to and including the trace header definitions
+//
+int csSeismicReader_ver04::readHeaderBlock( csSeismicIOConfig* config ) {
   char byteSizeChar[4];
   myFile->read( byteSizeChar, 4 );
   int byteSize = 0;
@@ -149,40 +197,7 @@ bool csSeismicReader_ver04::readFileHeader( csSeismicIOConfig* config ) {
   myByteSizeHdrValueBlock = config->byteSizeHdrValueBlock;
   myTraceByteSize         = myByteSizeSamples + myByteSizeHdrValueBlock + myByteSizeCompression;
 
-  //  fprintf(stderr,"ver04 Data buffer size %d  -->  %d \n", myBufferCapacityNumTraces, myBufferCapacityNumTraces * myTraceByteSize );
-
-  if( myBufferCapacityNumTraces <= 0 ) {  // Set number of buffered traces if it wasn't set explicitely in constructor
-    myBufferCapacityNumTraces = DEFAULT_BUFFERED_SAMPLES / config->numSamples;
-    if( myBufferCapacityNumTraces <= 0 ) myBufferCapacityNumTraces = 1;
-    else if( myBufferCapacityNumTraces > 20 ) myBufferCapacityNumTraces = 20;
-    //    fprintf(stderr,"RESET ver04 Data buffer size %d  -->  %d \n", myBufferCapacityNumTraces, myBufferCapacityNumTraces * myTraceByteSize );
-  }
-
-  // Determine number of traces in file
-  if( myFileSize != cseis_geolib::csFileUtils::FILESIZE_UNKNOWN ) {
-    csInt64_t sizeTraces  = myFileSize - (csInt64_t)myHeaderByteSize;
-    myNumTraces       = (int)(sizeTraces/(csInt64_t)(myTraceByteSize));  // Total number of full traces in input file
-    config->numTraces = myNumTraces;
-    myLastTraceIndex  = myNumTraces-1;
-    if( myBufferCapacityNumTraces > myNumTraces ) myBufferCapacityNumTraces = myNumTraces;
-    //    fprintf(stderr,"filesize: %lld, hdrsize: %d, Estimate number of traces in file:  %lld / %d = %d \n",
-    //       myFileSize, myHeaderByteSize, sizeTraces, myTraceByteSize, myNumTraces );
-  }
-  else {
-    config->numTraces = 0;
-    myLastTraceIndex = 0;
-  }
-
-  if( myBufferCapacityNumTraces > 1 || myByteSizeOneSample != 4 ) {
-    //    fprintf(stderr,"RESIZE ver04 Data buffer size %d  -->  %d \n", myBufferCapacityNumTraces, myBufferCapacityNumTraces * myTraceByteSize );
-    resizeDataBuffer( myBufferCapacityNumTraces );
-  }
-
-  //  fprintf(stderr,"IN:  Byte size: %d %d %d   %d, num trchdrs: %d\n", myByteSizeSamples, myByteSizeHdrValueBlock, myHeaderByteSize, byteSize, numTrcHdrs );
-
-  //  fprintf(stderr,"readFileHeader, byteSizeOneSample: %d, compression: %d\n", myByteSizeOneSample, myByteSizeCompression);
-
-  return true;
+  return byteLoc;
 }
 
 /*
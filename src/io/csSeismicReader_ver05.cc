@@ -0,0 +1,382 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csSeismicReader_ver05.h"
+#include "csSeismicIOConfig.h"
+#include "csException.h"
+#include "csIODefines.h"
+#include "csFileUtils.h"
+#include "csSampleCodec.h"
+#include "csVector.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace cseis_io;
+
+csSeismicReader_ver05::csSeismicReader_ver05( std::string filename, bool enableRandomAccess, int numTracesBuffer ) :
+  csSeismicReader_ver04( filename, enableRandomAccess, numTracesBuffer, VERSION_SEISMIC_READER ) {
+  myCodec = 0;
+  myBlockOffsets    = new cseis_geolib::csVector<csInt64_t>();
+  myBlockFirstTrace = new cseis_geolib::csVector<int>();
+  myFileBlockIndex  = 0;
+
+  myLoadedBlockIndex = -1;
+  myLoadedFirstTrace = 0;
+  myLoadedNumTraces  = 0;
+  myBlockBuffer      = NULL;
+  myBlockBufferSize  = 0;
+  myBlockSamples     = NULL;
+  myBlockSamplesNumTraces = 0;
+  myEncodedByteLoc     = NULL;
+  myEncodedByteLocSize = 0;
+}
+//----------------------------------------------------------------
+csSeismicReader_ver05::~csSeismicReader_ver05() {
+  if( myBlockOffsets != NULL ) {
+    delete myBlockOffsets;
+    myBlockOffsets = NULL;
+  }
+  if( myBlockFirstTrace != NULL ) {
+    delete myBlockFirstTrace;
+    myBlockFirstTrace = NULL;
+  }
+  if( myBlockBuffer != NULL ) {
+    delete [] myBlockBuffer;
+    myBlockBuffer = NULL;
+  }
+  if( myBlockSamples != NULL ) {
+    delete [] myBlockSamples;
+    myBlockSamples = NULL;
+  }
+  if( myEncodedByteLoc != NULL ) {
+    delete [] myEncodedByteLoc;
+    myEncodedByteLoc = NULL;
+  }
+}
+//--------------------------------------------------------------------
+bool csSeismicReader_ver05::readFileHeader( csSeismicIOConfig* config ) {
+  if( myFile == NULL ) return false;
+  if( myIsReadFileHeader ) throw( cseis_geolib::csException("csSeismicReader_ver05::readFileHeader: Attempt to re-read file header. This is probably a program bug in the calling function") );
+  myIsReadFileHeader = true;
+
+  int byteLoc = readHeaderBlock( config );
+  int byteSizeHeaderBlock = myHeaderByteSize - 12;  // Exclude ID text, version and header block size
+  if( myByteSizeOneSample != 4 || byteLoc + 4 > byteSizeHeaderBlock ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05::readFileHeader: Corrupt file header in file '%s'", myFilename.c_str()) );
+  }
+  memcpy( &myCodec, &myTempBuffer[byteLoc], 4 );
+  if( myCodec != cseis_geolib::csSampleCodec::CODEC_LOSSLESS && myCodec != cseis_geolib::csSampleCodec::CODEC_LOSSY ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05::readFileHeader: Unknown sample codec (%d) in file '%s'", myCodec, myFilename.c_str()) );
+  }
+
+  if( myFileSize != cseis_geolib::csFileUtils::FILESIZE_UNKNOWN ) {
+    if( !readBlockIndex() ) {
+      fprintf(stderr,"Warning: Block index missing in file '%s'. File may be incomplete. Scanning data blocks...\n", myFilename.c_str());
+      scanBlocks();
+    }
+    myFile->clear();
+    myFile->seekg( myHeaderByteSize, std::ios_base::beg );
+    if( myFile->fail() ) {
+      throw( cseis_geolib::csException("csSeismicReader_ver05::readFileHeader: Unexpected error occurred when reading file '%s'", myFilename.c_str()) );
+    }
+    config->numTraces = myNumTraces;
+    myLastTraceIndex  = myNumTraces-1;
+    myBufferCapacityNumTraces = 0;
+    for( int iblock = 0; iblock < myBlockFirstTrace->size(); iblock++ ) {
+      int lastTrace = ( iblock < myBlockFirstTrace->size()-1 ) ? myBlockFirstTrace->at(iblock+1) : myNumTraces;
+      myBufferCapacityNumTraces = std::max( myBufferCapacityNumTraces, lastTrace - myBlockFirstTrace->at(iblock) );
+    }
+  }
+  else {
+    config->numTraces = 0;
+    myLastTraceIndex = 0;
+  }
+  myFileBlockIndex = 0;
+
+  return true;
+}
+//--------------------------------------------------------------------
+// Read block index from end of file. See csSeismicWriter_ver::writeBlockIndex()
+//
+bool csSeismicReader_ver05::readBlockIndex() {
+  int idSize = (int)strlen( ID_TEXT_BLOCK_INDEX );
+  int trailerSize = 16 + idSize;
+  if( myFileSize < (csInt64_t)(myHeaderByteSize + trailerSize) ) return false;
+
+  char* trailer = new char[trailerSize];
+  myFile->clear();
+  myFile->seekg( myFileSize - trailerSize, std::ios_base::beg );
+  myFile->read( trailer, trailerSize );
+  csInt64_t indexOffset = 0;
+  int numBlocks = 0;
+  int numTraces = 0;
+  bool success = !myFile->fail() && !strncmp( &trailer[16], ID_TEXT_BLOCK_INDEX, idSize );
+  memcpy( &indexOffset, &trailer[0], 8 );
+  memcpy( &numBlocks, &trailer[8], 4 );
+  memcpy( &numTraces, &trailer[12], 4 );
+  delete [] trailer;
+  if( !success || numBlocks < 0 || indexOffset < myHeaderByteSize || indexOffset + (csInt64_t)numBlocks*12 + trailerSize != myFileSize ) {
+    return false;
+  }
+
+  char* index = new char[numBlocks*12 + 1];
+  myFile->seekg( indexOffset, std::ios_base::beg );
+  myFile->read( index, numBlocks*12 );
+  success = !myFile->fail();
+  int firstTrace = 0;
+  for( int iblock = 0; iblock < numBlocks && success; iblock++ ) {
+    csInt64_t blockOffset;
+    int numTracesBlock;
+    memcpy( &blockOffset, &index[iblock*12], 8 );
+    memcpy( &numTracesBlock, &index[iblock*12+8], 4 );
+    myBlockOffsets->insertEnd( blockOffset );
+    myBlockFirstTrace->insertEnd( firstTrace );
+    firstTrace += numTracesBlock;
+  }
+  delete [] index;
+  if( !success || firstTrace != numTraces ) {
+    myBlockOffsets->clear();
+    myBlockFirstTrace->clear();
+    return false;
+  }
+  myNumTraces = numTraces;
+  return true;
+}
+//--------------------------------------------------------------------
+// Build block index by stepping through all blocks. Stops at the first incomplete block
+//
+void csSeismicReader_ver05::scanBlocks() {
+  csInt64_t blockOffset = myHeaderByteSize;
+  int firstTrace = 0;
+  myFile->clear();
+  while( blockOffset + 8 <= myFileSize ) {
+    int numTracesBlock = 0;
+    int byteSizeBlock  = 0;
+    myFile->seekg( blockOffset, std::ios_base::beg );
+    myFile->read( (char*)&numTracesBlock, 4 );
+    myFile->read( (char*)&byteSizeBlock, 4 );
+    if( myFile->fail() || numTracesBlock <= 0 || byteSizeBlock <= 0 || blockOffset + 8 + byteSizeBlock > myFileSize ) break;
+    myBlockOffsets->insertEnd( blockOffset );
+    myBlockFirstTrace->insertEnd( firstTrace );
+    firstTrace  += numTracesBlock;
+    blockOffset += 8 + byteSizeBlock;
+  }
+  myNumTraces = firstTrace;
+}
+//--------------------------------------------------------------------
+int csSeismicReader_ver05::findBlock( int traceIndex ) const {
+  int blockFirst = 0;
+  int blockLast  = myBlockFirstTrace->size()-1;
+  while( blockFirst < blockLast ) {
+    int blockMid = ( blockFirst + blockLast + 1 ) / 2;
+    if( myBlockFirstTrace->at(blockMid) <= traceIndex ) {
+      blockFirst = blockMid;
+    }
+    else {
+      blockLast = blockMid-1;
+    }
+  }
+  return blockFirst;
+}
+//--------------------------------------------------------------------
+bool csSeismicReader_ver05::loadBlock( int blockIndex ) {
+  if( blockIndex == myLoadedBlockIndex ) return true;
+  if( blockIndex != myFileBlockIndex ) {
+    myFile->clear();
+    myFile->seekg( myBlockOffsets->at(blockIndex), std::ios_base::beg );
+    if( myFile->fail() ) return false;
+  }
+  myLoadedBlockIndex = -1;
+  myFileBlockIndex   = -1;
+  myLoadedFirstTrace = myBlockFirstTrace->at(blockIndex);
+  if( !loadNextBlock() ) return false;
+  myLoadedBlockIndex = blockIndex;
+  myFileBlockIndex   = blockIndex+1;
+  return true;
+}
+//--------------------------------------------------------------------
+// Read block at current file position
+// Block: Number of traces, byte size of remaining block, compressed byte size of each trace, trace header value blocks
+// of all traces, compressed samples of all traces
+//
+bool csSeismicReader_ver05::loadNextBlock() {
+  int numTraces = 0;
+  int byteSize  = 0;
+  myFile->read( (char*)&numTraces, 4 );
+  myFile->read( (char*)&byteSize, 4 );
+  if( myFile->fail() || numTraces <= 0 ) return false;  // End of blocks
+  if( byteSize < numTraces*(4+myByteSizeHdrValueBlock) ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05: Corrupt data block in file '%s'", myFilename.c_str()) );
+  }
+  if( byteSize > myBlockBufferSize ) {
+    if( myBlockBuffer != NULL ) delete [] myBlockBuffer;
+    myBlockBuffer = new char[byteSize];
+    myBlockBufferSize = byteSize;
+  }
+  myFile->read( myBlockBuffer, byteSize );
+  if( myFile->fail() ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05: Unexpected end of file '%s': Last data block is incomplete", myFilename.c_str()) );
+  }
+  if( numTraces > myBlockSamplesNumTraces ) {
+    if( myBlockSamples != NULL ) delete [] myBlockSamples;
+    myBlockSamples = new float[numTraces*myNumSamples];
+    myBlockSamplesNumTraces = numTraces;
+  }
+  if( numTraces+1 > myEncodedByteLocSize ) {
+    if( myEncodedByteLoc != NULL ) delete [] myEncodedByteLoc;
+    myEncodedByteLoc = new int[numTraces+1];
+    myEncodedByteLocSize = numTraces+1;
+  }
+  int byteLoc = numTraces*(4+myByteSizeHdrValueBlock);
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    int encodedByteSize;
+    memcpy( &encodedByteSize, &myBlockBuffer[itrc*4], 4 );
+    if( encodedByteSize < 0 || encodedByteSize > byteSize - byteLoc ) {
+      throw( cseis_geolib::csException("csSeismicReader_ver05: Corrupt data block in file '%s'", myFilename.c_str()) );
+    }
+    myEncodedByteLoc[itrc] = byteLoc;
+    byteLoc += encodedByteSize;
+  }
+  myEncodedByteLoc[numTraces] = byteLoc;
+  myLoadedNumTraces = numTraces;
+  decodeBlock();
+  return true;
+}
+//--------------------------------------------------------------------
+void csSeismicReader_ver05::decodeBlock() {
+  int numTraces = myLoadedNumTraces;
+  bool isCorrupt = false;
+#pragma omp parallel for schedule(dynamic) if(numTraces > 1)
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    try {
+      char const* buffer = &myBlockBuffer[myEncodedByteLoc[itrc]];
+      int byteSize = myEncodedByteLoc[itrc+1]-myEncodedByteLoc[itrc];
+      if( myCodec == cseis_geolib::csSampleCodec::CODEC_LOSSY ) {
+        cseis_geolib::csSampleCodec::decodeLossy( buffer, byteSize, myNumSamples, &myBlockSamples[itrc*myNumSamples] );
+      }
+      else {
+        cseis_geolib::csSampleCodec::decode( buffer, byteSize, myNumSamples, &myBlockSamples[itrc*myNumSamples] );
+      }
+    }
+    catch( cseis_geolib::csException& ) {
+      isCorrupt = true;  // Exceptions must not leave the parallel region
+    }
+  }
+  if( isCorrupt ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05: Corrupt compressed samples in file '%s'", myFilename.c_str()) );
+  }
+}
+//--------------------------------------------------------------------
+bool csSeismicReader_ver05::readTrace( float* samples, char* hdrValueBlock ) {
+  return readTrace( samples, hdrValueBlock, myNumSamples );
+}
+bool csSeismicReader_ver05::readTrace( float* samples, char* hdrValueBlock, int numSamples ) {
+  if( !myIsReadFileHeader ) throw( cseis_geolib::csException("csSeismicReader_ver05::readTrace(): File header has not been read. This is a program bug in the calling function") );
+  if( myFileSize != cseis_geolib::csFileUtils::FILESIZE_UNKNOWN ) {
+    if( myCurrentTraceIndex >= myNumTraces ) return false;
+    if( !loadBlock( findBlock( myCurrentTraceIndex ) ) ) return false;
+  }
+  else if( myCurrentTraceIndex >= myLoadedFirstTrace + myLoadedNumTraces ) {
+    // No block index: Read blocks sequentially
+    myLoadedFirstTrace += myLoadedNumTraces;
+    myLoadedNumTraces = 0;
+    if( !loadNextBlock() ) return false;
+  }
+  int itrc = myCurrentTraceIndex - myLoadedFirstTrace;
+  memcpy( hdrValueBlock, &myBlockBuffer[myLoadedNumTraces*4 + itrc*myByteSizeHdrValueBlock], myByteSizeHdrValueBlock );
+  int numSamplesToRead = std::min( numSamples, myNumSamples );
+  memcpy( samples, &myBlockSamples[itrc*myNumSamples], numSamplesToRead*sizeof(float) );
+  for( int isamp = myNumSamples; isamp < numSamples; isamp++ ) {
+    samples[isamp] = 0.0f;  // Zero out rest of buffer
+  }
+  myCurrentTraceIndex += 1;
+  return true;
+}
+//--------------------------------------------------------------------
+bool csSeismicReader_ver05::moveToTrace( int traceIndex ) {
+  return moveToTrace( traceIndex, myNumTraces-traceIndex );
+}
+bool csSeismicReader_ver05::moveToTrace( int traceIndex, int numTracesToRead ) {
+  if( !myIsReadFileHeader ) throw( cseis_geolib::csException("csSeismicReader_ver05::moveToTrace: File header has not been read. This is a program bug in the calling function") );
+  if( myEnableRandomAccess == false ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05::moveToTrace: Random access not enabled. Set enableRandomAccess to true. This is a program bug in the calling function." ) );
+  }
+  else if( myFileSize == cseis_geolib::csFileUtils::FILESIZE_UNKNOWN ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05::moveToTrace: File size unknown. This may be due to a compatibility problem of this compiled version of the program on the current platform." ) );
+  }
+  else if( traceIndex < 0 || traceIndex >= myNumTraces ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05::moveToTrace: Incorrect trace index: %d (number of traces in input file: %d). This is a program bug in the calling method",
+                                     traceIndex, myNumTraces) );
+  }
+  // Block containing the trace is loaded on the next call to readTrace()
+  myCurrentTraceIndex = traceIndex;
+  myLastTraceIndex = std::min( traceIndex + numTracesToRead - 1, myNumTraces-1 );
+  return true;
+}
+//--------------------------------------------------------------------
+bool csSeismicReader_ver05::peek( int byteOffset, int byteSize, char* buffer, int traceIndex ) {
+  if( !myIsReadFileHeader ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05::peek: File header has not been read. This is a program bug in the calling function") );
+  }
+  if( myEnableRandomAccess == false ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05::peek: Random access not enabled. Set enableRandomAccess to true. This is a program bug in the calling function." ) );
+  }
+  if( myFileSize == cseis_geolib::csFileUtils::FILESIZE_UNKNOWN ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver05::peek: File size unknown. This may be due to a compatibility problem of this compiled version of the program on the current platform." ) );
+  }
+  if( traceIndex < 0 ) {
+    traceIndex = myCurrentTraceIndex;
+  }
+  if( traceIndex >= myNumTraces ) return false;  // Last trace has been reached. Cannot peek ahead.
+
+  int blockIndex = findBlock( traceIndex );
+  int itrc = traceIndex - myBlockFirstTrace->at(blockIndex);
+  if( blockIndex == myLoadedBlockIndex ) {
+    memcpy( buffer, &myBlockBuffer[myLoadedNumTraces*4 + itrc*myByteSizeHdrValueBlock + byteOffset], byteSize );
+    return true;
+  }
+  // Trace headers are stored uncompressed: Read header value directly from file
+  int lastTraceBlock = ( blockIndex < myBlockFirstTrace->size()-1 ) ? myBlockFirstTrace->at(blockIndex+1) : myNumTraces;
+  int numTracesBlock = lastTraceBlock - myBlockFirstTrace->at(blockIndex);
+  csInt64_t bytePos = myBlockOffsets->at(blockIndex) + 8 + (csInt64_t)( numTracesBlock*4 + itrc*myByteSizeHdrValueBlock + byteOffset );
+  myFileBlockIndex = -1;
+  myFile->clear();
+  myFile->seekg( bytePos, std::ios_base::beg );
+  myFile->read( buffer, byteSize );
+  return !myFile->fail();
+}
+//--------------------------------------------------------------------
+bool csSeismicReader_ver05::mapFile() {
+  if( !myIsReadFileHeader ) throw( cseis_geolib::csException("csSeismicReader_ver05::mapFile(): File header has not been read. This is a program bug in the calling function") );
+  return false;
+}
+
+/*
+
+CSeis file format, version 0.5
+
+File header as in version 0.4, with sample byte size 4, followed by:
+X     int    4  Sample codec (csSampleCodec::CODEC_LOSSLESS or CODEC_LOSSY)
+
+Data blocks, one for each block of traces buffered by the writer:
+0     int    4  Number of traces in block (=NTRC)
+4     int    4  Byte size of remaining block
+8     int    4*NTRC  Byte size of compressed samples of each trace
+X     char*  NTRC*(byte size of header value block)  Trace header value blocks of all traces, uncompressed
+X     char*  ...  Compressed samples of all traces, csSampleCodec::encode() or encodeLossy()
+
+End of data blocks:
+0     int    4  0
+
+Block index:
+for( NBLOCKS ) {
+  X    int64  8  File position of block
+  X+8  int    4  Number of traces in block
+  X=X+12
+}
+X     int64  8  File position of block index
+X+8   int    4  Number of blocks (=NBLOCKS)
+X+12  int    4  Total number of traces
+X+16  char*  8  ID_TEXT_BLOCK_INDEX = "CSBLKIDX"
+
+*/
@@ -3,10 +3,13 @@
 
 #include "csSeismicWriter_ver.h"
 #include "csSeismicIOConfig.h"
+#include "csSeismicIndex.h"
+#include "csVector.h"
 #include "csException.h"
 #include "csGeolibUtils.h"
 #include "csHeaderInfo.h"
 #include "csIODefines.h"
+#include "csSampleCodec.h"
 #include <cstring>
 #include <limits>
 #include <cmath>
@@ -35,12 +38,38 @@ csSeismicWriter_ver::csSeismicWriter_ver( std::string filename, int numTracesBuf
   myDataBuffer       = NULL;
   myCurrentDataBufferSize = 0;
   myNumBufferTraces  = numTracesBuffer;
+  myIndexHeaderNames = NULL;
+  myIndex            = NULL;
+
+  myIsBlockCompressed  = false;
+  myMaxEncodedByteSize = 0;
+  myEncodedBuffer      = NULL;
+  myEncodedByteSizes   = NULL;
+  myCodec              = cseis_geolib::csSampleCodec::CODEC_LOSSLESS;
+  myMaxError           = 0;
+  myIsRelativeError    = false;
+  myTraceEnergy        = NULL;
+  myTraceErrorEnergy   = NULL;
+  mySignalEnergy       = 0;
+  myErrorEnergy        = 0;
+  myNumBytesSamples    = 0;
+  myNumBytesEncoded    = 0;
+  myBlockOffsets       = NULL;
+  myBlockNumTraces     = NULL;
 
   open( overwrite );
 }
 //----------------------------------------------------------------
 csSeismicWriter_ver::~csSeismicWriter_ver() {
   close();
+  if( myIndexHeaderNames != NULL ) {
+    delete myIndexHeaderNames;
+    myIndexHeaderNames = NULL;
+  }
+  if( myIndex != NULL ) {
+    delete myIndex;
+    myIndex = NULL;
+  }
   if( myTempBuffer != NULL ) {
     delete [] myTempBuffer;
     myTempBuffer = NULL;
@@ -53,6 +82,30 @@ csSeismicWriter_ver::~csSeismicWriter_ver() {
     delete [] myCompressedSampleBuffer;
     myCompressedSampleBuffer = NULL;
   }
+  if( myEncodedBuffer != NULL ) {
+    delete [] myEncodedBuffer;
+    myEncodedBuffer = NULL;
+  }
+  if( myEncodedByteSizes != NULL ) {
+    delete [] myEncodedByteSizes;
+    myEncodedByteSizes = NULL;
+  }
+  if( myTraceEnergy != NULL ) {
+    delete [] myTraceEnergy;
+    myTraceEnergy = NULL;
+  }
+  if( myTraceErrorEnergy != NULL ) {
+    delete [] myTraceErrorEnergy;
+    myTraceErrorEnergy = NULL;
+  }
+  if( myBlockOffsets != NULL ) {
+    delete myBlockOffsets;
+    myBlockOffsets = NULL;
+  }
+  if( myBlockNumTraces != NULL ) {
+    delete myBlockNumTraces;
+    myBlockNumTraces = NULL;
+  }
 }
 //----------------------------------------------------------------
 void csSeismicWriter_ver::open( bool overwrite ) {
@@ -78,6 +131,8 @@ void csSeismicWriter_ver::open( bool overwrite ) {
   if( myFile == NULL ) {
     throw( cseis_geolib::csException("Error occurred when opening file '%s'", myFileName.c_str() ) );
   }
+  // Remove header index of previous file, if any
+  remove( csSeismicIndex::indexFilename( myFileName ).c_str() );
 }
 //----------------------------------------------------------------
 void csSeismicWriter_ver::close() {
@@ -86,17 +141,134 @@ void csSeismicWriter_ver::close() {
       // Some traces are still buffered and haven't been flushed yet --> Write them out now
       writeCurrentDataBuffer();
     }
+    if( myIsBlockCompressed && !writeBlockIndex() ) {
+      fprintf(stderr,"Warning: Unable to write block index to file '%s'\n", myFileName.c_str());
+    }
     fclose( myFile );
     myFile = NULL;
+    if( myIndex != NULL ) {
+      // Index is optional: Readers fall back to scanning the data file if it is missing
+      if( !myIndex->write( myFileName ) ) {
+        fprintf(stderr,"Warning: Unable to write header index file for '%s'\n", myFileName.c_str());
+      }
+    }
   }
 }
+void csSeismicWriter_ver::addIndexHeader( std::string const& headerName ) {
+  if( myIndexHeaderNames == NULL ) myIndexHeaderNames = new cseis_geolib::csVector<std::string>();
+  myIndexHeaderNames->insertEnd( headerName );
+}
+void csSeismicWriter_ver::setBlockCompression( float maxError, bool isRelativeError ) {
+  if( myDataBuffer != NULL ) {
+    throw( cseis_geolib::csException("csSeismicWriter_ver::setBlockCompression: File header has already been written. This is a program bug in the calling function") );
+  }
+  if( myByteSizeOneSample != 4 ) {
+    throw( cseis_geolib::csException("csSeismicWriter_ver::setBlockCompression: Block compression requires 32bit samples, not %d bit", 8*myByteSizeOneSample) );
+  }
+  if( maxError < 0 ) {
+    throw( cseis_geolib::csException("csSeismicWriter_ver::setBlockCompression: Maximum error must not be negative: %f", maxError) );
+  }
+  myIsBlockCompressed = true;
+  myCodec           = ( maxError > 0 ) ? cseis_geolib::csSampleCodec::CODEC_LOSSY : cseis_geolib::csSampleCodec::CODEC_LOSSLESS;
+  myMaxError        = maxError;
+  myIsRelativeError = isRelativeError;
+  cseis_io::csIODefines::createVersionString( VERSION_SEISMIC_WRITER_BLOCK, myVersionText );
+  myBlockOffsets   = new cseis_geolib::csVector<csInt64_t>();
+  myBlockNumTraces = new cseis_geolib::csVector<int>();
+}
+double csSeismicWriter_ver::compressionRatio() const {
+  if( myNumBytesEncoded == 0 ) return 1.0;
+  return( (double)myNumBytesSamples / (double)myNumBytesEncoded );
+}
+double csSeismicWriter_ver::compressionSNR() const {
+  if( myErrorEnergy == 0 ) return std::numeric_limits<double>::infinity();
+  return( 10.0 * log10( mySignalEnergy / myErrorEnergy ) );
+}
 bool csSeismicWriter_ver::writeCurrentDataBuffer() {
+  if( myIsBlockCompressed ) return writeCompressedBlock();
   int sizeWrite = (int)fwrite( myDataBuffer, myCurrentDataBufferSize, 1, myFile );
   bool retValue = (sizeWrite == 1);
   myCurrentDataBufferSize = 0;
   return retValue;
 }
 //----------------------------------------------------------------
+// Block: Number of traces, byte size of remaining block, compressed byte size of each trace, trace header value blocks
+// of all traces, compressed samples of all traces. See csSeismicReader_ver05
+//
+bool csSeismicWriter_ver::writeCompressedBlock() {
+  int traceByteSize = myByteSizeHdrValueBlock + myByteSizeSamples;
+  int numTraces = myCurrentDataBufferSize / traceByteSize;
+  myCurrentDataBufferSize = 0;
+  if( numTraces == 0 ) return true;
+
+#pragma omp parallel for schedule(dynamic) if(numTraces > 1)
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    float const* samples = reinterpret_cast<float const*>( &myDataBuffer[itrc*traceByteSize + myByteSizeHdrValueBlock] );
+    char* buffer = &myEncodedBuffer[itrc*myMaxEncodedByteSize];
+    if( myCodec == cseis_geolib::csSampleCodec::CODEC_LOSSY ) {
+      float maxError = myMaxError;
+      if( myIsRelativeError ) {
+        float maxAmplitude = 0;
+        for( int isamp = 0; isamp < myNumSamples; isamp++ ) {
+          if( fabs(samples[isamp]) > maxAmplitude ) maxAmplitude = fabs(samples[isamp]);
+        }
+        maxError *= maxAmplitude;
+      }
+      myEncodedByteSizes[itrc] = cseis_geolib::csSampleCodec::encodeLossy( samples, myNumSamples, maxError, buffer,
+                                                                           myTraceEnergy[itrc], myTraceErrorEnergy[itrc] );
+    }
+    else {
+      myEncodedByteSizes[itrc] = cseis_geolib::csSampleCodec::encode( samples, myNumSamples, buffer );
+    }
+  }
+
+  int blockByteSize = numTraces * ( 4 + myByteSizeHdrValueBlock );
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    blockByteSize += myEncodedByteSizes[itrc];
+    myNumBytesEncoded += myEncodedByteSizes[itrc];
+    if( myCodec == cseis_geolib::csSampleCodec::CODEC_LOSSY ) {
+      mySignalEnergy += myTraceEnergy[itrc];
+      myErrorEnergy  += myTraceErrorEnergy[itrc];
+    }
+  }
+  myNumBytesSamples += (csInt64_t)numTraces * (csInt64_t)myByteSizeSamples;
+  myBlockOffsets->insertEnd( (csInt64_t)ftello( myFile ) );
+  myBlockNumTraces->insertEnd( numTraces );
+
+  bool success = ( fwrite( &numTraces, 4, 1, myFile ) == 1 );
+  success = success && ( fwrite( &blockByteSize, 4, 1, myFile ) == 1 );
+  success = success && ( (int)fwrite( myEncodedByteSizes, 4, numTraces, myFile ) == numTraces );
+  for( int itrc = 0; itrc < numTraces && success; itrc++ ) {
+    success = ( fwrite( &myDataBuffer[itrc*traceByteSize], myByteSizeHdrValueBlock, 1, myFile ) == 1 );
+  }
+  for( int itrc = 0; itrc < numTraces && success; itrc++ ) {
+    success = ( fwrite( &myEncodedBuffer[itrc*myMaxEncodedByteSize], myEncodedByteSizes[itrc], 1, myFile ) == 1 );
+  }
+  return success;
+}
+//----------------------------------------------------------------
+// End of blocks (block with zero traces), followed by block index: File position (8 bytes) and number of traces
+// (4 bytes) of each block. Then: File position of block index (8 bytes), number of blocks, total number of traces,
+// ID_TEXT_BLOCK_INDEX
+//
+bool csSeismicWriter_ver::writeBlockIndex() {
+  int numTraces = 0;
+  bool success = ( fwrite( &numTraces, 4, 1, myFile ) == 1 );
+  csInt64_t indexOffset = (csInt64_t)ftello( myFile );
+  int numBlocks = myBlockOffsets->size();
+  for( int iblock = 0; iblock < numBlocks && success; iblock++ ) {
+    csInt64_t blockOffset = myBlockOffsets->at(iblock);
+    int numTracesBlock = myBlockNumTraces->at(iblock);
+    success = ( fwrite( &blockOffset, 8, 1, myFile ) == 1 && fwrite( &numTracesBlock, 4, 1, myFile ) == 1 );
+    numTraces += numTracesBlock;
+  }
+  success = success && ( fwrite( &indexOffset, 8, 1, myFile ) == 1 );
+  success = success && ( fwrite( &numBlocks, 4, 1, myFile ) == 1 );
+  success = success && ( fwrite( &numTraces, 4, 1, myFile ) == 1 );
+  success = success && ( fwrite( ID_TEXT_BLOCK_INDEX, strlen(ID_TEXT_BLOCK_INDEX), 1, myFile ) == 1 );
+  return success;
+}
+//----------------------------------------------------------------
 void csSeismicWriter_ver::initialize() {
   std::string text;
   text.append( ID_TEXT_CSEIS );
@@ -131,6 +303,13 @@ bool csSeismicWriter_ver::writeFileHeader( csSeismicIOConfig const* config ) {
   }
 
   resizeDataBuffer( myNumBufferTraces * (myByteSizeSamples + myByteSizeHdrValueBlock + myByteSizeCompression) );
+  if( myIsBlockCompressed ) {
+    myMaxEncodedByteSize = cseis_geolib::csSampleCodec::maxEncodedByteSize( myNumSamples );
+    myEncodedBuffer      = new char[myNumBufferTraces * myMaxEncodedByteSize];
+    myEncodedByteSizes   = new int[myNumBufferTraces];
+    myTraceEnergy        = new double[myNumBufferTraces];
+    myTraceErrorEnergy   = new double[myNumBufferTraces];
+  }
 
 // Set super header
   appendInt(    config->numSamples );
@@ -187,6 +366,42 @@ bool csSeismicWriter_ver::writeFileHeader( csSeismicIOConfig const* config ) {
     }
   }
 
+  if( myIsBlockCompressed ) {
+    appendInt( myCodec );
+  }
+
+  if( myIndexHeaderNames != NULL ) {
+    myIndex = new csSeismicIndex();
+    for( int iname = 0; iname < myIndexHeaderNames->size(); iname++ ) {
+      std::string const& name = myIndexHeaderNames->at(iname);
+      // Trace header values are stored consecutively in header value block
+      int byteLocation = 0;
+      int ihdr = 0;
+      for( ; ihdr < numTrcHdrs; ihdr++ ) {
+        cseis_geolib::csHeaderInfo const* info = config->headerInfo( ihdr );
+        if( !info->name.compare( name ) ) break;
+        byteLocation += ( info->type != cseis_geolib::TYPE_STRING ) ? cseis_geolib::csGeolibUtils::numBytes( info->type ) : info->nElements;
+      }
+      if( ihdr == numTrcHdrs ) {
+        throw( cseis_geolib::csException("csSeismicWriter_ver::writeFileHeader: Trace header to index does not exist: '%s'", name.c_str()) );
+      }
+      cseis_geolib::type_t type = config->headerInfo( ihdr )->type;
+      if( type != cseis_geolib::TYPE_INT && type != cseis_geolib::TYPE_FLOAT && type != cseis_geolib::TYPE_DOUBLE && type != cseis_geolib::TYPE_INT64 ) {
+        throw( cseis_geolib::csException("csSeismicWriter_ver::writeFileHeader: Trace header '%s' cannot be indexed. Only number headers are supported", name.c_str()) );
+      }
+      myIndex->addHeader( name, type, byteLocation );
+    }
+  }
+
+  // Pad file header so that data samples of all traces are aligned to the sample size. This allows readers to reference
+  // samples directly in a memory-mapped file. Readers ignore any bytes following the trace header definitions.
+  if( myByteSizeOneSample == 4 && !myIsBlockCompressed && (myByteSizeHdrValueBlock+myByteSizeSamples) % myByteSizeOneSample == 0 ) {
+    int byteSizeIdText = (int)( strlen(ID_TEXT_CSEIS) + strlen(myVersionText) );
+    while( (byteSizeIdText + 4 + myByteLoc + myByteSizeHdrValueBlock) % myByteSizeOneSample != 0 ) {
+      appendChar( 0 );
+    }
+  }
+
   int sizeWrite = 0;
   if( (sizeWrite = (int)fwrite( &myByteLoc, 4, 1, myFile ) ) != 1 ) {
   }
@@ -256,8 +471,9 @@ void csSeismicWriter_ver::appendString( char const* value, int size ) {
   myByteLoc += size;
 }
 //----------------------------------------------------------------
-bool csSeismicWriter_ver::writeTrace( float* samples, char const* hdrValueBlock ) {
+bool csSeismicWriter_ver::writeTrace( float const* samples, char const* hdrValueBlock ) {
   if( myFile != NULL ) {
+    if( myIndex != NULL ) myIndex->addTrace( hdrValueBlock );
     memcpy( &(myDataBuffer[myCurrentDataBufferSize]), hdrValueBlock, myByteSizeHdrValueBlock );
     myCurrentDataBufferSize += myByteSizeHdrValueBlock;
 
@@ -3,6 +3,7 @@
 
 #include "cseis_includes.h"
 #include "geolib_methods.h"
+#include "geolib_window.h"
 #include "csTableNew.h"
 #include "csTableValueList.h"
 #include <cmath>
@@ -28,6 +29,7 @@ namespace mod_attribute {
     int hdrID_attr1;
     int hdrID_attr2;
     float* buffer;
+    double* energyBuffer;
     bool interpolate;
 
     csTableNew* table;
@@ -64,6 +66,7 @@ void init_mod_attribute_( csParamManager* param, csInitPhaseEnv* env, csLogWrite
   vars->startSample = 0;
   vars->endSample   = shdr->numSamples-1;
   vars->buffer = NULL;
+  vars->energyBuffer = NULL;
   vars->rmsWinWidthSample = 0;
   vars->rmsWinStepSample  = 0;
   vars->interpolate = true;
@@ -206,6 +209,9 @@ void init_mod_attribute_( csParamManager* param, csInitPhaseEnv* env, csLogWrite
   vars->hdrID_attr2 = hdef->headerIndex("attr2");
 
   vars->buffer = new float[5];
+  if( vars->method == mod_attribute::METHOD_RMS_MAXIMUM ) {
+    vars->energyBuffer = new double[shdr->numSamples];
+  }
 }
 
 //*************************************************************************************************
@@ -228,6 +234,10 @@ bool exec_mod_attribute_(
       delete [] vars->buffer;
       vars->buffer = NULL;
     }
+    if( vars->energyBuffer != NULL ) {
+      delete [] vars->energyBuffer;
+      vars->energyBuffer = NULL;
+    }
     if( vars->table != NULL ) {
       delete vars->table;
       vars->table = NULL;
@@ -297,12 +307,10 @@ bool exec_mod_attribute_(
   else if( vars->method == mod_attribute::METHOD_RMS_MAXIMUM ) {
     int sampMax = vars->startSample;
     float max = 0;
+    // Energy in window starting at each sample
+    compute_window_energy( &samples[vars->startSample], shdr->numSamples-vars->startSample, 0, vars->rmsWinWidthSample-1, vars->energyBuffer );
     for( int isamp = vars->startSample; isamp <= vars->endSample; isamp += vars->rmsWinStepSample ) {
-      double rms = 0;
-      for( int i = isamp; i < isamp+vars->rmsWinWidthSample; i++ ) {
-        rms += samples[i]*samples[i];
-      }
-      rms = sqrt(rms/(double)vars->rmsWinWidthSample);
+      double rms = sqrt(vars->energyBuffer[isamp-vars->startSample]/(double)vars->rmsWinWidthSample);
       if( rms > max ) {
         max = rms;
         sampMax = isamp + vars->rmsWinWidthSample/2;
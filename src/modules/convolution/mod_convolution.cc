@@ -4,6 +4,7 @@
 #include "cseis_includes.h"
 #include "csFlexNumber.h"
 #include "csASCIIFileReader.h"
+#include "csFFTConvolution.h"
 #include <cmath>
 #include <cstring>
 
@@ -25,6 +26,7 @@ namespace mod_convolution {
     float* bufferTrace;
     float* wavelet;
     int sampleAtZeroTime;
+    cseis_geolib::csFFTConvolution* fftConv; // Frequency domain convolution, for long wavelets
   };
   static int const UNIT_MS = 3;
   static int const UNIT_S  = 4;
@@ -50,6 +52,7 @@ void init_mod_convolution_( csParamManager* param, csInitPhaseEnv* env, csLogWri
   vars->wavelet   = NULL;
   vars->asciiParam = new cseis_io::ASCIIParam();
   vars->sampleAtZeroTime = 0;
+  vars->fftConv   = NULL;
 
 //---------------------------------------------
 //
@@ -157,6 +160,10 @@ void init_mod_convolution_( csParamManager* param, csInitPhaseEnv* env, csLogWri
   }
   vars->sampleAtZeroTime = (int)round( timeZero_ms / shdr->sampleInt );
 
+  if( csFFTConvolution::isFasterThanTimeDomain( vars->asciiParam->numSamples(), shdr->numSamples ) ) {
+    vars->fftConv = new csFFTConvolution( vars->wavelet, vars->asciiParam->numSamples(), shdr->numSamples );
+  }
+
   if( edef->isDebug() ) {
     for( int isamp = 0; isamp < vars->asciiParam->numSamples(); isamp++ ) {
       fprintf( stdout, "%d %f\n", isamp, vars->asciiParam->sample(isamp) );
@@ -185,12 +192,22 @@ bool exec_mod_convolution_(
       delete vars->asciiParam;
       vars->asciiParam = NULL;
     }
+    if( vars->fftConv != NULL ) {
+      delete vars->fftConv;
+      vars->fftConv = NULL;
+    }
     delete vars; vars = NULL;
     return true;
   }
 
   float* samples = trace->getTraceSamples();
 
+  if( vars->fftConv != NULL ) {
+    vars->fftConv->convolve( samples, vars->bufferTrace, vars->sampleAtZeroTime );
+    memcpy( samples, vars->bufferTrace, sizeof(float)*shdr->numSamples );
+    return true;
+  }
+
   for( int isampOut = 0; isampOut < shdr->numSamples; isampOut++ ) {
     float sum = 0.0;
     int startSamp = std::min( std::max( 0, isampOut + vars->sampleAtZeroTime - (vars->asciiParam->numSamples()-1) ), shdr->numSamples-1 );
@@ -5,6 +5,7 @@
 #include "geolib_math.h"
 #include "geolib_string_utils.h"
 #include "geolib_methods.h"
+#include "csFFTCorrelation.h"
 #include <cmath>
 #include <cstring>
 
@@ -31,6 +32,8 @@ namespace mod_correlation {
     int endSamp;   // End sample index
     int maxLag_samples;    // Maximum lag time in samples
     float* buffer;
+    cseis_geolib::csFFTCorrelation* fftCorr; // Frequency domain correlation with pilot trace
+    int fftCorrNumSamples; // Number of input samples that fftCorr was set up for
     int mode;
     int numSamplesOrig;
     int numSamplesBuffer;
@@ -64,6 +67,8 @@ void init_mod_correlation_( csParamManager* param, csInitPhaseEnv* env, csLogWri
   vars->hdrId_cross_lag = -1;
   vars->hdrId_cross_amp = -1;
   vars->buffer          = NULL;
+  vars->fftCorr         = NULL;
+  vars->fftCorrNumSamples = 0;
   vars->mode            = mod_correlation::MODE_CROSS;
   vars->startSamp       = 0;
   vars->endSamp         = shdr->numSamples-1;
@@ -270,6 +275,9 @@ void init_mod_correlation_( csParamManager* param, csInitPhaseEnv* env, csLogWri
     log->error("Header 'cross_amp' exists but has wrong format. Must be FLOAT or DOUBLE.");
   }
 
+  // Window taken from trace headers is adjusted in place and carried over to the next call: Process serially
+  edef->setThreadSafe( vars->hdrId_start < 0 && vars->hdrId_end < 0 );
+
   if( edef->isDebug() ) {
     log->line("time1: %f, time2: %f, sample1: %d, sample2: %d, sampInt: %f, max lag: %d samples\n", startTime, endTime, vars->startSamp, vars->endSamp, shdr->sampleInt, vars->maxLag_samples );
   }
@@ -297,6 +305,10 @@ void exec_mod_correlation_(
       delete [] vars->buffer;
       vars->buffer = NULL;
     }
+    if( vars->fftCorr != NULL ) {
+      delete vars->fftCorr;
+      vars->fftCorr = NULL;
+    }
     delete vars; vars = NULL;
     return;
   }
@@ -413,15 +425,33 @@ void exec_mod_correlation_(
   //
   else if( vars->mode == mod_correlation::MODE_CROSS_PILOT || vars->mode == mod_correlation::MODE_CROSS_PILOT_INPUT ) {
     float* trace1Ptr = traceGather->trace(0)->getTraceSamples();
+    // Pilot spectrum is computed once per ensemble if correlation in frequency domain is faster
+    bool useFFT = csFFTCorrelation::isFasterThanTimeDomain( nSampIn, vars->maxLag_samples, traceGather->numTraces() > 2 );
+    if( useFFT ) {
+      if( vars->fftCorr != NULL && vars->fftCorrNumSamples != nSampIn ) {
+        delete vars->fftCorr;
+        vars->fftCorr = NULL;
+      }
+      if( vars->fftCorr == NULL ) {
+        vars->fftCorr = new csFFTCorrelation( nSampIn, vars->maxLag_samples );
+        vars->fftCorrNumSamples = nSampIn;
+      }
+      vars->fftCorr->setPilot( &trace1Ptr[vars->startSamp] );
+    }
     for( int itrc = 1; itrc < traceGather->numTraces(); itrc++ ) {
       float* trace2Ptr = traceGather->trace(itrc)->getTraceSamples();
-      compute_twosided_correlation(
-				   &trace1Ptr[vars->startSamp],
-				   &trace2Ptr[vars->startSamp],
-				   nSampIn,
-				   vars->buffer,
-				   vars->maxLag_samples,
-				   vars->dampen );
+      if( useFFT ) {
+        vars->fftCorr->correlate( &trace2Ptr[vars->startSamp], vars->buffer, vars->dampen );
+      }
+      else {
+        compute_twosided_correlation(
+                                     &trace1Ptr[vars->startSamp],
+                                     &trace2Ptr[vars->startSamp],
+                                     nSampIn,
+                                     vars->buffer,
+                                     vars->maxLag_samples,
+                                     vars->dampen );
+      }
       
       int sampleIndex_maxAmp = 0;
       maxAmp = 0.0;
@@ -498,6 +528,22 @@ void exec_mod_correlation_(
   }
 }
 
+//*************************************************************************************************
+// Clone: Correlation buffer and FFT correlation object are scratch space, create new ones for each thread
+//
+//*************************************************************************************************
+void clone_mod_correlation_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  mod_correlation::VariableStruct* vars = reinterpret_cast<mod_correlation::VariableStruct*>( env->execPhaseDef->variables() );
+  mod_correlation::VariableStruct* varsClone = new mod_correlation::VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  *varsClone = *vars;
+  varsClone->buffer  = new float[vars->numSamplesBuffer];
+  varsClone->fftCorr = NULL;
+  varsClone->fftCorrNumSamples = 0;
+}
+
 //*************************************************************************************************
 // Parameter definition
 //
@@ -548,6 +594,9 @@ extern "C" void _params_mod_correlation_( csParamDef* pdef ) {
 extern "C" void _init_mod_correlation_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_correlation_( param, env, log );
 }
+extern "C" void _clone_mod_correlation_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_correlation_( env, envClone );
+}
 extern "C" void _exec_mod_correlation_( csTraceGather* traceGather, int* port, int* numTrcToKeep, csExecPhaseEnv* env, csLogWriter* log ) {
   exec_mod_correlation_( traceGather, port, numTrcToKeep, env, log );
 }
@@ -36,6 +36,7 @@ void init_mod_ens_define_( csParamManager* param, csInitPhaseEnv* env, csLogWrit
   VariableStruct* vars = new VariableStruct();
   edef->setVariables( vars );
   edef->setExecType( EXEC_TYPE_SINGLETRACE );
+  edef->setThreadSafe( true );
 
   vars->hdrID_all = -1;
 
@@ -54,6 +54,7 @@ namespace mod_filter {
     bool isNotchCosineTaper;
     float notchFreqHz;
     float notchWidthHz;
+    bool isClone;
   };
   static int const UNIT_HZ   = 1;
   static int const UNIT_PERCENT = 2;
@@ -117,6 +118,7 @@ void init_mod_filter_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
   vars->notchWidthHz = 0;
   vars->isNotchFilter = false;
   vars->isNotchCosineTaper = false;
+  vars->isClone = false;
 //---------------------------------------------
 //
   bool doRestore = false;
@@ -377,6 +379,7 @@ void init_mod_filter_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
     //  }
     // log->error("Whatever");
   }
+  edef->setThreadSafe( true );
 }
 //*************************************************************************************************
 // Exec phase
@@ -397,6 +400,16 @@ void exec_mod_filter_(
   csTraceHeaderDef const* hdef = env->headerDef;
 
   if( edef->isCleanup()){
+    if( vars->isClone ) {
+      // Shared with original module variables, deleted there
+      vars->winStartSample = NULL;
+      vars->winEndSample   = NULL;
+      vars->winNumSamples  = NULL;
+      vars->freqLowPass    = NULL;
+      vars->freqHighPass   = NULL;
+      vars->orderLowPass   = NULL;
+      vars->orderHighPass  = NULL;
+    }
     if( vars->fftTool != NULL ) {
       delete vars->fftTool;
       vars->fftTool = NULL;
@@ -588,6 +601,33 @@ void exec_mod_filter_(
 
 }
 
+//*************************************************************************************************
+// Clone method
+// Create module variables for another thread: Copy parameters, allocate separate work buffers
+//
+//*************************************************************************************************
+void clone_mod_filter_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( env->execPhaseDef->variables() );
+  csSuperHeader const* shdr = env->superHeader;
+  VariableStruct* varsClone = new VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  *varsClone = *vars;
+  varsClone->isClone = true;
+  if( vars->fftTool != NULL ) varsClone->fftTool = new csFFTTools( *vars->fftTool );
+  if( vars->fftToolWin != NULL ) {
+    varsClone->fftToolWin = new csFFTTools*[vars->numWin];
+    for( int iwin = 0; iwin < vars->numWin; iwin++ ) {
+      varsClone->fftToolWin[iwin] = new csFFTTools( *vars->fftToolWin[iwin] );
+    }
+  }
+  if( vars->bufferPaddedTrace != NULL ) varsClone->bufferPaddedTrace = new float[vars->numSamplesInclPad];
+  if( vars->bufferInput != NULL )  varsClone->bufferInput  = new float[shdr->numSamples];
+  if( vars->winBufferIn != NULL )  varsClone->winBufferIn  = new float[shdr->numSamples];
+  if( vars->winBufferOut != NULL ) varsClone->winBufferOut = new float[shdr->numSamples];
+}
+
 //*************************************************************************************************
 // Parameter definition
 //
@@ -664,6 +704,9 @@ extern "C" void _params_mod_filter_( csParamDef* pdef ) {
 extern "C" void _init_mod_filter_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_filter_( param, env, log );
 }
+extern "C" void _clone_mod_filter_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_filter_( env, envClone );
+}
 extern "C" void _exec_mod_filter_( csTraceGather* traceGather, int* port, int* numTrcToKeep, csExecPhaseEnv* env, csLogWriter* log ) {
   exec_mod_filter_( traceGather, port, numTrcToKeep, env, log );
 }
@@ -38,7 +38,10 @@ csFXDecon::~csFXDecon() {
     delete myFFT;
     myFFT = NULL;
   }
-  freeMem( myNumTraces );
+  // Buffers are only allocated once the first ensemble has been processed
+  if( fdata != NULL ) {
+    freeMem( myNumTraces );
+  }
 }
 //--------------------------------------------------------------------------------
 //
@@ -17,6 +17,7 @@ using namespace std;
 namespace mod_fxdecon {
   struct VariableStruct {
     csFXDecon* fxdecon;
+    mod_fxdecon::Attr attr;
   };
   static int const MODE_ENSEMBLE = 11;
   static int const MODE_TRACE    = 12;
@@ -42,6 +43,7 @@ void init_mod_fxdecon_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
 
   edef->setExecType( EXEC_TYPE_MULTITRACE );
   env->execPhaseDef->setTraceSelectionMode( TRCMODE_ENSEMBLE );
+  edef->setThreadSafe( true );
 
   mod_fxdecon::Attr attr;
   attr.fmin           = 0;
@@ -83,6 +85,7 @@ void init_mod_fxdecon_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
   if( attr.numWin == 0 ) attr.taperLen_s = 0;
 
   vars->fxdecon->initialize( shdr->sampleInt, shdr->numSamples, attr );
+  vars->attr = attr;
 
   if( edef->isDebug() ) {
     vars->fxdecon->dump();
@@ -141,6 +144,22 @@ void exec_mod_fxdecon_(
   delete [] samplesOut;
 }
 
+//*************************************************************************************************
+// Clone: FX decon object holds scratch buffers, create new one for each thread
+//
+//*************************************************************************************************
+void clone_mod_fxdecon_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( env->execPhaseDef->variables() );
+  csSuperHeader const* shdr = env->superHeader;
+  VariableStruct* varsClone = new VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  varsClone->attr    = vars->attr;
+  varsClone->fxdecon = new mod_fxdecon::csFXDecon();
+  varsClone->fxdecon->initialize( shdr->sampleInt, shdr->numSamples, varsClone->attr );
+}
+
 //*************************************************************************************************
 // Parameter definition
 //
@@ -170,6 +189,9 @@ extern "C" void _params_mod_fxdecon_( csParamDef* pdef ) {
 extern "C" void _init_mod_fxdecon_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_fxdecon_( param, env, log );
 }
+extern "C" void _clone_mod_fxdecon_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_fxdecon_( env, envClone );
+}
 extern "C" void _exec_mod_fxdecon_( csTraceGather* traceGather, int* port, int* numTrcToKeep, csExecPhaseEnv* env, csLogWriter* log ) {
   exec_mod_fxdecon_( traceGather, port, numTrcToKeep, env, log );
 }
@@ -7,6 +7,7 @@
 #include "csTableNew.h"
 #include "csInterpolation.h"
 #include "csGeolibUtils.h"
+#include "geolib_window.h"
 #include <cmath>
 #include <cstring>
 
@@ -30,6 +31,7 @@ namespace mod_gain {
 
     int sphDivOption;
     csTableNew* table;
+    csTimeFunction<double>* velTimeFunction;
     int* hdrId_keys;
     int hdrId_offset;
     float* velocityTrace;
@@ -44,6 +46,7 @@ namespace mod_gain {
     int outputOption;
 
     int traceCounter;
+    bool isClone;  // true for copy created by clone method. Shares read-only fields with original
   };
   static int const OUTPUT_DATA = 0;
   static int const OUTPUT_GAIN = 1;
@@ -74,6 +77,7 @@ void init_mod_gain_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
   vars->applyTraceEqualization = false;
   vars->applySphDiv = false;
   vars->table = NULL;
+  vars->velTimeFunction = NULL;
   vars->hdrId_keys = NULL;
   vars->hdrId_offset = -1;
   vars->velocityTrace = NULL;
@@ -89,6 +93,7 @@ void init_mod_gain_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
   vars->outputOption = mod_gain::OUTPUT_DATA;
 
   vars->traceCounter = 0;
+  vars->isClone = false;
 //---------------------------------------------
 //
   
@@ -190,6 +195,7 @@ void init_mod_gain_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
       vars->isVelSet = false;
       if( vars->sphDivOption == mod_gain::SPHDIV_OFFSET ) vars->hdrId_offset = hdef->headerIndex("offset");
       vars->velocityTrace = new float[shdr->numSamples];
+      vars->velTimeFunction = new csTimeFunction<double>();
     } // if applySphDiv
   }
 
@@ -220,6 +226,7 @@ void init_mod_gain_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
   else if( sum == 0 ) { // !vars->applyTGain && !vars->applyAGC && !vars->applyTraceEqualization ) {
     log->error("No gain option specified.");
   }
+  edef->setThreadSafe( true );
 
   // TEMP:
   //  for( int i = 0; i < hdef->numHeaders(); i++ ) {
@@ -243,6 +250,16 @@ bool exec_mod_gain_(
   csSuperHeader const* shdr = env->superHeader;
 
   if( edef->isCleanup()){
+    if( vars->isClone ) {
+      // Shared with original module variables, deleted there
+      vars->scalarTGain = NULL;
+      vars->table = NULL;
+      vars->hdrId_keys = NULL;
+    }
+    if( vars->velTimeFunction ) {
+      delete vars->velTimeFunction;
+      vars->velTimeFunction = NULL;
+    }
     if( vars->scalarTGain ) {
       delete [] vars->scalarTGain;
       vars->scalarTGain = NULL;
@@ -287,14 +304,9 @@ bool exec_mod_gain_(
     }
   }
   else if( vars->applyAGC ) {
+    compute_window_rms( samples, shdr->numSamples, vars->agcWindowLengthSamples, vars->buffer );
     for( int isamp = 0; isamp < shdr->numSamples; isamp++ ) {
-      int firstSamp = MAX(0,isamp-vars->agcWindowLengthSamples);
-      int lastSamp  = MIN(shdr->numSamples-1,isamp+vars->agcWindowLengthSamples);
-      float rms = 0.0;
-      for( int isampSum = firstSamp; isampSum <= lastSamp; isampSum++ ) {
-        rms += samples[isampSum]*samples[isampSum];
-      }
-      rms = sqrt( rms/(float)(lastSamp-firstSamp+1) );
+      float rms = vars->buffer[isamp];
       if( rms != 0 ) vars->buffer[isamp] = 1.0f / rms;
       else vars->buffer[isamp] = 0.0f;
     }
@@ -339,12 +351,12 @@ bool exec_mod_gain_(
           }
         }
       }
-      memcpy( vars->keyValueBuffer, keyValueBuffer, vars->table->numKeys() );
-      if( !vars->isVelSet ) velTimeFunc = vars->table->getFunction( keyValueBuffer, false );
+      memcpy( vars->keyValueBuffer, keyValueBuffer, vars->table->numKeys()*sizeof(double) );
+      if( !vars->isVelSet ) velTimeFunc = vars->table->getFunction( keyValueBuffer, vars->velTimeFunction );
       delete [] keyValueBuffer;
     }
     else if( !vars->isVelSet ) {
-      velTimeFunc = vars->table->getFunction( NULL, false );
+      velTimeFunc = vars->table->getFunction( NULL, vars->velTimeFunction );
     }
     if( !vars->isVelSet ) {
       int numVelocities = velTimeFunc->numValues();
@@ -424,6 +436,28 @@ bool exec_mod_gain_(
   return true;
 }
 
+//*************************************************************************************************
+// Clone method
+// Create module variables for another thread: Copy parameters, allocate separate work buffers
+//
+//*************************************************************************************************
+void clone_mod_gain_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( env->execPhaseDef->variables() );
+  csSuperHeader const* shdr = env->superHeader;
+  VariableStruct* varsClone = new VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  *varsClone = *vars;
+  varsClone->isClone = true;
+  varsClone->traceCounter = 1;  // Only print header list once
+  varsClone->isVelSet = false;
+  if( vars->buffer != NULL ) varsClone->buffer = new float[shdr->numSamples];
+  if( vars->velocityTrace != NULL ) varsClone->velocityTrace = new float[shdr->numSamples];
+  if( vars->velTimeFunction != NULL ) varsClone->velTimeFunction = new csTimeFunction<double>();
+  if( vars->keyValueBuffer != NULL ) varsClone->keyValueBuffer = new double[vars->table->numKeys()];
+}
+
 //*************************************************************************************************
 // Parameter definition
 //
@@ -484,6 +518,9 @@ extern "C" void _params_mod_gain_( csParamDef* pdef ) {
 extern "C" void _init_mod_gain_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_gain_( param, env, log );
 }
+extern "C" void _clone_mod_gain_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_gain_( env, envClone );
+}
 extern "C" bool _exec_mod_gain_( csTrace* trace, int* port, csExecPhaseEnv* env, csLogWriter* log ) {
   return exec_mod_gain_( trace, port, env, log );
 }
@@ -30,6 +30,7 @@ void init_mod_hdr_del_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
   edef->setVariables( NULL );
 
   edef->setExecType( EXEC_TYPE_SINGLETRACE );
+  edef->setThreadSafe( true );
 
   csVector<std::string> valueList;
   int numLines = param->getNumLines("header");
@@ -3,9 +3,8 @@
 
 #include "cseis_includes.h"
 #include <cmath>
-#include "csToken.h"
 #include "csVector.h"
-#include "csEquationSolver.h"
+#include "csHeaderEquation.h"
 
 using std::string;
 using namespace cseis_geolib;
@@ -21,15 +20,12 @@ using namespace cseis_system;
 namespace mod_hdr_math {
   struct VariableStruct {
     int nEquations;
-    csEquationSolver* solver;
+    csHeaderEquation* equations;
     int*          indexHdrs;
     type_t*       typeHdrs;
     std::string*  nameHdrs;
-    int**         constHdrIndex;
-    type_t**      constHdrType;
-    std::string** constNames;
-    int*          nHdrs;
-    csVector<string>** constList;
+    /// Constant text for string headers
+    std::string*  stringValues;
   };
   static const type_t SPECIAL_TYPE_TRACE = 255;
 }
@@ -56,15 +52,11 @@ void init_mod_hdr_math_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
   // Initialize
   //
   vars->nEquations = 0;
-  vars->solver     = NULL;
-  vars->constList  = NULL;
+  vars->equations  = NULL;
   vars->indexHdrs  = NULL;
   vars->nameHdrs   = NULL;
   vars->typeHdrs   = NULL;
-  vars->constHdrIndex  = NULL;
-  vars->constNames     = NULL;
-  vars->constHdrType   = NULL;
-  vars->nHdrs          = NULL;
+  vars->stringValues = NULL;
   
   //---------------------------------------------------------
   // Create new headers
@@ -154,33 +146,12 @@ void init_mod_hdr_math_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
   int nEquations = param->getNumLines( "equation" );
 
   vars->nEquations = nEquations;
-  vars->solver     = new csEquationSolver[nEquations];
-  vars->constList  = new csVector<string>*[nEquations];
+  vars->equations  = new csHeaderEquation[nEquations];
   // Resultant headers:
   vars->indexHdrs  = new int[nEquations];
   vars->nameHdrs   = new string[nEquations];
   vars->typeHdrs   = new type_t[nEquations];
-  // Equation 'constants':
-  vars->constHdrIndex  = new int*[nEquations];
-  vars->constNames     = new string*[nEquations];
-  vars->constHdrType   = new type_t*[nEquations];
-  vars->nHdrs          = new int[nEquations];
-
-  for( int ieq = 0; ieq < nEquations; ieq++ ) {
-    vars->constList[ieq] = NULL;
-    vars->constHdrIndex[ieq] = NULL;
-    vars->constNames[ieq]    = NULL;
-    vars->constHdrType[ieq]  = NULL;
-  }
-  
-  // List all header names. These may actually not really exist if they were deleted
-  // --> Check later that these headers exist
-  int numHeaders = hdef->numHeaders();
-  string* allHeaderNames = new string[numHeaders];
-  for( int ihdr = 0; ihdr < numHeaders; ihdr++ ) {
-    allHeaderNames[ihdr] = hdef->headerName(ihdr);
-  }
-  int nHdrs;
+  vars->stringValues = new string[nEquations];
 
   for( int ieq = 0; ieq < nEquations; ieq++ ) {
     param->getAll( "equation", &valueList, ieq );
@@ -202,35 +173,20 @@ void init_mod_hdr_math_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
       vars->typeHdrs[ieq]  = hdef->headerType(name.c_str());
       vars->indexHdrs[ieq] = hdef->headerIndex(name.c_str());
       if( vars->typeHdrs[ieq] == TYPE_STRING ) {
-        vars->nHdrs[ieq] = 1;
-        vars->constNames[ieq] = new string[1];
-        vars->constNames[ieq][0] = equationText;
+        vars->stringValues[ieq] = equationText;
         continue;
       }
-      vars->constList[ieq] = new csVector<string>;
-      if( !vars->solver[ieq].prepare( equationText, allHeaderNames, numHeaders ) ) {
-        log->error("Error occurred: %s", vars->solver[ieq].getErrorMessage().c_str() );
+      csVector<std::string> unknownNames;
+      try {
+        vars->equations[ieq].set( equationText, hdef, &unknownNames );
       }
-      vars->solver[ieq].prepareUserConstants( vars->constList[ieq] );
-      nHdrs = vars->constList[ieq]->size();
-      vars->nHdrs[ieq] = nHdrs;
-      vars->constNames[ieq]    = new string[nHdrs];
-      vars->constHdrIndex[ieq] = new int[nHdrs];
-      vars->constHdrType[ieq]  = new type_t[nHdrs];
-      
-      for( int ihdr = 0; ihdr < nHdrs; ihdr++ ) {
-        vars->constNames[ieq][ihdr] = vars->constList[ieq]->at(ihdr);
+      catch( csException& exc ) {
+        log->error("Error occurred: %s", exc.getMessage() );
       }
-      // Final check if all identifiers really exist as header names
-      for( int ihdr = 0; ihdr < vars->constList[ieq]->size(); ihdr++ ) {
-        if( !hdef->headerExists( vars->constList[ieq]->at(ihdr) ) ) {
-          log->line("Unknown identifier in equation: '%s'", vars->constList[ieq]->at(ihdr).c_str() );
-          env->addError();
-        }
-        else {
-          vars->constHdrIndex[ieq][ihdr] = hdef->headerIndex( vars->constNames[ieq][ihdr].c_str() );
-          vars->constHdrType[ieq][ihdr]  = hdef->headerType( vars->constNames[ieq][ihdr].c_str() );
-        }
+      // Report all unknown identifiers before failing
+      for( int i = 0; i < unknownNames.size(); i++ ) {
+        log->line("Unknown identifier in equation: '%s'", unknownNames.at(i).c_str() );
+        env->addError();
       }
     }
     else {
@@ -238,7 +194,6 @@ void init_mod_hdr_math_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
       env->addError();
     }
   }
-  delete [] allHeaderNames;
 
   nLines = param->getNumLines( "delete" );
   csVector<std::string> nameList(2);
@@ -285,8 +240,8 @@ bool exec_mod_hdr_math_(
   csExecPhaseDef* edef = env->execPhaseDef;
 
   if( edef->isCleanup() ) {
-    if( vars->solver != NULL ) {
-      delete [] vars->solver; vars->solver = NULL;
+    if( vars->equations != NULL ) {
+      delete [] vars->equations; vars->equations = NULL;
     }
     // Resultant headers:
     if( vars->indexHdrs != NULL ) {
@@ -298,27 +253,8 @@ bool exec_mod_hdr_math_(
     if( vars->typeHdrs != NULL ) {
       delete [] vars->typeHdrs; vars->typeHdrs = NULL;
     }
-    // Equation 'constants':
-    if( vars->nHdrs != NULL ) {
-      delete [] vars->nHdrs; vars->nHdrs = NULL;
-    }
-    for( int ieq = 0; ieq < vars->nEquations; ieq++ ) {
-      if( vars->constList[ieq] != NULL ) delete vars->constList[ieq];
-      if( vars->constNames[ieq] != NULL ) delete [] vars->constNames[ieq];
-      if( vars->constHdrIndex != NULL ) delete [] vars->constHdrIndex[ieq];
-      if( vars->constHdrType != NULL ) delete [] vars->constHdrType[ieq];
-    }
-    if( vars->constList != NULL ) {
-      delete [] vars->constList; vars->constList = NULL;
-    }
-    if( vars->constNames != NULL ) {
-      delete [] vars->constNames;     vars->constNames  =  NULL;
-    }
-    if( vars->constHdrType != NULL ) {
-      delete [] vars->constHdrType; vars->constHdrType = NULL;
-    }
-    if( vars->constHdrIndex != NULL ) {
-      delete [] vars->constHdrIndex; vars->constHdrIndex = NULL;
+    if( vars->stringValues != NULL ) {
+      delete [] vars->stringValues; vars->stringValues = NULL;
     }
     delete vars; vars = NULL;
     return true;
@@ -327,55 +263,25 @@ bool exec_mod_hdr_math_(
 
   csTraceHeader* trcHdr = trace->getTraceHeader();
 
-  try { 
-    for( int ieq = 0; ieq < vars->nEquations; ieq++ ) {
-      if( vars->typeHdrs[ieq] == TYPE_STRING ) {
-        trcHdr->setStringValue( vars->indexHdrs[ieq], vars->constNames[ieq][0] );
-        continue;
-      }
-      int nHdrs = vars->nHdrs[ieq];
-      string hdrName;
-      double* hdrValues = NULL;
-      if( nHdrs > 0 ) {
-        hdrValues = new double[nHdrs];
-        for( int ihdr = 0; ihdr < nHdrs; ihdr++ ) {
-          int indexHdr = vars->constHdrIndex[ieq][ihdr];
-          type_t type  = vars->constHdrType[ieq][ihdr];
-          if( type == TYPE_FLOAT ) {
-            hdrValues[ihdr] = (double)trcHdr->floatValue(indexHdr);
-          }
-          else if( type == TYPE_DOUBLE ) {
-            hdrValues[ihdr] = trcHdr->doubleValue( indexHdr );
-          }
-          else if( type == TYPE_INT ) {
-            hdrValues[ihdr] = (double)trcHdr->intValue(indexHdr);
-          }
-          else if( type == TYPE_INT64 ) {
-            hdrValues[ihdr] = (double)trcHdr->int64Value(indexHdr);
-          }
-        }
-        vars->solver[ieq].setUserConstants( hdrValues, nHdrs );
-        delete [] hdrValues;
-      } // END if nHdrs
-      double result = vars->solver[ieq].solve();
-      type_t type   = vars->typeHdrs[ieq];
-      if( type == TYPE_FLOAT ) {
-        trcHdr->setFloatValue( vars->indexHdrs[ieq], (float)result );
-      }
-      else if( type == TYPE_DOUBLE ) {
-        trcHdr->setDoubleValue( vars->indexHdrs[ieq], result );
-      }
-      else if( type == TYPE_INT ) {
-        trcHdr->setIntValue( vars->indexHdrs[ieq], (int)result );
-      }
-      else if( type == TYPE_INT64 ) {
-        trcHdr->setInt64Value( vars->indexHdrs[ieq], (csInt64_t)result );
-      }
+  for( int ieq = 0; ieq < vars->nEquations; ieq++ ) {
+    if( vars->typeHdrs[ieq] == TYPE_STRING ) {
+      trcHdr->setStringValue( vars->indexHdrs[ieq], vars->stringValues[ieq] );
+      continue;
+    }
+    double result = vars->equations[ieq].solve( trcHdr );
+    type_t type   = vars->typeHdrs[ieq];
+    if( type == TYPE_FLOAT ) {
+      trcHdr->setFloatValue( vars->indexHdrs[ieq], (float)result );
+    }
+    else if( type == TYPE_DOUBLE ) {
+      trcHdr->setDoubleValue( vars->indexHdrs[ieq], result );
+    }
+    else if( type == TYPE_INT ) {
+      trcHdr->setIntValue( vars->indexHdrs[ieq], (int)result );
+    }
+    else if( type == TYPE_INT64 ) {
+      trcHdr->setInt64Value( vars->indexHdrs[ieq], (csInt64_t)result );
     }
-  }
-  catch( EquationException& e ) {
-    log->line("Error occurred: %s", e.getMessage());
-    env->addError();
   }
 
   return true;
@@ -357,91 +357,37 @@ void exec_mod_hdr_math_ens_(
 //    else if( vars->selectFailOption = SELECT_FAIL_NONE ) {
 //    }
     else {  // if( vars->selectFailOption = SELECT_FAIL_HEADER ) {
-      double value = vars->selectFailValue;
-      for( int itrc = 0; itrc < nTracesIn; itrc++) {
-        if( vars->selectFailOption == mod_hdr_math_ens::SELECT_FAIL_HEADER ) {
-          value = traceGather->trace(itrc)->getTraceHeader()->doubleValue(vars->hdrId_selectFail);
-        }
-        if( vars->hdrType1 == TYPE_FLOAT ) {
-          traceGather->trace(itrc)->getTraceHeader()->setFloatValue( vars->hdrId1, (float)value );
-        }
-        else if( vars->hdrType1 == TYPE_DOUBLE ) {
-          traceGather->trace(itrc)->getTraceHeader()->setDoubleValue( vars->hdrId1, value );
-        }
-        else if( vars->hdrType1 == TYPE_INT ) {
-          traceGather->trace(itrc)->getTraceHeader()->setIntValue( vars->hdrId1, (int)value );
-        }
-        else if( vars->hdrType1 == TYPE_INT64 ) {
-          traceGather->trace(itrc)->getTraceHeader()->setInt64Value( vars->hdrId1, (csInt64_t)value );
-        }
-        if( vars->nHeaders == 2 ) {
-          if( vars->hdrType2 == TYPE_FLOAT ) {
-            traceGather->trace(itrc)->getTraceHeader()->setFloatValue( vars->hdrId2, (float)value );
-          }
-          else if( vars->hdrType2 == TYPE_DOUBLE ) {
-            traceGather->trace(itrc)->getTraceHeader()->setDoubleValue( vars->hdrId2, value );
-          }
-          else if( vars->hdrType2 == TYPE_INT ) {
-            traceGather->trace(itrc)->getTraceHeader()->setIntValue( vars->hdrId2, (int)value );
-          }
-          else if( vars->hdrType2 == TYPE_INT64 ) {
-            traceGather->trace(itrc)->getTraceHeader()->setInt64Value( vars->hdrId2, (csInt64_t)value );
-          }
-        }
+      if( vars->selectFailOption == mod_hdr_math_ens::SELECT_FAIL_HEADER ) {
+        double* failValues = new double[nTracesIn];
+        traceGather->getHeaderValues( vars->hdrId_selectFail, failValues );
+        traceGather->setHeaderValues( vars->hdrId1, failValues );
+        if( vars->nHeaders == 2 ) traceGather->setHeaderValues( vars->hdrId2, failValues );
+        delete [] failValues;
+      }
+      else {
+        traceGather->setHeaderValue( vars->hdrId1, vars->selectFailValue );
+        if( vars->nHeaders == 2 ) traceGather->setHeaderValue( vars->hdrId2, vars->selectFailValue );
       }
     }
   }
 
 //-------------------------------------------------------------------------------
     values = new double[nTracesSelected];
+    double* column = new double[nTracesIn];
+    traceGather->getHeaderValues( vars->hdrId1, column );
     int counter = 0;
-    if( vars->hdrType1 == TYPE_FLOAT ) {
-      for( int itrc = 0; itrc < nTracesIn; itrc++) {
-        if( isSelected[itrc] ) values[counter++] = (double)traceGather->trace(itrc)->getTraceHeader()->floatValue(vars->hdrId1);
-      }
-    }
-    else if( vars->hdrType1 == TYPE_DOUBLE ) {
-      for( int itrc = 0; itrc < nTracesIn; itrc++) {
-        if( isSelected[itrc] ) values[counter++] = traceGather->trace(itrc)->getTraceHeader()->doubleValue(vars->hdrId1);
-      }
-    }
-    else if( vars->hdrType1 == TYPE_INT ) {
-      for( int itrc = 0; itrc < nTracesIn; itrc++) {
-        if( isSelected[itrc] ) values[counter++] = (double)traceGather->trace(itrc)->getTraceHeader()->intValue(vars->hdrId1);
-      }
-    }
-    else if( vars->hdrType1 == TYPE_INT64 ) {
-      for( int itrc = 0; itrc < nTracesIn; itrc++) {
-        if( isSelected[itrc] ) values[counter++] = (double)traceGather->trace(itrc)->getTraceHeader()->int64Value(vars->hdrId1);
-      }
-    }
-    else {
-      log->error("mod_hdr_math_ens: Unsupported trace header type, code: %d", vars->hdrType1 );
+    for( int itrc = 0; itrc < nTracesIn; itrc++) {
+      if( isSelected[itrc] ) values[counter++] = column[itrc];
     }
     if( vars->nHeaders == 2 ) {
-      int counter = 0;
       values2 = new double[nTracesSelected];
-      if( vars->hdrType2 == TYPE_FLOAT ) {
-        for( int itrc = 0; itrc < nTracesIn; itrc++) {
-          if( isSelected[itrc] ) values2[counter++] = (double)traceGather->trace(itrc)->getTraceHeader()->floatValue(vars->hdrId2);
-        }
-      }
-      else if( vars->hdrType2 == TYPE_DOUBLE ) {
-        for( int itrc = 0; itrc < nTracesIn; itrc++) {
-          if( isSelected[itrc] ) values2[counter++] = traceGather->trace(itrc)->getTraceHeader()->doubleValue(vars->hdrId2);
-        }
-      }
-      else if( vars->hdrType2 == TYPE_INT ) {
-        for( int itrc = 0; itrc < nTracesIn; itrc++) {
-          if( isSelected[itrc] ) values2[counter++] = (double)traceGather->trace(itrc)->getTraceHeader()->intValue(vars->hdrId2);
-        }
-      }
-      else if( vars->hdrType2 == TYPE_INT64 ) {
-        for( int itrc = 0; itrc < nTracesIn; itrc++) {
-          if( isSelected[itrc] ) values2[counter++] = (double)traceGather->trace(itrc)->getTraceHeader()->int64Value(vars->hdrId2);
-        }
+      traceGather->getHeaderValues( vars->hdrId2, column );
+      counter = 0;
+      for( int itrc = 0; itrc < nTracesIn; itrc++) {
+        if( isSelected[itrc] ) values2[counter++] = column[itrc];
       }
     }
+    delete [] column;
 
   //----------------------------------------------------
   // Compute function
@@ -494,15 +440,8 @@ void exec_mod_hdr_math_ens_(
       values2[itrc] = values[itrc] * coefficients[1] + coefficients[0];
     }
 
-    if( vars->hdrType2 == TYPE_FLOAT ) {
-      for( int itrc = 0; itrc < nTracesSelected; itrc++) {
-        traceGather->trace(itrc)->getTraceHeader()->setFloatValue( vars->hdrId2, (float)values2[itrc] );
-      }
-    }
-    else if( vars->hdrType2 == TYPE_DOUBLE ) {
-      for( int itrc = 0; itrc < nTracesSelected; itrc++) {
-        traceGather->trace(itrc)->getTraceHeader()->setDoubleValue( vars->hdrId2, values2[itrc] );
-      }
+    if( vars->hdrType2 == TYPE_FLOAT || vars->hdrType2 == TYPE_DOUBLE ) {
+      traceGather->setHeaderValues( vars->hdrId2, values2, 0, nTracesSelected );
     }
     if( values != NULL ) delete [] values;
     if( values2 != NULL ) delete [] values2;
@@ -602,51 +541,12 @@ void exec_mod_hdr_math_ens_(
   //--------------------------------------------------------
   // Put results back into trace headers
   //
-  if( vars->hdrType1 == TYPE_FLOAT ) {
-    for( int itrc = 0; itrc < nTracesOut; itrc++) {
-      traceGather->trace(itrc)->getTraceHeader()->setFloatValue( vars->hdrId1, (float)result );
-    }
-    if( vars->computeStddev ) {
-      for( int itrc = 0; itrc < nTracesOut; itrc++) {
-        traceGather->trace(itrc)->getTraceHeader()->setFloatValue( vars->hdrStddevId1, (float)stddev );
-      }
-    }
+  traceGather->setHeaderValue( vars->hdrId1, result, 0, nTracesOut );
+  if( vars->computeStddev ) {
+    traceGather->setHeaderValue( vars->hdrStddevId1, stddev, 0, nTracesOut );
   }
-  else if( vars->hdrType1 == TYPE_DOUBLE ) {
-    for( int itrc = 0; itrc < nTracesOut; itrc++) {
-      traceGather->trace(itrc)->getTraceHeader()->setDoubleValue( vars->hdrId1, result );
-    }
-    if( vars->computeStddev ) {
-      for( int itrc = 0; itrc < nTracesOut; itrc++) {
-        traceGather->trace(itrc)->getTraceHeader()->setDoubleValue( vars->hdrStddevId1, stddev );
-      }
-    }
-  }
-  else if( vars->hdrType1 == TYPE_INT ) {
-    for( int itrc = 0; itrc < nTracesOut; itrc++) {
-      traceGather->trace(itrc)->getTraceHeader()->setIntValue( vars->hdrId1, (int)result );
-    }
-    if( vars->computeStddev ) {
-      for( int itrc = 0; itrc < nTracesOut; itrc++) {
-        traceGather->trace(itrc)->getTraceHeader()->setIntValue( vars->hdrStddevId1, (int)stddev );
-      }
-    }
-  }
-  else if( vars->hdrType1 == TYPE_INT64 ) {
-    for( int itrc = 0; itrc < nTracesOut; itrc++) {
-      traceGather->trace(itrc)->getTraceHeader()->setInt64Value( vars->hdrId1, (csInt64_t)result );
-    }
-    if( vars->computeStddev ) {
-      for( int itrc = 0; itrc < nTracesOut; itrc++) {
-        traceGather->trace(itrc)->getTraceHeader()->setInt64Value( vars->hdrStddevId1, (csInt64_t)stddev );
-      }
-    }
-  }
-
   if( vars->method == mod_hdr_math_ens::XCOR_COS2 ) {
-    for( int itrc = 0; itrc < nTracesOut; itrc++) {
-      traceGather->trace(itrc)->getTraceHeader()->setDoubleValue( vars->hdrId2, result2 );
-    }
+    traceGather->setHeaderValue( vars->hdrId2, result2, 0, nTracesOut );
   }
   
 }
@@ -3,6 +3,7 @@
 
 #include "cseis_includes.h"
 #include "csTableNew.h"
+#include <cstring>
 
 using namespace cseis_system;
 using namespace cseis_geolib;
@@ -20,6 +21,10 @@ namespace mod_hdr_set {
     csTableNew* table;
     int tableValueIndex; // Index of value column in table containing given header name that shall be set
     int* hdrId_keys;
+    double* keyValueBuffer;
+    double* lastKeyValues;  // Key values of last trace for which the value was retrieved from table
+    double lastValue;       // Table value for lastKeyValues
+    bool isValueSet;        // true if lastValue holds the table value for lastKeyValues
     int hdrId;
     int hdrType;
   };
@@ -46,6 +51,10 @@ void init_mod_hdr_set_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
 //
   vars->table = NULL;
   vars->hdrId_keys     = NULL;
+  vars->keyValueBuffer = NULL;
+  vars->lastKeyValues  = NULL;
+  vars->lastValue      = 0;
+  vars->isValueSet     = false;
   vars->hdrId   = -1;
   vars->hdrType = 0;
   vars->tableValueIndex = -1;
@@ -80,6 +89,8 @@ void init_mod_hdr_set_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
     log->error("No table key(s) specified.");
   }
   vars->hdrId_keys     = new int[numKeys];
+  vars->keyValueBuffer = new double[numKeys];
+  vars->lastKeyValues  = new double[numKeys];
   for( int ikey = 0; ikey < numKeys; ikey++ ) {
     std::string headerName;
     int col;
@@ -175,6 +186,14 @@ bool exec_mod_hdr_set_(
       delete [] vars->hdrId_keys;
       vars->hdrId_keys = NULL;
     }
+    if( vars->keyValueBuffer != NULL ) {
+      delete [] vars->keyValueBuffer;
+      vars->keyValueBuffer = NULL;
+    }
+    if( vars->lastKeyValues != NULL ) {
+      delete [] vars->lastKeyValues;
+      vars->lastKeyValues = NULL;
+    }
     delete vars; vars = NULL;
     return true;
   }
@@ -182,19 +201,23 @@ bool exec_mod_hdr_set_(
   csTraceHeader* trcHdr = trace->getTraceHeader();
 
   //  if( edef->isDebug() ) fprintf(stdout,"MOD_HDR_SET: Value: %f\n", value );
-  double* keyValueBuffer = new double[vars->table->numKeys()];
-  for( int ikey = 0; ikey < vars->table->numKeys(); ikey++ ) {
-    keyValueBuffer[ikey] = trace->getTraceHeader()->doubleValue( vars->hdrId_keys[ikey] );
-  }
-  double value;
-  try {
-    value = vars->table->getValue( keyValueBuffer, vars->tableValueIndex );
+  int numKeys = vars->table->numKeys();
+  for( int ikey = 0; ikey < numKeys; ikey++ ) {
+    vars->keyValueBuffer[ikey] = trace->getTraceHeader()->doubleValue( vars->hdrId_keys[ikey] );
   }
-  catch( csException& e ) {
-    delete [] keyValueBuffer;
-    log->error("Error occurred in HDR_SET: %s", e.getMessage());
-    throw(e);
+  // Consecutive traces usually share the same key values: Retrieve value only if key values have changed
+  if( !vars->isValueSet || memcmp( vars->keyValueBuffer, vars->lastKeyValues, numKeys*sizeof(double) ) != 0 ) {
+    try {
+      vars->lastValue = vars->table->getValue( vars->keyValueBuffer, vars->tableValueIndex );
+    }
+    catch( csException& e ) {
+      log->error("Error occurred in HDR_SET: %s", e.getMessage());
+      throw(e);
+    }
+    memcpy( vars->lastKeyValues, vars->keyValueBuffer, numKeys*sizeof(double) );
+    vars->isValueSet = true;
   }
+  double value = vars->lastValue;
 
   if( vars->hdrType == TYPE_INT ) {
     trcHdr->setIntValue( vars->hdrId, (int)value );
@@ -209,8 +232,6 @@ bool exec_mod_hdr_set_(
     trcHdr->setInt64Value( vars->hdrId, (csInt64_t)value );
   }
 
-  delete [] keyValueBuffer;
-
   return true;
 }
 
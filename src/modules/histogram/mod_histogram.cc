@@ -120,7 +120,7 @@ void exec_mod_histogram_(
   }
   int ntraces = traceGather->numTraces();
   for( int itrc = 0; itrc < ntraces; itrc++ ) {
-    float* samples = traceGather->trace(itrc)->getTraceSamples();
+    float const* samples = traceGather->trace(itrc)->getTraceSamplesReadOnly();
     for( int isamp = 0; isamp < vars->numSamplesIn; isamp++ ) {
       int index = (int)(( samples[isamp] - vars->ampMin ) / vars->sampleIntOut + 0.5 );
       if( index < 0 ) index = 0;
@@ -615,7 +615,7 @@ bool exec_mod_image_(
 
 
   if( vars->isTmpFile ) {
-    float* samples = trace->getTraceSamples();
+    float const* samples = trace->getTraceSamplesReadOnly();
     char const* hdrValueBlock = trace->getTraceHeader()->getTraceHeaderValueBlock();
 
     try {
@@ -7,6 +7,7 @@
 #include "csFlexHeader.h"
 #include "csIOSelection.h"
 #include "csSortManager.h"
+#include "csSharedBuffer.h"
 
 using namespace cseis_system;
 using namespace cseis_geolib;
@@ -52,6 +53,8 @@ namespace mod_input {
     bool isHdrSelection;
     int sortOrder;
     int sortMethod;
+
+    bool isMemoryMapped;
   };
   static int const MERGE_ALL    = 1;
   static int const MERGE_TRACE  = 2;
@@ -61,6 +64,8 @@ namespace mod_input {
   static int const MERGE_DECREASING = 22;
 
   static int const NOT_AVAILABLE = -1;
+
+  bool readTrace( VariableStruct* vars, csTrace* trace, int numSamples );
 }
 using mod_input::VariableStruct;
 
@@ -110,6 +115,7 @@ void init_mod_input_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* l
   vars->isHdrSelection = false;
   vars->sortOrder = cseis_geolib::csIOSelection::SORT_NONE;
   vars->sortMethod = cseis_geolib::csSortManager::SIMPLE_SORT;
+  vars->isMemoryMapped = false;
 
 //------------------------------------------------------------
   vars->numFiles = param->getNumLines( "filename" );
@@ -152,6 +158,20 @@ void init_mod_input_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* l
     }
   }
 
+  if( param->exists( "mmap" ) ) {
+    string text;
+    param->getString( "mmap", &text );
+    if( !text.compare("yes") ) {
+      vars->isMemoryMapped = true;
+    }
+    else if( !text.compare("no") ) {
+      vars->isMemoryMapped = false;
+    }
+    else {
+      log->error("Unknown option: %s", text.c_str());
+    }
+  }
+
   //----------------------------------------------------
   string mergeHeaderName = ""; 
   bool enableRandomAccess = false;
@@ -179,9 +199,9 @@ void init_mod_input_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* l
 
   /*
    * Trace selection based on header value
-   * Note that with the current version of the input data format there is no performance increase, rather a decrease compared
-   * to reading in all traces and selecting later on using the module $SELECT.
-   * Best to use this functionality only for sorting of input data.
+   * Note that without a header index file, all trace headers are scanned in the input file. There is then no performance increase,
+   * rather a decrease compared to reading in all traces and selecting later on using the module $SELECT.
+   * Header index files are written by module OUTPUT, user parameter 'index'.
    */
   std::string selectionText = "";
   std::string selectionHdrName = "";
@@ -226,7 +246,7 @@ void init_mod_input_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* l
       }
     }
     if( vars->sortOrder == cseis_geolib::csIOSelection::SORT_NONE ) {
-      log->warning("With the current Seaseis disk data format, selecting traces on input using user parameters 'header' & 'select' is typically slower than reading in all traces and performing the selection afterwards, e.g. by using module 'SELECT'. It is recommended to use input selection only when traces shall be sorted on input");
+      log->warning("Unless the input file has a header index for the selection header (see module OUTPUT, user parameter 'index'), selecting traces on input using user parameters 'header' & 'select' is typically slower than reading in all traces and performing the selection afterwards, e.g. by using module 'SELECT'. It is recommended to use input selection only when traces shall be sorted on input, or when a header index exists");
     }
   }
 
@@ -351,6 +371,18 @@ void init_mod_input_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* l
     //    if( numSamples > maxNumSamples ) maxNumSamples = numSamples;
     //  }
     vars->hdrValueBlock = new char[maxHdrValueBlockSize];
+
+    // (5) Memory-map input files
+    if( vars->isMemoryMapped ) {
+      for( int ifile = 0; ifile < vars->numFiles; ifile++ ) {
+        if( !vars->readers[ifile]->mapFile() ) {
+          log->warning("SeaSeis file '%s' cannot be memory-mapped (compressed data samples?). File is read without memory-mapping.", vars->filenames[ifile].c_str());
+        }
+        else if( !vars->readers[ifile]->isSharedReadSupported() ) {
+          log->warning("SeaSeis file '%s': Data samples are not aligned in memory-mapped file, and have to be copied into each trace.", vars->filenames[ifile].c_str());
+        }
+      }
+    }
   }
   catch( csException& exc ) {
     log->error("Error occurred when opening SeaSeis file. System message:\n%s", exc.getMessage() );
@@ -516,7 +548,6 @@ bool exec_mod_input_(
   if( vars->atEOF ) return false;
 
   csTraceHeader* trcHdr = trace->getTraceHeader();
-  float* samples = trace->getTraceSamples();
 
   if( vars->nTracesToRead > 0 && vars->nTracesToRead == vars->traceCounter ) {
     vars->atEOF = true;
@@ -530,14 +561,14 @@ bool exec_mod_input_(
 
   try {
     bool success = true;
-    if( success ) success = vars->readers[vars->currentFile]->readTrace( samples, vars->hdrValueBlock, shdr->numSamples );
+    if( success ) success = mod_input::readTrace( vars, trace, shdr->numSamples );
     if( !success ) {
       if( vars->mergeOption == mod_input::MERGE_ALL ) {
         delete vars->readers[vars->currentFile];
         vars->readers[vars->currentFile] = NULL;
         vars->currentFile += 1;
         while( !success && vars->currentFile < vars->numFiles ) {
-          success = vars->readers[vars->currentFile]->readTrace( samples, vars->hdrValueBlock, shdr->numSamples );
+          success = mod_input::readTrace( vars, trace, shdr->numSamples );
 //          if( edef->isDebug() ) fprintf(stdout,"Read in next file(%d, success = %s): %s\n", vars->currentFile, success ? "true" : "false", vars->filenames[vars->currentFile].c_str());
           if( !success ) {
             delete vars->readers[vars->currentFile];
@@ -584,7 +615,7 @@ bool exec_mod_input_(
         }
         vars->currentMergeHdrValue = minValue;
         vars->currentFile = vars->fileIndexList->at(vars->currentFilePointerIndex);
-        success = vars->readers[vars->currentFile]->readTrace( samples, vars->hdrValueBlock, shdr->numSamples );
+        success = mod_input::readTrace( vars, trace, shdr->numSamples );
         if( !success ) log->error("Unexpected end of file encountered for file '%s'... File corrupted..?", vars->filenames[vars->currentFile].c_str());
         if( edef->isDebug() ) {
           log->line("Header value of first trace, file #%-2d:  %s\n", vars->currentFile+1, vars->mergeHdrValues[vars->currentFile].toString().c_str() );
@@ -669,6 +700,21 @@ bool exec_mod_input_(
   vars->traceCounter += 1;
   return true;
 }
+//--------------------------------------------------------------------------------
+// Read next trace from current input file.
+// Samples of memory-mapped input files are not copied but referenced by the trace, unless the number of samples differs
+//
+bool mod_input::readTrace( VariableStruct* vars, csTrace* trace, int numSamples ) {
+  csSeismicReader* reader = vars->readers[vars->currentFile];
+  if( vars->isMemoryMapped && reader->isSharedReadSupported() && reader->numSamples() == numSamples ) {
+    float const* samples  = NULL;
+    csSharedBuffer* owner = NULL;
+    if( !reader->readTraceShared( vars->hdrValueBlock, samples, owner ) ) return false;
+    trace->getTraceDataObject()->setSharedData( samples, numSamples, owner );
+    return true;
+  }
+  return reader->readTrace( trace->getTraceSamples(), vars->hdrValueBlock, numSamples );
+}
 //********************************************************************************
 // Parameter definition
 //
@@ -697,7 +743,7 @@ void params_mod_input_( csParamDef* pdef ) {
                   "If number of samples in input data set is smaller, traces will be filled with zeros.");
   pdef->addValue( "", VALTYPE_NUMBER, "Number of samples to read in" );
 
-  pdef->addParam( "header", "Name of trace header used for trace selection", NUM_VALUES_FIXED, "Use in combination with user parameter 'select'. NOTE: With the current Seaseis disk data format, selecting traces on input is typically slower than reading in all traces and making the trace selection later on, e.g. by using module 'SELECT'" );
+  pdef->addParam( "header", "Name of trace header used for trace selection", NUM_VALUES_FIXED, "Use in combination with user parameter 'select'. If the input file has a header index for this trace header (see module OUTPUT, user parameter 'index'), traces are selected from the index without scanning the input file. Otherwise, all trace headers are scanned first, which is typically slower than reading in all traces and making the trace selection later on, e.g. by using module 'SELECT'" );
   pdef->addValue( "", VALTYPE_STRING, "Trace header name" );
   pdef->addParam( "select", "Selection of header values", NUM_VALUES_FIXED, "Only traces which fit the trace value selection will be read in. Use in combination with user parameter 'header'" );
   pdef->addValue( "", VALTYPE_STRING, "Selection string. See documentation for more detailed description of selection syntax" );
@@ -711,6 +757,12 @@ void params_mod_input_( csParamDef* pdef ) {
   pdef->addOption( "simple", "Simplest sort method. Fastest for small and partially pre-sorted data sets" );
   pdef->addOption( "tree", "Tree sorting method. Most efficient for large, totally un-sorted data sets" );
 
+  pdef->addParam( "mmap", "Memory-map input file(s)?", NUM_VALUES_FIXED,
+                  "Memory-mapped files are read without copying data through a read buffer. Trace samples are shared with the mapped file until a module modifies them. Flows that only modify trace headers, or only read trace samples, then never copy trace samples. Not supported for compressed data samples" );
+  pdef->addValue( "no", VALTYPE_OPTION );
+  pdef->addOption( "no", "Read input file(s) through read buffer" );
+  pdef->addOption( "yes", "Memory-map input file(s)" );
+
   pdef->addParam( "ntraces_buffer", "Number of traces to buffer", NUM_VALUES_FIXED,
                   "Reading a large number of traces at once may enhance performance, but requires more memory" );
   pdef->addValue( "0", VALTYPE_NUMBER, "Number of traces to buffer when reading" );
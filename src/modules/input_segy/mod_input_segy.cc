@@ -425,6 +425,13 @@ void init_mod_input_segy_( csParamManager* param, csInitPhaseEnv* env, csLogWrit
       numTracesBuffer = 0;
     }
   }
+  int readAheadDepth = 0;
+  if( param->exists( "read_ahead" ) ) {
+    param->getInt( "read_ahead", &readAheadDepth );
+    if( readAheadDepth < 0 || readAheadDepth > 100 ) {
+      log->error("Number of read-ahead buffers out of range (=%d). Valid range: 0-100", readAheadDepth);
+    }
+  }
  bool autoscale_hdrs = true;
   if( param->exists("auto_scale") ) {
     string text;
@@ -600,6 +607,7 @@ void init_mod_input_segy_( csParamManager* param, csInitPhaseEnv* env, csLogWrit
   vars->config.overrideSampleFormat  = data_format;
   vars->config.isSUFormat            = isSUFormat;
   vars->config.enableRandomAccess    = vars->isHdrSelection;
+  vars->config.readAheadDepth        = readAheadDepth;
   try {
     vars->segyReader = new csSegyReader( vars->filenames[vars->currentFile], vars->config, vars->hdrMap );
   }
@@ -1003,6 +1011,10 @@ void params_mod_input_segy_( csParamDef* pdef ) {
                   "Reading in a large number of traces at once may enhance performance, but requires more memory" );
   pdef->addValue( "20", VALTYPE_NUMBER, "Number of traces to buffer" );
  
+  pdef->addParam( "read_ahead", "Number of buffers to read ahead in background", NUM_VALUES_FIXED,
+                  "Traces are read in and converted (byte swapping, IBM to IEEE conversion) by a background thread while the current buffer is being processed. Each buffer holds 'ntraces_buffer' traces. Hides I/O latency, e.g. on network file systems. Not used for trace selection on input (parameter 'header'), or for 16bit integer data" );
+  pdef->addValue( "0", VALTYPE_NUMBER, "Number of read-ahead buffers. 0: Read in traces without read-ahead" );
+ 
   pdef->addParam( "print", "Print EBCDIC & binary header to log file", NUM_VALUES_FIXED );
   pdef->addValue( "no", VALTYPE_OPTION );
   pdef->addOption( "yes", "Print EBCDIC & binary header" );
@@ -4,6 +4,7 @@
 #include "cseis_includes.h"
 #include "csTableNew.h"
 #include <cmath>
+#include <cstring>
 
 using namespace cseis_system;
 using namespace cseis_geolib;
@@ -29,6 +30,9 @@ namespace mod_mute {
     string tableName;   // Name of user table.
     csTableNew* table;  // User's Table containing keys & mute value(s).
     int* hdrId_keys;    // Key's header IDs 
+    double* keyValueBuffer; // Key values of current trace
+    double* lastKeyValues;  // Key values of last trace for which mute values were retrieved from table
+    bool isMuteTimeSet;     // true if mute_time & mute_time2 hold the mute values for lastKeyValues
 
     int tableValueIndex1;   // Column in table with first mute value
     int tableValueIndex2;   // Column in table with (optional) second mute value
@@ -55,6 +59,8 @@ namespace mod_mute {
 
     int windowStartSample;
     int windowEndSample;
+
+    bool isClone;       // true for copy created by clone method. Shares table & key header IDs with original
   };
   static const string MY_NAME = "mute";
 
@@ -148,6 +154,9 @@ void init_mod_mute_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
   vars->inLength         = shdr->numSamples;
   vars->table            = NULL;
   vars->hdrId_keys       = NULL;
+  vars->keyValueBuffer   = NULL;
+  vars->lastKeyValues    = NULL;
+  vars->isMuteTimeSet    = false;
   vars->tableValueIndex1 = -1;
   vars->tableValueIndex2 = -1;
   vars->mute_start_samp  = 0;
@@ -164,6 +173,7 @@ void init_mod_mute_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
   vars->taperApply_str   = "MINIMUM";
   vars->windowStartSample = 0; // By default, apply mute to full trace length
   vars->windowEndSample   = shdr->numSamples-1; // By default, apply mute to full trace length
+  vars->isClone           = false;
 
   std::string text;
 
@@ -285,6 +295,8 @@ void init_mod_mute_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
       param->getString("table", &text );
       try {
         vars->table->initialize( text, sortTable );
+        vars->keyValueBuffer = new double[vars->table->numKeys()];
+        vars->lastKeyValues  = new double[vars->table->numKeys()];
       }
       catch( csException& exc ) {
         log->line("ERROR:Initializing input table '%s': %s\n", text.c_str(), exc.getMessage() );
@@ -478,6 +490,8 @@ void init_mod_mute_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
     }
   }
 
+  // Surgical mute: End of mute zone depends on mute of previous trace
+  edef->setThreadSafe( vars->nValued == 1 );
 }
 
 //*************************************************************************************************
@@ -493,6 +507,11 @@ bool exec_mod_mute_(
   csSuperHeader const* shdr = env->superHeader;
 
   if( edef->isCleanup()){
+    if( vars->isClone ) {
+      // Shared with original module variables, deleted there
+      vars->table = NULL;
+      vars->hdrId_keys = NULL;
+    }
     if( vars->table != NULL ) {
       delete vars->table;
       vars->table = NULL;
@@ -501,6 +520,14 @@ bool exec_mod_mute_(
       delete [] vars->hdrId_keys;
       vars->hdrId_keys = NULL;
     }
+    if( vars->keyValueBuffer != NULL ) {
+      delete [] vars->keyValueBuffer;
+      vars->keyValueBuffer = NULL;
+    }
+    if( vars->lastKeyValues != NULL ) {
+      delete [] vars->lastKeyValues;
+      vars->lastKeyValues = NULL;
+    }
     delete vars; vars = NULL;
     return true;
   }
@@ -509,32 +536,34 @@ bool exec_mod_mute_(
 
   // Fetch mutes from table is specified
   if( vars->table != NULL ) {
-    double* keyValueBuffer = new double[vars->table->numKeys()];
-    for( int ikey = 0; ikey < vars->table->numKeys(); ikey++ ) {
-      keyValueBuffer[ikey] = trace->getTraceHeader()->doubleValue( vars->hdrId_keys[ikey] );
-    }
-    double value, value2=-1;
-    try {
-      value = vars->table->getValue( keyValueBuffer, vars->tableValueIndex1 );
-    }
-    catch( csException& e ) {
-      delete [] keyValueBuffer;
-      log->error("MUTE:ERROR:Retrieving mute value from table %s", e.getMessage());
-      throw(e);
+    int numKeys = vars->table->numKeys();
+    for( int ikey = 0; ikey < numKeys; ikey++ ) {
+      vars->keyValueBuffer[ikey] = trace->getTraceHeader()->doubleValue( vars->hdrId_keys[ikey] );
     }
-    if ( vars->nValued == 2 ){
+    // Consecutive traces usually share the same key values: Retrieve mute values only if key values have changed
+    if( !vars->isMuteTimeSet || memcmp( vars->keyValueBuffer, vars->lastKeyValues, numKeys*sizeof(double) ) != 0 ) {
+      double value, value2=-1;
       try {
-        value2 = vars->table->getValue( keyValueBuffer, vars->tableValueIndex2 );
+        value = vars->table->getValue( vars->keyValueBuffer, vars->tableValueIndex1 );
       }
       catch( csException& e ) {
-        delete [] keyValueBuffer;
-        log->error("MUTE:ERROR:Retrieving second mute value from table %s", e.getMessage());
+        log->error("MUTE:ERROR:Retrieving mute value from table %s", e.getMessage());
         throw(e);
       }
+      if ( vars->nValued == 2 ){
+        try {
+          value2 = vars->table->getValue( vars->keyValueBuffer, vars->tableValueIndex2 );
+        }
+        catch( csException& e ) {
+          log->error("MUTE:ERROR:Retrieving second mute value from table %s", e.getMessage());
+          throw(e);
+        }
+      }
+      vars->mute_time  = (float)value;
+      vars->mute_time2 = (float)value2;
+      memcpy( vars->lastKeyValues, vars->keyValueBuffer, numKeys*sizeof(double) );
+      vars->isMuteTimeSet = true;
     }
-    delete [] keyValueBuffer;  
-    vars->mute_time  = (float)value;
-    vars->mute_time2 = (float)value2;
   }
 
   // If requested, apply indicate option & return
@@ -759,6 +788,24 @@ bool exec_mod_mute_(
   return true;
 }
 
+//*************************************************************************************************
+// Clone method
+//*************************************************************************************************
+void clone_mod_mute_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( env->execPhaseDef->variables() );
+  VariableStruct* varsClone = new VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  *varsClone = *vars;
+  varsClone->isClone = true;
+  if( vars->keyValueBuffer != NULL ) {
+    varsClone->keyValueBuffer = new double[vars->table->numKeys()];
+    varsClone->lastKeyValues  = new double[vars->table->numKeys()];
+  }
+  varsClone->isMuteTimeSet = false;
+}
+
 //*************************************************************************************************
 // Parameter definition
 //*************************************************************************************************
@@ -839,6 +886,9 @@ extern "C" void _params_mod_mute_( csParamDef* pdef ) {
 extern "C" void _init_mod_mute_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_mute_( param, env, log );
 }
+extern "C" void _clone_mod_mute_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_mute_( env, envClone );
+}
 extern "C" bool _exec_mod_mute_( csTrace* trace, int* port, csExecPhaseEnv* env, csLogWriter* log ) {
   return exec_mod_mute_( trace, port, env, log );
 }
@@ -10,6 +10,7 @@
 #include "csTableNew.h"
 #include "csTableValueList.h"
 #include <cmath>
+#include <cstring>
 
 using namespace cseis_system;
 using namespace cseis_geolib;
@@ -37,9 +38,14 @@ namespace mod_nmo {
     bool isDiffNMO;
     bool dump;
     csTableNew* table;
+    csTimeFunction<double>* timeFunction;
     csTableManagerNew* oldTableManager;
     int* hdrId_keys;
+    double* keyValueBuffer;
+    double* lastKeyValues;     // Key values of last trace for which the time function was retrieved from table
+    bool isTimeFunctionSet;    // true if timeFunction holds the function for lastKeyValues
     float timeSample1_ms;
+    bool isClone;  // true for copy created by clone method. Shares read-only fields with original
   };
 }
 using mod_nmo::VariableStruct;
@@ -72,11 +78,16 @@ void init_mod_nmo_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log
   vars->isDiffNMO = false;
   vars->offset_diffNMO = 0;
   vars->table          = NULL;
+  vars->timeFunction   = NULL;
   vars->oldTableManager   = NULL;
   vars->hdrId_keys     = NULL;
+  vars->keyValueBuffer = NULL;
+  vars->lastKeyValues  = NULL;
+  vars->isTimeFunctionSet = false;
   vars->dump           = false; 
   vars->percentVel = 0.0;
   vars->timeSample1_ms = 0.0;
+  vars->isClone = false;
 
   csVector<std::string> valueList;
   
@@ -337,6 +348,16 @@ void init_mod_nmo_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log
   }
 
   vars->hdrId_offset = hdef->headerIndex( "offset" );
+
+  if( vars->table != NULL ) {
+    vars->timeFunction = new csTimeFunction<double>();
+    if( vars->table->numKeys() > 0 ) {
+      vars->keyValueBuffer = new double[vars->table->numKeys()];
+      vars->lastKeyValues  = new double[vars->table->numKeys()];
+    }
+  }
+  // Old table manager retrieves functions through internal buffers
+  edef->setThreadSafe( vars->oldTableManager == NULL );
 }
 
 //*************************************************************************************************
@@ -351,6 +372,25 @@ bool exec_mod_nmo_( csTrace* trace, int* port, csExecPhaseEnv* env, csLogWriter*
   csExecPhaseDef* edef = env->execPhaseDef;
 
   if( edef->isCleanup() ) {
+    if( vars->isClone ) {
+      // Shared with original module variables, deleted there
+      vars->time_sec = NULL;
+      vars->table = NULL;
+      vars->oldTableManager = NULL;
+      vars->hdrId_keys = NULL;
+    }
+    if( vars->timeFunction != NULL ) {
+      delete vars->timeFunction;
+      vars->timeFunction = NULL;
+    }
+    if( vars->keyValueBuffer != NULL ) {
+      delete [] vars->keyValueBuffer;
+      vars->keyValueBuffer = NULL;
+    }
+    if( vars->lastKeyValues != NULL ) {
+      delete [] vars->lastKeyValues;
+      vars->lastKeyValues = NULL;
+    }
     if( vars->time_sec != NULL ) {
       delete [] vars->time_sec;
       vars->time_sec = NULL;
@@ -391,17 +431,22 @@ bool exec_mod_nmo_( csTrace* trace, int* port, csExecPhaseEnv* env, csLogWriter*
   }
 
   if( vars->table != NULL ) {
-    csTimeFunction<double> const* timeFunc;
-    if( vars->table->numKeys() > 0 ) {
-      double* keyValueBuffer = new double[vars->table->numKeys()];
-      for( int ikey = 0; ikey < vars->table->numKeys(); ikey++ ) {
-	keyValueBuffer[ikey] = trace->getTraceHeader()->doubleValue( vars->hdrId_keys[ikey] );
+    csTimeFunction<double> const* timeFunc = vars->timeFunction;
+    int numKeys = vars->table->numKeys();
+    if( numKeys > 0 ) {
+      for( int ikey = 0; ikey < numKeys; ikey++ ) {
+	vars->keyValueBuffer[ikey] = trace->getTraceHeader()->doubleValue( vars->hdrId_keys[ikey] );
+      }
+      // Consecutive traces usually share the same key values: Retrieve time function only if key values have changed
+      if( !vars->isTimeFunctionSet || vars->dump || memcmp( vars->keyValueBuffer, vars->lastKeyValues, numKeys*sizeof(double) ) != 0 ) {
+        timeFunc = vars->table->getFunction( vars->keyValueBuffer, vars->timeFunction, vars->dump );
+        memcpy( vars->lastKeyValues, vars->keyValueBuffer, numKeys*sizeof(double) );
+        vars->isTimeFunctionSet = true;
       }
-      timeFunc = vars->table->getFunction( keyValueBuffer, vars->dump );
-      delete [] keyValueBuffer;
     }
-    else {
-      timeFunc = vars->table->getFunction( NULL, vars->dump );
+    else if( !vars->isTimeFunctionSet || vars->dump ) {
+      timeFunc = vars->table->getFunction( NULL, vars->timeFunction, vars->dump );
+      vars->isTimeFunctionSet = true;
     }
     if( !vars->isDiffNMO ) {
       vars->nmo->perform_nmo( timeFunc, offset, samples );
@@ -429,6 +474,33 @@ bool exec_mod_nmo_( csTrace* trace, int* port, csExecPhaseEnv* env, csLogWriter*
   return true;
 }
 
+//*************************************************************************************************
+// Clone method
+// Create module variables for another thread: Copy parameters, allocate separate work buffers
+//
+//*************************************************************************************************
+void clone_mod_nmo_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( env->execPhaseDef->variables() );
+  VariableStruct* varsClone = new VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  *varsClone = *vars;
+  varsClone->isClone = true;
+  varsClone->nmo = new csNMOCorrection( *vars->nmo );
+  if( vars->timeFunction != NULL ) varsClone->timeFunction = new csTimeFunction<double>();
+  if( vars->keyValueBuffer != NULL ) {
+    varsClone->keyValueBuffer = new double[vars->table->numKeys()];
+    varsClone->lastKeyValues  = new double[vars->table->numKeys()];
+  }
+  varsClone->isTimeFunctionSet = false;
+  if( vars->velocities != NULL ) {
+    // Velocity may be updated from trace header
+    varsClone->velocities = new float[vars->numTimes];
+    memcpy( varsClone->velocities, vars->velocities, vars->numTimes*sizeof(float) );
+  }
+}
+
 //*************************************************************************************************
 // Parameter definition
 //
@@ -521,6 +593,9 @@ extern "C" void _params_mod_nmo_( csParamDef* pdef ) {
 extern "C" void _init_mod_nmo_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_nmo_( param, env, log );
 }
+extern "C" void _clone_mod_nmo_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_nmo_( env, envClone );
+}
 extern "C" bool _exec_mod_nmo_( csTrace* trace, int* port, csExecPhaseEnv* env, csLogWriter* log ) {
   return exec_mod_nmo_( trace, port, env, log );
 }
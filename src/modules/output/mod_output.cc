@@ -6,6 +6,7 @@
 #include "csSeismicWriter.h"
 #include "csTimer.h"
 #include "csFileUtils.h"
+#include "csVector.h"
 
 using namespace cseis_system;
 using namespace cseis_geolib;
@@ -26,6 +27,14 @@ namespace mod_output {
     bool isFirstCall;
     int numTracesBuffer;
     int sampleByteSize; //, doOverwrite
+    /// true if data samples shall be compressed in blocks, losslessly or with bounded error
+    bool isBlockCompressed;
+    /// Maximum error of lossy compression. 0: Lossless
+    float maxError;
+    /// true if maxError is relative to maximum absolute amplitude of each trace
+    bool isRelativeError;
+    /// Names of trace headers to index
+    cseis_geolib::csVector<std::string>* indexHeaderNames;
   };
 }
 using namespace mod_output;
@@ -38,7 +47,7 @@ using namespace mod_output;
 //*************************************************************************************************
 void init_mod_output_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log )
 {
-  //  csTraceHeaderDef* hdef = env->headerDef;
+  csTraceHeaderDef* hdef = env->headerDef;
   csExecPhaseDef*   edef = env->execPhaseDef;
   csSuperHeader*    shdr = env->superHeader;
   VariableStruct* vars = new VariableStruct();
@@ -51,7 +60,11 @@ void init_mod_output_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
   vars->nTracesOut = 0;
   vars->numTracesBuffer = 20;
   vars->sampleByteSize = 4;
+  vars->isBlockCompressed = false;
+  vars->maxError = 0;
+  vars->isRelativeError = true;
   vars->isFirstCall = true;
+  vars->indexHeaderNames = NULL;
 
   bool doOverwrite = true;
   if( param->exists("overwrite") ) {
@@ -81,6 +94,34 @@ void init_mod_output_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
     else if( !text.compare("8bit") ) { 
       vars->sampleByteSize = 1;
     }
+    else if( !text.compare("lossless") ) {
+      vars->sampleByteSize = 4;
+      vars->isBlockCompressed = true;
+    }
+    else if( !text.compare("lossy") ) {
+      vars->sampleByteSize = 4;
+      vars->isBlockCompressed = true;
+      vars->maxError = 0.01f;
+      if( param->exists("max_error") ) {
+        param->getFloat("max_error", &vars->maxError);
+        if( param->getNumValues("max_error") > 1 ) {
+          param->getString("max_error", &text, 1);
+          if( !text.compare("relative") ) {
+            vars->isRelativeError = true;
+          }
+          else if( !text.compare("absolute") ) {
+            vars->isRelativeError = false;
+          }
+          else {
+            log->line("Unknown option for user parameter max_error: '%s'", text.c_str());
+            env->addError();
+          }
+        }
+      }
+      if( vars->maxError <= 0 ) {
+        log->error("Maximum error of lossy compression must be larger than 0. Specified: %f", vars->maxError);
+      }
+    }
     else {
       log->line("Unknown option for user parameter compress: '%s'", text.c_str());
       env->addError();
@@ -105,6 +146,21 @@ void init_mod_output_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
     }
   }
 
+  if( param->exists( "index" ) ) {
+    vars->indexHeaderNames = new csVector<std::string>();
+    param->getAll( "index", vars->indexHeaderNames );
+    for( int ihdr = 0; ihdr < vars->indexHeaderNames->size(); ihdr++ ) {
+      std::string const& name = vars->indexHeaderNames->at(ihdr);
+      if( !hdef->headerExists( name ) ) {
+        log->error("Trace header to index does not exist: '%s'", name.c_str());
+      }
+      type_t type = hdef->headerType( name );
+      if( type != TYPE_INT && type != TYPE_FLOAT && type != TYPE_DOUBLE && type != TYPE_INT64 ) {
+        log->error("Trace header '%s' cannot be indexed. Only number headers are supported", name.c_str());
+      }
+    }
+  }
+
   if( !doOverwrite && csFileUtils::fileExists( vars->filename ) ) {
     log->error("File %s already exists but user parameter set to 'overwrite no'.", vars->filename.c_str() );
   }
@@ -138,10 +194,21 @@ bool exec_mod_output_(
   csTraceHeaderDef const* hdef = env->headerDef;
 
   if( edef->isCleanup() ) {
+    if( vars->writer != NULL && vars->isBlockCompressed ) {
+      vars->writer->close();
+      log->line("Compression ratio of data samples: %.2f", vars->writer->compressionRatio());
+      if( vars->maxError > 0 ) {
+        log->line("Signal-to-noise ratio of compressed data samples: %.1f dB", vars->writer->compressionSNR());
+      }
+    }
     if( vars->writer != NULL ) {
       delete vars->writer;
       vars->writer = NULL;
     }
+    if( vars->indexHeaderNames != NULL ) {
+      delete vars->indexHeaderNames;
+      vars->indexHeaderNames = NULL;
+    }
     delete vars; vars = NULL;
     return true;
   }
@@ -150,6 +217,12 @@ bool exec_mod_output_(
     vars->isFirstCall = false;
     try {
       vars->writer = new csSeismicWriter( vars->filename, vars->numTracesBuffer, vars->sampleByteSize, true );
+      if( vars->isBlockCompressed ) vars->writer->setBlockCompression( vars->maxError, vars->isRelativeError );
+      if( vars->indexHeaderNames != NULL ) {
+        for( int ihdr = 0; ihdr < vars->indexHeaderNames->size(); ihdr++ ) {
+          vars->writer->addIndexHeader( vars->indexHeaderNames->at(ihdr) );
+        }
+      }
     }
     catch( csException& exc ) {
       log->error("Error occurred when opening SeaSeis file. System message:\n%s", exc.getMessage() );
@@ -159,7 +232,7 @@ bool exec_mod_output_(
 
   if( edef->isDebug() ) log->line("Output SeaSeis trace #%d", vars->nTracesOut+1);
 
-  float* samples = trace->getTraceSamples();
+  float const* samples = trace->getTraceSamplesReadOnly();
   char const* hdrValueBlock   = trace->getTraceHeader()->getTraceHeaderValueBlock();
 
   try {
@@ -207,6 +280,25 @@ void params_mod_output_( csParamDef* pdef ) {
   pdef->addOption( "32bit", "No compression. Same as option 'no'");
   pdef->addOption( "16bit", "Compress data samples to 16bit");
   pdef->addOption( "8bit", "Compress data samples to 8bit");
+  pdef->addOption( "lossless", "Lossless compression of data samples",
+                   "Samples are restored bit for bit. Achieved compression depends on the data: Small for full precision floating point data, "\
+                   "larger for data with limited precision (e.g. converted from integer formats) or long muted zones. "\
+                   "Traces are compressed in parallel, in blocks of 'ntraces_buffer' traces. Writes SeaSeis file version 0.5" );
+  pdef->addOption( "lossy", "Lossy compression of data samples, with bounded error",
+                   "Samples are quantized within the maximum error given in user parameter 'max_error', and wavelet transformed. "\
+                   "Compression ratio and signal-to-noise ratio are written to the log file. Writes SeaSeis file version 0.5" );
+
+  pdef->addParam( "max_error", "Maximum error of lossy compression (parameter 'compress', option 'lossy')", NUM_VALUES_VARIABLE,
+                  "No decoded sample differs from the input sample by more than this value" );
+  pdef->addValue( "0.01", VALTYPE_NUMBER, "Maximum error" );
+  pdef->addValue( "relative", VALTYPE_OPTION );
+  pdef->addOption( "relative", "Maximum error relative to the maximum absolute amplitude of each trace" );
+  pdef->addOption( "absolute", "Maximum absolute error" );
+
+  pdef->addParam( "index", "Trace headers to index", NUM_VALUES_VARIABLE,
+                  "Writes header index file next to output file, with file extension '.idx'. "\
+                  "INPUT uses the index to select and sort traces by these headers without scanning the whole file" );
+  pdef->addValue( "", VALTYPE_STRING, "List of trace header names" );
 }
 
 extern "C" void _params_mod_output_( csParamDef* pdef ) {
@@ -296,14 +296,14 @@ bool exec_mod_output_rsf_(
     }
   }
 
-  float* samples = trace->getTraceSamples();
+  float const* samples = trace->getTraceSamplesReadOnly();
   csTraceHeader* trcHdr = trace->getTraceHeader();
 
   double val_dim2 = trcHdr->doubleValue( vars->hdrId_dim2 );
   double val_dim3 = trcHdr->doubleValue( vars->hdrId_dim3 );
 
   try {
-    vars->rsfWriter->writeNextTrace( (byte_t*)samples, vars->numSamplesOut, val_dim2, val_dim3 );
+    vars->rsfWriter->writeNextTrace( (byte_t const*)samples, vars->numSamplesOut, val_dim2, val_dim3 );
   }
   catch( csException& exc ) {
     log->error( "System message: %s" ,exc.getMessage() );
@@ -725,9 +725,9 @@ bool exec_mod_output_segy_(
     }
   }
 
-  float* samples = trace->getTraceSamples();
+  float const* samples = trace->getTraceSamplesReadOnly();
   try {
-    vars->segyWriter->writeNextTrace( (byte_t*)samples, vars->numSamplesOut );
+    vars->segyWriter->writeNextTrace( (byte_t const*)samples, vars->numSamplesOut );
   }
   catch( csException& exc ) {
     log->error( "System message: %s" ,exc.getMessage() );
@@ -164,8 +164,8 @@ void exec_mod_repeat_(
   csTraceData* trcDataCopy  = traceGather->trace(traceIndexNew)->getTraceDataObject();
   csTraceHeader* trcHdrCopy = traceGather->trace(traceIndexNew)->getTraceHeader();
 
-  // Copy seismic & header data
-  trcDataCopy->setData( trcDataOrig );
+  // Copy header data. Seismic data is shared until either trace is modified
+  trcDataCopy->shareData( trcDataOrig );
   trcHdrCopy->copyFrom( trcHdrOrig );
   // Set value for trace header 'repeat'
   trcHdrCopy->setIntValue( vars->hdrId_repeat, repeat );
@@ -25,6 +25,7 @@ namespace mod_resample {
     float sampleIntOld;  // [ms]
     float* buffer;
     float cutOffHz;
+    float filterOrder;
     bool debias;
     int filter;
     int hdrID_scalar;
@@ -68,6 +69,9 @@ void init_mod_resample_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
   vars->interpol = NULL;
   vars->normOption = mod_resample::NORM_YES;
   vars->normScalar = 1.0f;
+  vars->fftTool = NULL;
+  vars->cutOffHz = 0.0f;
+  vars->filterOrder = 0.0f;
 
 //---------------------------------------------
   vars->numSamplesOld = shdr->numSamples;
@@ -198,6 +202,8 @@ void init_mod_resample_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
     numSamplesNew     = (int)ceil((double)vars->numSamplesOld / ratio);  // Workaround BUGFIX 100504: Avoids clash for num samples = 2^N+1
     vars->fftTool     = new csFFTTools( vars->numSamplesOld, numSamplesNew, vars->sampleIntOld, sampleIntNew );
     vars->fftTool->setFilter( order, cutOffFreq, false );
+    vars->cutOffHz    = cutOffFreq;
+    vars->filterOrder = order;
 
     log->line("Sample int old/new: %f/%f ms\nNyquist: %f Hz\nCut-off frequency: %f Hz\nRatio: %f\nOrder: %f, #samples old/new/fft/fftout: %d/%d/%d/%d\n",
               vars->sampleIntOld, sampleIntNew, freqNy, cutOffFreq, ratio, order, vars->numSamplesOld, numSamplesNew, vars->fftTool->numFFTSamples(), vars->fftTool->numFFTSamplesOut() );
@@ -232,7 +238,7 @@ void init_mod_resample_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
     if( ratio > 2.1f ) ratio /= 2.0f;   // ..no idea why this is necessary. Tested with 1ms and 2ms input data, resampled to 4ms, 8ms...
     vars->normScalar = 1.0/ratio;
   }
-
+  edef->setThreadSafe( true );
 }
 
 //*************************************************************************************************
@@ -328,6 +334,27 @@ bool exec_mod_resample_(
   return true;
 }
 
+//*************************************************************************************************
+// Clone method
+// Create module variables for another thread: Copy parameters, allocate separate work buffers
+//
+//*************************************************************************************************
+void clone_mod_resample_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( env->execPhaseDef->variables() );
+  csSuperHeader const* shdr = env->superHeader;
+  VariableStruct* varsClone = new VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  *varsClone = *vars;
+  if( vars->buffer != NULL ) varsClone->buffer = new float[shdr->numSamples];
+  if( vars->interpol != NULL ) varsClone->interpol = new csInterpolation( *vars->interpol );
+  if( vars->fftTool != NULL ) {
+    varsClone->fftTool = new csFFTTools( vars->numSamplesOld, shdr->numSamples, vars->sampleIntOld, shdr->sampleInt );
+    varsClone->fftTool->setFilter( vars->filterOrder, vars->cutOffHz, false );
+  }
+}
+
 //*************************************************************************************************
 // Parameter definition
 //
@@ -383,6 +410,9 @@ extern "C" void _params_mod_resample_( csParamDef* pdef ) {
 extern "C" void _init_mod_resample_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_resample_( param, env, log );
 }
+extern "C" void _clone_mod_resample_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_resample_( env, envClone );
+}
 extern "C" bool _exec_mod_resample_( csTrace* trace, int* port, csExecPhaseEnv* env, csLogWriter* log ) {
   return exec_mod_resample_( trace, port, env, log );
 }
@@ -154,7 +154,7 @@ bool exec_mod_rms_(
   }
 
   int nSamples = vars->endSamp - vars->startSamp + 1;
-  float rms = compute_rms( &(trace->getTraceSamples()[vars->startSamp]), nSamples );
+  float rms = compute_rms( &(trace->getTraceSamplesReadOnly()[vars->startSamp]), nSamples );
 
   // Set double value to account for different header types
   trace->getTraceHeader()->setDoubleValue( vars->hdrId_rms, rms );
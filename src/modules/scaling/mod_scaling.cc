@@ -45,6 +45,7 @@ void init_mod_scaling_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
   edef->setVariables( vars );
   
   edef->setExecType( EXEC_TYPE_SINGLETRACE );
+  edef->setThreadSafe( true );
 
   vars->option    = 0;
   vars->numTimes  = 0;
@@ -63,6 +63,7 @@ void init_mod_select_time_( csParamManager* param, csInitPhaseEnv* env, csLogWri
   edef->setVariables( vars );
 
   edef->setExecType( EXEC_TYPE_SINGLETRACE );
+  edef->setThreadSafe( true );
 
   vars->isShiftTrace = false;
   vars->startSamp = 0;
@@ -2,11 +2,10 @@
 /* All rights reserved.                       */
 
 #include "cseis_includes.h"
-#include "csNMOCorrection.h"
+#include "csVelocityScan.h"
 #include "csTableManagerNew.h"
 #include "csTableAll.h"
 #include "csVector.h"
-#include "csInterpolation.h"
 #include <cmath>
 #include <cstring>
 
@@ -23,7 +22,7 @@ using namespace std;
  */
 namespace mod_semblance {
   struct VariableStruct {
-    csNMOCorrection* nmo;
+    csVelocityScan* scan;
     int hdrId_offset;
     int hdrId_rec_z;
     int hdrId_sou_z;
@@ -38,14 +37,16 @@ namespace mod_semblance {
     float velMax;
     int numVels;
 
+    float* velocities;
     float* bufferSemblance;
 
     bool isNMO;
-    cseis_geolib::csInterpolation* lmoInterpol;
+    int moveoutType;
     float lmoRefVel;  // LMO reference velocity
     float lmoRefVelInverse;
 
     csTableManagerNew* tableManager;
+    bool isClone;  // true for copy created by clone method. Shares read-only fields with original
   };
   static int const OUTPUT_FIRST   = 1;
   static int const OUTPUT_LAST    = 2;
@@ -70,7 +71,7 @@ void init_mod_semblance_( csParamManager* param, csInitPhaseEnv* env, csLogWrite
   edef->setExecType( EXEC_TYPE_MULTITRACE );
   edef->setTraceSelectionMode( TRCMODE_ENSEMBLE );
 
-  vars->nmo            = NULL;
+  vars->scan           = NULL;
   vars->hdrId_offset   = -1;
   vars->hdrId_vel_rms  = -1;
   vars->hdrId_rec_z    = -1;
@@ -83,26 +84,28 @@ void init_mod_semblance_( csParamManager* param, csInitPhaseEnv* env, csLogWrite
   vars->velMin    = 0;
   vars->velMax    = 0;
   vars->numVels   = 0;
+  vars->velocities = NULL;
   vars->bufferSemblance  = NULL;
   vars->tableManager = NULL;
   vars->isNMO     = true;
-  vars->lmoInterpol  = NULL;
+  vars->moveoutType  = csVelocityScan::MOVEOUT_PP;
+  vars->isClone      = false;
   vars->lmoRefVel = 0;
   vars->lmoRefVelInverse = 0;
 
   //-------------------------------------
   std::string text;
-  int mode_nmo = csNMOCorrection::PP_NMO;
   if( param->exists("wave_mode") ) {
     param->getString( "wave_mode", &text );
     if( !text.compare("pp_iso") ) {
-      mode_nmo = csNMOCorrection::PP_NMO;
+      vars->moveoutType = csVelocityScan::MOVEOUT_PP;
     }
     else if( !text.compare("ps_iso") ) {
-      mode_nmo = csNMOCorrection::PS_NMO;
+      vars->moveoutType = csVelocityScan::MOVEOUT_PS;
     }
     else if( !text.compare("p_direct") ) {
       vars->isNMO = false;
+      vars->moveoutType = csVelocityScan::MOVEOUT_LINEAR;
       log->line("Linear moveout correction is performed. Source/receiver depths are read in from trace headers 'rec_z' and 'sou_z'");
       if( param->exists("lmo_refvel") ) {
         param->getFloat("lmo_refvel", &vars->lmoRefVel );
@@ -167,6 +170,10 @@ void init_mod_semblance_( csParamManager* param, csInitPhaseEnv* env, csLogWrite
   }
 
   vars->numVels = (int)( (vars->velMax - vars->velMin) / vars->velInc ) + 1;
+  vars->velocities = new float[vars->numVels];
+  for( int ivel = 0; ivel < vars->numVels; ivel++ ) {
+    vars->velocities[ivel] = vars->velMin + (float)ivel * vars->velInc;
+  }
 
   //-----------------------------------------------
   //
@@ -223,14 +230,19 @@ void init_mod_semblance_( csParamManager* param, csInitPhaseEnv* env, csLogWrite
   //-----------------------------------------------
   csVector<std::string> valueList;
 
-  if( vars->isNMO ) {
-    vars->nmo = new csNMOCorrection( shdr->sampleInt, shdr->numSamples, mode_nmo );
-  }
-  else {
+  if( !vars->isNMO ) {
     vars->hdrId_rec_z = hdef->headerIndex( "rec_z" );
     vars->hdrId_sou_z = hdef->headerIndex( "sou_z" );
-    vars->lmoInterpol = new csInterpolation( shdr->numSamples, shdr->sampleInt, 8 );
   }
+  // Serial by default: Flows run with -t or -pipe already use one thread per module instance or pipeline group
+  int numThreads = 1;
+  if( param->exists("num_threads") ) {
+    param->getInt( "num_threads", &numThreads );
+    if( numThreads < 0 ) log->error("Number of threads must be >= 0. Specified: %d", numThreads);
+  }
+  vars->scan = new csVelocityScan( shdr->numSamples, shdr->sampleInt, vars->moveoutType, vars->windowLengthSamples );
+  vars->scan->setLinearReferenceVelocity( vars->lmoRefVel );
+  vars->scan->setNumThreads( numThreads );
 
   if( !hdef->headerExists( "offset" ) ) {
     log->error("Trace header 'offset' does not exist. Cannot perform NMO correction.");
@@ -250,6 +262,8 @@ void init_mod_semblance_( csParamManager* param, csInitPhaseEnv* env, csLogWrite
     log->line("Number of velocities: %d   %f %f %f", vars->numVels, vars->velMin, vars->velMax, vars->velInc );
     log->line("Number of samples in window: %d", vars->windowLengthSamples );
   }
+  // Table manager retrieves mute times through internal buffers
+  edef->setThreadSafe( vars->tableManager == NULL );
 }
 
 //*************************************************************************************************
@@ -270,6 +284,13 @@ void exec_mod_semblance_(
   csSuperHeader const* shdr = env->superHeader;
 
   if( edef->isCleanup()){
+    if( vars->isClone ) {
+      // Shared with original module variables, deleted there
+      vars->tableManager = NULL;
+      vars->velStart = NULL;
+      vars->velEnd   = NULL;
+      vars->velocities = NULL;
+    }
     if( vars->bufferSemblance ) {
       delete [] vars->bufferSemblance;
       vars->bufferSemblance = NULL;
@@ -286,13 +307,13 @@ void exec_mod_semblance_(
       delete [] vars->velEnd;
       vars->velEnd = NULL;
     }
-    if( vars->nmo != NULL ) {
-      delete vars->nmo;
-      vars->nmo = NULL;
+    if( vars->velocities != NULL ) {
+      delete [] vars->velocities;
+      vars->velocities = NULL;
     }
-    if( vars->lmoInterpol != NULL ) {
-      delete vars->lmoInterpol;
-      vars->lmoInterpol = NULL;
+    if( vars->scan != NULL ) {
+      delete vars->scan;
+      vars->scan = NULL;
     }
     delete vars; vars = NULL;
     return;
@@ -342,107 +363,74 @@ void exec_mod_semblance_(
     outTrace = 0;
   }
   */
-  traceGather->createTraces( nTracesIn, nTracesIn, env->headerDef, shdr->numSamples );
-
-  float** samplesTmpNMO = new float*[nTracesIn];
-  for( int itrc = 0; itrc < nTracesIn; itrc++ ) {
-    samplesTmpNMO[itrc] = traceGather->trace(itrc+nTracesIn)->getTraceSamples();
-  }
-
+  float const** samplesIn = new float const*[nTracesIn];
   float* offset = new float[nTracesIn];
   for( int itrc = 0; itrc < nTracesIn; itrc++ ) {
-    csTraceHeader* trcHdr = traceGather->trace(itrc)->getTraceHeader();
-    offset[itrc]          = trcHdr->doubleValue( vars->hdrId_offset );
+    samplesIn[itrc] = traceGather->trace(itrc)->getTraceSamples();
   }
+  traceGather->getHeaderValues( vars->hdrId_offset, offset );
   if( !vars->isNMO ) {
+    double* rec_z = new double[nTracesIn];
+    double* sou_z = new double[nTracesIn];
+    traceGather->getHeaderValues( vars->hdrId_rec_z, rec_z );
+    traceGather->getHeaderValues( vars->hdrId_sou_z, sou_z );
     for( int itrc = 0; itrc < nTracesIn; itrc++ ) {
-      csTraceHeader* trcHdr = traceGather->trace(itrc)->getTraceHeader();
-      double rec_z          = trcHdr->doubleValue( vars->hdrId_rec_z );
-      double sou_z          = trcHdr->doubleValue( vars->hdrId_sou_z );
-      offset[itrc]          = sqrt( pow(offset[itrc],2) + pow(rec_z-sou_z,2) );
+      offset[itrc] = sqrt( pow(offset[itrc],2) + pow(rec_z[itrc]-sou_z[itrc],2) );
     }
+    delete [] rec_z;
+    delete [] sou_z;
   }
-  //--------------------------------------------------------------------
-  //
-  //
-/*
-    // TEMP: Compute simple stack response
-    for( int isamp = 0; isamp < shdr->numSamples; isamp++ ) {
-      int firstSamp = std::max( 0, isamp-vars->windowLengthSamples );
-      int lastSamp  = std::min( shdr->numSamples-1, isamp+vars->windowLengthSamples );
-      double sum_stack = 0;
-      for( int itrc = 0; itrc < nTracesIn; itrc++ ) {
-        for( int isampSum = lastSamp; isampSum <= lastSamp; isampSum++ ) {
-          sum_stack += samplesTmpNMO[itrc][isamp];
-        }
-      }
-      semblancePtr[isamp] = sum_stack*sum_stack / nTracesIn;
-    }*/
 
-  float time = 0.0;
-  for( int ivel = 0; ivel < vars->numVels; ivel++ ) {
-    float velocity  = vars->velMin + (float)ivel * vars->velInc;
-    if( edef->isDebug() ) log->line("Compute semblance for velocity #%d: %f", ivel, velocity);
-    for( int itrc = 0; itrc < nTracesIn; itrc++ ) {
-      float const* samplesIn = traceGather->trace(itrc)->getTraceSamples();
-      //      double offset          = traceGather->trace(itrc)->getTraceHeader()->doubleValue( vars->hdrId_offset );
-      if( vars->isNMO ) {
-        vars->nmo->perform_nmo( samplesIn, 1, &time, &velocity, offset[itrc], samplesTmpNMO[itrc] );
-      }
-      else {
-        float shift_ms = -offset[itrc]*1000.0 * ( (1.0/(vars->lmoRefVel+velocity)) - vars->lmoRefVelInverse ); 
-        vars->lmoInterpol->static_shift( shift_ms, samplesIn, samplesTmpNMO[itrc] );
-      }
-    }
-    float* semblancePtr = &vars->bufferSemblance[ivel*shdr->numSamples];
-
-    // Compute semblance
-
-    for( int isamp = 0; isamp < shdr->numSamples; isamp++ ) {
-      if( vars->velStart[isamp] > velocity || vars->velEnd[isamp] < velocity ) {
-        semblancePtr[isamp] = 0.0;
-        continue;
-      }
-      int firstSamp = std::max( 0, isamp-vars->windowLengthSamples );
-      int lastSamp  = std::min( shdr->numSamples-1, isamp+vars->windowLengthSamples );
-      double sumUpper = 0.0;
-      double sumLower = 0.0;
-      for( int isampSum = firstSamp; isampSum <= lastSamp; isampSum++ ) {
-        double sum    = 0.0;
-        double sum_sq = 0.0;
-        for( int itrc = 0; itrc < nTracesIn; itrc++ ) {
-          if( isampSum <= sampleMuteEnd[itrc] ) continue;
-          sum    += samplesTmpNMO[itrc][isampSum];
-          sum_sq += samplesTmpNMO[itrc][isampSum]*samplesTmpNMO[itrc][isampSum];
-        }
-        sumUpper += sum*sum;
-        sumLower += sum_sq;
-      }
-      if( sumLower == 0 ) semblancePtr[isamp] = 0.0;
-      else semblancePtr[isamp] = sumUpper / sumLower;
-    }
+  //--------------------------------------------------------------------
+  // Compute semblance for all velocities
+  vars->scan->setGather( nTracesIn, samplesIn, offset, sampleMuteEnd );
+  try {
+    vars->scan->computeSemblance( vars->numVels, vars->velocities, vars->velStart, vars->velEnd, vars->bufferSemblance );
+  }
+  catch( csException& exc ) {
+    log->error("Error when computing semblance: %s", exc.getMessage());
   }
 
-  if( vars->numVels > 2*nTracesIn ) {
-    traceGather->createTraces( 2*nTracesIn, vars->numVels-2*nTracesIn, env->headerDef, shdr->numSamples );
+  if( vars->numVels > nTracesIn ) {
+    traceGather->createTraces( nTracesIn, vars->numVels-nTracesIn, env->headerDef, shdr->numSamples );
   }
   else {
-    traceGather->freeTraces( vars->numVels, 2*nTracesIn-vars->numVels );
+    traceGather->freeTraces( vars->numVels, nTracesIn-vars->numVels );
   }
   for( int ivel = 0; ivel < vars->numVels; ivel++ ) {
-    float velocity  = vars->velMin + (float)ivel * vars->velInc;
     csTraceHeader* trcHdr = traceGather->trace(ivel)->getTraceHeader();
-    trcHdr->setFloatValue( vars->hdrId_vel_rms, velocity+vars->lmoRefVel );
+    trcHdr->setFloatValue( vars->hdrId_vel_rms, vars->velocities[ivel]+vars->lmoRefVel );
     float* samplesOut  = traceGather->trace(ivel)->getTraceSamples();
     memcpy( samplesOut, &vars->bufferSemblance[ivel*shdr->numSamples], shdr->numSamples*sizeof(float) );
   }
 
-  delete [] samplesTmpNMO;
+  delete [] samplesIn;
   delete [] sampleMuteEnd;
   delete [] offset;
 //  *numTrcToKeep = vars->num_vels;
 }
 
+//*************************************************************************************************
+// Clone method
+// Create module variables for another thread: Copy parameters, allocate separate work buffers
+//
+//*************************************************************************************************
+void clone_mod_semblance_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( env->execPhaseDef->variables() );
+  csSuperHeader const* shdr = env->superHeader;
+  VariableStruct* varsClone = new VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  *varsClone = *vars;
+  varsClone->isClone = true;
+  varsClone->bufferSemblance = new float[vars->numVels*shdr->numSamples];
+  varsClone->scan = new csVelocityScan( shdr->numSamples, shdr->sampleInt, vars->moveoutType, vars->windowLengthSamples );
+  varsClone->scan->setLinearReferenceVelocity( vars->lmoRefVel );
+  // Clones run on ensemble worker threads: Do not add nested threads per velocity
+  varsClone->scan->setNumThreads( 1 );
+}
+
 //*************************************************************************************************
 // Parameter definition
 //
@@ -478,6 +466,11 @@ void params_mod_semblance_( csParamDef* pdef ) {
   pdef->addValue( "", VALTYPE_STRING, "Mute table file.",
     "The mute table must have at least two columns, one giving a key and the second giving the mute time in [ms]" );
 
+  pdef->addParam( "num_threads", "Number of threads used to compute semblance for different velocities in parallel", NUM_VALUES_FIXED,
+                  "Applies to serial execution only. Copies of this module running in parallel (see option -t) always use one thread each. "
+                  "Threads are added to those of the flow: Avoid values > 1 when running with option -pipe" );
+  pdef->addValue( "1", VALTYPE_NUMBER, "Number of threads", "=0: Use all available processors (explicit opt-in)" );
+
   pdef->addParam( "output_hdr", "How shall trace header of output trace be determined?", NUM_VALUES_FIXED );
   pdef->addValue( "first", VALTYPE_OPTION );
   pdef->addOption( "first", "Output trace header values of first input trace to output trace" );
@@ -492,6 +485,9 @@ extern "C" void _params_mod_semblance_( csParamDef* pdef ) {
 extern "C" void _init_mod_semblance_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_semblance_( param, env, log );
 }
+extern "C" void _clone_mod_semblance_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_semblance_( env, envClone );
+}
 extern "C" void _exec_mod_semblance_( csTraceGather* traceGather, int* port, int* numTrcToKeep, csExecPhaseEnv* env, csLogWriter* log ) {
   exec_mod_semblance_( traceGather, port, numTrcToKeep, env, log );
 }
@@ -1,9 +1,19 @@
 /* Copyright (c) Colorado School of Mines, 2013.*/
 /* All rights reserved.                       */
 
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <pthread.h>
+#include <unistd.h>
 #include "cseis_includes.h"
 #include "csVector.h"
 #include "csSortManager.h"
+#include "csMemoryPoolManager.h"
+#include "csSeismicWriter.h"
+#include "csSeismicReader_ver.h"
+#include "csSeismicIOConfig.h"
 
 using namespace cseis_system;
 using namespace cseis_geolib;
@@ -17,6 +27,36 @@ using namespace std;
  * @date   2007
  */
 namespace mod_sort {
+  struct VariableStruct;
+  /// Arguments passed to thread sorting one run of traces and spilling it to a temporary file
+  struct RunWriterArgs {
+    VariableStruct const* vars;
+    csTraceGather* gather;
+    cseis_geolib::csSortManager* sortManager;
+    std::string filename;
+    csSuperHeader const* shdr;
+    csTraceHeaderDef const* hdef;
+    std::string errorMessage;
+  };
+  /// One sorted run that is read back in during the merge
+  struct RunReader {
+    cseis_io::csSeismicReader_ver* reader;
+    /// Number of traces not yet merged, excluding head trace
+    int numTracesLeft;
+    /// Number of traces not yet read from file. Only accessed by read-ahead thread once the merge has started
+    int numTracesOnFile;
+    /// Two chunks of traces read from file: The merge consumes one chunk while the read-ahead thread fills the other one
+    float* chunkSamples[2];
+    char*  chunkHdrValues[2];
+    int    chunkNumTraces[2];
+    /// Chunk currently consumed by the merge, and index of next trace in this chunk
+    int chunkCurrent;
+    int chunkTrace;
+    /// true when the other chunk has been filled by the read-ahead thread. Guarded by read-ahead mutex
+    bool isChunkFilled;
+    /// Error message set by read-ahead thread
+    std::string errorMessage;
+  };
   struct VariableStruct {
     int numHeaders;
     int* indexHdr;
@@ -25,9 +65,91 @@ namespace mod_sort {
     int* sortDir;
     int traceCounter;
     cseis_geolib::csSortManager* sortManager;
+
+    // Out-of-core sort:
+    /// true if traces shall be spilled to temporary files when memory limit is exceeded
+    bool isExternal;
+    /// Maximum number of bytes used to buffer input traces
+    csInt64_t maxNumBytes;
+    /// Maximum number of traces in one run, computed from maxNumBytes
+    int maxNumTracesRun;
+    std::string tempDir;
+    /// Traces collected for the current run
+    csTraceGather* gatherRun;
+    /// Traces of previous run, being sorted and spilled by writer thread
+    csTraceGather* gatherSpill;
+    cseis_geolib::csSortManager* sortManagerSpill;
+    pthread_t writerThread;
+    bool isWriting;
+    RunWriterArgs* writerArgs;
+    cseis_geolib::csVector<std::string>* runFilenames;
+    cseis_geolib::csVector<int>* runNumTraces;
+    /// true once all input traces have been spilled and the runs are being merged
+    bool isMerging;
+    RunReader* runs;
+    /// One trace for each run: Next trace of this run to be merged
+    csTraceGather* gatherHeads;
+    /// Maximum number of traces in one chunk read from a run
+    int numTracesChunk;
+    int numSamples;
+    int hdrByteSize;
+    /// Read-ahead thread: Fills chunks of all runs, in the order requested by the merge
+    pthread_t readAheadThread;
+    bool isReadAheadRunning;
+    bool readAheadStop;
+    pthread_mutex_t readAheadMutex;
+    /// Signalled when a run is added to the request queue
+    pthread_cond_t readAheadCondRequest;
+    /// Signalled when a chunk has been filled
+    pthread_cond_t readAheadCondFilled;
+    /// Queue of run indices whose next chunk shall be filled
+    std::deque<int>* readAheadRequests;
+    /// Sort key values of head trace of each run, as double and integer values
+    double* keysDouble;
+    csInt64_t* keysInt;
+    /// Heap of run indices, ordered by sort key values of run's head trace
+    std::vector<int>* heap;
   };
   static int const INCREASING = 1;
   static int const DECREASING = 2;
+
+  /// Number of traces buffered by writer/reader of temporary files
+  static int const NUM_TRACES_BUFFER = 20;
+  /// Number of merged traces output in one call
+  static int const NUM_TRACES_MERGE = 100;
+
+  void sortGather( VariableStruct const* vars, csTraceGather* traceGather, cseis_geolib::csSortManager* sortManager );
+  void* writeRunThread( void* args );
+  void spillRun( VariableStruct* vars, csExecPhaseEnv* env );
+  void waitForWriter( VariableStruct* vars );
+  void startMerge( VariableStruct* vars, csExecPhaseEnv* env );
+  void readHeadTrace( VariableStruct* vars, int irun, csExecPhaseEnv* env );
+  void fillChunk( VariableStruct* vars, int irun, int ichunk );
+  void* readAheadThread( void* args );
+  void stopReadAhead( VariableStruct* vars );
+  void removeRunFiles( VariableStruct* vars );
+
+  /// Comparison of run head traces: Defines min-heap of run indices. Runs with equal keys are merged in run order
+  struct HeadCompare {
+    VariableStruct const* vars;
+    HeadCompare( VariableStruct const* v ) : vars(v) {}
+    bool operator()( int irun1, int irun2 ) const {
+      int n = vars->numHeaders;
+      for( int ihdr = 0; ihdr < n; ihdr++ ) {
+        if( vars->hdrTypes[ihdr] == cseis_geolib::TYPE_DOUBLE ) {
+          double v1 = vars->keysDouble[irun1*n+ihdr];
+          double v2 = vars->keysDouble[irun2*n+ihdr];
+          if( v1 != v2 ) return( v1 > v2 );
+        }
+        else {
+          csInt64_t v1 = vars->keysInt[irun1*n+ihdr];
+          csInt64_t v2 = vars->keysInt[irun2*n+ihdr];
+          if( v1 != v2 ) return( v1 > v2 );
+        }
+      }
+      return( irun1 > irun2 );
+    }
+  };
 }
 using namespace mod_sort;
 
@@ -46,7 +168,6 @@ void init_mod_sort_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
   edef->setVariables( vars );
 
   edef->setExecType( EXEC_TYPE_MULTITRACE );
-  edef->setTraceSelectionMode( TRCMODE_ENSEMBLE );
 
   vars->numHeaders = 0;
   vars->indexHdr = NULL;
@@ -56,6 +177,30 @@ void init_mod_sort_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
   vars->traceCounter = 0;
   vars->sortManager  = NULL;
 
+  vars->isExternal      = false;
+  vars->maxNumBytes     = 0;
+  vars->maxNumTracesRun = 0;
+  vars->tempDir         = "/tmp";
+  vars->gatherRun       = NULL;
+  vars->gatherSpill     = NULL;
+  vars->sortManagerSpill = NULL;
+  vars->isWriting       = false;
+  vars->writerArgs      = NULL;
+  vars->runFilenames    = NULL;
+  vars->runNumTraces    = NULL;
+  vars->isMerging       = false;
+  vars->runs            = NULL;
+  vars->gatherHeads     = NULL;
+  vars->numTracesChunk  = 0;
+  vars->numSamples      = 0;
+  vars->hdrByteSize     = 0;
+  vars->isReadAheadRunning = false;
+  vars->readAheadStop   = false;
+  vars->readAheadRequests = NULL;
+  vars->keysDouble      = NULL;
+  vars->keysInt         = NULL;
+  vars->heap            = NULL;
+
   //-----------------------------------------
 
   int nLines = param->getNumLines( "header" );
@@ -123,6 +268,30 @@ void init_mod_sort_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* lo
 
   vars->sortManager = new csSortManager( vars->numHeaders, sortMethod );
 
+  if( param->exists("memory") ) {
+    double memoryMB;
+    param->getDouble("memory", &memoryMB);
+    if( memoryMB <= 0 ) {
+      log->error("Memory limit must be larger than 0: %f", memoryMB);
+    }
+    vars->isExternal  = true;
+    vars->maxNumBytes = (csInt64_t)( memoryMB * 1024.0 * 1024.0 );
+    if( param->exists("temp_dir") ) {
+      param->getString("temp_dir", &vars->tempDir);
+    }
+    vars->gatherRun        = new csTraceGather( hdef );
+    vars->gatherSpill      = new csTraceGather( hdef );
+    vars->gatherHeads      = new csTraceGather( hdef );
+    vars->sortManagerSpill = new csSortManager( vars->numHeaders, sortMethod );
+    vars->runFilenames     = new csVector<std::string>();
+    vars->runNumTraces     = new csVector<int>();
+    // Collect input traces one by one. All input traces are sorted at once, ensembles are ignored
+    edef->setTraceSelectionMode( TRCMODE_FIXED, 1 );
+  }
+  else {
+    edef->setTraceSelectionMode( TRCMODE_ENSEMBLE );
+  }
+
   vars->traceCounter = 0;
 }
 
@@ -164,47 +333,164 @@ void exec_mod_sort_(
       delete vars->sortManager;
       vars->sortManager = NULL;
     }
+    if( vars->isWriting ) {
+      pthread_join( vars->writerThread, NULL );
+      delete vars->writerArgs;
+      vars->writerArgs = NULL;
+    }
+    removeRunFiles( vars );
+    if( vars->gatherRun != NULL ) {
+      vars->gatherRun->freeAllTraces();
+      delete vars->gatherRun;
+      vars->gatherRun = NULL;
+    }
+    if( vars->gatherSpill != NULL ) {
+      vars->gatherSpill->freeAllTraces();
+      delete vars->gatherSpill;
+      vars->gatherSpill = NULL;
+    }
+    if( vars->gatherHeads != NULL ) {
+      vars->gatherHeads->freeAllTraces();
+      delete vars->gatherHeads;
+      vars->gatherHeads = NULL;
+    }
+    if( vars->sortManagerSpill != NULL ) {
+      delete vars->sortManagerSpill;
+      vars->sortManagerSpill = NULL;
+    }
+    if( vars->runFilenames != NULL ) {
+      delete vars->runFilenames;
+      vars->runFilenames = NULL;
+    }
+    if( vars->runNumTraces != NULL ) {
+      delete vars->runNumTraces;
+      vars->runNumTraces = NULL;
+    }
+    if( vars->runs != NULL ) {
+      delete [] vars->runs;
+      vars->runs = NULL;
+    }
+    if( vars->readAheadRequests != NULL ) {
+      delete vars->readAheadRequests;
+      vars->readAheadRequests = NULL;
+    }
+    if( vars->keysDouble != NULL ) {
+      delete [] vars->keysDouble;
+      vars->keysDouble = NULL;
+    }
+    if( vars->keysInt != NULL ) {
+      delete [] vars->keysInt;
+      vars->keysInt = NULL;
+    }
+    if( vars->heap != NULL ) {
+      delete vars->heap;
+      vars->heap = NULL;
+    }
     delete vars; vars = NULL;
     return;
   }
 
 //-------------------------------------------
+  if( vars->isExternal ) {
+    csSuperHeader const* shdr = env->superHeader;
+    if( !vars->isMerging ) {
+      vars->traceCounter += traceGather->numTraces();
+      traceGather->moveTracesTo( 0, traceGather->numTraces(), vars->gatherRun );
+      if( vars->maxNumTracesRun == 0 ) {
+        // Memory limit is shared between run being collected and run being spilled in the background
+        csInt64_t numBytesPerTrace = csMemoryPoolManager::numBytesPerTrace( shdr->numSamples, env->headerDef->getTotalNumBytes() );
+        vars->maxNumTracesRun = (int)std::max( (csInt64_t)1, vars->maxNumBytes / (2*numBytesPerTrace) );
+        if( edef->isDebug() ) log->line("Maximum number of traces per run: %d", vars->maxNumTracesRun );
+      }
+      if( vars->gatherRun->numTraces() >= vars->maxNumTracesRun ) {
+        spillRun( vars, env );
+      }
+      if( !edef->isLastCall() ) {
+        edef->setTracesAreWaiting();
+        return;
+      }
+      if( vars->runFilenames->size() == 0 ) {
+        // All traces fit into memory
+        sortGather( vars, vars->gatherRun, vars->sortManager );
+        vars->gatherRun->moveTracesTo( 0, vars->gatherRun->numTraces(), traceGather );
+        return;
+      }
+      if( vars->gatherRun->numTraces() > 0 ) spillRun( vars, env );
+      waitForWriter( vars );
+      startMerge( vars, env );
+      vars->isMerging = true;
+      log->line("Merging %d sorted runs of traces (%d traces in total)", vars->runFilenames->size(), vars->traceCounter );
+    }
+    // Trace gather may still hold last trace of previous call
+    std::vector<int>& heap = *vars->heap;
+    HeadCompare compare( vars );
+    for( int itrc = 0; itrc < NUM_TRACES_MERGE && !heap.empty(); itrc++ ) {
+      std::pop_heap( heap.begin(), heap.end(), compare );
+      int irun = heap.back();
+      heap.pop_back();
+      csTrace* trace = traceGather->createTrace( env->headerDef, shdr->numSamples );
+      (*traceGather)[traceGather->numTraces()-1] = (*vars->gatherHeads)[irun];
+      (*vars->gatherHeads)[irun] = trace;
+      if( vars->runs[irun].numTracesLeft > 0 ) {
+        readHeadTrace( vars, irun, env );
+        heap.push_back( irun );
+        std::push_heap( heap.begin(), heap.end(), compare );
+      }
+    }
+    if( !heap.empty() ) {
+      // Keep last trace so that exec phase is called again
+      *numTrcToKeep = 1;
+    }
+    else {
+      removeRunFiles( vars );
+    }
+    return;
+  }
+
   int nTraces = traceGather->numTraces();
   if( edef->isDebug() ) log->line("Number of input traces: %d", nTraces );
   vars->traceCounter += nTraces;
 
-  vars->sortManager->resetValues( nTraces );
+  sortGather( vars, traceGather, vars->sortManager );
+}
+
+//*************************************************************************************************
+// Sort all traces in trace gather
+//
+void mod_sort::sortGather( VariableStruct const* vars, csTraceGather* traceGather, csSortManager* sortManager ) {
+  int nTraces = traceGather->numTraces();
+  sortManager->resetValues( nTraces );
   for( int ihdr = 0; ihdr < vars->numHeaders; ihdr++ ) {
     int sign = ( vars->sortDir[ihdr] == INCREASING ) ? 1 : -1;
     if( vars->hdrTypes[ihdr] == TYPE_INT ) {
       for( int itrc = 0; itrc < nTraces; itrc++ ) {
         int value = sign*traceGather->trace(itrc)->getTraceHeader()->intValue(vars->indexHdr[ihdr]);
-        vars->sortManager->setValue( itrc, vars->numHeaders-ihdr-1, csFlexNumber(value) );
+        sortManager->setValue( itrc, vars->numHeaders-ihdr-1, csFlexNumber(value) );
       }
     }
     else if( vars->hdrTypes[ihdr] == TYPE_DOUBLE ) {
       for( int itrc = 0; itrc < nTraces; itrc++ ) {
         double value = (double)sign*traceGather->trace(itrc)->getTraceHeader()->doubleValue(vars->indexHdr[ihdr]);
-        vars->sortManager->setValue( itrc, vars->numHeaders-ihdr-1, csFlexNumber(value) );
+        sortManager->setValue( itrc, vars->numHeaders-ihdr-1, csFlexNumber(value) );
       }
     }
     else { // INT64
       for( int itrc = 0; itrc < nTraces; itrc++ ) {
         csInt64_t value = sign*traceGather->trace(itrc)->getTraceHeader()->int64Value(vars->indexHdr[ihdr]);
-        vars->sortManager->setValue( itrc, vars->numHeaders-ihdr-1, csFlexNumber(value) );
+        sortManager->setValue( itrc, vars->numHeaders-ihdr-1, csFlexNumber(value) );
       }
     }
   }
-  //  fprintf(stdout,"START sorting %d ( =? %d ) traces...\n", nTraces, vars->sortManager->numValues());
-  //  vars->sortManager->dump();
+  //  fprintf(stdout,"START sorting %d ( =? %d ) traces...\n", nTraces, sortManager->numValues());
+  //  sortManager->dump();
   //  fflush(stdout);
-  vars->sortManager->sort();
+  sortManager->sort();
   // fprintf(stdout,"END sort...\n");
   // fflush(stdout);
 
   csTrace** tracePtr = new csTrace*[nTraces];
   for( int itrc = 0; itrc < nTraces; itrc++ ) {
-    tracePtr[itrc] = traceGather->trace( vars->sortManager->sortedIndex(itrc) );
+    tracePtr[itrc] = traceGather->trace( sortManager->sortedIndex(itrc) );
   }
   for( int itrc = 0; itrc < nTraces; itrc++ ) {
     (*traceGather)[itrc] = tracePtr[itrc];
@@ -212,6 +498,277 @@ void exec_mod_sort_(
   delete [] tracePtr;
 }
 
+//*************************************************************************************************
+// Out-of-core sort
+//
+//*************************************************************************************************
+/**
+ * Thread function: Sort one run of traces and write it to a temporary SeaSeis file
+ */
+void* mod_sort::writeRunThread( void* argsPtr ) {
+  RunWriterArgs* args = reinterpret_cast<RunWriterArgs*>( argsPtr );
+  csSeismicWriter* writer = NULL;
+  try {
+    sortGather( args->vars, args->gather, args->sortManager );
+    writer = new csSeismicWriter( args->filename, NUM_TRACES_BUFFER, 4, true );
+    bool success = writer->writeFileHeader( args->shdr, args->hdef );
+    int nTraces = args->gather->numTraces();
+    for( int itrc = 0; itrc < nTraces && success; itrc++ ) {
+      csTrace* trace = args->gather->trace(itrc);
+      success = writer->writeTrace( trace->getTraceSamplesReadOnly(), trace->getTraceHeader()->getTraceHeaderValueBlock() );
+    }
+    if( !success ) args->errorMessage = "Unknown error occurred when writing to temporary file " + args->filename;
+  }
+  catch( csException& exc ) {
+    args->errorMessage = exc.getMessage();
+  }
+  if( writer != NULL ) delete writer;
+  args->gather->freeAllTraces();
+  return NULL;
+}
+/**
+ * Hand over current run to writer thread. Waits until previous run has been spilled
+ */
+void mod_sort::spillRun( VariableStruct* vars, csExecPhaseEnv* env ) {
+  waitForWriter( vars );
+  char filename[1024];
+  snprintf( filename, 1024, "%s/seaseis_sort_%d_%lx_%d.tmp", vars->tempDir.c_str(), (int)getpid(),
+            (unsigned long)vars, vars->runFilenames->size() );
+  vars->runFilenames->insertEnd( std::string(filename) );
+  vars->runNumTraces->insertEnd( vars->gatherRun->numTraces() );
+
+  csTraceGather* gather = vars->gatherSpill;
+  vars->gatherSpill = vars->gatherRun;
+  vars->gatherRun   = gather;
+
+  RunWriterArgs* args = new RunWriterArgs();
+  args->vars        = vars;
+  args->gather      = vars->gatherSpill;
+  args->sortManager = vars->sortManagerSpill;
+  args->filename    = filename;
+  args->shdr        = env->superHeader;
+  args->hdef        = env->headerDef;
+  vars->writerArgs  = args;
+  if( pthread_create( &vars->writerThread, NULL, writeRunThread, args ) != 0 ) {
+    throw( csException("SORT: Unable to start thread writing temporary file") );
+  }
+  vars->isWriting = true;
+}
+/**
+ * Wait until writer thread has finished spilling current run
+ */
+void mod_sort::waitForWriter( VariableStruct* vars ) {
+  if( !vars->isWriting ) return;
+  pthread_join( vars->writerThread, NULL );
+  vars->isWriting = false;
+  std::string errorMessage = vars->writerArgs->errorMessage;
+  delete vars->writerArgs;
+  vars->writerArgs = NULL;
+  if( !errorMessage.empty() ) {
+    throw( csException("SORT: Error occurred when writing temporary file. System message:\n%s", errorMessage.c_str()) );
+  }
+}
+/**
+ * Open all runs, read in first chunk and first trace of each run, then start read-ahead thread
+ */
+void mod_sort::startMerge( VariableStruct* vars, csExecPhaseEnv* env ) {
+  int numRuns = vars->runFilenames->size();
+  int numHeaders = vars->numHeaders;
+  // Two chunks per run: Use memory limit for all chunks together
+  vars->numTracesChunk = std::max( 1, std::min( vars->maxNumTracesRun / (2*numRuns), 100*NUM_TRACES_BUFFER ) );
+  vars->numSamples     = env->superHeader->numSamples;
+  vars->hdrByteSize    = env->headerDef->getTotalNumBytes();
+
+  vars->runs          = new RunReader[numRuns];
+  vars->keysDouble    = new double[numRuns*numHeaders];
+  vars->keysInt       = new csInt64_t[numRuns*numHeaders];
+  vars->heap          = new std::vector<int>();
+  vars->readAheadRequests = new std::deque<int>();
+  for( int irun = 0; irun < numRuns; irun++ ) {
+    RunReader& run = vars->runs[irun];
+    run.reader = NULL;
+    for( int ichunk = 0; ichunk < 2; ichunk++ ) {
+      run.chunkSamples[ichunk]   = NULL;
+      run.chunkHdrValues[ichunk] = NULL;
+      run.chunkNumTraces[ichunk] = 0;
+    }
+  }
+  for( int irun = 0; irun < numRuns; irun++ ) {
+    RunReader& run = vars->runs[irun];
+    run.reader = cseis_io::csSeismicReader_ver::createReaderObject( vars->runFilenames->at(irun), false, NUM_TRACES_BUFFER );
+    cseis_io::csSeismicIOConfig config;
+    if( !run.reader->readFileHeader( &config ) ) {
+      throw( csException("SORT: Error occurred when reading temporary file %s", vars->runFilenames->at(irun).c_str()) );
+    }
+    for( int ichunk = 0; ichunk < 2; ichunk++ ) {
+      run.chunkSamples[ichunk]   = new float[vars->numTracesChunk*vars->numSamples];
+      run.chunkHdrValues[ichunk] = new char[vars->numTracesChunk*vars->hdrByteSize];
+    }
+    run.numTracesLeft   = vars->runNumTraces->at(irun);
+    run.numTracesOnFile = vars->runNumTraces->at(irun);
+    run.chunkCurrent    = 0;
+    run.chunkTrace      = 0;
+    run.isChunkFilled   = false;
+    fillChunk( vars, irun, 0 );
+    if( !run.errorMessage.empty() ) {
+      throw( csException("SORT: %s", run.errorMessage.c_str()) );
+    }
+    vars->gatherHeads->createTrace( env->headerDef, vars->numSamples );
+    readHeadTrace( vars, irun, env );
+    vars->heap->push_back( irun );
+    if( run.numTracesOnFile > 0 ) vars->readAheadRequests->push_back( irun );
+  }
+  std::make_heap( vars->heap->begin(), vars->heap->end(), HeadCompare( vars ) );
+
+  vars->readAheadStop = false;
+  pthread_mutex_init( &vars->readAheadMutex, NULL );
+  pthread_cond_init( &vars->readAheadCondRequest, NULL );
+  pthread_cond_init( &vars->readAheadCondFilled, NULL );
+  if( pthread_create( &vars->readAheadThread, NULL, readAheadThread, vars ) != 0 ) {
+    pthread_mutex_destroy( &vars->readAheadMutex );
+    pthread_cond_destroy( &vars->readAheadCondRequest );
+    pthread_cond_destroy( &vars->readAheadCondFilled );
+    throw( csException("SORT: Unable to start thread reading temporary files") );
+  }
+  vars->isReadAheadRunning = true;
+}
+/**
+ * Read next trace of given run into run's head trace, and set sort key values.
+ * Switches to the run's other chunk when the current chunk has been consumed, and requests the next chunk from the read-ahead thread
+ */
+void mod_sort::readHeadTrace( VariableStruct* vars, int irun, csExecPhaseEnv* env ) {
+  RunReader& run = vars->runs[irun];
+  if( run.chunkTrace == run.chunkNumTraces[run.chunkCurrent] ) {
+    pthread_mutex_lock( &vars->readAheadMutex );
+    while( !run.isChunkFilled ) {
+      pthread_cond_wait( &vars->readAheadCondFilled, &vars->readAheadMutex );
+    }
+    run.isChunkFilled = false;
+    run.chunkCurrent  = 1 - run.chunkCurrent;
+    run.chunkTrace    = 0;
+    bool isError = !run.errorMessage.empty();
+    if( !isError && run.numTracesLeft > run.chunkNumTraces[run.chunkCurrent] ) {
+      vars->readAheadRequests->push_back( irun );
+      pthread_cond_signal( &vars->readAheadCondRequest );
+    }
+    pthread_mutex_unlock( &vars->readAheadMutex );
+    if( isError ) {
+      throw( csException("SORT: %s", run.errorMessage.c_str()) );
+    }
+  }
+  csTrace* trace = vars->gatherHeads->trace(irun);
+  csTraceHeader* trcHdr = trace->getTraceHeader();
+  memcpy( trace->getTraceSamples(), &run.chunkSamples[run.chunkCurrent][run.chunkTrace*vars->numSamples], vars->numSamples*sizeof(float) );
+  trcHdr->setTraceHeaderValueBlock( &run.chunkHdrValues[run.chunkCurrent][run.chunkTrace*vars->hdrByteSize], vars->hdrByteSize );
+  run.chunkTrace    += 1;
+  run.numTracesLeft -= 1;
+
+  int n = vars->numHeaders;
+  for( int ihdr = 0; ihdr < n; ihdr++ ) {
+    int sign = ( vars->sortDir[ihdr] == INCREASING ) ? 1 : -1;
+    if( vars->hdrTypes[ihdr] == TYPE_INT ) {
+      vars->keysInt[irun*n+ihdr] = sign*trcHdr->intValue(vars->indexHdr[ihdr]);
+    }
+    else if( vars->hdrTypes[ihdr] == TYPE_DOUBLE ) {
+      vars->keysDouble[irun*n+ihdr] = (double)sign*trcHdr->doubleValue(vars->indexHdr[ihdr]);
+    }
+    else { // INT64
+      vars->keysInt[irun*n+ihdr] = sign*trcHdr->int64Value(vars->indexHdr[ihdr]);
+    }
+  }
+}
+/**
+ * Read next chunk of traces of given run from file. Sets run's error message if reading fails
+ */
+void mod_sort::fillChunk( VariableStruct* vars, int irun, int ichunk ) {
+  RunReader& run = vars->runs[irun];
+  int numTraces = std::min( vars->numTracesChunk, run.numTracesOnFile );
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    if( !run.reader->readTrace( &run.chunkSamples[ichunk][itrc*vars->numSamples], &run.chunkHdrValues[ichunk][itrc*vars->hdrByteSize], vars->numSamples ) ) {
+      run.errorMessage = "Error occurred when reading temporary file " + vars->runFilenames->at(irun);
+      numTraces = itrc;
+      break;
+    }
+  }
+  run.chunkNumTraces[ichunk] = numTraces;
+  run.numTracesOnFile -= numTraces;
+}
+/**
+ * Thread function: Read ahead chunks of traces from temporary files while the runs are being merged
+ */
+void* mod_sort::readAheadThread( void* argsPtr ) {
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( argsPtr );
+  pthread_mutex_lock( &vars->readAheadMutex );
+  while( true ) {
+    while( vars->readAheadRequests->empty() && !vars->readAheadStop ) {
+      pthread_cond_wait( &vars->readAheadCondRequest, &vars->readAheadMutex );
+    }
+    if( vars->readAheadStop ) break;
+    int irun = vars->readAheadRequests->front();
+    vars->readAheadRequests->pop_front();
+    int ichunk = 1 - vars->runs[irun].chunkCurrent;
+    pthread_mutex_unlock( &vars->readAheadMutex );
+
+    try {
+      fillChunk( vars, irun, ichunk );
+    }
+    catch( csException& exc ) {
+      vars->runs[irun].errorMessage = exc.getMessage();
+    }
+
+    pthread_mutex_lock( &vars->readAheadMutex );
+    vars->runs[irun].isChunkFilled = true;
+    pthread_cond_broadcast( &vars->readAheadCondFilled );
+  }
+  pthread_mutex_unlock( &vars->readAheadMutex );
+  return NULL;
+}
+/**
+ * Stop read-ahead thread
+ */
+void mod_sort::stopReadAhead( VariableStruct* vars ) {
+  if( !vars->isReadAheadRunning ) return;
+  pthread_mutex_lock( &vars->readAheadMutex );
+  vars->readAheadStop = true;
+  pthread_cond_signal( &vars->readAheadCondRequest );
+  pthread_mutex_unlock( &vars->readAheadMutex );
+  pthread_join( vars->readAheadThread, NULL );
+  pthread_mutex_destroy( &vars->readAheadMutex );
+  pthread_cond_destroy( &vars->readAheadCondRequest );
+  pthread_cond_destroy( &vars->readAheadCondFilled );
+  vars->isReadAheadRunning = false;
+}
+/**
+ * Close and remove all temporary files
+ */
+void mod_sort::removeRunFiles( VariableStruct* vars ) {
+  if( vars->runFilenames == NULL ) return;
+  stopReadAhead( vars );
+  int numRuns = vars->runFilenames->size();
+  if( vars->runs != NULL ) {
+    for( int irun = 0; irun < numRuns; irun++ ) {
+      RunReader& run = vars->runs[irun];
+      if( run.reader != NULL ) {
+        delete run.reader;
+        run.reader = NULL;
+      }
+      for( int ichunk = 0; ichunk < 2; ichunk++ ) {
+        if( run.chunkSamples[ichunk] != NULL ) {
+          delete [] run.chunkSamples[ichunk];
+          run.chunkSamples[ichunk] = NULL;
+        }
+        if( run.chunkHdrValues[ichunk] != NULL ) {
+          delete [] run.chunkHdrValues[ichunk];
+          run.chunkHdrValues[ichunk] = NULL;
+        }
+      }
+    }
+  }
+  for( int irun = 0; irun < numRuns; irun++ ) {
+    remove( vars->runFilenames->at(irun).c_str() );
+  }
+  vars->runFilenames->clear();
+}
 
 //*************************************************************************************************
 // Parameter definition
@@ -219,7 +776,7 @@ void exec_mod_sort_(
 //
 //*************************************************************************************************
 void params_mod_sort_( csParamDef* pdef ) {
-  pdef->setModule( "SORT", "Sort traces", "Very simple implementation. Requires to hold all traces to be sorted in memory at once." );
+  pdef->setModule( "SORT", "Sort traces", "By default, all traces of one ensemble are sorted in memory. Specify user parameter 'memory' to sort large data sets that do not fit into memory." );
 
   pdef->addParam( "mode", "Sort mode", NUM_VALUES_FIXED );
   pdef->addValue( "ensemble", VALTYPE_OPTION );
@@ -235,6 +792,15 @@ void params_mod_sort_( csParamDef* pdef ) {
   pdef->addValue( "simple", VALTYPE_OPTION );
   pdef->addOption( "simple", "Simplest sort method. Fastest for small and partially pre-sorted data sets" );
   pdef->addOption( "tree", "Tree sorting method. Most efficient for large, totally un-sorted data sets" );
+
+  pdef->addParam( "memory", "Memory limit for out-of-core sort", NUM_VALUES_FIXED,
+                  "All input traces are sorted at once, ensembles are ignored. Input traces are collected in runs of up to the given memory size. " \
+                  "Each run is sorted and spilled to a temporary file, while the next run is collected. At the end, all runs are merged. " \
+                  "During the merge, a background thread reads ahead the next chunk of traces from each temporary file." );
+  pdef->addValue( "", VALTYPE_NUMBER, "Maximum memory used to buffer input traces [MB]" );
+
+  pdef->addParam( "temp_dir", "Directory for temporary files written by out-of-core sort", NUM_VALUES_FIXED );
+  pdef->addValue( "/tmp", VALTYPE_STRING, "Directory name" );
 }
 
 
@@ -88,9 +88,6 @@ void compute_s1s2_splitting_stacks( float** samples, float const* sr_azim, int n
     float angleWidthOmit, int normMethod, int s2Scaling, int nAngles, float angleInc,
     float** s1, float** s2 );
 
-  void compute_twosided_correlation2( float const* samplesLeft, float const* samplesRight,
-                                   int nSampIn, float* corr, int maxlag_in_num_samples );
-
 //*************************************************************************************************
 // Init phase
 //
@@ -523,7 +520,7 @@ void exec_mod_splitting_(
       double* val22 = new double[vars->nAngles];
       for( int iangle = 0; iangle < vars->nAngles; iangle++ ) {
         // Cross-correlate S1 & S2 trace for each tested S1 angle
-        compute_twosided_correlation2(
+        compute_twosided_correlation(
                           &vars->s1[iangle][startIndex],
                           &vars->s2[iangle][startIndex],
                           nSampIn,
@@ -854,40 +851,5 @@ void compute_s1s2_splitting_stacks( float** samples, float const* sr_azim, int n
 
 }
 
-  void compute_twosided_correlation2( float const* samplesLeft, float const* samplesRight,
-                                   int nSampIn, float* corr, int maxlag_in_num_samples ) {
-
-    int sampStart;
-    int sampEnd;
-
-    //---------------------------------------
-    // Compute negative lags
-    //
-    sampEnd    = nSampIn;
-    for( int ilag = -maxlag_in_num_samples; ilag < 0; ilag++ ) {
-      sampStart  = -ilag;
-      float sum = 0;
-      for( int isamp = sampStart; isamp < sampEnd; isamp++ ) {
-        sum += samplesLeft[isamp]*samplesRight[isamp+ilag];
-      }
-      //      int nSamp = sampEnd-sampStart;
-//      corr[ilag+maxlag_in_num_samples] = sum/(float)nSamp;
-      corr[ilag+maxlag_in_num_samples] = sum;
-    }
-
-    //---------------------------------------
-    // Compute positive lags
-    //
-    sampStart  = 0;
-    for( int ilag = 0; ilag <= maxlag_in_num_samples; ilag++ ) {
-      sampEnd    = nSampIn-ilag;
-      float sum = 0;
-      for( int isamp = sampStart; isamp < sampEnd; isamp++ ) {
-        sum += samplesLeft[isamp]*samplesRight[isamp+ilag];
-      }
-      //      int nSamp = sampEnd-sampStart;
-      corr[ilag+maxlag_in_num_samples] = sum;
-    }
-  }
 
 
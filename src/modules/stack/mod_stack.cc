@@ -29,6 +29,9 @@ namespace mod_stack {
     int hdrId_fold;
     float normFactor;
     cseis_system::csStackUtil* stackUtil;
+    int outputOption;
+    bool normTimeVariant;
+    bool outputNormTrace;
     bool isFirstCall;
   }; 
   static int const MODE_ENSEMBLE = 11;
@@ -91,6 +94,8 @@ void init_mod_stack_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* l
   if( !text.compare("ensemble") ) {
     vars->mode = MODE_ENSEMBLE;
     edef->setTraceSelectionMode( TRCMODE_ENSEMBLE );
+    // Each ensemble is stacked independently. Other modes buffer stacked traces across calls
+    edef->setThreadSafe( true );
   }
   else if( !text.compare("all") ) {
     vars->mode = MODE_ALL;
@@ -155,6 +160,9 @@ void init_mod_stack_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* l
     vars->hdrId_stack = hdef->headerIndex( text );
   }
 
+  vars->outputOption    = outputOption;
+  vars->normTimeVariant = normTimeVariant;
+  vars->outputNormTrace = outputNormTrace;
   vars->stackUtil = new csStackUtil( shdr->numSamples, vars->normFactor, outputOption );
   vars->stackUtil->setTimeVariantNorm( normTimeVariant, vars->hdrId_stack );
   vars->stackUtil->setOutputNormTrace( outputNormTrace );
@@ -364,6 +372,27 @@ void exec_mod_stack_(
   }
 }
 
+//*************************************************************************************************
+// Clone: Ensemble mode only. Stack utility holds normalisation buffers, create new one for each thread
+//
+//*************************************************************************************************
+void clone_mod_stack_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( env->execPhaseDef->variables() );
+  csSuperHeader const* shdr = env->superHeader;
+  VariableStruct* varsClone = new VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  *varsClone = *vars;
+  varsClone->stackedTraces        = NULL;
+  varsClone->stackTraceList       = NULL;
+  varsClone->hdrValueList         = NULL;
+  varsClone->numStackedTracesList = NULL;
+  varsClone->stackUtil = new csStackUtil( shdr->numSamples, vars->normFactor, vars->outputOption );
+  varsClone->stackUtil->setTimeVariantNorm( vars->normTimeVariant, vars->hdrId_stack );
+  varsClone->stackUtil->setOutputNormTrace( vars->outputNormTrace );
+}
+
 //*************************************************************************************************
 // Parameter definition
 //
@@ -407,6 +436,9 @@ extern "C" void _params_mod_stack_( csParamDef* pdef ) {
 extern "C" void _init_mod_stack_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_stack_( param, env, log );
 }
+extern "C" void _clone_mod_stack_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_stack_( env, envClone );
+}
 extern "C" void _exec_mod_stack_( csTraceGather* traceGather, int* port, int* numTrcToKeep, csExecPhaseEnv* env, csLogWriter* log ) {
   exec_mod_stack_( traceGather, port, numTrcToKeep, env, log );
 }
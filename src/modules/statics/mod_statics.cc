@@ -166,6 +166,7 @@ void init_mod_statics_( csParamManager* param, csInitPhaseEnv* env, csLogWriter*
   vars->buffer = new float[shdr->numSamples];
   vars->hdrID_time_samp1_s  = hdef->headerIndex( HDR_TIME_SAMP1.name );
   vars->hdrID_time_samp1_us = hdef->headerIndex( HDR_TIME_SAMP1_US.name );
+  edef->setThreadSafe( true );
 }
 
 //*************************************************************************************************
@@ -263,6 +264,23 @@ bool exec_mod_statics_(
   return true;
 }
 
+//*************************************************************************************************
+// Clone method
+// Create module variables for another thread: Copy parameters, allocate separate work buffers
+//
+//*************************************************************************************************
+void clone_mod_statics_( csExecPhaseEnv* env, csExecPhaseEnv* envClone )
+{
+  VariableStruct* vars = reinterpret_cast<VariableStruct*>( env->execPhaseDef->variables() );
+  csSuperHeader const* shdr = env->superHeader;
+  VariableStruct* varsClone = new VariableStruct();
+  envClone->execPhaseDef->setVariables( varsClone );
+
+  *varsClone = *vars;
+  varsClone->buffer = new float[shdr->numSamples];
+  if( vars->interpol != NULL ) varsClone->interpol = new csInterpolation( *vars->interpol );
+}
+
 //*************************************************************************************************
 // Parameter definition
 //
@@ -302,6 +320,9 @@ extern "C" void _params_mod_statics_( csParamDef* pdef ) {
 extern "C" void _init_mod_statics_( csParamManager* param, csInitPhaseEnv* env, csLogWriter* log ) {
   init_mod_statics_( param, env, log );
 }
+extern "C" void _clone_mod_statics_( csExecPhaseEnv* env, csExecPhaseEnv* envClone ) {
+  clone_mod_statics_( env, envClone );
+}
 extern "C" bool _exec_mod_statics_( csTrace* trace, int* port, csExecPhaseEnv* env, csLogWriter* log ) {
   return exec_mod_statics_( trace, port, env, log );
 }
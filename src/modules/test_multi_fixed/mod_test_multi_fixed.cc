@@ -3,6 +3,8 @@
 
 #include "cseis_includes.h"
 #include <cstdio>
+#include <cmath>
+#include <cstring>
 
 using namespace cseis_system;
 using namespace cseis_geolib;
@@ -17,6 +19,14 @@ namespace mod_test_multi_fixed {
     int repeat;
     int skip;
     int hdrId_bias;
+    int hdrId_check;
+    double lastCheckValue;
+    bool isFirstTrace;
+    int numTracesKept;
+    /// Maximum sample difference within each input trace pair. <0: Do not compare traces
+    float maxDiff;
+    /// true if maxDiff is relative to maximum absolute amplitude of first trace in pair
+    bool isRelativeDiff;
   };
 }
 using mod_test_multi_fixed::VariableStruct;
@@ -42,6 +52,12 @@ void init_mod_test_multi_fixed_( csParamManager* param, csInitPhaseEnv* env, csL
   vars->repeat          = 0;
   vars->skip            = 0;
   vars->hdrId_bias      = -1;
+  vars->hdrId_check     = -1;
+  vars->lastCheckValue  = 0;
+  vars->isFirstTrace    = true;
+  vars->numTracesKept   = 0;
+  vars->maxDiff         = -1;
+  vars->isRelativeDiff  = false;
 
   edef->setExecType( EXEC_TYPE_MULTITRACE );
 
@@ -76,6 +92,38 @@ void init_mod_test_multi_fixed_( csParamManager* param, csInitPhaseEnv* env, csL
     }
   }
 
+  if( param->exists("check_order") ) {
+    string headerName;
+    param->getString("check_order", &headerName );
+    if( !hdef->headerExists( headerName ) ) {
+      log->error("Trace header '%s' does not exist", headerName.c_str());
+    }
+    vars->hdrId_check = hdef->headerIndex( headerName );
+  }
+
+  if( param->exists("check_diff") ) {
+    param->getFloat("check_diff", &vars->maxDiff );
+    if( vars->maxDiff < 0 ) {
+      log->error("Incorrect entry for maximum sample difference: %f", vars->maxDiff);
+    }
+    if( param->getNumValues("check_diff") > 1 ) {
+      string text;
+      param->getString("check_diff", &text, 1 );
+      if( !text.compare("relative") ) {
+        vars->isRelativeDiff = true;
+      }
+      else if( !text.compare("absolute") ) {
+        vars->isRelativeDiff = false;
+      }
+      else {
+        log->error("Unknown option: '%s'", text.c_str());
+      }
+    }
+    if( vars->numTraces % 2 != 0 || vars->numTracesToRoll != 0 ) {
+      log->error("Comparison of trace pairs requires an even number of input traces, and no rolling of traces");
+    }
+  }
+
   if( vars->numTracesToAdd != 0 && vars->numTracesToRoll != 0 ) {
     log->error("Cannot add and roll traces at the same time... Specify one at a time");
   }
@@ -115,6 +163,42 @@ void exec_mod_test_multi_fixed_(
   }
 
   int numTracesIn = traceGather->numTraces();
+  if( vars->hdrId_check >= 0 ) {
+    // Traces kept in the previous call have already been checked
+    for( int itrc = vars->numTracesKept; itrc < numTracesIn; itrc++ ) {
+      double value = traceGather->trace(itrc)->getTraceHeader()->doubleValue( vars->hdrId_check );
+      if( !vars->isFirstTrace && value <= vars->lastCheckValue ) {
+        log->error("Input traces are out of order: Trace header '%s' = %f follows %f", hdef->headerName( vars->hdrId_check ).c_str(), value, vars->lastCheckValue);
+      }
+      vars->lastCheckValue = value;
+      vars->isFirstTrace   = false;
+    }
+  }
+  if( vars->maxDiff >= 0 ) {
+    if( numTracesIn % 2 != 0 ) {
+      log->error("Odd number of input traces (%d): Cannot compare trace pairs", numTracesIn);
+    }
+    for( int itrc = 0; itrc < numTracesIn; itrc += 2 ) {
+      float const* samples1 = traceGather->trace(itrc)->getTraceSamples();
+      float const* samples2 = traceGather->trace(itrc+1)->getTraceSamples();
+      double maxDiff = vars->maxDiff;
+      if( vars->isRelativeDiff ) {
+        double maxAbs = 0;
+        for( int isamp = 0; isamp < shdr->numSamples; isamp++ ) {
+          if( fabs(samples1[isamp]) > maxAbs ) maxAbs = fabs(samples1[isamp]);
+        }
+        maxDiff *= maxAbs;
+      }
+      for( int isamp = 0; isamp < shdr->numSamples; isamp++ ) {
+        double diff = fabs( (double)samples2[isamp] - (double)samples1[isamp] );
+        // Zero difference: Require bit-identical samples
+        if( diff > maxDiff || (vars->maxDiff == 0 && memcmp( &samples1[isamp], &samples2[isamp], sizeof(float) ) != 0) ) {
+          log->error("Input trace pair #%d differs at sample #%d: %.9g vs %.9g (maximum difference: %g)",
+                     itrc/2+1, isamp+1, samples1[isamp], samples2[isamp], maxDiff);
+        }
+      }
+    }
+  }
   int numTracesOut;
   if( numTracesIn == vars->numTraces && !edef->isLastCall() ) {
     numTracesOut = numTracesIn - vars->numTracesToRoll;
@@ -124,6 +208,7 @@ void exec_mod_test_multi_fixed_(
     numTracesOut = numTracesIn;
     *numTrcToKeep = 0;
   }
+  vars->numTracesKept = *numTrcToKeep;
 
   if( edef->isDebug() ) {
     log->line("Number of input traces: %d, last call: %d", numTracesIn, edef->isLastCall());
@@ -187,6 +272,16 @@ void params_mod_test_multi_fixed_( csParamDef* pdef ) {
 
   pdef->addParam( "repeat", "Number of times to repeat", NUM_VALUES_FIXED );
   pdef->addValue( "0", VALTYPE_NUMBER, "Number of times to repeat each processing" );
+
+  pdef->addParam( "check_order", "Check order of input traces", NUM_VALUES_FIXED, "Terminate flow if the given trace header does not increase from one input trace to the next" );
+  pdef->addValue( "", VALTYPE_STRING, "Trace header name" );
+
+  pdef->addParam( "check_diff", "Compare pairs of input traces", NUM_VALUES_VARIABLE,
+                  "Terminate flow if any sample of the second trace in a pair differs from the first trace by more than the given value. Requires an even number of input traces" );
+  pdef->addValue( "0", VALTYPE_NUMBER, "Maximum sample difference. Specify 0 to require identical samples" );
+  pdef->addValue( "absolute", VALTYPE_OPTION );
+  pdef->addOption( "absolute", "Maximum absolute difference" );
+  pdef->addOption( "relative", "Maximum difference relative to the maximum absolute amplitude of the first trace in each pair" );
 }
 
 extern "C" void _params_mod_test_multi_fixed_( csParamDef* pdef ) {
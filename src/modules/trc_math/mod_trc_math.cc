@@ -4,10 +4,11 @@
 #include "cseis_includes.h"
 #include <cmath>
 #include <cstring>
+#include <algorithm>
 #include "csToken.h"
 #include "csVector.h"
 #include "csEquationSolver.h"
-#include "csSort.h"
+#include "csSlidingMedian.h"
 
 using namespace cseis_system;
 using namespace cseis_geolib;
@@ -25,7 +26,9 @@ namespace mod_trc_math {
     float value;
     bool isAdd;
     cseis_geolib::csEquationSolver* solver;
-    double* userConstantValues;
+    double* sampleValues;   // Input sample values, converted to double
+    double* resultValues;   // Equation result for each sample
+    double const** userConstantValues;  // Values for each user constant: All point to sampleValues
     int  numVariables;
     int option;
     bool isGradient;
@@ -36,7 +39,7 @@ namespace mod_trc_math {
     bool isMedianFilt;
     int numSampMedianFilt;
     int numSampMedianFiltALL;
-    cseis_geolib::csSort<float>* sortObj;
+    cseis_geolib::csSlidingMedian* median;
     float* medianBuffer;
   };
   static int const OPTION_NONE     = 0;
@@ -47,7 +50,8 @@ namespace mod_trc_math {
 }
 using namespace mod_trc_math;
 
-// BUGFIX 080805  TRC_MATH was only working correctly if sample variable 'x' was used once. Fixed now. However, inefficient. Should set data values only once...
+// BUGFIX 080805  TRC_MATH was only working correctly if sample variable 'x' was used once. Fixed now.
+// Equation is solved for all samples at once, in batch mode
 
 //*************************************************************************************************
 // Init phase
@@ -72,6 +76,8 @@ void init_mod_trc_math_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
   vars->solver          = NULL;
   vars->numVariables    = 0;
   vars->userConstantValues = NULL;
+  vars->sampleValues    = NULL;
+  vars->resultValues    = NULL;
   vars->dbScalar = 10.0;
   vars->buffer = NULL;
   vars->medianBuffer = NULL;
@@ -79,7 +85,7 @@ void init_mod_trc_math_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
   vars->isMedianFilt = false;
   vars->numSampMedianFilt = 0;
   vars->numSampMedianFiltALL = 0;
-  vars->sortObj = NULL;
+  vars->median = NULL;
 
   if( param->exists("gradient") ) {
     vars->isGradient = true;
@@ -93,8 +99,7 @@ void init_mod_trc_math_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
     vars->numSampMedianFilt = (int)( 0.5 * length / shdr->sampleInt );
     vars->numSampMedianFiltALL = 2*vars->numSampMedianFilt + 1;
     log->line("Length of median filter = %d samples  (%f)", 2*vars->numSampMedianFilt+1, length );
-    vars->sortObj = new csSort<float>();
-    vars->buffer = new float[shdr->numSamples];
+    vars->median = new csSlidingMedian( vars->numSampMedianFiltALL );
     vars->medianBuffer = new float[shdr->numSamples];
   }
   if( param->exists("add") ) {
@@ -144,13 +149,16 @@ void init_mod_trc_math_( csParamManager* param, csInitPhaseEnv* env, csLogWriter
     vars->solver->prepareUserConstants( &constList );
 
     vars->numVariables = constList.size();
-    vars->userConstantValues = new double[vars->numVariables];
+    vars->sampleValues = new double[shdr->numSamples];
+    vars->resultValues = new double[shdr->numSamples];
+    vars->userConstantValues = new double const*[std::max(vars->numVariables,1)];
     for( int ivar = 0; ivar < vars->numVariables; ivar++ ) {
       if( constList.at(ivar).compare("x") ) {
         log->error("Unknown variable name in equation: '%s'. Use variable 'x' to reference sample value.", constList.at(ivar).c_str() );
         env->addError();
       }
       if( edef->isDebug() ) log->line("Variable #%d: %s", ivar, constList.at(ivar).c_str() );
+      vars->userConstantValues[ivar] = vars->sampleValues;
     }
   }
 }
@@ -178,15 +186,23 @@ bool exec_mod_trc_math_(
       delete [] vars->userConstantValues;
       vars->userConstantValues = NULL;
     }
+    if( vars->sampleValues != NULL ) {
+      delete [] vars->sampleValues;
+      vars->sampleValues = NULL;
+    }
+    if( vars->resultValues != NULL ) {
+      delete [] vars->resultValues;
+      vars->resultValues = NULL;
+    }
     if( vars->buffer != NULL ) {
       delete [] vars->buffer; vars->buffer = NULL;
     }
     if( vars->medianBuffer != NULL ) {
       delete [] vars->medianBuffer; vars->medianBuffer = NULL;
     }
-    if( vars->sortObj != NULL ) {
-      delete vars->sortObj;
-      vars->sortObj = NULL;
+    if( vars->median != NULL ) {
+      delete vars->median;
+      vars->median = NULL;
     }
     delete vars; vars = NULL;
     return true;
@@ -197,26 +213,12 @@ bool exec_mod_trc_math_(
 
 
   if( vars->solver != NULL ) {
-    if( vars->numVariables == 1 ) {
-      for( int isamp = 0; isamp < nSamples; isamp++ ) {
-        vars->userConstantValues[0] = (double)samples[isamp];
-        vars->solver->setUserConstants( vars->userConstantValues, 1 );
-        samples[isamp] = (float)vars->solver->solve();
-      }
-    }
-    else if( vars->numVariables > 1 ) {
-      for( int isamp = 0; isamp < nSamples; isamp++ ) {
-        for( int ivar = 0; ivar < vars->numVariables; ivar++ ) {
-          vars->userConstantValues[ivar] = (double)samples[isamp];
-        }
-        vars->solver->setUserConstants( vars->userConstantValues, vars->numVariables );
-        samples[isamp] = (float)vars->solver->solve();
-      }
+    for( int isamp = 0; isamp < nSamples; isamp++ ) {
+      vars->sampleValues[isamp] = (double)samples[isamp];
     }
-    else {
-      for( int isamp = 0; isamp < nSamples; isamp++ ) {
-        samples[isamp] = (float)vars->solver->solve();
-      }
+    vars->solver->solve( nSamples, vars->userConstantValues, vars->resultValues );
+    for( int isamp = 0; isamp < nSamples; isamp++ ) {
+      samples[isamp] = (float)vars->resultValues[isamp];
     }
   }
 
@@ -239,13 +241,17 @@ bool exec_mod_trc_math_(
   }
 
   if( vars->isMedianFilt ) {
+    vars->median->clear();
+    for( int isamp = 0; isamp < std::min( vars->numSampMedianFiltALL-1, nSamples ); isamp++ ) {
+      vars->median->push( samples[isamp] );
+    }
     for( int isamp = vars->numSampMedianFilt; isamp < nSamples-vars->numSampMedianFilt; isamp++ ) {
-      int index1 = isamp-vars->numSampMedianFilt;
-      memcpy( vars->buffer, &samples[index1], vars->numSampMedianFiltALL * sizeof(float) );
-      vars->sortObj->treeSort( vars->buffer, vars->numSampMedianFiltALL );
-      vars->medianBuffer[isamp] = vars->buffer[vars->numSampMedianFilt];
+      vars->median->push( samples[isamp+vars->numSampMedianFilt] );
+      vars->medianBuffer[isamp] = vars->median->value();
+    }
+    if( nSamples > 2*vars->numSampMedianFilt ) {
+      memcpy( &samples[vars->numSampMedianFilt], &vars->medianBuffer[vars->numSampMedianFilt],  (nSamples-2*vars->numSampMedianFilt) * sizeof(float) );
     }
-    memcpy( &samples[vars->numSampMedianFilt], &vars->medianBuffer[vars->numSampMedianFilt],  (nSamples-vars->numSampMedianFilt) * sizeof(float) );
   }
 
   if( (vars->option & OPTION_FLIP) != 0 ) {
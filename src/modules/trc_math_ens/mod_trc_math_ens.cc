@@ -28,7 +28,8 @@ namespace mod_trc_math_ens {
     cseis_system::csTraceGather* gather;
     bool isFirstCall;
     cseis_geolib::csEquationSolver* solver;
-    double* userVarValues;
+    double** userVarValues;  // Sample values for each user constant, converted to double
+    double* resultValues;    // Equation result for each sample
     int  numVariables;
     int* varIndexList;
   };
@@ -54,7 +55,7 @@ void init_mod_trc_math_ens_( csParamManager* param, csInitPhaseEnv* env, csLogWr
 {
   csTraceHeaderDef* hdef = env->headerDef;
   csExecPhaseDef*   edef = env->execPhaseDef;
-//  csSuperHeader*    shdr = env->superHeader;
+  csSuperHeader*    shdr = env->superHeader;
   VariableStruct* vars = new VariableStruct();
   edef->setVariables( vars );
   edef->setExecType( EXEC_TYPE_MULTITRACE );
@@ -70,6 +71,7 @@ void init_mod_trc_math_ens_( csParamManager* param, csInitPhaseEnv* env, csLogWr
   vars->solver = NULL;
   vars->numVariables = 0;
   vars->userVarValues = NULL;
+  vars->resultValues  = NULL;
   vars->varIndexList = NULL;
 
   int numTracesFixed = 0;
@@ -174,7 +176,11 @@ void init_mod_trc_math_ens_( csParamManager* param, csInitPhaseEnv* env, csLogWr
     vars->solver->prepareUserConstants( &constList );
 
     vars->numVariables = constList.size();
-    vars->userVarValues = new double[vars->numVariables];
+    vars->userVarValues = new double*[vars->numVariables];
+    for( int ivar = 0; ivar < vars->numVariables; ivar++ ) {
+      vars->userVarValues[ivar] = new double[shdr->numSamples];
+    }
+    vars->resultValues = new double[shdr->numSamples];
     vars->varIndexList = new int[vars->numVariables];
 
     if( vars->numVariables != numTraces ) {
@@ -201,6 +207,8 @@ void init_mod_trc_math_ens_( csParamManager* param, csInitPhaseEnv* env, csLogWr
       vars->varIndexList[ivar] = traceNum-1;
     }
   }
+  // Other methods only read module variables. Rolling mean buffers ensembles across calls, the equation solver holds scratch values
+  edef->setThreadSafe( vars->method != mod_trc_math_ens::METHOD_ROLL_MEAN && vars->method != mod_trc_math_ens::METHOD_EQUATION );
 
 
 }
@@ -228,9 +236,16 @@ void exec_mod_trc_math_ens_(
       delete vars->solver; vars->solver = NULL;
     }
     if( vars->userVarValues != NULL ) {
+      for( int ivar = 0; ivar < vars->numVariables; ivar++ ) {
+        delete [] vars->userVarValues[ivar];
+      }
       delete [] vars->userVarValues;
       vars->userVarValues = NULL;
     }
+    if( vars->resultValues != NULL ) {
+      delete [] vars->resultValues;
+      vars->resultValues = NULL;
+    }
     if( vars->varIndexList != NULL ) {
       delete [] vars->varIndexList;
       vars->varIndexList = NULL;
@@ -349,13 +364,16 @@ void exec_mod_trc_math_ens_(
     }
     float* samplesOut = traceGather->trace(0)->getTraceSamples();
     int nSamples = shdr->numSamples;
-    for( int isamp = 0; isamp < nSamples; isamp++ ) {
-      for( int ivar = 0; ivar < vars->numVariables; ivar++ ) {
-	float* samples = traceGather->trace(ivar)->getTraceSamples();
-	vars->userVarValues[ vars->varIndexList[ivar] ] = (double)samples[isamp];
+    for( int ivar = 0; ivar < vars->numVariables; ivar++ ) {
+      float const* samples = traceGather->trace(ivar)->getTraceSamples();
+      double* values = vars->userVarValues[ vars->varIndexList[ivar] ];
+      for( int isamp = 0; isamp < nSamples; isamp++ ) {
+        values[isamp] = (double)samples[isamp];
       }
-      vars->solver->setUserConstants( vars->userVarValues, vars->numVariables );
-      samplesOut[isamp] = (float)vars->solver->solve();
+    }
+    vars->solver->solve( nSamples, vars->userVarValues, vars->resultValues );
+    for( int isamp = 0; isamp < nSamples; isamp++ ) {
+      samplesOut[isamp] = (float)vars->resultValues[isamp];
     }
     traceGather->freeTraces( 1, traceGather->numTraces()-1 );
   }
@@ -155,7 +155,7 @@ bool exec_mod_trc_print_(
   }
 
   //  log->line("TRC_PRINT: numSamples: %d, superheader: %d",trace->numSamples(), shdr->numSamples);
-  float* samples = trace->getTraceSamples();
+  float const* samples = trace->getTraceSamplesReadOnly();
   vars->traceCounter += 1;
 
   if( vars->addBlankLine && vars->traceCounter != 1 ) fprintf(vars->fout,"\n");
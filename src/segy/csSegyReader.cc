@@ -57,6 +57,10 @@ csSegyReader::csSegyReader( std::string filename, SegyReaderConfig const& config
   myOverrideSampleFormat    = config.overrideSampleFormat;
   myEnableRandomAccess      = config.enableRandomAccess;
   myIsSUFormat              = config.isSUFormat;
+  myReadAheadDepth          = config.readAheadDepth;
+  myIsReadAheadRunning      = false;
+  myReadAheadBuffers        = NULL;
+  myReadAheadNumTraces      = NULL;
 
   myHdrCheckByteOffset = 0;
   myHdrCheckInType       = cseis_geolib::TYPE_UNKNOWN;
@@ -109,6 +113,7 @@ csSegyReader::~csSegyReader() {
     delete myIOSelection;
     myIOSelection = NULL;
   }
+  stopReadAhead();
   freeCharBinHdr();
   if( myBigBuffer ) {
     delete [] myBigBuffer;
@@ -160,6 +165,7 @@ void csSegyReader::openFile() {
 }
 //-----------------------------------------------------------------------------------------
 void csSegyReader::closeFile() {
+  stopReadAhead();
   if( myFile != NULL ) {
     myFile->close();
     // Do not clear ios flags..
@@ -486,7 +492,16 @@ bool csSegyReader::getNextTrace( byte_t* sampleBufferOut, int nSamples ) {
   //  fprintf(stdout,"SEGY %d %d:  %d  %d\n", myBufferCurrentTrace, myCurrentTraceInFile, myBufferNumTraces, myResidualNumBytesAtEnd );
   //  fflush(stdout);
 
-  if( myBufferCurrentTrace == myBufferNumTraces ) {
+  if( myReadAheadDepth > 0 && !myIsReadAheadRunning && myBufferCurrentTrace == myBufferNumTraces ) {
+    startReadAhead();
+  }
+  if( myIsReadAheadRunning ) {
+    // Traces are read in and decoded by read-ahead thread
+    if( myBufferCurrentTrace == myBufferNumTraces ) {
+      if( !nextReadAheadBuffer() ) return false;
+    }
+  }
+  else if( myBufferCurrentTrace == myBufferNumTraces ) {
     if( myFile->eof() ) {
       return false;
     }
@@ -548,36 +563,8 @@ bool csSegyReader::getNextTrace( byte_t* sampleBufferOut, int nSamples ) {
     myBufferCurrentTrace = 0;
     myCurrentTraceInFile += myBufferNumTraces;
 
-    // Perform ENDIAN processing if necessary
-    // Convert samples from endian format in input file to internal endian format
-    if( myDoSwapEndianData ) {
-      if( myDataSampleFormat != csSegyHeader::DATA_FORMAT_INT16 ) {
-        for( int itrc = 0; itrc < myBufferNumTraces; itrc++ ) {
-          swapEndian4( myBigBuffer+myTraceByteSize*itrc+csSegyHeader::SIZE_TRCHDR, nSamples*mySampleByteSize );
-        }
-      }
-      else {
-        for( int itrc = 0; itrc < myBufferNumTraces; itrc++ ) {
-          swapEndian2( myBigBuffer+myTraceByteSize*itrc+csSegyHeader::SIZE_TRCHDR, nSamples*mySampleByteSize );
-        }
-      }
-    }
-
-    // Convert sample value format if necessary
-    if( myDataSampleFormat == csSegyHeader::DATA_FORMAT_IBM ) {
-      for( int itrc = 0; itrc < myBufferNumTraces; itrc++ ) {
-        ibm2ieee( (unsigned char*)(myBigBuffer+myTraceByteSize*itrc+csSegyHeader::SIZE_TRCHDR), nSamples );
-      }
-    }
-    else if( myDataSampleFormat == csSegyHeader::DATA_FORMAT_IEEE ) {
-      // Nothing to be done here...
-    }
-    else if( myDataSampleFormat== csSegyHeader::DATA_FORMAT_INT32 ) {
-      for( int itrc = 0; itrc < myBufferNumTraces; itrc++ ) {
-        convertInt2Float( (int*)(myBigBuffer+myTraceByteSize*itrc+csSegyHeader::SIZE_TRCHDR), nSamples );
-      }
-    }
-    else if( myDataSampleFormat== csSegyHeader::DATA_FORMAT_INT16 ) {
+    decodeSamples( myBigBuffer, myBufferNumTraces, nSamples );
+    if( myDataSampleFormat == csSegyHeader::DATA_FORMAT_INT16 ) {
       //For 16bit files, only single trace is read in at once
       convertShort2Float( (short*)(myBigBuffer+csSegyHeader::SIZE_TRCHDR), (float*)sampleBufferOut, nSamples );
     }
@@ -598,6 +585,186 @@ bool csSegyReader::getNextTrace( byte_t* sampleBufferOut, int nSamples ) {
   myBufferCurrentTrace += 1;
   return true;
 }
+//--------------------------------------------------------------------------------
+// Convert data samples of all traces in buffer from endian and sample format in input file to internal float format
+// INT16 samples are only swapped here. They are converted to float when copied to the output buffer.
+//
+void csSegyReader::decodeSamples( char* buffer, int numTraces, int nSamples ) {
+  // Convert IBM samples to IEEE. Endian swapping is done in the same pass
+  if( myDataSampleFormat == csSegyHeader::DATA_FORMAT_IBM ) {
+    for( int itrc = 0; itrc < numTraces; itrc++ ) {
+      ibm2ieee( (unsigned char*)(buffer+myTraceByteSize*itrc+csSegyHeader::SIZE_TRCHDR), nSamples, myDoSwapEndianData );
+    }
+    return;
+  }
+
+  // Perform ENDIAN processing if necessary
+  // Convert samples from endian format in input file to internal endian format
+  if( myDoSwapEndianData ) {
+    if( myDataSampleFormat != csSegyHeader::DATA_FORMAT_INT16 ) {
+      for( int itrc = 0; itrc < numTraces; itrc++ ) {
+        swapEndian4( buffer+myTraceByteSize*itrc+csSegyHeader::SIZE_TRCHDR, nSamples*mySampleByteSize );
+      }
+    }
+    else {
+      for( int itrc = 0; itrc < numTraces; itrc++ ) {
+        swapEndian2( buffer+myTraceByteSize*itrc+csSegyHeader::SIZE_TRCHDR, nSamples*mySampleByteSize );
+      }
+    }
+  }
+
+  // Convert sample value format if necessary
+  if( myDataSampleFormat == csSegyHeader::DATA_FORMAT_IEEE ) {
+    // Nothing to be done here...
+  }
+  else if( myDataSampleFormat== csSegyHeader::DATA_FORMAT_INT32 ) {
+    for( int itrc = 0; itrc < numTraces; itrc++ ) {
+      convertInt2Float( (int*)(buffer+myTraceByteSize*itrc+csSegyHeader::SIZE_TRCHDR), nSamples );
+    }
+  }
+}
+
+//*******************************************************************
+//
+// Read-ahead
+// A background thread reads in and decodes the next buffers while the current buffer is being processed.
+// Buffers are used in round-robin order: The current buffer is followed by up to myReadAheadDepth filled buffers.
+// Only used for sequential access: The read-ahead thread is the only one accessing the input file while it runs.
+//
+//*******************************************************************
+
+void csSegyReader::startReadAhead() {
+  if( myEnableRandomAccess || myIOSelection != NULL || myDataSampleFormat == csSegyHeader::DATA_FORMAT_INT16 || myPeekIsInProgress ) {
+    myReadAheadDepth = 0;  // Not supported: Read traces on calling thread
+    return;
+  }
+  if( myFile->eof() ) return;
+  int numBuffers = myReadAheadDepth + 1;
+  myReadAheadBuffers   = new char*[numBuffers];
+  myReadAheadNumTraces = new int[numBuffers];
+  myReadAheadBuffers[0] = myBigBuffer;
+  for( int ibuf = 1; ibuf < numBuffers; ibuf++ ) {
+    myReadAheadBuffers[ibuf] = new char[ myBufferCapacityNumTraces * myTraceByteSize ];
+  }
+  for( int ibuf = 0; ibuf < numBuffers; ibuf++ ) {
+    myReadAheadNumTraces[ibuf] = 0;
+  }
+  // Calling thread holds last buffer. First buffer is filled first
+  myReadAheadCurrent   = numBuffers-1;
+  myReadAheadNumFilled = 0;
+  myReadAheadIsEOF     = false;
+  myReadAheadIsError   = false;
+  myReadAheadStop      = false;
+  pthread_mutex_init( &myReadAheadMutex, NULL );
+  pthread_cond_init( &myReadAheadCondFilled, NULL );
+  pthread_cond_init( &myReadAheadCondFree, NULL );
+  if( pthread_create( &myReadAheadThread, NULL, csSegyReader::readAheadThread, this ) != 0 ) {
+    throw( csException("csSegyReader::startReadAhead: Unable to create read-ahead thread") );
+  }
+  myIsReadAheadRunning = true;
+}
+void csSegyReader::stopReadAhead() {
+  if( !myIsReadAheadRunning ) return;
+  pthread_mutex_lock( &myReadAheadMutex );
+  myReadAheadStop = true;
+  pthread_cond_signal( &myReadAheadCondFree );
+  pthread_mutex_unlock( &myReadAheadMutex );
+  pthread_join( myReadAheadThread, NULL );
+  pthread_cond_destroy( &myReadAheadCondFilled );
+  pthread_cond_destroy( &myReadAheadCondFree );
+  pthread_mutex_destroy( &myReadAheadMutex );
+  myBigBuffer = myReadAheadBuffers[0];
+  for( int ibuf = 1; ibuf < myReadAheadDepth+1; ibuf++ ) {
+    delete [] myReadAheadBuffers[ibuf];
+  }
+  delete [] myReadAheadBuffers;
+  delete [] myReadAheadNumTraces;
+  myReadAheadBuffers   = NULL;
+  myReadAheadNumTraces = NULL;
+  myBufferNumTraces    = 0;
+  myBufferCurrentTrace = 0;
+  myIsReadAheadRunning = false;
+}
+void* csSegyReader::readAheadThread( void* args ) {
+  csSegyReader* reader = reinterpret_cast<csSegyReader*>( args );
+  reader->runReadAhead();
+  return NULL;
+}
+void csSegyReader::runReadAhead() {
+  int numBuffers = myReadAheadDepth + 1;
+  while( true ) {
+    pthread_mutex_lock( &myReadAheadMutex );
+    while( myReadAheadNumFilled == myReadAheadDepth && !myReadAheadStop ) {
+      pthread_cond_wait( &myReadAheadCondFree, &myReadAheadMutex );
+    }
+    if( myReadAheadStop ) {
+      pthread_mutex_unlock( &myReadAheadMutex );
+      return;
+    }
+    int index = ( myReadAheadCurrent + myReadAheadNumFilled + 1 ) % numBuffers;
+    pthread_mutex_unlock( &myReadAheadMutex );
+
+    // Buffer at 'index' is neither held by calling thread nor filled: Read into it without holding lock
+    char* buffer  = myReadAheadBuffers[index];
+    int numTraces = myBufferCapacityNumTraces;
+    int numBytesResidual = 0;
+    bool isEOF   = false;
+    bool isError = false;
+    myFile->read( buffer, myTraceByteSize*numTraces );
+    if( myFile->fail() ) {
+      if( myFile->eof() ) {
+        int numBytesRead = (int)myFile->gcount();
+        numTraces        = numBytesRead / myTraceByteSize;
+        numBytesResidual = numBytesRead % myTraceByteSize;
+        isEOF = true;
+      }
+      else {
+        numTraces = 0;
+        isError   = true;
+      }
+    }
+    if( numTraces > 0 ) {
+      decodeSamples( buffer, numTraces, myNumSamples );
+    }
+
+    pthread_mutex_lock( &myReadAheadMutex );
+    myReadAheadNumTraces[index] = numTraces;
+    if( numTraces > 0 ) myReadAheadNumFilled += 1;
+    if( isEOF ) myResidualNumBytesAtEnd = numBytesResidual;
+    myReadAheadIsEOF   = isEOF;
+    myReadAheadIsError = isError;
+    pthread_cond_signal( &myReadAheadCondFilled );
+    pthread_mutex_unlock( &myReadAheadMutex );
+    if( isEOF || isError ) return;
+  }
+}
+bool csSegyReader::nextReadAheadBuffer() {
+  int numBuffers = myReadAheadDepth + 1;
+  pthread_mutex_lock( &myReadAheadMutex );
+  while( myReadAheadNumFilled == 0 && !myReadAheadIsEOF && !myReadAheadIsError ) {
+    pthread_cond_wait( &myReadAheadCondFilled, &myReadAheadMutex );
+  }
+  if( myReadAheadNumFilled == 0 ) {
+    bool isError = myReadAheadIsError;
+    pthread_mutex_unlock( &myReadAheadMutex );
+    if( isError ) {
+      throw( csException("csSegyReader::getNextTrace: Unexpected error occurred when reading in data from input file '%s'", myFilename.c_str()) );
+    }
+    return false;
+  }
+  // Hand current buffer back to read-ahead thread, move on to next filled buffer
+  myReadAheadCurrent    = ( myReadAheadCurrent + 1 ) % numBuffers;
+  myReadAheadNumFilled -= 1;
+  myBufferNumTraces     = myReadAheadNumTraces[myReadAheadCurrent];
+  pthread_cond_signal( &myReadAheadCondFree );
+  pthread_mutex_unlock( &myReadAheadMutex );
+
+  myBigBuffer           = myReadAheadBuffers[myReadAheadCurrent];
+  myBufferCurrentTrace  = 0;
+  myCurrentTraceInFile += myBufferNumTraces;
+  return true;
+}
+//--------------------------------------------------------------------------------
 // This method returns a constant pointer to the trace buffer
 //
 float const* csSegyReader::getNextTracePointer() {
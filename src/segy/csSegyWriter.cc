@@ -205,13 +205,14 @@ void csSegyWriter::writeNextTrace( byte_t const* theBuffer, csSegyTraceHeader co
   if( nSamples == 0 || nSamples > myNumSamples ) nSamples = myNumSamples;
 
   if( myCurrentTrace == NTRACES_BUFFER || myForceToWrite ) {
+    // Convert IEEE samples to IBM. Endian swapping is done in the same pass
     if( myDataSampleFormat == csSegyHeader::DATA_FORMAT_IBM ) {
       for( int itrc = 0; itrc < myNumSavedTraces; itrc++ ) {
-        ieee2ibm( (unsigned char*)(myBigBuffer+myTotalTraceSize*itrc+csSegyHeader::SIZE_TRCHDR), nSamples );
+        ieee2ibm( (unsigned char*)(myBigBuffer+myTotalTraceSize*itrc+csSegyHeader::SIZE_TRCHDR), nSamples, myDoSwapEndian );
       }
     }
     // Convert trace header, store into trace header output array:
-    if( myDoSwapEndian ) {
+    else if( myDoSwapEndian ) {
       for( int itrc = 0; itrc < myNumSavedTraces; itrc++ ) {
         swapEndian4( myBigBuffer+myTotalTraceSize*itrc+csSegyHeader::SIZE_TRCHDR, nSamples*mySampleByteSize );
       }
@@ -89,6 +89,10 @@ int main( int argc, char** argv ) {
   //  char* flowOutputDir = NULL;
   char* flowOutputName= NULL;
   int memoryPolicy    = csMemoryPoolManager::POLICY_SPEED;
+  int numThreads      = 1;
+  int queueDepth      = 0;
+  int maxMemoryMB     = 0;
+  bool isFusion       = true;
   cseis_geolib::csCompareVector<csUserConstant> globalConstList;
 
   gl_error_stream = stderr;
@@ -121,7 +125,7 @@ int main( int argc, char** argv ) {
           return(-1);
         }
         fprintf( stderr, " SeaSeis job flow submission tool.\n");
-        fprintf( stderr, " Usage:  %s -f <jobflow> [-o <joblog> | -d <joblog_dir>] [-h] [-m <name>] [-v] [-c] [-std] [-p {speed|memory} ] [-g <const_file>] [-s <spreadsheet>]\n", argv[0] );
+        fprintf( stderr, " Usage:  %s -f <jobflow> [-o <joblog> | -d <joblog_dir>] [-h] [-m <name>] [-v] [-c] [-std] [-p {speed|memory} ] [-t <num_threads>] [-pipe <queue_depth>] [-no_fuse] [-mem <megabytes>] [-g <const_file>] [-s <spreadsheet>]\n", argv[0] );
         fprintf( stderr, " -f <flow1> <flow2> ... : File name(s) of job flow(s) to run\n");
         fprintf( stderr, " -o [<log>|stdout]      : File name of job log (defaulted to flowname.log if not specified)\n");
         fprintf( stderr, "                        : Use 'stdout' to redirect all log file output to standard output\n");
@@ -144,6 +148,10 @@ int main( int argc, char** argv ) {
         fprintf( stderr, " -std                   : Dump all standard trace headers\n");
         fprintf( stderr, " -c                     : Check for link problems and consistency of all modules' params(=help) methods.\n");
         fprintf( stderr, " -p [speed | memory]    : Set memory policy: Optimised for speed or memory.\n");
+        fprintf( stderr, " -t <num_threads>       : Number of threads used to run consecutive thread-safe single-trace modules in parallel (default: 1)\n");
+        fprintf( stderr, " -pipe <queue_depth>    : Pipelined execution: Run groups of modules in separate threads, passing on up to <queue_depth> traces between threads\n");
+        fprintf( stderr, " -no_fuse               : Do not fuse consecutive single-trace modules, i.e. pass each trace from module to module\n");
+        fprintf( stderr, " -mem <megabytes>       : Memory budget for trace samples and headers in [MB] (default: %d). Flow terminates when budget is exceeded\n", (int)csMemoryPoolManager::MAX_NUM_MEGABYTES);
         fprintf( stderr, " -no_run                : Do not run flow. This option is useful if an individual flow file is generated using option -ff\n");
         fprintf( stderr, " -init_only             : Run init phase only.\n");
         fprintf( stderr, " -no_verbose            : Do not output information messages.\n");
@@ -265,6 +273,9 @@ int main( int argc, char** argv ) {
         else if( !strcmp( argv[iArg], "-no_verbose" ) ) {
           isVerbose = false;
         }
+        else if( !strcmp( argv[iArg], "-no_fuse" ) ) {
+          isFusion = false;
+        }
         else {
           fprintf(stderr,"Unknown option '%s'\n", argv[iArg]);
           return(-1);
@@ -281,6 +292,18 @@ int main( int argc, char** argv ) {
         }
         ++iArg;
       }
+      else if ( option == 'm' && !strcmp( argv[iArg], "-mem" ) ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -mem\n");
+        }
+        maxMemoryMB = atoi( argv[iArg] );
+        if( maxMemoryMB <= 0 ) {
+          fprintf(stderr,"Invalid memory budget: '%s'. Must be a positive integer\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
       else if ( option == 'm' ) {
         ++iArg;
         std::string versionString = "";
@@ -299,6 +322,18 @@ int main( int argc, char** argv ) {
         //cseis_help( moduleName );
         return(-1);
       }
+      else if ( option == 'p' && !strcmp( argv[iArg], "-pipe" ) ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -pipe\n");
+        }
+        queueDepth = atoi( argv[iArg] );
+        if( queueDepth <= 0 ) {
+          fprintf(stderr,"Invalid queue depth: '%s'. Must be a positive integer\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
       else if ( option == 'p' ) {
         ++iArg;
         if( iArg == argc ) {
@@ -317,6 +352,18 @@ int main( int argc, char** argv ) {
         }
         ++iArg;
       }
+      else if ( option == 't' ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -%c\n", option);
+        }
+        numThreads = atoi( argv[iArg] );
+        if( numThreads <= 0 ) {
+          fprintf(stderr,"Invalid number of threads: '%s'. Must be a positive integer\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
       else if ( option == 'd' ) {
         if( !strcmp( argv[iArg], "-debug" ) ) {
           isDebug = true;
@@ -526,7 +573,7 @@ int main( int argc, char** argv ) {
 
     //--------------------------------------------------------------------------------
     try {
-      csRunManager runManager( f_log, memoryPolicy, isDebug );
+      csRunManager runManager( f_log, memoryPolicy, isDebug, numThreads, queueDepth, maxMemoryMB, isFusion );
       if( isOutputFlow ) {
         FILE* f_flow_in;
         FILE* f_flow_out;
@@ -21,6 +21,7 @@ csExecPhaseDef::csExecPhaseDef( std::string& moduleName ) {
   myIsDebug    = false;
   myTracesAreWaiting = false;
   myIsLastCall  = false;
+  myIsThreadSafe = false;
 }
 csExecPhaseDef::~csExecPhaseDef() {
 }
@@ -58,6 +59,9 @@ bool csExecPhaseDef::isLastCall() const {
 int csExecPhaseDef::getTraceMode() const {
   return traceMode;
 }
+void csExecPhaseDef::setThreadSafe( bool isThreadSafe ) {
+  myIsThreadSafe = isThreadSafe;
+}
 void csExecPhaseDef::setCleanUp( bool isCleanUp ) {
   myIsCleanup = isCleanUp;
 }
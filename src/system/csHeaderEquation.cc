@@ -0,0 +1,153 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csHeaderEquation.h"
+#include "csTraceHeaderDef.h"
+#include "csTraceHeader.h"
+#include "csTraceGather.h"
+#include "csTrace.h"
+#include "csEquationSolver.h"
+#include "csException.h"
+#include "csVector.h"
+
+using namespace cseis_system;
+
+csHeaderEquation::csHeaderEquation() {
+  mySolver        = NULL;
+  myNumVariables  = 0;
+  myVariableNames = NULL;
+  myHeaderIndex   = NULL;
+  myHeaderType    = NULL;
+  myValues        = NULL;
+  myBatchValues   = NULL;
+  myBatchCapacity = 0;
+}
+csHeaderEquation::~csHeaderEquation() {
+  freeBuffers();
+}
+void csHeaderEquation::freeBuffers() {
+  if( mySolver != NULL ) {
+    delete mySolver;
+    mySolver = NULL;
+  }
+  if( myVariableNames != NULL ) {
+    delete [] myVariableNames;
+    myVariableNames = NULL;
+  }
+  if( myHeaderIndex != NULL ) {
+    delete [] myHeaderIndex;
+    myHeaderIndex = NULL;
+  }
+  if( myHeaderType != NULL ) {
+    delete [] myHeaderType;
+    myHeaderType = NULL;
+  }
+  if( myValues != NULL ) {
+    delete [] myValues;
+    myValues = NULL;
+  }
+  if( myBatchValues != NULL ) {
+    for( int ivar = 0; ivar < myNumVariables; ivar++ ) {
+      delete [] myBatchValues[ivar];
+    }
+    delete [] myBatchValues;
+    myBatchValues = NULL;
+  }
+  myBatchCapacity = 0;
+  myNumVariables  = 0;
+}
+//--------------------------------------------------------------------
+//
+void csHeaderEquation::set( std::string const& equation, csTraceHeaderDef const* hdef, cseis_geolib::csVector<std::string>* unknownNames ) {
+  freeBuffers();
+  int numHeaders = hdef->numHeaders();
+  std::string* allHeaderNames = new std::string[numHeaders];
+  for( int ihdr = 0; ihdr < numHeaders; ihdr++ ) {
+    allHeaderNames[ihdr] = hdef->headerName(ihdr);
+  }
+  mySolver = new cseis_geolib::csEquationSolver();
+  bool success = mySolver->prepare( equation, allHeaderNames, numHeaders );
+  delete [] allHeaderNames;
+  if( !success ) {
+    throw( cseis_geolib::csException("%s", mySolver->getErrorMessage().c_str()) );
+  }
+  cseis_geolib::csVector<std::string> constList;
+  mySolver->prepareUserConstants( &constList );
+
+  myNumVariables  = constList.size();
+  myVariableNames = new std::string[myNumVariables];
+  myHeaderIndex   = new int[myNumVariables];
+  myHeaderType    = new cseis_geolib::type_t[myNumVariables];
+  myValues        = new double[myNumVariables];
+  for( int ivar = 0; ivar < myNumVariables; ivar++ ) {
+    myVariableNames[ivar] = constList.at(ivar);
+    myValues[ivar] = 0.0;
+    if( !hdef->headerExists( myVariableNames[ivar] ) ) {
+      if( unknownNames == NULL ) {
+        throw( cseis_geolib::csException("Unknown identifier in equation: '%s'", myVariableNames[ivar].c_str()) );
+      }
+      // Keep going to report all unknown identifiers at once. The variable is never read
+      unknownNames->insertEnd( myVariableNames[ivar] );
+      myHeaderIndex[ivar] = -1;
+      myHeaderType[ivar]  = cseis_geolib::TYPE_UNKNOWN;
+      continue;
+    }
+    myHeaderIndex[ivar] = hdef->headerIndex( myVariableNames[ivar] );
+    myHeaderType[ivar]  = hdef->headerType( myVariableNames[ivar] );
+    if( myHeaderType[ivar] == cseis_geolib::TYPE_STRING ) {
+      throw( cseis_geolib::csException("String trace header '%s' cannot be used in equation", myVariableNames[ivar].c_str()) );
+    }
+  }
+}
+std::string const& csHeaderEquation::variableName( int index ) const {
+  return myVariableNames[index];
+}
+//--------------------------------------------------------------------
+//
+inline double csHeaderEquation::headerValue( csTraceHeader const* trcHeader, int ivar ) const {
+  csTraceHeaderData const* data = trcHeader->myTraceHeaderData;
+  int index = myHeaderIndex[ivar];
+  switch( myHeaderType[ivar] ) {
+  case cseis_geolib::TYPE_FLOAT:
+    return (double)data->floatValue( index );
+  case cseis_geolib::TYPE_DOUBLE:
+    return data->doubleValue( index );
+  case cseis_geolib::TYPE_INT:
+    return (double)data->intValue( index );
+  case cseis_geolib::TYPE_INT64:
+    return (double)data->int64Value( index );
+  default:
+    return 0.0;
+  }
+}
+double csHeaderEquation::solve( csTraceHeader const* trcHeader ) {
+  for( int ivar = 0; ivar < myNumVariables; ivar++ ) {
+    myValues[ivar] = headerValue( trcHeader, ivar );
+  }
+  mySolver->setUserConstants( myValues, myNumVariables );
+  return mySolver->solve();
+}
+void csHeaderEquation::solve( csTraceGather const* gather, double* results ) {
+  int numTraces = gather->numTraces();
+  if( numTraces > myBatchCapacity ) {
+    if( myBatchValues == NULL ) {
+      myBatchValues = new double*[myNumVariables];
+    }
+    else {
+      for( int ivar = 0; ivar < myNumVariables; ivar++ ) {
+        delete [] myBatchValues[ivar];
+      }
+    }
+    for( int ivar = 0; ivar < myNumVariables; ivar++ ) {
+      myBatchValues[ivar] = new double[numTraces];
+    }
+    myBatchCapacity = numTraces;
+  }
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    csTraceHeader const* trcHeader = gather->trace(itrc)->getTraceHeader();
+    for( int ivar = 0; ivar < myNumVariables; ivar++ ) {
+      myBatchValues[ivar][itrc] = headerValue( trcHeader, ivar );
+    }
+  }
+  mySolver->solve( numTraces, myBatchValues, results );
+}
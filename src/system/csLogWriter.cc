@@ -16,14 +16,17 @@ csLogWriter::csLogWriter( char const* filename ) : myFilename( filename ), myIsO
     }
     myIsOpenedLocally = true;
   }
+  pthread_mutex_init( &myMutex, NULL );
 }
 csLogWriter::csLogWriter( FILE* file ) : myFilename( "Unknown" ), myIsOpenedLocally( false ) {
   myLogFile = file;
+  pthread_mutex_init( &myMutex, NULL );
 }
 csLogWriter::csLogWriter() {
   myFilename = NULL;
   myIsOpenedLocally = false;
   myLogFile = stdout;
+  pthread_mutex_init( &myMutex, NULL );
 }
 //-----------------------------------------
 csLogWriter::~csLogWriter() {
@@ -31,10 +34,12 @@ csLogWriter::~csLogWriter() {
     fclose( myLogFile );
     myLogFile = NULL;
   }
+  pthread_mutex_destroy( &myMutex );
 }
 //-----------------------------------------
 void csLogWriter::line( char const* text, ... ) {
   if( myLogFile ) {
+    pthread_mutex_lock( &myMutex );
     va_list argList;
     va_start( argList, text );
     vfprintf( myLogFile, text, argList );
@@ -42,32 +47,38 @@ void csLogWriter::line( char const* text, ... ) {
 #ifdef CS_DEBUG
     fflush(myLogFile);
 #endif
+    pthread_mutex_unlock( &myMutex );
   }
 }
 //-----------------------------------------
 void csLogWriter::write( char const* text, ... ) {
   if( myLogFile ) {
+    pthread_mutex_lock( &myMutex );
     va_list argList;
     va_start( argList, text );
     vfprintf( myLogFile, text, argList );
   #ifdef CS_DEBUG
     fflush(myLogFile);
   #endif
+    pthread_mutex_unlock( &myMutex );
   }
 }
 //-----------------------------------------
 void csLogWriter::error( char const* text, ... ) {
   if( myLogFile ) {
+    pthread_mutex_lock( &myMutex );
     va_list argList;
     va_start( argList, text );
     fprintf( myLogFile, "FATAL ERROR:\n" );
     vfprintf( myLogFile, text, argList );
     fprintf( myLogFile, "\n" );
+    pthread_mutex_unlock( &myMutex );
   }
   throw( cseis_geolib::csException("Fatal error occurred. See log file for details.") );  
 }
 void csLogWriter::error( char const* moduleName, int moduleIndex, char const* text, ... ) {
   if( myLogFile ) {
+    pthread_mutex_lock( &myMutex );
     va_list argList;
     va_start( argList, text );
     if( moduleName != NULL ) {
@@ -83,23 +94,28 @@ void csLogWriter::error( char const* moduleName, int moduleIndex, char const* te
     }
     vfprintf( myLogFile, text, argList );
     fprintf( myLogFile, "\n" );
+    pthread_mutex_unlock( &myMutex );
   }
   throw( cseis_geolib::csException("Fatal error occurred. See log file for details.") );
 }
 //-----------------------------------------
 void csLogWriter::warning( char const* text, ... ) {
   if( myLogFile ) {
+    pthread_mutex_lock( &myMutex );
     va_list argList;
     va_start( argList, text );
     fprintf( myLogFile, "WARNING:\n" );
     vfprintf( myLogFile, text, argList );
     fprintf( myLogFile, "\n" );
+    pthread_mutex_unlock( &myMutex );
   }
 }
 //-----------------------------------------
 void csLogWriter::flush() {
   if( myLogFile ) {
+    pthread_mutex_lock( &myMutex );
     fflush(myLogFile);
+    pthread_mutex_unlock( &myMutex );
   }
 }
 
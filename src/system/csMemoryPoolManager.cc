@@ -6,6 +6,7 @@
 #include "csException.h"
 #include "csTrace.h"
 #include "csTracePool.h"
+#include "csSlabAllocator.h"
 #include "csTraceData.h"
 #include "csTraceHeader.h"
 #include "csTraceHeaderDef.h"
@@ -15,31 +16,34 @@
 using namespace cseis_system;
 using namespace cseis_geolib;
 
-csMemoryPoolManager::csMemoryPoolManager( int policy ) {
-  init(policy);
+csMemoryPoolManager::csMemoryPoolManager( int policy, csInt64_t maxNumMegabytes ) {
+  init( policy, maxNumMegabytes );
 }
 csMemoryPoolManager::csMemoryPoolManager() {
-  init(csMemoryPoolManager::POLICY_SPEED);
+  init( csMemoryPoolManager::POLICY_SPEED, MAX_NUM_MEGABYTES );
 }
-void csMemoryPoolManager::init( int policy ) {
+void csMemoryPoolManager::init( int policy, csInt64_t maxNumMegabytes ) {
   myPolicy = policy;
-  myTracePool = new csTracePool( myPolicy );
+  myAllocator = new csSlabAllocator( maxNumMegabytes * 1024L * 1024L, myPolicy );
+  myTracePool = new csTracePool( myPolicy, myAllocator );
   myTraceHeaderInfoPool = new csTraceHeaderInfoPool();
-  myMaxNumBytes = MAX_NUM_MEGABYTES * 1024L * 1024L;
-  myMaxNumBytesAllocated = 0;
 }
 csMemoryPoolManager::~csMemoryPoolManager() {
   if( myTracePool ) {
     delete myTracePool;
     myTracePool = NULL;
   }
+  // Delete allocator after trace pool: Traces release their memory blocks to the allocator
+  if( myAllocator ) {
+    delete myAllocator;
+    myAllocator = NULL;
+  }
   if( myTraceHeaderInfoPool ) {
     delete myTraceHeaderInfoPool;
     myTraceHeaderInfoPool = NULL;
   }
 }
 csTrace* csMemoryPoolManager::getNewTrace() {
-  checkMemory();
   //  static int counter = 0;
   //  static int const maxCount = 1;
   csTrace* trace = myTracePool->getNewTrace();
@@ -57,6 +61,9 @@ csTrace* csMemoryPoolManager::getNewTrace( csTrace const* traceOld ) {
   traceNew->getTraceDataObject()->setData( traceOld->getTraceDataObject() );
   return traceNew;
 }
+void csMemoryPoolManager::setMaxNumHeaderBytes( int numHeaderBytes ) {
+  myTracePool->setNumHeaderBytes( numHeaderBytes );
+}
 csTraceHeaderInfo const* csMemoryPoolManager::getNewTraceHeaderInfo( cseis_geolib::type_t type, std::string const& name, std::string const& description ) {
   csTraceHeaderInfo const* info = myTraceHeaderInfoPool->createTraceHeaderInfo( type, name, description );
   return info;
@@ -67,27 +74,8 @@ csTraceHeaderInfo const* csMemoryPoolManager::getNewTraceHeaderInfo( cseis_geoli
 }
 void csMemoryPoolManager::dumpSummary( FILE* fout ) const {
   myTracePool->dumpSummary( fout );
-  fprintf( fout," Total number of allocated (trace) memory:  %.2fkb  (= %.2fMb)\n",
-           (double)myMaxNumBytesAllocated/(1024.0), (double)myMaxNumBytesAllocated/(1024.0*1024.0) );
+  myAllocator->dumpSummary( fout );
 }
-bool csMemoryPoolManager::checkMemory() {
-  if( myTracePool->numAvailableTraces() > 1 ) {
-    return true;
-  }
-  csInt64_t numBytes = myTracePool->computeNumBytes();
-  if( numBytes > myMaxNumBytesAllocated ) myMaxNumBytesAllocated = numBytes;
-  //  fprintf(stderr,"Memory usage: %d traces (%d), %fkb, max allowed: %fkb\n",
-  //        myTracePool->numAvailableTraces(), myTracePool->myNumAllocatedTraces, (double)numBytes/(1024.0), (double)myMaxNumBytes/(1024.0) );
-
-  if( numBytes > myMaxNumBytes ) {
-    throw( csException("\ncsMemoryPoolManager::checkMemory(): Bytes allocated: %fkb, max allowed: %fkb\n"\
-                       "\nSeaSeis dynamically allocates traces for each module. Most trace-buffering usually occurs for multi-trace modules. " \
-                       "Modules working on 'ensembles' are most prone to buffer a large amount of traces, such as sorting, stacking... " \
-                       "In that respect, it is important that the user is aware of the correct setting of the 'ensemble trace header'. " \
-                       "The ensemble header can be set using module 'ENS_DEFINE'. All consecutive traces for which the ensemble trace header "\
-                       "value does not change constitute one ensemble.",
-                       (double)numBytes/(1024.0), (double)myMaxNumBytes/(1024.0) ) );
-  }
-  return true;
+csInt64_t csMemoryPoolManager::numBytesPerTrace( int numSamples, int numHeaderBytes ) {
+  return( csSlabAllocator::blockSize( (csInt64_t)numSamples*sizeof(float) ) + csSlabAllocator::blockSize( numHeaderBytes ) );
 }
-
@@ -212,6 +212,26 @@ void csMethodRetriever::getExecMethodMultiTrace( std::string const& name, int ve
   //  myMethodNameList.insertEnd(nameLower);
   // myExecList.insertEnd(exec);
 }
+//----------------------------------------------------------
+//
+void csMethodRetriever::getCloneMethod( std::string const& name, int verMajor, int verMinor, MClonePtr& clone ) {
+  std::string nameLower = cseis_geolib::toLowerCase( name );
+
+  char* soName     = new char[200];
+  char const* ptr  = nameLower.c_str();
+  sprintf(soName,"libas_%s.so.%d.%d",ptr,verMajor,verMinor);
+
+  void* handle = dlopen( soName, RTLD_LAZY );
+  const char *dlopen_error = dlerror();
+  delete [] soName;
+
+  if( dlopen_error ) {
+    throw( cseis_geolib::csException("Error occurred while opening shared library. ...does module '%s' exist? Does version '%d.%d' exist?\nSystem message: %s\n",
+                       name.c_str(), verMajor, verMinor, dlopen_error ) );
+  }
+
+  clone = getCloneMethod( nameLower, handle );
+}
 //
 //---------------------------------------------------------
 MExecSingleTracePtr csMethodRetriever::getExecMethodSingleTrace( std::string const& nameLower, void* handle  ) {
@@ -251,6 +271,23 @@ MExecMultiTracePtr csMethodRetriever::getExecMethodMultiTrace( std::string const
   }
   return method;
 }
+//---------------------------------------------------------
+MClonePtr csMethodRetriever::getCloneMethod( std::string const& nameLower, void* handle  ) {
+  char* methodName = new char[200];
+  sprintf( methodName, "_clone_mod_%s_", nameLower.c_str() );
+
+  MClonePtr method;
+  void *ptr = dlsym(handle,methodName);
+  memcpy(&method, &ptr, sizeof(void *));
+
+  // Clone method is optional: Return NULL if it has not been defined
+  const char *dlsym_error = dlerror();
+  delete [] methodName;
+  if( dlsym_error ) {
+    return NULL;
+  }
+  return method;
+}
 
 
 //--------------------------------------------------------------------
@@ -14,6 +14,7 @@
 #include "csMethodRetriever.h"
 #include "csExecPhaseDef.h"
 #include "csInitExecEnv.h"
+#include "csTraceRingBuffer.h"
 
 #include "csException.h"
 #include "csVector.h"
@@ -22,6 +23,11 @@
 #include "csTimer.h"
 #include "csTable.h"
 #include <cstdlib>
+#include <string>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace cseis_system;
 
@@ -40,6 +46,7 @@ void csModule::init() {
   myMethodInit  = NULL;
   myMethodExecSingleTrace = NULL;
   myMethodExecMultiTrace  = NULL;
+  myMethodClone           = NULL;
 
   myNumTracesToBePassed     = 0;
   myTotalNumProcessedTraces = 0;
@@ -56,8 +63,16 @@ void csModule::init() {
   myNumOutputPorts         = 1;
   myNumInputPorts          = 1;
   myTimeExecPhaseCPU       = 0.0;
+  myMaxNumBytesHeld        = 0;
 
   myIsFinishedProcessing = false;
+  myNumEnsemblesInQueue  = 0;
+  myLastQueuedKeyValue   = NULL;
+
+  myNumWorkers          = 1;
+  myNumGathersPerSubmit = 1;
+  myWorkerExecPhaseDef  = NULL;
+  myWorkerExecEnv       = NULL;
 
   myVersion[MAJOR] = 1;
   myVersion[MINOR] = 0;
@@ -91,6 +106,20 @@ void csModule::init() {
 //---------------------------------------------------------------------
 //
 csModule::~csModule() {
+  if( myWorkerExecEnv != NULL ) {
+    for( int iworker = 1; iworker < myNumWorkers; iworker++ ) {
+      delete myWorkerExecEnv[iworker];
+      delete myWorkerExecPhaseDef[iworker];
+    }
+    delete [] myWorkerExecEnv;
+    delete [] myWorkerExecPhaseDef;
+    myWorkerExecEnv = NULL;
+    myWorkerExecPhaseDef = NULL;
+  }
+  if( myLastQueuedKeyValue != NULL ) {
+    delete [] myLastQueuedKeyValue;
+    myLastQueuedKeyValue = NULL;
+  }
   if( myExecPhaseDef != NULL ) {
     delete myExecPhaseDef;
     myExecPhaseDef = NULL;
@@ -235,11 +264,15 @@ bool csModule::isReadyToSubmitExec( bool forceToRun ) const {
     int totalNumTraces = myTraceGather->numTraces()+myTraceQueue->size();
     if( myExecPhaseDef->traceMode == TRCMODE_FIXED ) {
       //printf("isReadyToSubmit '%s': gather ntraces %d, myExecPhase ntraces %d, queue ntraces: %d, forcetorun: %d\n", getName(), myTraceGather->numTraces(), myExecPhaseDef->numTraces, myTraceQueue->size(), forceToRun);
-      if( totalNumTraces >= myExecPhaseDef->numTraces ) return true;
+      // With several workers, wait until there are enough traces to fill one trace gather for each worker call
+      if( totalNumTraces >= myNumGathersPerSubmit*myExecPhaseDef->numTraces ) return true;
     }
     else { // if( myExecPhaseDef->traceMode == TRCMODE_ENSEMBLE ) {
 //      printf("isReadyToSubmit ENSEMBLE '%s': gather ntraces %d, myExecPhase ntraces %d, queue ntraces: %d, force: %d %d\n", getName(), myTraceGather->numTraces(), myExecPhaseDef->numTraces,  myTraceQueue->size(), forceToRun, myExecPhaseDef->tracesAreWaiting() );
-      if( mySuperHeader->numEnsembleKeys() > 0 && myIsEnsembleFull ) return true;
+      if( mySuperHeader->numEnsembleKeys() > 0 && myIsEnsembleFull ) {
+        // With several workers, wait until there are enough complete ensembles. The last ensemble in the queue may still be incomplete
+        if( myNumWorkers == 1 || myNumEnsemblesInQueue >= myNumGathersPerSubmit ) return true;
+      }
       // else: No ensemble key set --> process entire data set only at end, when forced
     }
     return( forceToRun && (totalNumTraces > 0 || myExecPhaseDef->tracesAreWaiting()) );
@@ -261,6 +294,7 @@ bool csModule::submitExecPhase(  bool forceToProcess, csLogWriter* log, int& out
   timer.start();
   int nProcessedTraces = 0;
   myExecPhaseDef->myIsLastCall = forceToProcess;
+  updateMaxNumBytesHeld( myTraceGather->numTraces()+myTraceQueue->size() );
 
   //  printf("submitExecPhase: Gather ntraces: %d  ---  Queue ntraces: %d \n", myTraceGather->numTraces(), myTraceQueue->size() );
   if( myExecPhaseDef->execType() == EXEC_TYPE_INPUT ) {
@@ -304,6 +338,10 @@ bool csModule::submitExecPhase(  bool forceToProcess, csLogWriter* log, int& out
     //fprintf(stdout,"  num trace/queue/finished: %d %d - %d\n", myTraceGather->numTraces(), myTraceQueue->size(), myIsFinishedProcessing );
   }
   //----------------------------------------------------------------------------------------
+  else if( myExecPhaseDef->execType() == EXEC_TYPE_MULTITRACE && myNumWorkers > 1 ) {
+    nProcessedTraces = submitExecPhaseWorkers( forceToProcess, log, outPort );
+  }
+  //----------------------------------------------------------------------------------------
   else if( myExecPhaseDef->execType() == EXEC_TYPE_MULTITRACE ) {
     //fprintf(stdout,"  Submit multi trace module\n");
     if( myExecPhaseDef->traceMode == TRCMODE_FIXED ) {
@@ -380,12 +418,301 @@ bool csModule::submitExecPhase(  bool forceToProcess, csLogWriter* log, int& out
   }
   myNumTracesToBePassed     += nProcessedTraces; // Add processed traces to number of traces to be passed to next module
   myTotalNumProcessedTraces += nProcessedTraces; // Accumulate number of traces processed by this module
+  updateMaxNumBytesHeld( myTraceGather->numTraces()+myTraceQueue->size() );
   myTimeExecPhaseCPU += timer.getElapsedTime();  // Accumulate exec phase CPU time
   return( nProcessedTraces > 0 );
 }
 //-------------------------------------------------------------------
 //
 //
+void csModule::updateMaxNumBytesHeld( int numTraces ) {
+  csInt64_t numBytes = (csInt64_t)numTraces * csMemoryPoolManager::numBytesPerTrace( mySuperHeader->numSamples, myHeaderDef->getTotalNumBytes() );
+  if( numBytes > myMaxNumBytesHeld ) myMaxNumBytesHeld = numBytes;
+}
+//-------------------------------------------------------------------
+//
+//
+bool csModule::isReadyToSubmitStage( bool forceToRun, int minNumTraces ) const {
+  if( myNumTracesToBePassed != 0 ) {
+    throw( cseis_geolib::csException("csModule::isReadyToSubmitStage(): Program bug? Processed traces in trace gather have not been passed yet..") );
+  }
+  int totalNumTraces = myTraceGather->numTraces()+myTraceQueue->size();
+  if( totalNumTraces >= minNumTraces ) return true;
+  return( forceToRun && totalNumTraces > 0 );
+}
+//-------------------------------------------------------------------
+//
+//
+bool csModule::submitExecPhaseStage( csModule** stageModules, int numStageModules, int numThreads, bool forceToProcess, csLogWriter* log, int& outPort ) {
+  if( stageModules[0] != this ) {
+    throw( cseis_geolib::csException("csModule::submitExecPhaseStage(): Program bug. First stage module is not the submitting module") );
+  }
+  while( !myTraceQueue->isEmpty() ) {
+    myTraceGather->addTrace( myTraceQueue->pop() );
+  }
+  int numTraces = myTraceGather->numTraces();
+  outPort = 0;
+  if( numTraces == 0 ) return false;
+  for( int imod = 0; imod < numStageModules; imod++ ) {
+    stageModules[imod]->updateMaxNumBytesHeld( numTraces );
+  }
+
+  csTrace** traces = new csTrace*[numTraces];
+  // Number of stage modules that each trace has passed. Equals numStageModules for traces that were not removed from the flow
+  int* numModulesPassed = new int[numTraces];
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    traces[itrc] = myTraceGather->trace(itrc);
+  }
+  myTraceGather->deleteTraces( 0, numTraces );
+
+  // Exec phase time, accumulated separately for each thread and module
+  double* timeExecPhase = new double[numThreads*numStageModules];
+  for( int i = 0; i < numThreads*numStageModules; i++ ) {
+    timeExecPhase[i] = 0.0;
+  }
+  bool isError = false;
+  std::string errorMessage;
+
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic) if(numThreads > 1)
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    int threadID = 0;
+#ifdef _OPENMP
+    threadID = omp_get_thread_num();
+#endif
+    csTrace* trace = traces[itrc];
+    int imod = 0;
+    try {
+      cseis_geolib::csTimer timer;
+      for( imod = 0; imod < numStageModules; imod++ ) {
+        csModule* module = stageModules[imod];
+        if( imod > 0 ) {
+          trace->getTraceHeader()->setHeaders( module->myHeaderDef, 0 );
+          trace->getTraceDataObject()->setMax( module->mySuperHeader->numSamples );
+        }
+        int port = 0;
+        timer.start();
+        csExecPhaseEnv* env = ( threadID > 0 && threadID < module->myNumWorkers ) ? module->myWorkerExecEnv[threadID] : module->myExecEnvPtr;
+        // As in submitExecPhase(): Only the last trace is the last call, when forced
+        env->execPhaseDef->myIsLastCall = ( forceToProcess && itrc == numTraces-1 );
+        bool success = (*module->myMethodExecSingleTrace)( trace, &port, env, log );
+        timeExecPhase[threadID*numStageModules+imod] += timer.getElapsedTime();
+        if( !success ) break;  // Trace shall be removed from flow
+        if( module->myHeaderDef->getIndexOfHeadersToDel()->size() > 0 ) {
+          trace->getTraceHeader()->deleteHeaders( module->myHeaderDef );
+        }
+        trace->getTraceDataObject()->set( module->mySuperHeader->numSamples );
+      }
+    }
+    catch( cseis_geolib::csException& e ) {
+#pragma omp critical
+      {
+        if( !isError ) {
+          isError = true;
+          errorMessage = std::string("Module ") + stageModules[imod]->getName() + ": " + e.getMessage();
+        }
+      }
+    }
+    catch( ... ) {
+      // Exceptions must not escape from the parallel region
+#pragma omp critical
+      {
+        if( !isError ) {
+          isError = true;
+          errorMessage = std::string("Module ") + stageModules[imod]->getName() + ": Unknown error occurred";
+        }
+      }
+    }
+    numModulesPassed[itrc] = imod;
+  }
+
+  if( isError ) {
+    for( int itrc = 0; itrc < numTraces; itrc++ ) {
+      myTraceGather->addTrace( traces[itrc] );
+    }
+    delete [] traces;
+    delete [] numModulesPassed;
+    delete [] timeExecPhase;
+    throw( cseis_geolib::csException(errorMessage) );
+  }
+
+  // Accumulate statistics for each module, as if the modules had been run one after the other
+  for( int imod = 0; imod < numStageModules; imod++ ) {
+    csModule* module = stageModules[imod];
+    for( int itrc = 0; itrc < numTraces; itrc++ ) {
+      if( numModulesPassed[itrc] >= imod ) module->myTotalNumIncomingTraces  += 1;
+      if( numModulesPassed[itrc] >  imod ) module->myTotalNumProcessedTraces += 1;
+    }
+    for( int ithread = 0; ithread < numThreads; ithread++ ) {
+      module->myTimeExecPhaseCPU += timeExecPhase[ithread*numStageModules+imod];
+    }
+    module->myIsFinishedProcessing = true;
+  }
+
+  // Pass traces to last module in stage, keeping the original trace order. Free traces that were removed from the flow
+  csModule* lastModule = stageModules[numStageModules-1];
+  int nProcessedTraces = 0;
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    if( numModulesPassed[itrc] == numStageModules ) {
+      lastModule->myTraceGather->addTrace( traces[itrc] );
+      nProcessedTraces += 1;
+    }
+    else {
+      traces[itrc]->free();
+    }
+  }
+  lastModule->myNumTracesToBePassed += nProcessedTraces;
+
+  delete [] traces;
+  delete [] numModulesPassed;
+  delete [] timeExecPhase;
+
+  return( nProcessedTraces > 0 );
+}
+//-------------------------------------------------------------------
+//
+//
+int csModule::submitExecPhaseWorkers( bool forceToProcess, csLogWriter* log, int& outPort ) {
+  // Collect trace gathers, i.e. complete ensembles or fixed number of traces. The first gather is held in the trace gather, the following ones in the trace queue
+  csTraceGather** gathers = new csTraceGather*[myNumGathersPerSubmit];
+  int numGathers = 0;
+  int numIncomingTraces = 0;
+  bool isEnsembleMode = ( myExecPhaseDef->traceMode == TRCMODE_ENSEMBLE );
+  while( numGathers < myNumGathersPerSubmit ) {
+    if( isEnsembleMode ) {
+      if( myTraceGather->numTraces() == 0 || !( myIsEnsembleFull || (forceToProcess && myTraceQueue->isEmpty()) ) ) break;
+    }
+    else {
+      while( myTraceGather->numTraces() < myExecPhaseDef->numTraces && !myTraceQueue->isEmpty() ) {
+        myTraceGather->addTrace( myTraceQueue->pop() );
+      }
+      if( myTraceGather->numTraces() == 0 || (myTraceGather->numTraces() < myExecPhaseDef->numTraces && !forceToProcess) ) break;
+    }
+    csTraceGather* gather = new csTraceGather( myMemoryPoolManager );
+    numIncomingTraces += myTraceGather->numTraces();
+    myTraceGather->moveTracesTo( 0, myTraceGather->numTraces(), gather );
+    gathers[numGathers++] = gather;
+    if( isEnsembleMode ) updateTracesEnsembleModule();
+  }
+  myTotalNumIncomingTraces += numIncomingTraces;
+  outPort = 0;
+
+  int* ports = new int[numGathers];
+  int* numTrcToKeep = new int[numGathers];
+  bool* tracesAreWaiting = new bool[numGathers];
+  bool isError = false;
+  std::string errorMessage;
+  bool isLastGather = forceToProcess && myTraceGather->numTraces() == 0 && myTraceQueue->isEmpty();
+  int numThreads = std::min( myNumWorkers, std::max( numGathers, 1 ) );
+
+  // Each gather is processed by one worker. Workers use their own exec phase environment
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+  for( int igather = 0; igather < numGathers; igather++ ) {
+    int threadID = 0;
+#ifdef _OPENMP
+    threadID = omp_get_thread_num();
+#endif
+    csExecPhaseDef* edef = myWorkerExecPhaseDef[threadID];
+    edef->myIsLastCall = isLastGather && igather == numGathers-1;
+    edef->myTracesAreWaiting = false;
+    ports[igather] = 0;
+    numTrcToKeep[igather] = 0;
+    try {
+      (*myMethodExecMultiTrace)( gathers[igather], &ports[igather], &numTrcToKeep[igather], myWorkerExecEnv[threadID], log );
+    }
+    catch( cseis_geolib::csException& e ) {
+#pragma omp critical
+      {
+        if( !isError ) {
+          isError = true;
+          errorMessage = e.getMessage();
+        }
+      }
+    }
+    catch( ... ) {
+#pragma omp critical
+      {
+        if( !isError ) {
+          isError = true;
+          errorMessage = "Unknown error occurred";
+        }
+      }
+    }
+    tracesAreWaiting[igather] = edef->myTracesAreWaiting;
+  }
+
+  // Output processed traces in input order, in front of the remaining (not yet processed) traces
+  csTraceGather* remainingTraces = new csTraceGather();
+  myTraceGather->moveTracesTo( 0, myTraceGather->numTraces(), remainingTraces );
+  int nProcessedTraces = 0;
+  for( int igather = 0; igather < numGathers; igather++ ) {
+    if( numTrcToKeep[igather] != 0 || ports[igather] != 0 || tracesAreWaiting[igather] ) {
+      if( !isError ) {
+        isError = true;
+        errorMessage = "Parallel processing requires that module outputs all traces of each input gather to port 0, without keeping any traces.";
+      }
+    }
+    nProcessedTraces += gathers[igather]->numTraces();
+    gathers[igather]->moveTracesTo( 0, gathers[igather]->numTraces(), myTraceGather );
+    delete gathers[igather];
+  }
+  remainingTraces->moveTracesTo( 0, remainingTraces->numTraces(), myTraceGather );
+  delete remainingTraces;
+  delete [] gathers;
+  delete [] ports;
+  delete [] numTrcToKeep;
+  delete [] tracesAreWaiting;
+  if( isError ) {
+    throw( cseis_geolib::csException(errorMessage) );
+  }
+
+  int numTracesLeft = myTraceGather->numTraces()-nProcessedTraces + myTraceQueue->size();
+  if( isEnsembleMode ) {
+    if( numGathers == 0 ) {
+      myIsFinishedProcessing = true;
+    }
+    if( forceToProcess && numTracesLeft != 0 ) {
+      myIsEnsembleFull = true;
+      myIsFinishedProcessing = false;
+    }
+  }
+  else {
+    myIsFinishedProcessing = !( numTracesLeft >= myNumGathersPerSubmit*myExecPhaseDef->numTraces || (forceToProcess && numTracesLeft != 0) );
+  }
+  return nProcessedTraces;
+}
+//-------------------------------------------------------------------
+//
+//
+void csModule::setNumWorkers( int numWorkers, int numGathersPerWorker ) {
+  if( myNumWorkers > 1 || numWorkers <= 1 ) return;
+  if( myExecEnvPtr == NULL ) {
+    throw( cseis_geolib::csException("csModule::setNumWorkers: Program bug: Exec phase environment has not been set up yet.") );
+  }
+  csMethodRetriever::getCloneMethod( myName, myVersion[MAJOR], myVersion[MINOR], myMethodClone );
+
+  myNumWorkers = numWorkers;
+  myNumGathersPerSubmit = numWorkers * std::max( numGathersPerWorker, 1 );
+  myWorkerExecPhaseDef = new csExecPhaseDef*[myNumWorkers];
+  myWorkerExecEnv      = new csExecPhaseEnv*[myNumWorkers];
+  myWorkerExecPhaseDef[0] = myExecPhaseDef;
+  myWorkerExecEnv[0]      = myExecEnvPtr;
+  for( int iworker = 1; iworker < myNumWorkers; iworker++ ) {
+    // Without clone method, all workers share the same module variables
+    myWorkerExecPhaseDef[iworker] = new csExecPhaseDef( *myExecPhaseDef );
+    myWorkerExecEnv[iworker] = new csExecPhaseEnv( myHeaderDef, myWorkerExecPhaseDef[iworker], mySuperHeader );
+    if( myMethodClone != NULL ) {
+      myWorkerExecPhaseDef[iworker]->varPtr = NULL;
+      (*myMethodClone)( myExecEnvPtr, myWorkerExecEnv[iworker] );
+    }
+  }
+  int numKeys = mySuperHeader->numEnsembleKeys();
+  if( myExecPhaseDef->execType() == EXEC_TYPE_MULTITRACE && myExecPhaseDef->traceMode == TRCMODE_ENSEMBLE && numKeys > 0 ) {
+    myLastQueuedKeyValue = new cseis_geolib::csFlexNumber[numKeys];
+  }
+}
+//-------------------------------------------------------------------
+//
+//
 bool csModule::submitCleanupPhase(  csLogWriter* log ) {
   myExecPhaseDef->myIsCleanup = true;
   int outPortDummy = 0;
@@ -395,6 +722,12 @@ bool csModule::submitCleanupPhase(  csLogWriter* log ) {
     case EXEC_TYPE_INPUT:
     case EXEC_TYPE_SINGLETRACE:
       if( myMethodExecSingleTrace ) {
+        if( myMethodClone != NULL ) {
+          for( int iworker = 1; iworker < myNumWorkers; iworker++ ) {
+            myWorkerExecPhaseDef[iworker]->myIsCleanup = true;
+            (*myMethodExecSingleTrace)( NULL, &outPortDummy, myWorkerExecEnv[iworker], log );
+          }
+        }
         success = (*myMethodExecSingleTrace)( NULL, &outPortDummy, myExecEnvPtr, log );
         if( !success ) log->line( "Error occurred during cleanup phase of module '%s'\nCheck that the module's exec phase function returns 'bool', not 'void'",
                                   getName() );
@@ -402,6 +735,12 @@ bool csModule::submitCleanupPhase(  csLogWriter* log ) {
       break;
     case EXEC_TYPE_MULTITRACE:
       if( myMethodExecMultiTrace ) {
+        if( myMethodClone != NULL ) {
+          for( int iworker = 1; iworker < myNumWorkers; iworker++ ) {
+            myWorkerExecPhaseDef[iworker]->myIsCleanup = true;
+            (*myMethodExecMultiTrace)( NULL, &outPortDummy, &nTracesDummy, myWorkerExecEnv[iworker], log );
+          }
+        }
         (*myMethodExecMultiTrace)( NULL, &outPortDummy, &nTracesDummy, myExecEnvPtr, log );
       }
       break;
@@ -423,11 +762,22 @@ void csModule::addNewTraceToGather( csTrace* trace, int inPort ) {
 void csModule::addNewTraceToQueue( csTrace* trace, int inPort ) {
   trace->getTraceHeader()->setHeaders( myHeaderDef, inPort );
   trace->getTraceDataObject()->setMax( mySuperHeader->numSamples );
+  if( myLastQueuedKeyValue != NULL ) {
+    // Count number of ensembles in queue
+    int numKeys = mySuperHeader->numEnsembleKeys();
+    readEnsembleKeys( trace, myHelperHdrValues );
+    bool isNewEnsemble = myTraceQueue->isEmpty();
+    for( int ikey = 0; ikey < numKeys; ikey++ ) {
+      if( myLastQueuedKeyValue[ikey] != myHelperHdrValues[ikey] ) isNewEnsemble = true;
+      myLastQueuedKeyValue[ikey] = myHelperHdrValues[ikey];
+    }
+    if( isNewEnsemble ) myNumEnsemblesInQueue += 1;
+  }
   myTraceQueue->push( trace );
 }
 //------------------------------------------------------
 //
-bool csModule::traceIsPartOfCurrentEnsemble( csTrace* trace ) {
+void csModule::readEnsembleKeys( csTrace* trace, cseis_geolib::csFlexNumber* keyValues ) const {
   csTraceHeader* trcHdrPtr = trace->getTraceHeader();
   int numKeys = mySuperHeader->numEnsembleKeys();
   for( int ikey = 0; ikey < numKeys; ikey++ ) {
@@ -436,18 +786,24 @@ bool csModule::traceIsPartOfCurrentEnsemble( csTrace* trace ) {
     if( hdrType == cseis_geolib::TYPE_INT ) {
     //        printf("Current trace ensemble header value: %d  (current ensemble: %d), num traces currently held:%d\n",
      //        trcHdrPtr->intValue(hdrIndex), myEnsembleKeyValue[0].intValue(), myTraceGather->numTraces() );
-      myHelperHdrValues[ikey].setIntValue( trcHdrPtr->intValue(hdrIndex) );
+      keyValues[ikey].setIntValue( trcHdrPtr->intValue(hdrIndex) );
     }
     else if( hdrType == cseis_geolib::TYPE_FLOAT ) {
-      myHelperHdrValues[ikey].setFloatValue( trcHdrPtr->floatValue(hdrIndex) );
+      keyValues[ikey].setFloatValue( trcHdrPtr->floatValue(hdrIndex) );
     }
     else if( hdrType == cseis_geolib::TYPE_DOUBLE ) {
-      myHelperHdrValues[ikey].setDoubleValue( trcHdrPtr->doubleValue(hdrIndex) );
+      keyValues[ikey].setDoubleValue( trcHdrPtr->doubleValue(hdrIndex) );
     }
     else if( hdrType == cseis_geolib::TYPE_STRING ) {
       throw( cseis_geolib::csException("Encountered ensemble key of type string. This is currently not supported.") );
     }
   }
+}
+//------------------------------------------------------
+//
+bool csModule::traceIsPartOfCurrentEnsemble( csTrace* trace ) {
+  int numKeys = mySuperHeader->numEnsembleKeys();
+  readEnsembleKeys( trace, myHelperHdrValues );
 
   if( myTraceGather->numTraces() > 0 ) {  // Current module already has traces in gather -> Check if ensemble header values agree
     for( int ikey = 0; ikey < numKeys; ikey++ ) {
@@ -479,6 +835,7 @@ void csModule::updateTracesEnsembleModule() {
   if( !myTraceQueue->isEmpty() ) {
     // Move first trace from queue to gather, this doesn't need check
     myTraceGather->addTrace( myTraceQueue->pop() );
+    if( myNumEnsemblesInQueue > 0 ) myNumEnsemblesInQueue -= 1;
     while( !myTraceQueue->isEmpty() ) {
       csTrace* trace = myTraceQueue->peek();
       if( traceIsPartOfCurrentEnsemble( trace ) ) {
@@ -501,59 +858,70 @@ void csModule::moveTracesFrom( csModule* module, int inPort ) {
   if( module->myNumTracesToBePassed == 0 ) {  // Does this ever occur?
     throw( cseis_geolib::csException("csModule::moveTracesFrom: No traces passed to be moved to next module. Is that good or bad?") );
   }
-
+  for( int itrc = 0; itrc < module->myNumTracesToBePassed; itrc++ ) {
+    addIncomingTrace( module->myTraceGather->trace( itrc ), inPort );
+  }
+  // Remove traces from trace gather, but DO NOT FREE TRACES. Traces are freed when last module is reached.
+  // Traces can not be freed yet because they are still in use by the remaining modules.
+  module->myTraceGather->deleteTraces( 0, module->myNumTracesToBePassed );
+  module->myNumTracesToBePassed = 0;
+}
+//------------------------------------------------------
+//
+void csModule::addIncomingTrace( csTrace* trace, int inPort ) {
   // Case A) Single trace or fixed trace module
   if( myExecPhaseDef->execType() == EXEC_TYPE_SINGLETRACE || myExecPhaseDef->execType() == EXEC_TYPE_INPUT ||
       myExecPhaseDef->traceMode == TRCMODE_FIXED ) {
-    int firstTraceIndex = 0;
-    int numFixedTraces = myExecPhaseDef->numTraces;
-    // A1. Move as many traces as possible from the other 'module' to the 'trace gather'.
-    while( myTraceGather->numTraces() < numFixedTraces && firstTraceIndex < module->myNumTracesToBePassed ) {
-      addNewTraceToGather( module->myTraceGather->trace( firstTraceIndex++ ), inPort );
-      //   printf("A1. Old gather: %d, new gather: %d   --- %d (%d)\n", module->myTraceGather->numTraces(), myTraceGather->numTraces(), firstTraceIndex, module->myNumTracesToBePassed );
+    // A1. Move as many traces as possible to the 'trace gather'.
+    //     Traces already waiting in the queue go first: Traces arriving in batches must not overtake them
+    if( myTraceGather->numTraces() < myExecPhaseDef->numTraces && myTraceQueue->isEmpty() ) {
+      addNewTraceToGather( trace, inPort );
     }
     // A2. Move remaining traces to the 'trace queue'
-    for( int itrc = firstTraceIndex; itrc < module->myNumTracesToBePassed; itrc++ ) {
-      addNewTraceToQueue( module->myTraceGather->trace( itrc ), inPort );
-      //       printf("A2. Old gather: %d, new queue: %d   ---  %d\n", module->myTraceGather->numTraces(), myTraceQueue->size(), firstTraceIndex);
+    else {
+      addNewTraceToQueue( trace, inPort );
     }
   }
   // Case B) Ensemble trace module or module with variable number of traces
-  else { // else if( myExecPhaseDef->traceMode == TRCMODE_ENSEMBLE ) {
-    // First attempt: - Move all traces to the 'trace queue'.
-    // - Next, try to move as many traces as possible from trace queue to trace gather
-
-    // B1. The main case for multi-trace ensemble modules:
-    // Check whether each trace is part of the current 'trace gather'.
-    // If yes, add trace to trace gather. Otherwise, move this and all remaining traces into trace queue.
-    if( mySuperHeader->numEnsembleKeys() > 0 ) {
-      int firstTraceIndex = 0;
-      // 1. If next ensemble has not been found yet, keep moving traces to trace gather
-      while( firstTraceIndex < module->myNumTracesToBePassed ) {
-        csTrace* trace = module->myTraceGather->trace( firstTraceIndex );
-        //printf("moveTracesFrom: Trace is FULL: %s\n", myIsEnsembleFull ? "yes" : "no" );
-        if( myIsEnsembleFull || !traceIsPartOfCurrentEnsemble( trace ) ) {
-          //printf("moveTracesFrom: Trace is FULL or NOT part of current ensemble.  %s\n",  myName.c_str() );
-          addNewTraceToQueue( trace, inPort );
-        }
-        else { //if( traceIsPartOfCurrentEnsemble( trace ) ) {
-          //printf("moveTracesFrom: Trace is part of current ensemble.  %s\n", myName.c_str());
-          addNewTraceToGather( trace, inPort );
-        }
-        firstTraceIndex += 1;
-      }  // end while
+  // B1. The main case for multi-trace ensemble modules:
+  // Check whether each trace is part of the current 'trace gather'.
+  // If yes, add trace to trace gather. Otherwise, move this and all remaining traces into trace queue.
+  else if( mySuperHeader->numEnsembleKeys() > 0 ) {
+    if( myIsEnsembleFull || !traceIsPartOfCurrentEnsemble( trace ) ) {
+      addNewTraceToQueue( trace, inPort );
     }
-    // B2. No ensemble key set --> buffer entire data set directly into the trace gather
-    else { //if( mySuperHeader->numEnsembleKeys() == 0 ) {
-      for( int itrc = 0; itrc < module->myNumTracesToBePassed; itrc++ ) {
-        addNewTraceToGather( module->myTraceGather->trace( itrc ), inPort );
-      }
+    else {
+      addNewTraceToGather( trace, inPort );
     }
   }
-  // Remove traces from trace gather, but DO NOT FREE TRACES. Traces are freed when last module is reached.
-  // Traces can not be freed yet because they are still in use by the remaining modules.
-  module->myTraceGather->deleteTraces( 0, module->myNumTracesToBePassed );
-  module->myNumTracesToBePassed = 0;
+  // B2. No ensemble key set --> buffer entire data set directly into the trace gather
+  else {
+    addNewTraceToGather( trace, inPort );
+  }
+}
+//------------------------------------------------------
+//
+void csModule::passTracesTo( csTraceRingBuffer* buffer ) {
+  for( int itrc = 0; itrc < myNumTracesToBePassed; itrc++ ) {
+    if( !buffer->push( myTraceGather->trace( itrc ) ) ) {
+      myTraceGather->trace( itrc )->free();  // Receiving thread has stopped
+    }
+  }
+  myTraceGather->deleteTraces( 0, myNumTracesToBePassed );
+  myNumTracesToBePassed = 0;
+}
+//------------------------------------------------------
+//
+int csModule::receiveTracesFrom( csTraceRingBuffer* buffer, int inPort ) {
+  csTrace* trace = buffer->pop();
+  int numTraces = 0;
+  while( trace != NULL ) {
+    addIncomingTrace( trace, inPort );
+    numTraces += 1;
+    if( numTraces == buffer->capacity() ) break;
+    trace = buffer->tryPop();
+  }
+  return numTraces;
 }
 
 //------------------------------------------------------
@@ -15,10 +15,12 @@
 #include "csLogWriter.h"
 #include "csTimer.h"
 #include "csMethodRetriever.h"
+#include "csTraceRingBuffer.h"
 
 #include <stdarg.h>
 #include <ctime>
 #include <cstring>
+#include <pthread.h>
 
 // cseis : Geolib
 #include "csException.h"
@@ -34,14 +36,18 @@ namespace cseis_system {
   extern std::string replaceUserConstants( char const* line, cseis_geolib::csVector<cseis_system::csUserConstant> const* list );
 }
 
-csRunManager::csRunManager( csLogWriter* log, int memoryPolicy, bool isDebug ) {
+csRunManager::csRunManager( csLogWriter* log, int memoryPolicy, bool isDebug, int numThreads, int queueDepth, int maxMemoryMB, bool isFusion ) {
   myIsDebug = isDebug;
+  myNumThreads = numThreads > 1 ? numThreads : 1;
+  myQueueDepth = queueDepth > 0 ? queueDepth : 0;
+  myIsFusion   = isFusion;
+  myStageLastModule = NULL;
   myLog     = log;
   myModules = NULL;
   myNumModules = 0;
   myNextModuleID = NULL;
   myPrevModuleID = NULL;
-  myMemoryPoolManager = new csMemoryPoolManager( memoryPolicy );
+  myMemoryPoolManager = new csMemoryPoolManager( memoryPolicy, maxMemoryMB > 0 ? maxMemoryMB : csMemoryPoolManager::MAX_NUM_MEGABYTES );
   myTimerCPU = new cseis_geolib::csTimer();
   myTables = NULL;
   myNumTables = 0;
@@ -575,6 +581,14 @@ int csRunManager::runInitPhase( char const* filenameFlow, FILE* f_flow, cseis_ge
   }
   prevModuleList.dispose();
 
+  // Size header value blocks of all new traces for the largest header definition in the flow
+  int maxNumHeaderBytes = 0;
+  for( int imodule = 0; imodule < myNumModules; imodule++ ) {
+    csTraceHeaderDef const* hdef = modules[imodule]->getHeaderDef();
+    if( hdef != NULL && hdef->getTotalNumBytes() > maxNumHeaderBytes ) maxNumHeaderBytes = hdef->getTotalNumBytes();
+  }
+  myMemoryPoolManager->setMaxNumHeaderBytes( maxNumHeaderBytes );
+
   if( myIsDebug ) {
     fprintf(stdout,"--------------------------------------\n\n");
     for( int imodule = 0; imodule < myNumModules; imodule++ ) {
@@ -677,39 +691,65 @@ int csRunManager::runInitPhase( char const* filenameFlow, FILE* f_flow, cseis_ge
 // Exec phase processing loop
 //
 //
-int csRunManager::runExecPhase() {
+//----------------------------------------------------------------------
+//
+void* csRunManager::runExecPhaseGroupThread( void* ptr ) {
+  csGroupThreadArgs* args = (csGroupThreadArgs*)ptr;
+  args->isSuccess = args->runManager->runExecPhaseGroup( args->firstModule, args->lastModule, args->inBuffer, args->outBuffer );
+  return NULL;
+}
+//----------------------------------------------------------------------
+//
+void csRunManager::passTracesOut( csModule* module, csTraceRingBuffer* outBuffer ) {
+  if( outBuffer == NULL ) {
+    module->lastModuleTraceCleanup();
+  }
+  else {
+    module->passTracesTo( outBuffer );
+  }
+}
+//----------------------------------------------------------------------
+//
+bool csRunManager::runExecPhaseGroup( int firstModule, int lastModule, csTraceRingBuffer* inBuffer, csTraceRingBuffer* outBuffer ) {
   csModule** modules = myModules;
-
-  int returnFlag = 0;
-
-  int indexLastModule  = myNumModules-1;
   cseis_geolib::csModuleIndexStack stack_moduleIndex( myNumModules+1 );
+  int iModule = firstModule;
 
-  myLog->line( "\n================================================================================\n" );
-  myLog->line( "Run exec phase...\n" );
-
-  if( myIsDebug ) fprintf(stdout,"--------------------------------------\n\n");
-
-  myLog->flush();
-  int iModule = 0;
-  
   try {
     bool isInputFinished = false;
-    if( modules[0]->getExecType() != EXEC_TYPE_INPUT ) isInputFinished = true;
+    if( inBuffer == NULL && modules[0]->getExecType() != EXEC_TYPE_INPUT ) isInputFinished = true;
     //---------------------------------------------------------------------
     // BIG LOOP FOR ALL INPUT TRACES
     //
     while( !isInputFinished ) {
+      if( outBuffer != NULL && outBuffer->isAborted() ) {
+        // Next group has stopped due to an error: Stop this group, and all previous groups
+        if( inBuffer != NULL ) inBuffer->abort();
+        return false;
+      }
       // STEP (1) Read in input trace. If none is read in, set isInputFinished = true. No trace will be passed on.
       int outPort = 0;
       iModule = myNumModules;
-      if( modules[0]->submitExecPhase( isInputFinished, myLog, outPort ) ) {  // Successful submission of exec phase
-        if( myNextModuleID[0]->size() > 0 ) {  // Only move on traces if Input module is not the only (=last) module in flow
+      if( inBuffer != NULL ) {
+        // Group runs in its own thread: Receive traces from module running in previous thread
+        iModule = firstModule;
+        int numTraces = modules[firstModule]->receiveTracesFrom( inBuffer, 0 );
+        if( inBuffer->isAborted() ) {
+          // Previous group has stopped due to an error: Do not process incomplete input. Stop this group, and all following groups
+          if( outBuffer != NULL ) outBuffer->abort();
+          return false;
+        }
+        if( numTraces == 0 ) {
+          isInputFinished = true;
+        }
+      }
+      else if( modules[0]->submitExecPhase( isInputFinished, myLog, outPort ) ) {  // Successful submission of exec phase
+        if( myNextModuleID[0]->size() > 0 && myNextModuleID[0]->at(0) <= lastModule ) {  // Only move on traces if Input module is not the only (=last) module in flow
           iModule = myNextModuleID[0]->at(0);
           modules[iModule]->moveTracesFrom( modules[0], outPort );
         }
-        else {  // Input module is only module in flow --> clean up traces
-          modules[0]->lastModuleTraceCleanup();
+        else {  // Input module is only module in flow (or in this group) --> clean up or pass on traces
+          passTracesOut( modules[0], outBuffer );
         }
       }
       else {
@@ -725,7 +765,7 @@ int csRunManager::runExecPhase() {
       //---------------------------------------------------------------------
       // INNER LOOP FOR ALL MODULES EXCEPT INPUT MODULE
       //
-      while( iModule < myNumModules ) {
+      while( iModule <= lastModule ) {
         csModule* module = modules[iModule];
         if( myIsDebug ) fprintf(stdout,"Module %2d %s...\n", iModule, module->getName());
         outPort = 0;
@@ -736,7 +776,11 @@ int csRunManager::runExecPhase() {
         bool forceToRun = isInputFinished && stack_moduleIndex.isEmpty();
         if( myIsDebug ) fprintf(stdout,"  Forced to run?  %d\n", forceToRun);
         // STEP (2) Check if module is ready for submission
-        if( !module->isReadyToSubmitExec( forceToRun ) ) {
+        int stageLast = myStageLastModule[iModule];
+        // Parallel stage modules run in myNumThreads workers, fused stage modules in one
+        int numThreadsStage = module->numWorkers();
+        bool isReady = ( stageLast < 0 ) ? module->isReadyToSubmitExec( forceToRun ) : module->isReadyToSubmitStage( forceToRun, numThreadsStage * NUM_TRACES_PER_THREAD );
+        if( !isReady ) {
           if( myIsDebug ) fprintf(stdout,"  ...is NOT ready to submit\n");
           if( !forceToRun ) {
             iModule = stack_moduleIndex.pop();  // returns myNumModules if empty
@@ -744,9 +788,20 @@ int csRunManager::runExecPhase() {
           else {
             iModule += 1;  // If forced, step to next module in list
           }
+          continue;
+        }
+        bool isSubmitted;
+        if( stageLast < 0 ) {
+          isSubmitted = module->submitExecPhase(forceToRun,myLog,outPort);
+        }
+        else {
+          // Parallel or fused stage: Traces are passed through all stage modules at once, then continue from last module in stage
+          isSubmitted = module->submitExecPhaseStage( &modules[iModule], stageLast-iModule+1, numThreadsStage, forceToRun, myLog, outPort );
+          iModule = stageLast;
+          module  = modules[iModule];
         }
         // STEP (3) If module is ready for submission (or when forced), submit exec phase
-        else if( !module->submitExecPhase(forceToRun,myLog,outPort) ) {
+        if( !isSubmitted ) {
           if( myIsDebug ) fprintf(stdout,"  STEP 3 ...did NOT run correctly\n");
           // Exec phase failed. This indicates that no trace was output
           if( module->finishedProcessing() ) {
@@ -760,9 +815,9 @@ int csRunManager::runExecPhase() {
           // else: nothing to be done. Continue processing this module, keep iModule
         }
         // STEP (4) Module has been processed, current module is last module in flow
-        else if( iModule == indexLastModule ) {
+        else if( iModule == lastModule ) {
           if( myIsDebug ) fprintf(stdout,"  STEP 4 ...is last module\n");
-          module->lastModuleTraceCleanup();
+          passTracesOut( module, outBuffer );
           if( module->finishedProcessing() ) {
             iModule = stack_moduleIndex.pop();  // returns myNumModules if empty
           } // else keep iModule, process next trace(s)
@@ -776,9 +831,9 @@ int csRunManager::runExecPhase() {
           }
           // STEP (6) Find correct combination: Output port of current module  <-->  Input port of next module
           int nextModuleID = myNextModuleID[iModule]->at(outPort);
-          if( nextModuleID >= myNumModules ) { // Next module 'pointer' of given output port points beyond last module
+          if( nextModuleID > lastModule ) { // Next module 'pointer' of given output port points beyond last module
             if( myIsDebug ) fprintf(stdout,"  STEP 7a ...is last module\n");
-            module->lastModuleTraceCleanup();
+            passTracesOut( module, outBuffer );
             if( module->finishedProcessing() ) {
               iModule = stack_moduleIndex.pop();  // returns myNumModules if empty
             } // else keep iModule, process next trace(s)
@@ -804,8 +859,9 @@ int csRunManager::runExecPhase() {
             }
           }
         } // END else (Step 5)
-      }  // while( iModule < myNumModules ) {
+      }  // while( iModule <= lastModule ) {
     }  // while( !isInputFinished ) {
+    if( outBuffer != NULL ) outBuffer->setFinished();
   }
   catch( cseis_geolib::csException& e ) {
     if( iModule >= myNumModules || iModule < 0 ) {
@@ -815,11 +871,103 @@ int csRunManager::runExecPhase() {
             iModule+1, myModules[iModule]->getName(), e.getMessage());
     myLog->line("\nException caught while running exec phase, module #%2d %s. System message: \n%s",
                 iModule+1, myModules[iModule]->getName(), e.getMessage());
-    exit( -1 );
+    if( inBuffer == NULL && outBuffer == NULL ) exit( -1 );
+    // Pipelined exec phase: Release neighbouring groups. They stop in turn and abort their other ring buffer
+    if( inBuffer != NULL ) inBuffer->abort();
+    if( outBuffer != NULL ) outBuffer->abort();
+    return false;
   }
-  //  catch(...) {
-  //  printf("Unknown exception occurred\n");
-  // }
+  catch( ... ) {
+    if( inBuffer == NULL && outBuffer == NULL ) throw;
+    if( iModule >= myNumModules || iModule < 0 ) {
+      iModule = 0;
+    }
+    fprintf(stderr,"\nUnknown exception caught while running exec phase, module #%2d %s\n", iModule+1, myModules[iModule]->getName());
+    myLog->line("\nUnknown exception caught while running exec phase, module #%2d %s", iModule+1, myModules[iModule]->getName());
+    if( inBuffer != NULL ) inBuffer->abort();
+    if( outBuffer != NULL ) outBuffer->abort();
+    return false;
+  }
+  return true;
+}
+//----------------------------------------------------------------------
+//
+int csRunManager::runExecPhase() {
+  csModule** modules = myModules;
+
+  int returnFlag = 0;
+
+  myLog->line( "\n================================================================================\n" );
+  myLog->line( "Run exec phase...\n" );
+
+  if( myIsDebug ) fprintf(stdout,"--------------------------------------\n\n");
+
+  myStageLastModule = new int[myNumModules];
+  setupParallelStages( myStageLastModule );
+  int* groupFirstModule = new int[myNumModules+1];
+  int numGroups = setupPipelineGroups( groupFirstModule );
+
+  myLog->flush();
+
+  if( numGroups == 1 ) {
+    runExecPhaseGroup( 0, myNumModules-1, NULL, NULL );
+  }
+  else {
+    // Pipelined execution: Each group of modules runs in its own thread. Traces are passed on through ring buffers
+    csTraceRingBuffer** buffers = new csTraceRingBuffer*[numGroups-1];
+    for( int igroup = 0; igroup < numGroups-1; igroup++ ) {
+      buffers[igroup] = new csTraceRingBuffer( myQueueDepth );
+    }
+    pthread_t* threads = new pthread_t[numGroups];
+    csGroupThreadArgs* args = new csGroupThreadArgs[numGroups];
+    for( int igroup = 0; igroup < numGroups; igroup++ ) {
+      args[igroup].isSuccess   = false;
+      args[igroup].runManager  = this;
+      args[igroup].firstModule = groupFirstModule[igroup];
+      args[igroup].lastModule  = groupFirstModule[igroup+1]-1;
+      args[igroup].inBuffer    = ( igroup > 0 ) ? buffers[igroup-1] : NULL;
+      args[igroup].outBuffer   = ( igroup < numGroups-1 ) ? buffers[igroup] : NULL;
+    }
+    int numThreadsCreated = 1;
+    for( int igroup = 1; igroup < numGroups; igroup++ ) {
+      if( pthread_create( &threads[igroup], NULL, runExecPhaseGroupThread, &args[igroup] ) != 0 ) {
+        myLog->line("Error: Failed to create thread for pipelined exec phase");
+        // Stop threads that are already running
+        for( int ibuffer = 0; ibuffer < numGroups-1; ibuffer++ ) {
+          buffers[ibuffer]->abort();
+        }
+        break;
+      }
+      numThreadsCreated += 1;
+    }
+    if( numThreadsCreated == numGroups ) {
+      runExecPhaseGroupThread( &args[0] );
+    }
+    for( int igroup = 1; igroup < numThreadsCreated; igroup++ ) {
+      pthread_join( threads[igroup], NULL );
+    }
+    bool isSuccess = ( numThreadsCreated == numGroups );
+    for( int igroup = 0; igroup < numGroups; igroup++ ) {
+      if( !args[igroup].isSuccess ) isSuccess = false;
+    }
+    for( int igroup = 0; igroup < numGroups-1; igroup++ ) {
+      delete buffers[igroup];
+    }
+    delete [] buffers;
+    delete [] threads;
+    delete [] args;
+    if( !isSuccess ) {
+      // As in the serial exec phase, the cleanup phase is not run after an error
+      delete [] groupFirstModule;
+      delete [] myStageLastModule;
+      myStageLastModule = NULL;
+      myLog->line("Error occurred during pipelined exec phase. Processing was stopped.");
+      return 21;
+    }
+  }
+  delete [] groupFirstModule;
+  delete [] myStageLastModule;
+  myStageLastModule = NULL;
 
   // Run cleanup phase. Cleaning up allocated memory in modules
   for( int iModule = 0; iModule < myNumModules; iModule++ ) {
@@ -840,15 +988,16 @@ int csRunManager::runExecPhase() {
   //
   myLog->line( "\n------------------------------------------------------------" );
   myLog->line( "Exec phase summary\n" );
-  myLog->line( "  #  Module                Traces in  Traces out     CPU time   CPU time all" );
+  myLog->line( "  #  Module                Traces in  Traces out     CPU time   CPU time all   Memory peak[Mb]" );
 
   double timeCPUExecAll = 0.0;
   for( int iModule = 0; iModule < myNumModules; iModule++ ) {
     csModule* module = modules[iModule];
     double timeCPU  = module->getExecPhaseCPUTime();
     timeCPUExecAll += timeCPU;
-    myLog->line( "%3d  %-19s %11d %11d %12.3f   %12.3f", iModule+1, module->getName(),
-                 module->numIncomingTraces(), module->numProcessedTraces(), timeCPU, timeCPUExecAll );
+    myLog->line( "%3d  %-19s %11d %11d %12.3f   %12.3f   %15.3f", iModule+1, module->getName(),
+                 module->numIncomingTraces(), module->numProcessedTraces(), timeCPU, timeCPUExecAll,
+                 (double)module->getMaxNumBytesHeld()/(1024.0*1024.0) );
   }
   myLog->line( "\n------------------------------------------------------------\n" );
   
@@ -869,6 +1018,134 @@ int csRunManager::runExecPhase() {
 //
 //**********************************************************************
 
+bool csRunManager::isFusedStageModule( int moduleIndex ) const {
+  csModule const* module = myModules[moduleIndex];
+  return( moduleIndex > 0 &&
+          module->getType() == MODTYPE_UNKNOWN &&
+          module->getExecType() == EXEC_TYPE_SINGLETRACE &&
+          myPrevModuleID[moduleIndex]->size() == 1 &&
+          myNextModuleID[moduleIndex]->size() == 1 );
+}
+
+bool csRunManager::isParallelStageModule( int moduleIndex ) const {
+  return( isFusedStageModule( moduleIndex ) && myModules[moduleIndex]->getExecPhaseDef()->isThreadSafe() );
+}
+
+int csRunManager::findStageLastModule( int firstModule, bool isParallel, int const* stageLastModule ) const {
+  int lastModule = firstModule;
+  while( lastModule+1 < myNumModules && myNextModuleID[lastModule]->at(0) == lastModule+1 &&
+         ( isParallel ? isParallelStageModule( lastModule+1 ) : isFusedStageModule( lastModule+1 ) ) &&
+         stageLastModule[lastModule+1] < 0 && myPrevModuleID[lastModule+1]->at(0) == lastModule ) {
+    lastModule += 1;
+  }
+  return lastModule;
+}
+
+int csRunManager::setupPipelineGroups( int* groupFirstModule ) const {
+  int numGroups = 0;
+  groupFirstModule[numGroups++] = 0;
+  if( myQueueDepth > 0 ) {
+    int maxNextModule = 0;   // Maximum index of next module, for all modules above current split point
+    int stageLastModule = -1;
+    for( int imodule = 0; imodule < myNumModules-1; imodule++ ) {
+      for( int i = 0; i < myNextModuleID[imodule]->size(); i++ ) {
+        if( myNextModuleID[imodule]->at(i) > maxNextModule ) maxNextModule = myNextModuleID[imodule]->at(i);
+      }
+      if( myStageLastModule[imodule] > stageLastModule ) stageLastModule = myStageLastModule[imodule];
+      if( maxNextModule == imodule+1 && stageLastModule <= imodule &&
+          myPrevModuleID[imodule+1]->size() == 1 && myPrevModuleID[imodule+1]->at(0) == imodule ) {
+        groupFirstModule[numGroups++] = imodule+1;
+      }
+    }
+  }
+  groupFirstModule[numGroups] = myNumModules;
+  if( numGroups > 1 ) {
+    myLog->line("Pipelined exec phase: %d threads, queue depth %d traces", numGroups, myQueueDepth);
+    for( int igroup = 0; igroup < numGroups; igroup++ ) {
+      myLog->write("  Thread %2d:", igroup+1);
+      for( int i = groupFirstModule[igroup]; i < groupFirstModule[igroup+1]; i++ ) {
+        myLog->write(" #%d %s", i+1, myModules[i]->getName());
+      }
+      myLog->line("");
+    }
+  }
+  return numGroups;
+}
+
+bool csRunManager::isParallelWorkerModule( int moduleIndex ) const {
+  csModule const* module = myModules[moduleIndex];
+  csExecPhaseDef const* edef = module->getExecPhaseDef();
+  if( module->getType() != MODTYPE_UNKNOWN || module->getExecType() != EXEC_TYPE_MULTITRACE || !edef->isThreadSafe() ) {
+    return false;
+  }
+  if( edef->getTraceMode() == TRCMODE_ENSEMBLE ) {
+    return( module->getSuperHeader()->numEnsembleKeys() > 0 );
+  }
+  // Fixed mode: Only supported for modules processing one trace at a time. Others typically keep traces between calls
+  return( edef->getTraceMode() == TRCMODE_FIXED && edef->getNumTraces() == 1 );
+}
+
+void csRunManager::setupParallelStages( int* stageLastModule ) {
+  for( int imodule = 0; imodule < myNumModules; imodule++ ) {
+    stageLastModule[imodule] = -1;
+  }
+
+  int imodule = 0;
+  while( imodule < myNumModules && myNumThreads > 1 ) {
+    if( !isParallelStageModule( imodule ) ) {
+      imodule += 1;
+      continue;
+    }
+    int lastModule = findStageLastModule( imodule, true, stageLastModule );
+    stageLastModule[imodule] = lastModule;
+    myLog->write("Parallel stage (%d threads):", myNumThreads);
+    for( int i = imodule; i <= lastModule; i++ ) {
+      myLog->write(" #%d %s", i+1, myModules[i]->getName());
+      myModules[i]->setNumWorkers( myNumThreads );
+    }
+    myLog->line("");
+    imodule = lastModule + 1;
+  }
+
+  // Fused stages: Remaining runs of single-trace modules, including modules that are not thread-safe.
+  // Each trace runs through all stage modules back-to-back in one thread, while its samples are still in cache
+  imodule = 0;
+  while( imodule < myNumModules && myIsFusion ) {
+    if( stageLastModule[imodule] >= 0 ) {
+      imodule = stageLastModule[imodule] + 1;
+      continue;
+    }
+    if( !isFusedStageModule( imodule ) ) {
+      imodule += 1;
+      continue;
+    }
+    int lastModule = findStageLastModule( imodule, false, stageLastModule );
+    if( lastModule > imodule ) {  // A single module gains nothing from being run as a stage
+      stageLastModule[imodule] = lastModule;
+      myLog->write("Fused stage:");
+      for( int i = imodule; i <= lastModule; i++ ) {
+        myLog->write(" #%d %s", i+1, myModules[i]->getName());
+      }
+      myLog->line("");
+    }
+    imodule = lastModule + 1;
+  }
+  if( myNumThreads <= 1 ) return;
+
+  for( int imodule = 0; imodule < myNumModules; imodule++ ) {
+    if( isParallelWorkerModule( imodule ) ) {
+      if( myModules[imodule]->getExecPhaseDef()->getTraceMode() == TRCMODE_ENSEMBLE ) {
+        myModules[imodule]->setNumWorkers( myNumThreads );
+        myLog->line("Parallel ensembles (%d threads): #%d %s", myNumThreads, imodule+1, myModules[imodule]->getName());
+      }
+      else {
+        myModules[imodule]->setNumWorkers( myNumThreads, NUM_TRACES_PER_THREAD );
+        myLog->line("Parallel traces (%d threads): #%d %s", myNumThreads, imodule+1, myModules[imodule]->getName());
+      }
+    }
+  }
+}
+
 /**
  * Check all user defined parameters/values etc
  *
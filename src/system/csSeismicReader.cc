@@ -14,6 +14,8 @@
 #include "csTraceHeaderInfo.h"
 #include "csFlexHeader.h"
 #include "csIOSelection.h"
+#include "csSeismicIndex.h"
+#include "csMappedFile.h"
 #include <string>
 
 using namespace cseis_system;
@@ -21,11 +23,13 @@ using namespace cseis_system;
 csSeismicReader::csSeismicReader( std::string filename, int numTraces ) {
   bool enableRandomAccess = false;
   myReader = cseis_io::csSeismicReader_ver::createReaderObject( filename, enableRandomAccess, numTraces );
+  myFilename = filename;
   init();
 }
 
 csSeismicReader::csSeismicReader( std::string filename, bool enableRandomAccess, int numTraces ) {
   myReader = cseis_io::csSeismicReader_ver::createReaderObject( filename, enableRandomAccess, numTraces );
+  myFilename = filename;
   init();
 }
 
@@ -37,9 +41,15 @@ void csSeismicReader::init() {
   myHdrCheckBuffer     = NULL;
   myTrcHdrDef          = NULL;
   myIOSelection        = NULL;
+  myIndex              = NULL;
+  myIsIndexRead        = false;
 }
 
 csSeismicReader::~csSeismicReader() {
+  if( myIndex != NULL ) {
+    delete myIndex;
+    myIndex = NULL;
+  }
   if( myIOSelection != NULL ) {
     delete myIOSelection;
     myIOSelection = NULL;
@@ -125,6 +135,19 @@ bool csSeismicReader::readTrace( float* samples, char* hdrValueBlock ) {
   }
   return myReader->readTrace( samples, hdrValueBlock );
 }
+bool csSeismicReader::mapFile() {
+  return myReader->mapFile();
+}
+bool csSeismicReader::isSharedReadSupported() const {
+  return myReader->isSharedReadSupported();
+}
+bool csSeismicReader::readTraceShared( char* hdrValueBlock, float const*& samples, cseis_geolib::csSharedBuffer*& owner ) {
+  if( myIOSelection ) {
+    if( !performIOSelection() ) return false;
+  }
+  owner = myReader->mappedFile();
+  return myReader->readTraceMapped( hdrValueBlock, samples );
+}
 bool csSeismicReader::performIOSelection() {
   bool success = false;
   int traceIndex = myIOSelection->getNextTraceIndex();
@@ -182,6 +205,10 @@ bool csSeismicReader::peekHeaderValue( cseis_geolib::csFlexHeader* hdrValue, int
     double value = *(reinterpret_cast<double*>( myHdrCheckBuffer ));
     hdrValue->setDoubleValue( value );
   }
+  else if( myHdrCheckType == cseis_geolib::TYPE_INT64 ) {
+    csInt64_t value = *(reinterpret_cast<csInt64_t*>( myHdrCheckBuffer ));
+    hdrValue->setInt64Value( value );
+  }
   else if( myHdrCheckType == cseis_geolib::TYPE_STRING ) {
     std::string text = std::string( myHdrCheckBuffer );
     hdrValue->setStringValue( text );
@@ -212,6 +239,24 @@ bool csSeismicReader::setSelection( std::string const& hdrValueSelectionText, st
   myIOSelection = new cseis_geolib::csIOSelection( headerName, sortOrder, sortMethod );
   return myIOSelection->initialize( this, hdrValueSelectionText );
 }
+bool csSeismicReader::getIndexedHeaderValues( std::string const& headerName, double const*& sortedValues, csInt64_t const*& sortedValuesInt64,
+                                              int const*& sortedTraceIndices ) {
+  if( !myIsIndexRead ) {
+    myIsIndexRead = true;
+    myIndex = new cseis_io::csSeismicIndex();
+    if( !myIndex->read( myFilename, myNumTraces ) ) {
+      delete myIndex;
+      myIndex = NULL;
+    }
+  }
+  if( myIndex == NULL ) return false;
+  int hdrIndex = myIndex->headerIndex( headerName );
+  if( hdrIndex < 0 || myIndex->headerType( hdrIndex ) != myHdrCheckType ) return false;
+  sortedValues       = myIndex->sortedValues( hdrIndex );
+  sortedValuesInt64  = myIndex->sortedValuesInt64( hdrIndex );
+  sortedTraceIndices = myIndex->sortedTraceIndices( hdrIndex );
+  return true;
+}
 int csSeismicReader::getCurrentTraceIndex() const {
   return myReader->currentTraceIndex();
 }
@@ -86,7 +86,22 @@ bool csSeismicWriter::writeFileHeader( csSuperHeader const* shdr, csTraceHeaderD
 
   return myWriter->writeFileHeader( &config );
 }
-bool csSeismicWriter::writeTrace( float* samples, char const* hdrValueBlock ) {
+void csSeismicWriter::addIndexHeader( std::string const& headerName ) {
+  myWriter->addIndexHeader( headerName );
+}
+void csSeismicWriter::setBlockCompression( float maxError, bool isRelativeError ) {
+  myWriter->setBlockCompression( maxError, isRelativeError );
+}
+void csSeismicWriter::close() {
+  myWriter->close();
+}
+double csSeismicWriter::compressionRatio() const {
+  return myWriter->compressionRatio();
+}
+double csSeismicWriter::compressionSNR() const {
+  return myWriter->compressionSNR();
+}
+bool csSeismicWriter::writeTrace( float const* samples, char const* hdrValueBlock ) {
   if( myHdrTempBuffer == NULL ) {
     return myWriter->writeTrace( samples, hdrValueBlock );
   }
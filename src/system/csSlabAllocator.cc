@@ -0,0 +1,213 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include <cstdlib>
+#include <cstring>
+#include "csSlabAllocator.h"
+#include "csMemoryPoolManager.h"
+#include "csException.h"
+
+using namespace cseis_system;
+
+csSlabAllocator::csSlabAllocator( csInt64_t maxNumBytes, int policy ) {
+  myMaxNumBytes       = maxNumBytes;
+  myNumBytesInUse     = 0;
+  myMaxNumBytesInUse  = 0;
+  myNumBytesAllocated = 0;
+  myMaxNumBytesAllocated = 0;
+  for( int i = 0; i < NUM_SIZE_CLASSES; i++ ) {
+    myPartialSlabs[i]  = NULL;
+    myNumEmptySlabs[i] = 0;
+  }
+  mySlabMap = new std::map<char*,csSlab*>();
+  myReleaseEmptySlabs = ( policy == csMemoryPoolManager::POLICY_MEMORY );
+  pthread_mutex_init( &myMutex, NULL );
+}
+csSlabAllocator::~csSlabAllocator() {
+  if( mySlabMap != NULL ) {
+    for( std::map<char*,csSlab*>::iterator iter = mySlabMap->begin(); iter != mySlabMap->end(); iter++ ) {
+      free( iter->second->memory );
+      delete iter->second;
+    }
+    delete mySlabMap;
+    mySlabMap = NULL;
+  }
+  pthread_mutex_destroy( &myMutex );
+}
+//----------------------------------------------------
+//
+int csSlabAllocator::sizeClass( csInt64_t numBytes ) {
+  if( numBytes <= MAX_SMALL_BLOCK_SIZE ) {
+    return( numBytes <= 0 ? 0 : (int)( (numBytes-1) / MIN_BLOCK_SIZE ) );
+  }
+  if( numBytes > MAX_BLOCK_SIZE ) return -1;
+  // Largest power of two below numBytes, and its index counted from MAX_SMALL_BLOCK_SIZE
+  csInt64_t base = MAX_SMALL_BLOCK_SIZE;
+  int ibase = 0;
+  while( 2*base < numBytes ) {
+    base *= 2;
+    ibase += 1;
+  }
+  csInt64_t step = base / NUM_SUB_CLASSES;
+  int isub = (int)( (numBytes - base + step - 1) / step );
+  return( NUM_SUB_CLASSES*(ibase+1) + isub - 1 );
+}
+csInt64_t csSlabAllocator::classSize( int sizeClass ) {
+  if( sizeClass < NUM_SUB_CLASSES ) {
+    return( (csInt64_t)MIN_BLOCK_SIZE * (sizeClass+1) );
+  }
+  csInt64_t base = (csInt64_t)MAX_SMALL_BLOCK_SIZE << ( sizeClass/NUM_SUB_CLASSES - 1 );
+  return( base + (base/NUM_SUB_CLASSES) * ( sizeClass%NUM_SUB_CLASSES + 1 ) );
+}
+csInt64_t csSlabAllocator::blockSize( csInt64_t numBytes ) {
+  int sc = sizeClass( numBytes );
+  if( sc < 0 ) {
+    return( ((numBytes+ALIGNMENT-1) / ALIGNMENT) * ALIGNMENT );
+  }
+  return classSize( sc );
+}
+//----------------------------------------------------
+//
+void* csSlabAllocator::allocateSystem( csInt64_t numBytes ) {
+  void* ptr = NULL;
+  if( posix_memalign( &ptr, ALIGNMENT, (size_t)numBytes ) != 0 ) {
+    throw( cseis_geolib::csException("csSlabAllocator::allocate(): Unable to allocate %lld bytes. Out of memory.", numBytes) );
+  }
+  myNumBytesAllocated += numBytes;
+  if( myNumBytesAllocated > myMaxNumBytesAllocated ) myMaxNumBytesAllocated = myNumBytesAllocated;
+  return ptr;
+}
+//----------------------------------------------------
+//
+csSlabAllocator::csSlab* csSlabAllocator::allocateSlab( int sizeClass ) {
+  csInt64_t size = classSize( sizeClass );
+  int numBlocks = (int)( SLAB_SIZE / size );
+  csSlab* slab = new csSlab();
+  slab->memory     = (char*)allocateSystem( size*numBlocks );
+  slab->numBytes   = size*numBlocks;
+  slab->sizeClass  = sizeClass;
+  slab->numBlocks  = numBlocks;
+  slab->numFreeBlocks = numBlocks;
+  slab->freeBlocks = NULL;
+  slab->prev = NULL;
+  slab->next = NULL;
+  for( int iblock = numBlocks-1; iblock >= 0; iblock-- ) {
+    csFreeBlock* block = reinterpret_cast<csFreeBlock*>( &slab->memory[iblock*size] );
+    block->next = slab->freeBlocks;
+    slab->freeBlocks = block;
+  }
+  mySlabMap->insert( std::pair<char*,csSlab*>( slab->memory, slab ) );
+  linkSlab( slab );
+  myNumEmptySlabs[sizeClass] += 1;
+  return slab;
+}
+void csSlabAllocator::releaseSlab( csSlab* slab ) {
+  unlinkSlab( slab );
+  mySlabMap->erase( slab->memory );
+  free( slab->memory );
+  myNumBytesAllocated -= slab->numBytes;
+  delete slab;
+}
+//----------------------------------------------------
+//
+void csSlabAllocator::linkSlab( csSlab* slab ) {
+  slab->prev = NULL;
+  slab->next = myPartialSlabs[slab->sizeClass];
+  if( slab->next != NULL ) slab->next->prev = slab;
+  myPartialSlabs[slab->sizeClass] = slab;
+}
+void csSlabAllocator::unlinkSlab( csSlab* slab ) {
+  if( slab->prev != NULL ) {
+    slab->prev->next = slab->next;
+  }
+  else {
+    myPartialSlabs[slab->sizeClass] = slab->next;
+  }
+  if( slab->next != NULL ) slab->next->prev = slab->prev;
+  slab->prev = NULL;
+  slab->next = NULL;
+}
+//----------------------------------------------------
+//
+void* csSlabAllocator::allocate( csInt64_t numBytes ) {
+  int sc = sizeClass( numBytes );
+  csInt64_t size = blockSize( numBytes );
+  void* ptr = NULL;
+  pthread_mutex_lock( &myMutex );
+  try {
+    if( myNumBytesInUse + size > myMaxNumBytes ) {
+      throw( cseis_geolib::csException("\ncsSlabAllocator::allocate(): Trace memory in use: %fkb, max allowed: %fkb\n"\
+                       "\nSeaSeis dynamically allocates traces for each module. Most trace-buffering usually occurs for multi-trace modules. " \
+                       "Modules working on 'ensembles' are most prone to buffer a large amount of traces, such as sorting, stacking... " \
+                       "In that respect, it is important that the user is aware of the correct setting of the 'ensemble trace header'. " \
+                       "The ensemble header can be set using module 'ENS_DEFINE'. All consecutive traces for which the ensemble trace header "\
+                       "value does not change constitute one ensemble. The memory limit can be changed with the command line option -mem.",
+                       (double)(myNumBytesInUse+size)/(1024.0), (double)myMaxNumBytes/(1024.0) ) );
+    }
+    if( sc < 0 ) {
+      ptr = allocateSystem( size );
+    }
+    else {
+      csSlab* slab = myPartialSlabs[sc];
+      if( slab == NULL ) slab = allocateSlab( sc );
+      if( slab->numFreeBlocks == slab->numBlocks ) myNumEmptySlabs[sc] -= 1;
+      csFreeBlock* block = slab->freeBlocks;
+      slab->freeBlocks = block->next;
+      slab->numFreeBlocks -= 1;
+      if( slab->numFreeBlocks == 0 ) unlinkSlab( slab );
+      ptr = block;
+    }
+  }
+  catch( cseis_geolib::csException& e ) {
+    pthread_mutex_unlock( &myMutex );
+    throw;
+  }
+  myNumBytesInUse += size;
+  if( myNumBytesInUse > myMaxNumBytesInUse ) myMaxNumBytesInUse = myNumBytesInUse;
+  pthread_mutex_unlock( &myMutex );
+  return ptr;
+}
+//----------------------------------------------------
+//
+void csSlabAllocator::release( void* ptr, csInt64_t numBytes ) {
+  if( ptr == NULL ) return;
+  int sc = sizeClass( numBytes );
+  csInt64_t size = blockSize( numBytes );
+  pthread_mutex_lock( &myMutex );
+  if( sc < 0 ) {
+    free( ptr );
+    myNumBytesAllocated -= size;
+  }
+  else {
+    // Slab holding the block: Last slab starting at or below block address
+    std::map<char*,csSlab*>::iterator iter = mySlabMap->upper_bound( reinterpret_cast<char*>( ptr ) );
+    if( iter == mySlabMap->begin() ) {
+      pthread_mutex_unlock( &myMutex );
+      throw( cseis_geolib::csException("csSlabAllocator::release(): Memory block was not allocated by this allocator. This is a program bug.") );
+    }
+    csSlab* slab = (--iter)->second;
+    csFreeBlock* block = reinterpret_cast<csFreeBlock*>( ptr );
+    block->next = slab->freeBlocks;
+    slab->freeBlocks = block;
+    if( slab->numFreeBlocks == 0 ) linkSlab( slab );
+    slab->numFreeBlocks += 1;
+    if( slab->numFreeBlocks == slab->numBlocks ) {
+      // Keep one empty slab per size class for re-use, unless memory shall be returned to the system
+      if( myReleaseEmptySlabs || myNumEmptySlabs[sc] > 0 ) {
+        releaseSlab( slab );
+      }
+      else {
+        myNumEmptySlabs[sc] += 1;
+      }
+    }
+  }
+  myNumBytesInUse -= size;
+  pthread_mutex_unlock( &myMutex );
+}
+//----------------------------------------------------
+//
+void csSlabAllocator::dumpSummary( FILE* fout ) const {
+  fprintf( fout," Maximum trace memory in use (samples+headers):  %.2fMb  (memory budget: %.2fMb)\n",
+           (double)myMaxNumBytesInUse/(1024.0*1024.0), (double)myMaxNumBytes/(1024.0*1024.0) );
+  fprintf( fout," Maximum memory allocated in slabs/large blocks: %.2fMb\n", (double)myMaxNumBytesAllocated/(1024.0*1024.0) );
+}
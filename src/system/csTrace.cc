@@ -5,24 +5,28 @@
 #include "csTraceHeader.h"
 #include "csTraceData.h"
 #include "csTracePool.h"
+#include "csSlabAllocator.h"
+#include "csMemoryPoolManager.h"
 #include "csException.h"
 
 using namespace cseis_system;
 
-int csTrace::myIdentCounter = 0;
+std::atomic<int> csTrace::myIdentCounter( 0 );
 
 //---------------------------------------------------------
 csTrace::csTrace( csTracePool* const tracePoolPtr ) :
   myTracePoolPtr( tracePoolPtr ),
-  myIdentNumber( myIdentCounter++ )
+  myIdentNumber( myIdentCounter++ ),
+  myIsFree( true )
 {
-  myTraceHeader = new csTraceHeader();
-  myData        = new csTraceData();
+  myTraceHeader = new csTraceHeader( tracePoolPtr->myAllocator, tracePoolPtr->myNumHeaderBytes );
+  myData        = new csTraceData( tracePoolPtr->myAllocator );
 }
 //---------------------------------------------------------
 csTrace::csTrace() :
   myTracePoolPtr( NULL ),
-  myIdentNumber( myIdentCounter++ )
+  myIdentNumber( myIdentCounter++ ),
+  myIsFree( false )
 {
   myTraceHeader = new csTraceHeader();
   myData        = new csTraceData();
@@ -55,7 +59,10 @@ float* csTrace::getTraceSamples() {
   return myData->getSamples();
 }
 float const* csTrace::getTraceSamples() const {
-  return myData->getSamples();
+  return myData->getSamplesReadOnly();
+}
+float const* csTrace::getTraceSamplesReadOnly() const {
+  return myData->getSamplesReadOnly();
 }
 int csTrace::numSamples() const {
   return myData->numSamples();
@@ -66,8 +73,13 @@ int csTrace::numHeaders() const {
 //--------------------------------------------------
 void csTrace::free() {
   if( myTracePoolPtr != NULL ) {
-    myTracePoolPtr->freeTrace( this );
+    // Clear header first: Once returned to the pool, trace may be retrieved by another thread
     myTraceHeader->clear();
+    // Release shared samples, so that memory they reside in can be freed
+    if( myData->isShared() ) myData->unshare( false );
+    // Return sample buffer to allocator, so that slabs of released buffers can be returned to the system
+    if( myTracePoolPtr->myPolicy == csMemoryPoolManager::POLICY_MEMORY ) myData->clearMemory();
+    myTracePoolPtr->freeTrace( this );
   }
   else {  // TEMP
     throw cseis_geolib::csException("csTrace: ERROR, pool pointer is NULL");
@@ -2,6 +2,8 @@
 /* All rights reserved.                       */
 
 #include "csTraceData.h"
+#include "csSlabAllocator.h"
+#include "csSharedBuffer.h"
 #include "csException.h"
 #include <string>
 #include <cstdio>
@@ -9,27 +11,107 @@
 
 using namespace cseis_system;
 
+namespace {
+  /**
+   * Sample buffer of a trace, shared by several traces (copy-on-write)
+   * The buffer is released to its allocator when the last reference is released, unless a trace has taken it over.
+   */
+  class csSharedSamples : public cseis_geolib::csSharedBuffer {
+  public:
+    csSharedSamples( float* samples, int numAllocatedSamples, csSlabAllocator* allocator ) :
+      mySamples( samples ),
+      myNumAllocatedSamples( numAllocatedSamples ),
+      myAllocator( allocator ) {
+    }
+    inline float* samples() { return mySamples; }
+    inline int numAllocatedSamples() const { return myNumAllocatedSamples; }
+    inline csSlabAllocator* allocator() const { return myAllocator; }
+    /// Hand over sample buffer to caller. Call only when holding the only reference
+    inline void detach() { mySamples = NULL; }
+  protected:
+    virtual ~csSharedSamples() {
+      if( mySamples == NULL ) return;
+      if( myAllocator == NULL ) {
+        delete [] mySamples;
+      }
+      else {
+        myAllocator->release( mySamples, (csInt64_t)myNumAllocatedSamples*sizeof(float) );
+      }
+    }
+  private:
+    float* mySamples;
+    int myNumAllocatedSamples;
+    csSlabAllocator* myAllocator;
+  };
+}
+
 csTraceData::csTraceData() {
+  myAllocator  = NULL;
   myNumSamples = 0;
   myNumAllocatedSamples = 0;
   myDataSamples = NULL;
   myDoTrimOnNextCall = false;
+  mySharedSamples = NULL;
+  mySharedOwner   = NULL;
+  myIsSharedTraceBuffer = false;
 }
 csTraceData::csTraceData( int numSamples ) {
+  myAllocator  = NULL;
   myNumSamples = numSamples;
   myNumAllocatedSamples = numSamples;
   myDataSamples = new float[myNumAllocatedSamples];
   myDoTrimOnNextCall = false;
+  mySharedSamples = NULL;
+  mySharedOwner   = NULL;
+  myIsSharedTraceBuffer = false;
+}
+csTraceData::csTraceData( csSlabAllocator* allocator ) {
+  myAllocator  = allocator;
+  myNumSamples = 0;
+  myNumAllocatedSamples = 0;
+  myDataSamples = NULL;
+  myDoTrimOnNextCall = false;
+  mySharedSamples = NULL;
+  mySharedOwner   = NULL;
+  myIsSharedTraceBuffer = false;
 }
 csTraceData::~csTraceData() {
+  if( mySharedSamples != NULL ) {
+    unshare( false );
+  }
   if( myDataSamples ) {
-    delete [] myDataSamples;
+    releaseSamples( myDataSamples, myNumAllocatedSamples );
     myDataSamples = NULL;
   }
 }
 //---------------------------------------------------------------------------
 //
+float* csTraceData::allocateSamples( int numSamples, int& numAllocatedSamples ) {
+  if( myAllocator == NULL ) {
+    numAllocatedSamples = numSamples;
+    return new float[numSamples];
+  }
+  // Use full size of allocated block
+  csInt64_t numBytes = csSlabAllocator::blockSize( (csInt64_t)numSamples*sizeof(float) );
+  numAllocatedSamples = (int)( numBytes / sizeof(float) );
+  return reinterpret_cast<float*>( myAllocator->allocate( numBytes ) );
+}
+void csTraceData::releaseSamples( float* samples, int numAllocatedSamples ) {
+  if( myAllocator == NULL ) {
+    delete [] samples;
+  }
+  else {
+    myAllocator->release( samples, (csInt64_t)numAllocatedSamples*sizeof(float) );
+  }
+}
+//---------------------------------------------------------------------------
+//
 void csTraceData::setData( csTraceData const* data ) {
+  if( data->mySharedSamples != NULL ) {
+    // Share samples with other trace instead of copying them
+    setSharedData( data->mySharedSamples, data->myNumSamples, data->mySharedOwner, data->myIsSharedTraceBuffer );
+    return;
+  }
   if( myNumSamples != data->myNumSamples ) {
     // BUGFIX 080630: Previously, no check was made whether this data object had the same number of samples. This lead to data objects with 0 numSamples etc.
     set( data->myNumSamples );
@@ -37,28 +119,120 @@ void csTraceData::setData( csTraceData const* data ) {
   setData( data->myDataSamples, data->myNumSamples );
 }
 void csTraceData::setData( float const* samples, int nSamples ) {
+  if( mySharedSamples != NULL ) {
+    // No need to copy shared samples that are overwritten anyway
+    unshare( nSamples < myNumSamples || myNumSamples > myNumAllocatedSamples );
+  }
   memcpy( myDataSamples, samples, std::min(nSamples,myNumSamples)*sizeof(float) );
 }
+void csTraceData::setSharedData( float const* samples, int nSamples, cseis_geolib::csSharedBuffer* owner ) {
+  setSharedData( samples, nSamples, owner, false );
+}
+void csTraceData::setSharedData( float const* samples, int nSamples, cseis_geolib::csSharedBuffer* owner, bool isTraceBuffer ) {
+  owner->addRef();
+  if( mySharedSamples != NULL ) {
+    unshare( false );
+  }
+  mySharedSamples = samples;
+  mySharedOwner   = owner;
+  myNumSamples    = nSamples;
+  myIsSharedTraceBuffer = isTraceBuffer;
+}
+void csTraceData::shareData( csTraceData* data ) {
+  if( data == this ) return;
+  if( data->mySharedSamples == NULL ) {
+    if( data->myDataSamples == NULL ) {
+      setData( data );
+      return;
+    }
+    // Move other object's sample buffer into reference counted buffer. Other object holds the first reference
+    csSharedSamples* shared = new csSharedSamples( data->myDataSamples, data->myNumAllocatedSamples, data->myAllocator );
+    data->myDataSamples         = NULL;
+    data->myNumAllocatedSamples = 0;
+    data->mySharedSamples       = shared->samples();
+    data->mySharedOwner         = shared;
+    data->myIsSharedTraceBuffer = true;
+  }
+  setSharedData( data->mySharedSamples, data->myNumSamples, data->mySharedOwner, data->myIsSharedTraceBuffer );
+}
+void csTraceData::unshare( bool copySamples ) {
+  float const* samples = mySharedSamples;
+  cseis_geolib::csSharedBuffer* owner = mySharedOwner;
+  bool isTraceBuffer = myIsSharedTraceBuffer;
+  mySharedSamples = NULL;
+  mySharedOwner   = NULL;
+  myIsSharedTraceBuffer = false;
+  if( isTraceBuffer && owner->numRefs() == 1 ) {
+    csSharedSamples* shared = static_cast<csSharedSamples*>( owner );
+    if( shared->allocator() == myAllocator && shared->numAllocatedSamples() >= myNumSamples ) {
+      // Last reference to other trace's sample buffer: Take over buffer instead of copying samples
+      if( myDataSamples != NULL ) {
+        releaseSamples( myDataSamples, myNumAllocatedSamples );
+      }
+      myDataSamples         = shared->samples();
+      myNumAllocatedSamples = shared->numAllocatedSamples();
+      shared->detach();
+      owner->release();
+      return;
+    }
+  }
+  if( copySamples ) {
+    if( myNumSamples > myNumAllocatedSamples ) {
+      int numSamples = myNumSamples;
+      myNumSamples = std::min( myNumSamples, myNumAllocatedSamples );
+      set( numSamples );
+    }
+    memcpy( myDataSamples, samples, myNumSamples*sizeof(float) );
+  }
+  else if( myNumSamples > myNumAllocatedSamples ) {
+    // Own buffer is smaller than shared samples. Leave it to set() to re-allocate
+    myNumSamples = myNumAllocatedSamples;
+  }
+  owner->release();
+}
+void csTraceData::clearMemory() {
+  if( mySharedSamples != NULL ) {
+    unshare( false );
+  }
+  if( myDataSamples != NULL ) {
+    releaseSamples( myDataSamples, myNumAllocatedSamples );
+    myDataSamples = NULL;
+  }
+  myNumAllocatedSamples = 0;
+  myNumSamples = 0;
+  myDoTrimOnNextCall = false;
+}
 void csTraceData::trim() {
   //  printf("---Trimmed from %d to %d samples\n", myNumAllocatedSamples, myNumSamples );
   myDoTrimOnNextCall = true;
 }
 void csTraceData::set( int numSamplesNew, int firstLiveSample ) {
+  if( mySharedSamples != NULL ) {
+    if( numSamplesNew <= myNumSamples && firstLiveSample <= 0 && !myDoTrimOnNextCall ) {
+      myNumSamples = numSamplesNew;
+      return;
+    }
+    unshare( true );
+  }
   //  if( myDoTrimOnNextCall ) printf("Trimmed from %d to %d to %d samples\n", myNumAllocatedSamples, myNumSamples, numSamplesNew );
   if( numSamplesNew > myNumAllocatedSamples || myDoTrimOnNextCall ) {
     float* dataNew = NULL;
+    int numAllocatedSamplesNew = 0;
     try {
-      dataNew = new float[numSamplesNew];
+      dataNew = allocateSamples( numSamplesNew, numAllocatedSamplesNew );
+    }
+    catch( cseis_geolib::csException& e ) {
+      throw;  // Memory budget exceeded
     }
     catch(...) {
       throw( cseis_geolib::csException("csTraceData::set: Unable to allocate new trace data buffer. Out of memory.") );
     }
     if( myDataSamples ) {
       memcpy( dataNew, myDataSamples, std::min( myNumSamples, numSamplesNew )*sizeof(float) );
-      delete [] myDataSamples;
+      releaseSamples( myDataSamples, myNumAllocatedSamples );
     }
     myDataSamples = dataNew;
-    myNumAllocatedSamples = numSamplesNew;
+    myNumAllocatedSamples = numAllocatedSamplesNew;
     myNumSamples = numSamplesNew;
     myDoTrimOnNextCall = false;
   }
@@ -111,7 +111,10 @@ void csTraceGather::copyTraceTo( int traceIndex, csTraceGather* traceGather ) {
     throw( cseis_geolib::csException("csTraceGather::copyTraceTo(): This instance has no memory manager. To use this function, Construct the trace gather instance using one of the other constructors") );
   }
   csTrace* traceOld = myTraceList->at( traceIndex );
-  csTrace* traceNew = myMemoryManager->getNewTrace( traceOld );
+  csTrace* traceNew = myMemoryManager->getNewTrace();
+  traceNew->getTraceHeader()->copyFrom( traceOld->getTraceHeader() );
+  // Samples are shared until either trace requests write access
+  traceNew->getTraceDataObject()->shareData( traceOld->getTraceDataObject() );
   traceGather->addTrace( traceNew );
 }
 //------------------------------------------------------------------
@@ -123,3 +126,106 @@ void csTraceGather::addTrace( csTrace* trace, int atTraceIndex ) {
   myTraceList->insert( trace, atTraceIndex );
 }
 
+
+//------------------------------------------------------------------
+// Columnar header access
+//
+inline csTraceHeaderData* csTraceGather::headerData( int traceIndex ) const {
+  return myTraceList->at(traceIndex)->getTraceHeader()->myTraceHeaderData;
+}
+int csTraceGather::headerColumnRange( int firstTrace, int numTraces ) const {
+  int numTracesGather = myTraceList->size();
+  if( numTraces < 0 ) numTraces = numTracesGather - firstTrace;
+  if( firstTrace < 0 || firstTrace + numTraces > numTracesGather ) {
+    throw( cseis_geolib::csException("csTraceGather: Trace range %d-%d out of bounds. Number of traces in gather: %d",
+                                     firstTrace, firstTrace+numTraces-1, numTracesGather) );
+  }
+  return numTraces;
+}
+template<typename T>
+void csTraceGather::readHeaderColumn( int hdrIndex, T* values, int firstTrace, int numTraces ) const {
+  numTraces = headerColumnRange( firstTrace, numTraces );
+  if( numTraces == 0 ) return;
+  int lastTrace = firstTrace + numTraces - 1;
+  switch( myTraceList->at(firstTrace)->getTraceHeader()->type(hdrIndex) ) {
+  case cseis_geolib::TYPE_INT:
+    for( int itrc = firstTrace; itrc <= lastTrace; itrc++ ) {
+      values[itrc-firstTrace] = (T)headerData(itrc)->intValue( hdrIndex );
+    }
+    break;
+  case cseis_geolib::TYPE_FLOAT:
+    for( int itrc = firstTrace; itrc <= lastTrace; itrc++ ) {
+      values[itrc-firstTrace] = (T)headerData(itrc)->floatValue( hdrIndex );
+    }
+    break;
+  case cseis_geolib::TYPE_DOUBLE:
+    for( int itrc = firstTrace; itrc <= lastTrace; itrc++ ) {
+      values[itrc-firstTrace] = (T)headerData(itrc)->doubleValue( hdrIndex );
+    }
+    break;
+  case cseis_geolib::TYPE_INT64:
+    for( int itrc = firstTrace; itrc <= lastTrace; itrc++ ) {
+      values[itrc-firstTrace] = (T)headerData(itrc)->int64Value( hdrIndex );
+    }
+    break;
+  default:
+    throw( cseis_geolib::csException("csTraceGather::getHeaderValues(): Header does not have a number type.") );
+  }
+}
+template<typename T>
+void csTraceGather::writeHeaderColumn( int hdrIndex, T const* values, int valueStep, int firstTrace, int numTraces ) {
+  numTraces = headerColumnRange( firstTrace, numTraces );
+  if( numTraces == 0 ) return;
+  int lastTrace = firstTrace + numTraces - 1;
+  switch( myTraceList->at(firstTrace)->getTraceHeader()->type(hdrIndex) ) {
+  case cseis_geolib::TYPE_INT:
+    for( int itrc = firstTrace; itrc <= lastTrace; itrc++ ) {
+      headerData(itrc)->setIntValue( hdrIndex, (int)values[(itrc-firstTrace)*valueStep] );
+    }
+    break;
+  case cseis_geolib::TYPE_FLOAT:
+    for( int itrc = firstTrace; itrc <= lastTrace; itrc++ ) {
+      headerData(itrc)->setFloatValue( hdrIndex, (float)values[(itrc-firstTrace)*valueStep] );
+    }
+    break;
+  case cseis_geolib::TYPE_DOUBLE:
+    for( int itrc = firstTrace; itrc <= lastTrace; itrc++ ) {
+      headerData(itrc)->setDoubleValue( hdrIndex, (double)values[(itrc-firstTrace)*valueStep] );
+    }
+    break;
+  case cseis_geolib::TYPE_INT64:
+    for( int itrc = firstTrace; itrc <= lastTrace; itrc++ ) {
+      headerData(itrc)->setInt64Value( hdrIndex, (csInt64_t)values[(itrc-firstTrace)*valueStep] );
+    }
+    break;
+  default:
+    throw( cseis_geolib::csException("csTraceGather::setHeaderValues(): Header does not have a number type.") );
+  }
+}
+void csTraceGather::getHeaderValues( int hdrIndex, double* values, int firstTrace, int numTraces ) const {
+  readHeaderColumn( hdrIndex, values, firstTrace, numTraces );
+}
+void csTraceGather::getHeaderValues( int hdrIndex, float* values, int firstTrace, int numTraces ) const {
+  readHeaderColumn( hdrIndex, values, firstTrace, numTraces );
+}
+void csTraceGather::getHeaderValues( int hdrIndex, int* values, int firstTrace, int numTraces ) const {
+  readHeaderColumn( hdrIndex, values, firstTrace, numTraces );
+}
+void csTraceGather::getHeaderValues( int hdrIndex, csInt64_t* values, int firstTrace, int numTraces ) const {
+  readHeaderColumn( hdrIndex, values, firstTrace, numTraces );
+}
+void csTraceGather::setHeaderValues( int hdrIndex, double const* values, int firstTrace, int numTraces ) {
+  writeHeaderColumn( hdrIndex, values, 1, firstTrace, numTraces );
+}
+void csTraceGather::setHeaderValues( int hdrIndex, float const* values, int firstTrace, int numTraces ) {
+  writeHeaderColumn( hdrIndex, values, 1, firstTrace, numTraces );
+}
+void csTraceGather::setHeaderValues( int hdrIndex, int const* values, int firstTrace, int numTraces ) {
+  writeHeaderColumn( hdrIndex, values, 1, firstTrace, numTraces );
+}
+void csTraceGather::setHeaderValues( int hdrIndex, csInt64_t const* values, int firstTrace, int numTraces ) {
+  writeHeaderColumn( hdrIndex, values, 1, firstTrace, numTraces );
+}
+void csTraceGather::setHeaderValue( int hdrIndex, double value, int firstTrace, int numTraces ) {
+  writeHeaderColumn( hdrIndex, &value, 0, firstTrace, numTraces );
+}
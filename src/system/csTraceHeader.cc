@@ -10,11 +10,11 @@
 
 using namespace cseis_system;
 
-csTraceHeader::csTraceHeader() :
+csTraceHeader::csTraceHeader( csSlabAllocator* allocator, int numBytesToAllocate ) :
   myTraceHeaderData( NULL ),
   myHeaderDefPtr( NULL )
 {
-  myTraceHeaderData = new csTraceHeaderData();
+  myTraceHeaderData = new csTraceHeaderData( allocator, numBytesToAllocate );
 }
 //----------------------------------------------------------------------
 //
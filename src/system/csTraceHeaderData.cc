@@ -6,9 +6,7 @@
 #include "cseis_defines.h"
 #include "csTraceHeaderData.h"
 #include "csTraceHeaderDef.h"
-#include "csTraceHeaderInfo.h"
-#include "csGeolibUtils.h"
-#include "csVector.h"
+#include "csSlabAllocator.h"
 #include "csException.h"
 
 using namespace cseis_system;
@@ -18,7 +16,8 @@ int csTraceHeaderData::counter = 0;
 int csTraceHeaderData::NUM_ADD_HEADERS = 5;
 int csTraceHeaderData::NUM_ADD_BYTES = 20;
 
-csTraceHeaderData::csTraceHeaderData() {
+csTraceHeaderData::csTraceHeaderData( csSlabAllocator* allocator, int numBytesToAllocate ) {
+  myAllocator = allocator;
   csTraceHeaderData::counter += 1;
   myIndex = csTraceHeaderData::counter;
   
@@ -29,13 +28,18 @@ csTraceHeaderData::csTraceHeaderData() {
   myValueBlock   = NULL;
   myByteLocationPtr = NULL;
 
-  reallocateBytes( NUM_ADD_BYTES );
+  reallocateBytes( numBytesToAllocate > NUM_ADD_BYTES ? numBytesToAllocate : NUM_ADD_BYTES );
 }
 //----------------------------------------------------------------------
 //
 csTraceHeaderData::~csTraceHeaderData() {
   if( myValueBlock ) {
-    delete [] myValueBlock;
+    if( myAllocator == NULL ) {
+      delete [] myValueBlock;
+    }
+    else {
+      myAllocator->release( myValueBlock, myNumAllocatedBytes );
+    }
     myValueBlock = NULL;
   }
 }
@@ -43,9 +47,13 @@ csTraceHeaderData::~csTraceHeaderData() {
 //
 void csTraceHeaderData::setHeaders( csTraceHeaderDef const* hdef, int inPort ) {
   int totalNumBytes = hdef->getTotalNumBytes();
-  if( myNumBytes < totalNumBytes ) {
+  if( myNumAllocatedBytes < totalNumBytes ) {
     reallocateBytes( totalNumBytes );    
   }
+  else if( myNumBytes < totalNumBytes ) {
+    // Re-use allocated block. New header values are zero, as for a newly allocated block
+    memset( &myValueBlock[myNumBytes], 0, totalNumBytes-myNumBytes );
+  }
   myNumBytes = totalNumBytes;
 
   myByteLocationPtr = hdef->getHandleByteLocation();
@@ -54,43 +62,13 @@ void csTraceHeaderData::setHeaders( csTraceHeaderDef const* hdef, int inPort ) {
 //----------------------------------------------------------------------
 //
 void csTraceHeaderData::deleteHeaders( csTraceHeaderDef const* hdef ) {
-  cseis_geolib::csVector<int> const* indexOfHeadersToDel = hdef->getIndexOfHeadersToDel();
-  int numHdrToDel = indexOfHeadersToDel->size();
-  int const* byteLocation = hdef->getHandleByteLocation();
-
-  int sumNumBytesToDel = 0;
-  for( int iHdrDel = 0; iHdrDel < numHdrToDel; iHdrDel++ ) {
-    int indexHdrDel = indexOfHeadersToDel->at(iHdrDel);
-    csTraceHeaderInfo const* info = hdef->headerInfo(indexHdrDel);
-    int numBytesHdrDel = cseis_geolib::csGeolibUtils::numBytes(info->type);  // or info->numBytes
-    sumNumBytesToDel += numBytesHdrDel;
-  }
-  int numOldBytes = myNumBytes;
-  int numNewBytes = myNumBytes-sumNumBytesToDel;
-
-  char* temp_buffer = new char[numNewBytes];
-  int bytePos = 0;
-  int bytePosNew = 0;
-  int bytePosCurrent = 0;
-
-  for( int iHdrDel = 0; iHdrDel < numHdrToDel; iHdrDel++ ) {
-    int indexHdrDel = indexOfHeadersToDel->at(iHdrDel);
-    csTraceHeaderInfo const* info = hdef->headerInfo(indexHdrDel);
-    int numBytesHdrDel = cseis_geolib::csGeolibUtils::numBytes(info->type);  // or info->numBytes
-    bytePosNew = byteLocation[indexHdrDel];
-    memcpy( &temp_buffer[bytePosCurrent], &myValueBlock[bytePos], bytePosNew-bytePos );
-    bytePosCurrent += bytePosNew-bytePos;
-    bytePos = bytePosNew + numBytesHdrDel;
-  }
-  if( numOldBytes-bytePos+bytePosCurrent != numNewBytes ) {
-    throw cseis_geolib::csException("Error: Unequal number of bytes, %d != %d  (%d %d %d)\n",
-                                    numOldBytes-bytePos+bytePosCurrent, numNewBytes,
-                                    numOldBytes, bytePos, bytePosCurrent );
+  // Apply delete plan compiled in the init phase: Move remaining headers in place
+  csTraceHeaderDef::ByteSegment const* segments = hdef->getDeleteSegments();
+  int numSegments = hdef->numDeleteSegments();
+  for( int iseg = 0; iseg < numSegments; iseg++ ) {
+    memmove( &myValueBlock[segments[iseg].byteDest], &myValueBlock[segments[iseg].byteSource], segments[iseg].numBytes );
   }
-
-  memcpy( &temp_buffer[bytePosCurrent], &myValueBlock[bytePos], numOldBytes-bytePos );
-  memcpy( myValueBlock, temp_buffer, numNewBytes );
-  delete [] temp_buffer;
+  myNumBytes = hdef->getNumBytesAfterDelete();
 }
 //----------------------------------------------------------------------
 //
@@ -108,16 +86,31 @@ void csTraceHeaderData::copyFrom( csTraceHeaderData const* hdr ) {
 //----------------------------------------------------------------------
 //
 void csTraceHeaderData::reallocateBytes( int numBytesToAllocate ) {
-  myNumAllocatedBytes  = numBytesToAllocate;
   char* newValueBlock = NULL;
-  newValueBlock     = new char[myNumAllocatedBytes];
-  memset( newValueBlock, 0, myNumAllocatedBytes );
+  int numAllocatedBytesNew = numBytesToAllocate;
+  if( myAllocator == NULL ) {
+    newValueBlock = new char[numAllocatedBytesNew];
+  }
+  else {
+    // Use full size of allocated block
+    numAllocatedBytesNew = (int)csSlabAllocator::blockSize( numBytesToAllocate );
+    newValueBlock = reinterpret_cast<char*>( myAllocator->allocate( numAllocatedBytesNew ) );
+  }
+  memset( newValueBlock, 0, numAllocatedBytesNew );
   if( myNumBytes != 0 ) {
     memcpy( newValueBlock, myValueBlock, myNumBytes );
   }
 
-  if( myValueBlock ) delete [] myValueBlock;
+  if( myValueBlock ) {
+    if( myAllocator == NULL ) {
+      delete [] myValueBlock;
+    }
+    else {
+      myAllocator->release( myValueBlock, myNumAllocatedBytes );
+    }
+  }
   myValueBlock = newValueBlock;
+  myNumAllocatedBytes = numAllocatedBytesNew;
 }
 //---------------------------------------------------------------------
 //
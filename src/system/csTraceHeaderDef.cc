@@ -46,6 +46,9 @@ void csTraceHeaderDef::init( int numInputPorts, csMemoryPoolManager* memManager
   myTotalNumBytes = 0;
 
   myByteLocation = NULL;
+  myDeleteSegments      = NULL;
+  myNumDeleteSegments   = 0;
+  myNumBytesAfterDelete = 0;
 
   myIndexOfHeadersToDel = new cseis_geolib::csVector<int>(0);
 
@@ -68,17 +71,19 @@ void csTraceHeaderDef::initInputPorts( csTraceHeaderDef const** hdefPrev ) {
   cseis_geolib::csVector<int> const* indexOfHeadersToDel = hdef->getIndexOfHeadersToDel();
   int nHeadersToDel = indexOfHeadersToDel->size();
   int counterDel = 0;
+  // Total number of bytes excludes deleted headers: Header value blocks shrink accordingly when traces leave the previous module
+  myTotalNumBytes = 0;
   for( int iHdr = 0; iHdr < nHeaders; iHdr++ ) {
     csTraceHeaderInfo const* info = hdef->myTraceHeaderInfoList->at(iHdr);
     // This header shall be deleted, not to be passed on...
     if( nHeadersToDel > counterDel && indexOfHeadersToDel->at(counterDel) == iHdr ) {
-      counterDel += 1;
+      while( nHeadersToDel > counterDel && indexOfHeadersToDel->at(counterDel) == iHdr ) counterDel += 1;
     }
     else {
       myTraceHeaderInfoList->insertEnd( info );
+      myTotalNumBytes += cseis_geolib::csGeolibUtils::numBytes( info->type )*info->nElements;
     }
   }
-  myTotalNumBytes = hdefPrev[0]->myTotalNumBytes;
   myNumBytesOfHeadersToAdd[0] = 0;
 
   if( myNumInputPorts > 1 ) {
@@ -168,6 +173,10 @@ csTraceHeaderDef::~csTraceHeaderDef() {
     delete [] myByteLocation;
     myByteLocation = NULL;
   }
+  if( myDeleteSegments != NULL ) {
+    delete [] myDeleteSegments;
+    myDeleteSegments = NULL;
+  }
 }
 int csTraceHeaderDef::numHeaders() const {
   return myTraceHeaderInfoList->size();
@@ -427,6 +436,47 @@ void csTraceHeaderDef::resetByteLocation() {
     }
     myByteLocation[ihdr] = numBytes;
   }
+  compileDeletePlan();
+}
+//----------------------------------------------------------------
+// Headers to delete are sorted by index, and so are their byte locations. Each run of remaining headers between two
+// deleted headers moves down by the number of bytes deleted so far. Since segments only ever move towards the start
+// of the value block, moving them in ascending order does not overwrite bytes that have not been moved yet.
+//
+void csTraceHeaderDef::compileDeletePlan() {
+  if( myDeleteSegments != NULL ) {
+    delete [] myDeleteSegments;
+    myDeleteSegments = NULL;
+  }
+  myNumDeleteSegments   = 0;
+  myNumBytesAfterDelete = myTotalNumBytes;
+  int numHdrToDel = myIndexOfHeadersToDel->size();
+  if( numHdrToDel == 0 ) return;
+
+  int nHeaders = numHeaders();
+  myDeleteSegments = new ByteSegment[numHdrToDel+1];
+  int byteSource = 0;  // Start of current run of remaining headers
+  int byteDest   = 0;
+  for( int iHdrDel = 0; iHdrDel <= numHdrToDel; iHdrDel++ ) {
+    int byteRunEnd  = myTotalNumBytes;
+    int byteNextRun = myTotalNumBytes;
+    if( iHdrDel < numHdrToDel ) {
+      int indexHdrDel = myIndexOfHeadersToDel->at(iHdrDel);
+      byteRunEnd  = myByteLocation[indexHdrDel];
+      byteNextRun = ( indexHdrDel < nHeaders-1 ) ? myByteLocation[indexHdrDel+1] : myTotalNumBytes;
+      if( byteRunEnd < byteSource ) continue;  // Same header listed twice
+    }
+    int numBytes = byteRunEnd - byteSource;
+    if( numBytes > 0 && byteSource != byteDest ) {
+      ByteSegment* segment = &myDeleteSegments[myNumDeleteSegments++];
+      segment->byteSource = byteSource;
+      segment->byteDest   = byteDest;
+      segment->numBytes   = numBytes;
+    }
+    byteDest  += numBytes;
+    byteSource = byteNextRun;
+  }
+  myNumBytesAfterDelete = byteDest;
 }
 
 bool csTraceHeaderDef::isSystemTraceHeader( std::string const& name ) const {
@@ -3,150 +3,249 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
+#include <algorithm>
 #include "csTracePool.h"
 #include "csMemoryPoolManager.h"
 #include "csException.h"
 #include "csTrace.h"
-#include <map>
 
 using namespace cseis_system;
 
-csTracePool::csTracePool( int policy ) {
-  myNumAllocatedTraces = 0;
-  myIndexNextFreeTrace = 0;
-  myNumUsedTraces      = 0;
-  myMaxNumUsedTraces   = 0;
-  myPolicy             = policy;
-  myTraceIndexMap = new std::map<int,int>();
+thread_local csTracePool::csThreadCacheSlot csTracePool::myThreadCacheSlot;
+pthread_mutex_t csTracePool::myThreadCacheSlotMutex = PTHREAD_MUTEX_INITIALIZER;
+csTracePool* csTracePool::myFirstPool = NULL;
+int csTracePool::myFreeThreadCacheSlots[csTracePool::MAX_NUM_THREAD_CACHES];
+int csTracePool::myNumFreeThreadCacheSlots = 0;
+int csTracePool::myNumThreadCacheSlots = 0;
+
+csTracePool::csTracePool( int policy, csSlabAllocator* allocator ) :
+  myNumUsedTraces( 0 ),
+  myMaxNumUsedTraces( 0 ),
+  myNumAllocatedTraces( 0 )
+{
+  myTraces           = NULL;
+  myFreeTraces       = NULL;
+  myNumCreatedTraces = 0;
+  myNumFreeTraces    = 0;
+  myCapacity         = 0;
+  myPolicy           = policy;
+  myAllocator        = allocator;
+  myNumHeaderBytes   = 0;
+  for( int i = 0; i < MAX_NUM_THREAD_CACHES; i++ ) {
+    myThreadCaches[i] = NULL;
+  }
+  pthread_mutex_init( &myMutex, NULL );
   if( myPolicy == csMemoryPoolManager::POLICY_SPEED ) {
     myBlockSize = 4;
   }
   else {
     myBlockSize = 1;
   }
+  myNumAllocatedTraces = myBlockSize;
   reallocate( myBlockSize );
+
+  pthread_mutex_lock( &myThreadCacheSlotMutex );
+  myNextPool  = myFirstPool;
+  myFirstPool = this;
+  pthread_mutex_unlock( &myThreadCacheSlotMutex );
 }
 csTracePool::~csTracePool() {
+  pthread_mutex_lock( &myThreadCacheSlotMutex );
+  csTracePool** poolPtr = &myFirstPool;
+  while( *poolPtr != this ) {
+    poolPtr = &(*poolPtr)->myNextPool;
+  }
+  *poolPtr = myNextPool;
+  pthread_mutex_unlock( &myThreadCacheSlotMutex );
+
   if( myTraces != NULL ) {
-    for( int i = 0; i < myNumAllocatedTraces; i++ ) {
-      if( myTraces[i] ) delete myTraces[i];
+    for( int i = 0; i < myNumCreatedTraces; i++ ) {
+      delete myTraces[i];
     }
     delete [] myTraces;
     myTraces = NULL;
   }
-  if( myIsTraceFree != NULL ) {
-    delete [] myIsTraceFree;
-    myIsTraceFree = NULL;
+  if( myFreeTraces != NULL ) {
+    delete [] myFreeTraces;
+    myFreeTraces = NULL;
   }
-  if( myTraceIndexMap != NULL ) {
-    delete myTraceIndexMap;
-    myTraceIndexMap = NULL;
+  for( int i = 0; i < MAX_NUM_THREAD_CACHES; i++ ) {
+    if( myThreadCaches[i] != NULL ) {
+      delete myThreadCaches[i];
+      myThreadCaches[i] = NULL;
+    }
   }
-
+  pthread_mutex_destroy( &myMutex );
+}
+void csTracePool::setNumHeaderBytes( int numHeaderBytes ) {
+  myNumHeaderBytes = numHeaderBytes;
 }
 //----------------------------------------------------
-void csTracePool::reallocate( int numTracesNew ) {
-  csTrace** trcs = new csTrace*[numTracesNew];
-  bool* isFree = new bool[numTracesNew];
-  if( myNumAllocatedTraces > 0 ) {
-    for( int i = 0; i < myNumAllocatedTraces; i++ ) {
-      trcs[i]   = myTraces[i];
-      isFree[i] = myIsTraceFree[i];
-    }
-    delete [] myIsTraceFree;
+void csTracePool::reallocate( int newCapacity ) {
+  csTrace** trcs     = new csTrace*[newCapacity];
+  csTrace** trcsFree = new csTrace*[newCapacity];
+  if( myCapacity > 0 ) {
+    memcpy( trcs, myTraces, myNumCreatedTraces*sizeof(csTrace*) );
+    memcpy( trcsFree, myFreeTraces, myNumFreeTraces*sizeof(csTrace*) );
     delete [] myTraces;
+    delete [] myFreeTraces;
   }
-
-// Only fully allocate one trace. Leave other traces to be allocated later
-  isFree[myNumAllocatedTraces] = true;
-  trcs[myNumAllocatedTraces]   = new csTrace(this);
-  myTraceIndexMap->insert(std::pair<int,int>(trcs[myNumAllocatedTraces]->getIdentNumber(),myNumAllocatedTraces) );
-  for( int i = myNumAllocatedTraces+1; i < numTracesNew; i++ ) {
-    isFree[i] = true;  // is free yet not allocated yet
-    trcs[i]   = NULL;
+  myTraces     = trcs;
+  myFreeTraces = trcsFree;
+  myCapacity   = newCapacity;
+}
+//----------------------------------------------------
+//
+csTracePool::csTraceCache* csTracePool::threadCache() {
+  if( myPolicy != csMemoryPoolManager::POLICY_SPEED ) return NULL;
+  int slot = myThreadCacheSlot.slot;
+  if( slot < 0 ) {
+    slot = acquireThreadCacheSlot();
+    if( slot < 0 ) return NULL;  // Try again next time: Another thread may have released its slot
+    myThreadCacheSlot.slot = slot;
   }
-
-  myTraces = trcs;
-  myIsTraceFree  = isFree;
-  myNumAllocatedTraces = numTracesNew;
+  csTraceCache* cache = myThreadCaches[slot];
+  if( cache == NULL ) {
+    // Slot is held by calling thread: No other thread accesses this cache
+    cache = new csTraceCache();
+    cache->numTraces = 0;
+    myThreadCaches[slot] = cache;
+  }
+  return cache;
+}
+//----------------------------------------------------
+//
+int csTracePool::acquireThreadCacheSlot() {
+  int slot = -1;
+  pthread_mutex_lock( &myThreadCacheSlotMutex );
+  if( myNumFreeThreadCacheSlots > 0 ) {
+    slot = myFreeThreadCacheSlots[--myNumFreeThreadCacheSlots];
+  }
+  else if( myNumThreadCacheSlots < MAX_NUM_THREAD_CACHES ) {
+    slot = myNumThreadCacheSlots++;
+  }
+  pthread_mutex_unlock( &myThreadCacheSlotMutex );
+  return slot;
 }
 //----------------------------------------------------
-csInt64_t csTracePool::computeNumBytes() {
-  csInt64_t numSamples = 0;
-  for( int i = 0; i < myNumAllocatedTraces; i++ ) {
-    if( !myIsTraceFree[i] && myTraces[i] != NULL ) {
-      numSamples += myTraces[i]->numSamples();
+//
+void csTracePool::releaseThreadCacheSlot( int slot ) {
+  pthread_mutex_lock( &myThreadCacheSlotMutex );
+  for( csTracePool* pool = myFirstPool; pool != NULL; pool = pool->myNextPool ) {
+    csTraceCache* cache = pool->myThreadCaches[slot];
+    if( cache != NULL && cache->numTraces > 0 ) {
+      pthread_mutex_lock( &pool->myMutex );
+      pool->pushFreeTraces( cache->traces, cache->numTraces );
+      pthread_mutex_unlock( &pool->myMutex );
+      cache->numTraces = 0;
     }
   }
-  return( numSamples * (csInt64_t)sizeof(float) );
+  myFreeThreadCacheSlots[myNumFreeThreadCacheSlots++] = slot;
+  pthread_mutex_unlock( &myThreadCacheSlotMutex );
 }
 //----------------------------------------------------
 //
-void csTracePool::freeTrace( csTrace* trace ) {
-  int identNumber = trace->getIdentNumber();
-//  bool isOK = false;
-  std::map<int,int>::iterator iter = myTraceIndexMap->find(identNumber);
-  if( iter != myTraceIndexMap->end() ) {
-    myIsTraceFree[iter->second] = true;
-    myIndexNextFreeTrace = iter->second;
+csTracePool::csThreadCacheSlot::~csThreadCacheSlot() {
+  if( slot >= 0 ) {
+    csTracePool::releaseThreadCacheSlot( slot );
+    slot = -1;
   }
-  else {
+}
+//----------------------------------------------------
+//
+void csTracePool::addNumUsedTraces( int numTraces ) {
+  int numUsed = myNumUsedTraces.fetch_add( numTraces, std::memory_order_relaxed ) + numTraces;
+  int maxNumUsed = myMaxNumUsedTraces.load( std::memory_order_relaxed );
+  while( numUsed > maxNumUsed && !myMaxNumUsedTraces.compare_exchange_weak( maxNumUsed, numUsed, std::memory_order_relaxed ) ) {
+  }
+}
+//----------------------------------------------------
+//
+int csTracePool::popFreeTraces( csTrace** traces, int maxTraces ) {
+  if( myNumFreeTraces == 0 ) {
+    if( myNumCreatedTraces == myNumAllocatedTraces ) {
+      myNumAllocatedTraces += myBlockSize;
+      if( myPolicy == csMemoryPoolManager::POLICY_SPEED ) myBlockSize += BLOCK_SIZE_ATOM;
+    }
+    if( myNumCreatedTraces == myCapacity ) {
+      reallocate( 2*myCapacity );
+    }
+    // Only create one trace. Leave other allocated traces to be created later
+    csTrace* trace = new csTrace( this );
+    myTraces[myNumCreatedTraces++] = trace;
+    traces[0] = trace;
+    return 1;
+  }
+  int numTraces = std::min( maxTraces, myNumFreeTraces );
+  myNumFreeTraces -= numTraces;
+  memcpy( traces, &myFreeTraces[myNumFreeTraces], numTraces*sizeof(csTrace*) );
+  return numTraces;
+}
+//----------------------------------------------------
+//
+void csTracePool::pushFreeTraces( csTrace* const* traces, int numTraces ) {
+  memcpy( &myFreeTraces[myNumFreeTraces], traces, numTraces*sizeof(csTrace*) );
+  myNumFreeTraces += numTraces;
+}
+//----------------------------------------------------
+//
+void csTracePool::freeTrace( csTrace* trace ) {
+  if( trace->myTracePoolPtr != this || trace->myIsFree ) {
     throw( cseis_geolib::csException("csTracePool::freeTrace: Error...") );
   }
+  trace->myIsFree = true;
+  addNumUsedTraces( -1 );
 
-//  if( !isOK ) {
-//    printf("*** Free trace:  %3d %3d,  used: %3d   (NOT FOUND!!!!)\n", myIndexNextFreeTrace, myNumAllocatedTraces, myNumUsedTraces);
-//  }
-  myNumUsedTraces--;
-  //  fprintf(stdout,"******* Free trace from trace pool *******\n");
-  //  dump();
+  csTraceCache* cache = threadCache();
+  if( cache == NULL ) {
+    pthread_mutex_lock( &myMutex );
+    pushFreeTraces( &trace, 1 );
+    pthread_mutex_unlock( &myMutex );
+    return;
+  }
+  if( cache->numTraces == CACHE_SIZE ) {
+    // Cache is full: Move oldest half back to shared stack
+    pthread_mutex_lock( &myMutex );
+    pushFreeTraces( cache->traces, CACHE_BATCH_SIZE );
+    pthread_mutex_unlock( &myMutex );
+    cache->numTraces -= CACHE_BATCH_SIZE;
+    memmove( cache->traces, &cache->traces[CACHE_BATCH_SIZE], cache->numTraces*sizeof(csTrace*) );
+  }
+  cache->traces[cache->numTraces++] = trace;
 }
 //----------------------------------------------------
 //
 csTrace* csTracePool::getNewTrace() {
-  //  printf("*** Get new trace:  %3d %3d,   used: %3d", myIndexNextFreeTrace, myNumAllocatedTraces, myNumUsedTraces);
-  if( myTraces[myIndexNextFreeTrace] == NULL ) {
-    myTraces[myIndexNextFreeTrace] = new csTrace( this );
-    myTraceIndexMap->insert(std::pair<int,int>(myTraces[myIndexNextFreeTrace]->getIdentNumber(),myIndexNextFreeTrace));
-  }
-  csTrace* trace = myTraces[myIndexNextFreeTrace];
-//  printf(",   ID: %3d\n", myTraces[myIndexNextFreeTrace]->getIdentNumber() );
-  myIsTraceFree[myIndexNextFreeTrace] = false;
-  myNumUsedTraces++;
-  myIndexNextFreeTrace++;
-  if( myNumUsedTraces > myMaxNumUsedTraces ) myMaxNumUsedTraces= myNumUsedTraces;
-
-  if( myNumUsedTraces >= myNumAllocatedTraces ) {
-    reallocate( myNumAllocatedTraces+myBlockSize );
-    if( myPolicy == csMemoryPoolManager::POLICY_SPEED ) myBlockSize += BLOCK_SIZE_ATOM;
+  csTrace* trace = NULL;
+  csTraceCache* cache = threadCache();
+  if( cache == NULL ) {
+    pthread_mutex_lock( &myMutex );
+    popFreeTraces( &trace, 1 );
+    pthread_mutex_unlock( &myMutex );
   }
-
-  if( myIndexNextFreeTrace >= myNumAllocatedTraces || !myIsTraceFree[myIndexNextFreeTrace] ) {
-    for( int i = 0; i < myNumAllocatedTraces; i++ ) {
-      if( myIsTraceFree[i] ) {
-        myIndexNextFreeTrace = i;
-        break;
-      }
-    }
-    if( myIndexNextFreeTrace >= myNumAllocatedTraces || !myIsTraceFree[myIndexNextFreeTrace] ) {
-      fprintf(stderr,"ERROR in trace pool. %d %d\n", myIndexNextFreeTrace, myNumAllocatedTraces );
+  else {
+    if( cache->numTraces == 0 ) {
+      pthread_mutex_lock( &myMutex );
+      cache->numTraces = popFreeTraces( cache->traces, CACHE_BATCH_SIZE );
+      pthread_mutex_unlock( &myMutex );
     }
+    trace = cache->traces[--cache->numTraces];
   }
+  trace->myIsFree = false;
+  addNumUsedTraces( 1 );
   return trace;
 }
 //----------------------------------------------------
 //
 void csTracePool::dumpSummary( FILE* fout ) const {
-  std::string speed  = "SPEED";
-  std::string memory = "MEMORY";
-  fprintf( fout," Total number of used/allocated traces:  %d/%d\n", myMaxNumUsedTraces, myNumAllocatedTraces );
+  fprintf( fout," Total number of used/allocated traces:  %d/%d\n", myMaxNumUsedTraces.load(), myNumAllocatedTraces.load() );
 }
 void csTracePool::dump() {
   std::string speed  = "SPEED";
   std::string memory = "MEMORY";
   fprintf(stdout,"****** TracePool dump *******\n");
-  fprintf(stdout," Number of traces allocated/used/max:   %d / %d / %d\n", myNumAllocatedTraces, myNumUsedTraces, myMaxNumUsedTraces );
+  fprintf(stdout," Number of traces allocated/used/max:   %d / %d / %d\n", myNumAllocatedTraces.load(), myNumUsedTraces.load(), myMaxNumUsedTraces.load() );
   fprintf(stdout," Memory pool policy used:           %s\n", myPolicy == csMemoryPoolManager::POLICY_SPEED ? speed.c_str() : memory.c_str() );
-  fprintf(stdout," Index of next free trace: %d\n", myIndexNextFreeTrace);
+  fprintf(stdout," Number of created traces / free traces on shared stack: %d / %d\n", myNumCreatedTraces, myNumFreeTraces);
 }
-
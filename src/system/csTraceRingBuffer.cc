@@ -0,0 +1,88 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+#include "csTraceRingBuffer.h"
+#include "csException.h"
+#include <sched.h>
+#include <unistd.h>
+
+using namespace cseis_system;
+
+csTraceRingBuffer::csTraceRingBuffer( int capacity ) :
+  myNumPopped( 0 ),
+  myNumPushed( 0 ),
+  myIsFinished( false ),
+  myIsAborted( false )
+{
+  if( capacity <= 0 ) {
+    throw( cseis_geolib::csException("csTraceRingBuffer: Invalid capacity: %d", capacity) );
+  }
+  myCapacity = capacity;
+  myBuffer   = new csTrace*[myCapacity];
+}
+csTraceRingBuffer::~csTraceRingBuffer() {
+  if( myBuffer != NULL ) {
+    delete [] myBuffer;
+    myBuffer = NULL;
+  }
+}
+//--------------------------------------------------------------------
+//
+bool csTraceRingBuffer::push( csTrace* trace ) {
+  long numPushed = myNumPushed.load( std::memory_order_relaxed );
+  int numWaits = 0;
+  while( numPushed - myNumPopped.load( std::memory_order_acquire ) >= myCapacity ) {
+    if( isAborted() ) return false;
+    wait( numWaits );
+  }
+  myBuffer[numPushed % myCapacity] = trace;
+  myNumPushed.store( numPushed+1, std::memory_order_release );
+  return true;
+}
+//--------------------------------------------------------------------
+//
+csTrace* csTraceRingBuffer::tryPop() {
+  long numPopped = myNumPopped.load( std::memory_order_relaxed );
+  if( numPopped == myNumPushed.load( std::memory_order_acquire ) ) {
+    return NULL;
+  }
+  csTrace* trace = myBuffer[numPopped % myCapacity];
+  myNumPopped.store( numPopped+1, std::memory_order_release );
+  return trace;
+}
+//--------------------------------------------------------------------
+//
+csTrace* csTraceRingBuffer::pop() {
+  int numWaits = 0;
+  while( true ) {
+    if( isAborted() ) return NULL;
+    csTrace* trace = tryPop();
+    if( trace != NULL ) return trace;
+    if( myIsFinished.load( std::memory_order_acquire ) ) {
+      // All traces are pushed before finished flag is set: Check one last time
+      return tryPop();
+    }
+    wait( numWaits );
+  }
+}
+//--------------------------------------------------------------------
+//
+void csTraceRingBuffer::setFinished() {
+  myIsFinished.store( true, std::memory_order_release );
+}
+//--------------------------------------------------------------------
+//
+void csTraceRingBuffer::abort() {
+  myIsAborted.store( true, std::memory_order_release );
+}
+//--------------------------------------------------------------------
+//
+void csTraceRingBuffer::wait( int& numWaits ) {
+  numWaits += 1;
+  if( numWaits < 100 ) {
+    sched_yield();
+  }
+  else {
+    usleep( 50 );
+  }
+}